@@ -52,6 +52,7 @@
 // and pairable_mask is either 0 if static, or set to all if non static
 
 #include "bvh_tree.h"
+#include "core/object/worker_thread_pool.h"
 #include "core/os/mutex.h"
 
 #define BVHTREE_CLASS BVH_Tree<T, NUM_TREES, 2, MAX_ITEMS, USER_PAIR_TEST_FUNCTION, USER_CULL_TEST_FUNCTION, USE_PAIRS, BOUNDS, POINT>
@@ -88,6 +89,14 @@ public:
 		tree.params_set_pairing_expansion(p_value);
 	}
 
+	// When at least this many items changed since the last collision check, their tree queries
+	// run in parallel on the WorkerThreadPool. Pairs are still added and removed in the
+	// order of the single threaded check, so callbacks are the same. 0 disables it.
+	void params_set_parallel_pairing_threshold(uint32_t p_min_changed_items) {
+		BVH_LOCKED_FUNCTION
+		_parallel_pairing_threshold = p_min_changed_items;
+	}
+
 	void set_pair_callback(PairCallback p_callback, void *p_userdata) {
 		BVH_LOCKED_FUNCTION
 		pair_callback = p_callback;
@@ -381,6 +390,44 @@ public:
 		return params.result_count_overall;
 	}
 
+	// Unlocked cull tests which collect the hits in the caller's list instead of the shared one,
+	// so several threads can cull at once as long as the tree is not modified meanwhile.
+	int cull_aabb_unlocked(const BOUNDS &p_aabb, LocalVector<uint32_t, uint32_t, true> &r_hits, T **p_result_array, int p_result_max, const T *p_tester, uint32_t p_tree_collision_mask = 0xFFFFFFFF, int *p_subindex_array = nullptr) {
+		typename BVHTREE_CLASS::CullParams params;
+
+		params.result_count_overall = 0;
+		params.result_max = p_result_max;
+		params.result_array = p_result_array;
+		params.subindex_array = p_subindex_array;
+		params.tree_collision_mask = p_tree_collision_mask;
+		params.abb.from(p_aabb);
+		params.tester = p_tester;
+		params.hits = &r_hits;
+
+		tree.cull_aabb(params);
+
+		return params.result_count_overall;
+	}
+
+	int cull_segment_unlocked(const POINT &p_from, const POINT &p_to, LocalVector<uint32_t, uint32_t, true> &r_hits, T **p_result_array, int p_result_max, const T *p_tester, uint32_t p_tree_collision_mask = 0xFFFFFFFF, int *p_subindex_array = nullptr) {
+		typename BVHTREE_CLASS::CullParams params;
+
+		params.result_count_overall = 0;
+		params.result_max = p_result_max;
+		params.result_array = p_result_array;
+		params.subindex_array = p_subindex_array;
+		params.tester = p_tester;
+		params.tree_collision_mask = p_tree_collision_mask;
+		params.hits = &r_hits;
+
+		params.segment.from = p_from;
+		params.segment.to = p_to;
+
+		tree.cull_segment(params);
+
+		return params.result_count_overall;
+	}
+
 	int cull_point(const POINT &p_point, T **p_result_array, int p_result_max, const T *p_tester, uint32_t p_tree_collision_mask = 0xFFFFFFFF, int *p_subindex_array = nullptr) {
 		BVH_LOCKED_FUNCTION
 		typename BVHTREE_CLASS::CullParams params;
@@ -435,6 +482,11 @@ private:
 			return;
 		}
 
+		if (_parallel_pairing_threshold && changed_items.size() >= _parallel_pairing_threshold && WorkerThreadPool::get_singleton()) {
+			_check_for_collisions_parallel(p_full_check);
+			return;
+		}
+
 		BOUNDS bb;
 
 		typename BVHTREE_CLASS::CullParams params;
@@ -484,6 +536,53 @@ private:
 		_reset();
 	}
 
+	// The tree is not modified while pairing, so the queries of all changed items can run at once.
+	void _cull_changed_item(uint32_t p_index, void *p_userdata) {
+		const BVHHandle &h = changed_items[p_index];
+
+		typename BVHTREE_CLASS::CullParams params;
+		params.result_count_overall = 0;
+		params.result_max = INT_MAX;
+		params.result_array = nullptr;
+		params.subindex_array = nullptr;
+		params.hits = &changed_item_hits[p_index];
+
+		tree.item_fill_cullparams(h, params);
+		params.abb.from(tree._pairs[h.id()].expanded_aabb);
+		tree.cull_aabb(params, false);
+	}
+
+	void _check_for_collisions_parallel(bool p_full_check) {
+		// Never shrunk, so the hit lists keep their memory between checks.
+		if (changed_item_hits.size() < changed_items.size()) {
+			changed_item_hits.resize(changed_items.size());
+		}
+
+		WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &BVH_Manager::_cull_changed_item, nullptr, changed_items.size(), -1, true, SNAME("BVHPairing"));
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+
+		// Leavers depend on the pairs made so far, so they and the callbacks stay in order.
+		for (unsigned int n = 0; n < changed_items.size(); n++) {
+			const BVHHandle &h = changed_items[n];
+
+			BVHABB_CLASS abb;
+			abb.from(tree._pairs[h.id()].expanded_aabb);
+			_find_leavers(h, abb, p_full_check);
+
+			const LocalVector<uint32_t, uint32_t, true> &hits = changed_item_hits[n];
+			for (unsigned int i = 0; i < hits.size(); i++) {
+				if (hits[i] == h.id()) {
+					continue;
+				}
+
+				BVHHandle h_collidee;
+				h_collidee.set_id(hits[i]);
+				_collide(h, h_collidee);
+			}
+		}
+		_reset();
+	}
+
 public:
 	void item_get_AABB(BVHHandle p_handle, BOUNDS &r_aabb) {
 		DEV_ASSERT(!p_handle.is_invalid());
@@ -777,6 +876,9 @@ private:
 	LocalVector<BVHHandle, uint32_t, true> changed_items;
 	uint32_t _tick = 1; // Start from 1 so items with 0 indicate never updated.
 
+	uint32_t _parallel_pairing_threshold = 0;
+	LocalVector<LocalVector<uint32_t, uint32_t, true>> changed_item_hits;
+
 	class BVHLockedFunction {
 	public:
 		BVHLockedFunction(Mutex *p_mutex, bool p_thread_safe) {
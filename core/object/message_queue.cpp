@@ -27,7 +27,6 @@
 /* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
-
 #include "message_queue.h"
 
 #include "core/config/project_settings.h"
@@ -37,65 +36,158 @@
 
 MessageQueue *MessageQueue::singleton = nullptr;
 
+uint64_t MessageQueue::last_id = 0;
+thread_local MessageQueue::ThreadBufferRef MessageQueue::thread_buffer;
+
+MessageQueue::ThreadBufferRef::~ThreadBufferRef() {
+	MessageQueue *queue = MessageQueue::singleton;
+	if (buffer && queue && queue->id == queue_id) {
+		MutexLock lock(queue->buffers_mutex);
+		buffer->thread_ended = true;
+	}
+	buffer = nullptr;
+	queue_id = 0;
+}
+
 MessageQueue *MessageQueue::get_singleton() {
 	return singleton;
 }
 
-Error MessageQueue::push_callp(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
-	return push_callablep(Callable(p_id, p_method), p_args, p_argcount, p_show_error);
+MessageQueue::ThreadBuffer *MessageQueue::_get_thread_buffer() {
+	ThreadBufferRef &ref = thread_buffer;
+	if (likely(ref.queue_id == id)) {
+		return ref.buffer;
+	}
+
+	// First message of this thread.
+	ThreadBuffer *buffer = memnew(ThreadBuffer);
+	buffers_mutex.lock();
+	buffers.push_back(buffer);
+	buffers_mutex.unlock();
+
+	ref.buffer = buffer;
+	ref.queue_id = id;
+	return buffer;
 }
 
-Error MessageQueue::push_set(ObjectID p_id, const StringName &p_prop, const Variant &p_value) {
-	_THREAD_SAFE_METHOD_
+MessageQueue::Page *MessageQueue::_alloc_page(uint32_t p_size) {
+	Page *page = nullptr;
+	if (p_size <= PAGE_SIZE) {
+		free_pages_lock.lock();
+		page = free_pages;
+		if (page) {
+			free_pages = page->next;
+			free_page_count--;
+		}
+		free_pages_lock.unlock();
+	}
+
+	if (!page) {
+		// Messages larger than a page get a page of their own.
+		const uint32_t size = MAX(p_size, (uint32_t)PAGE_SIZE);
+		page = memnew_placement(memalloc(sizeof(Page) + size), Page);
+		page->size = size;
+	}
+
+	page->next = nullptr;
+	page->used = 0;
+	return page;
+}
+
+void MessageQueue::_free_pages(Page *p_page) {
+	while (p_page) {
+		Page *next = p_page->next;
+		bool kept = false;
+		if (p_page->size == PAGE_SIZE) {
+			// Keep a few pages for the next messages, a burst of them shouldn't hold on to its memory.
+			free_pages_lock.lock();
+			if (free_page_count < MAX_FREE_PAGES) {
+				p_page->next = free_pages;
+				free_pages = p_page;
+				free_page_count++;
+				kept = true;
+			}
+			free_pages_lock.unlock();
+		}
+		if (!kept) {
+			memfree(p_page);
+		}
+		p_page = next;
+	}
+}
+
+MessageQueue::Message *MessageQueue::_alloc_message(ThreadBuffer *p_buffer, uint32_t p_size) {
+	Page *page = p_buffer->last;
+	if (!page || page->used + p_size > page->size) {
+		Page *new_page = _alloc_page(p_size);
+		if (page) {
+			page->next = new_page;
+		} else {
+			p_buffer->first = new_page;
+		}
+		p_buffer->last = new_page;
+		page = new_page;
+	}
 
-	uint8_t room_needed = sizeof(Message) + sizeof(Variant);
+	Message *msg = memnew_placement(page->get_data() + page->used, Message);
+	msg->order = next_order.postincrement();
+	page->used += p_size;
+	p_buffer->used += p_size;
+	return msg;
+}
 
-	if ((buffer_end + room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id)) {
-			type = ObjectDB::get_instance(p_id)->get_class();
+uint32_t MessageQueue::_get_message_size(const Message *p_message) {
+	uint32_t size = sizeof(Message);
+	if ((p_message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+		size += sizeof(Variant) * p_message->args;
+	}
+	return size;
+}
+
+void MessageQueue::_destroy_message(Message *p_message) {
+	if ((p_message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+		Variant *args = (Variant *)(p_message + 1);
+		for (int i = 0; i < p_message->args; i++) {
+			args[i].~Variant();
 		}
-		print_line("Failed set: " + type + ":" + p_prop + " target ID: " + itos(p_id));
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
 	}
+	p_message->~Message();
+}
+
+Error MessageQueue::push_callp(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
+	return push_callablep(Callable(p_id, p_method), p_args, p_argcount, p_show_error);
+}
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+Error MessageQueue::push_set(ObjectID p_id, const StringName &p_prop, const Variant &p_value) {
+	ThreadBuffer *buffer = _get_thread_buffer();
+	buffer->lock.lock();
+
+	Message *msg = _alloc_message(buffer, sizeof(Message) + sizeof(Variant));
 	msg->args = 1;
 	msg->callable = Callable(p_id, p_prop);
 	msg->type = TYPE_SET;
 
-	buffer_end += sizeof(Message);
-
-	Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-	buffer_end += sizeof(Variant);
+	Variant *v = memnew_placement(msg + 1, Variant);
 	*v = p_value;
 
+	buffer->lock.unlock();
 	return OK;
 }
 
 Error MessageQueue::push_notification(ObjectID p_id, int p_notification) {
-	_THREAD_SAFE_METHOD_
-
 	ERR_FAIL_COND_V(p_notification < 0, ERR_INVALID_PARAMETER);
 
-	uint8_t room_needed = sizeof(Message);
-
-	if ((buffer_end + room_needed) >= buffer_size) {
-		print_line("Failed notification: " + itos(p_notification) + " target ID: " + itos(p_id));
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
+	ThreadBuffer *buffer = _get_thread_buffer();
+	buffer->lock.lock();
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	Message *msg = _alloc_message(buffer, sizeof(Message));
 
 	msg->type = TYPE_NOTIFICATION;
 	msg->callable = Callable(p_id, CoreStringNames::get_singleton()->notification); //name is meaningless but callable needs it
 	//msg->target;
 	msg->notification = p_notification;
 
-	buffer_end += sizeof(Message);
-
+	buffer->lock.unlock();
 	return OK;
 }
 
@@ -112,17 +204,10 @@ Error MessageQueue::push_set(Object *p_object, const StringName &p_prop, const V
 }
 
 Error MessageQueue::push_callablep(const Callable &p_callable, const Variant **p_args, int p_argcount, bool p_show_error) {
-	_THREAD_SAFE_METHOD_
-
-	int room_needed = sizeof(Message) + sizeof(Variant) * p_argcount;
+	ThreadBuffer *buffer = _get_thread_buffer();
+	buffer->lock.lock();
 
-	if ((buffer_end + room_needed) >= buffer_size) {
-		print_line("Failed method: " + p_callable);
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
-
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	Message *msg = _alloc_message(buffer, sizeof(Message) + sizeof(Variant) * p_argcount);
 	msg->args = p_argcount;
 	msg->callable = p_callable;
 	msg->type = TYPE_CALL;
@@ -130,74 +215,80 @@ Error MessageQueue::push_callablep(const Callable &p_callable, const Variant **p
 		msg->type |= FLAG_SHOW_ERROR;
 	}
 
-	buffer_end += sizeof(Message);
-
+	Variant *args = (Variant *)(msg + 1);
 	for (int i = 0; i < p_argcount; i++) {
-		Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-		buffer_end += sizeof(Variant);
+		Variant *v = memnew_placement(&args[i], Variant);
 		*v = *p_args[i];
 	}
 
+	buffer->lock.unlock();
 	return OK;
 }
 
 void MessageQueue::statistics() {
+	struct ClassCount {
+		int calls = 0;
+		int notifications = 0;
+		int sets = 0;
+	};
+
+	HashMap<StringName, ClassCount> class_count;
 	HashMap<StringName, int> set_count;
 	HashMap<int, int> notify_count;
 	HashMap<Callable, int> call_count;
 	int null_count = 0;
-
-	uint32_t read_pos = 0;
-	while (read_pos < buffer_end) {
-		Message *message = (Message *)&buffer[read_pos];
-
-		Object *target = message->callable.get_object();
-
-		if (target != nullptr) {
-			switch (message->type & FLAG_MASK) {
-				case TYPE_CALL: {
-					if (!call_count.has(message->callable)) {
-						call_count[message->callable] = 0;
-					}
-
-					call_count[message->callable]++;
-
-				} break;
-				case TYPE_NOTIFICATION: {
-					if (!notify_count.has(message->notification)) {
-						notify_count[message->notification] = 0;
-					}
-
-					notify_count[message->notification]++;
-
-				} break;
-				case TYPE_SET: {
-					StringName t = message->callable.get_method();
-					if (!set_count.has(t)) {
-						set_count[t] = 0;
-					}
-
-					set_count[t]++;
-
-				} break;
+	uint32_t total_bytes = 0;
+
+	MutexLock lock(buffers_mutex);
+	for (uint32_t i = 0; i < buffers.size(); i++) {
+		ThreadBuffer *buffer = buffers[i];
+		buffer->lock.lock();
+		total_bytes += buffer->used;
+
+		for (Page *page = buffer->first; page; page = page->next) {
+			uint32_t read_pos = 0;
+			while (read_pos < page->used) {
+				Message *message = (Message *)&page->get_data()[read_pos];
+				read_pos += _get_message_size(message);
+
+				Object *target = message->callable.get_object();
+				if (target == nullptr) {
+					//object was deleted
+					print_line("Object was deleted while awaiting a callback");
+
+					null_count++;
+					continue;
+				}
+
+				ClassCount &counts = class_count[target->get_class_name()];
+				switch (message->type & FLAG_MASK) {
+					case TYPE_CALL: {
+						call_count[message->callable]++;
+						counts.calls++;
+					} break;
+					case TYPE_NOTIFICATION: {
+						notify_count[message->notification]++;
+						counts.notifications++;
+					} break;
+					case TYPE_SET: {
+						set_count[message->callable.get_method()]++;
+						counts.sets++;
+					} break;
+				}
 			}
-
-		} else {
-			//object was deleted
-			print_line("Object was deleted while awaiting a callback");
-
-			null_count++;
 		}
 
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			read_pos += sizeof(Variant) * message->args;
-		}
+		buffer->lock.unlock();
 	}
 
-	print_line("TOTAL BYTES: " + itos(buffer_end));
+	print_line("TOTAL BYTES: " + itos(total_bytes));
+	print_line("THREAD BUFFERS: " + itos(buffers.size()));
 	print_line("NULL count: " + itos(null_count));
 
+	for (const KeyValue<StringName, ClassCount> &E : class_count) {
+		print_line("CLASS " + E.key + ": " + itos(E.value.calls) + " calls, " + itos(E.value.notifications) + " notifications, " + itos(E.value.sets) + " sets");
+	}
+
 	for (const KeyValue<StringName, int> &E : set_count) {
 		print_line("SET " + E.key + ": " + itos(E.value));
 	}
@@ -233,113 +324,155 @@ void MessageQueue::_call_function(const Callable &p_callable, const Variant *p_a
 }
 
 void MessageQueue::flush() {
-	if (buffer_end > buffer_max_used) {
-		buffer_max_used = buffer_end;
-	}
-
-	uint32_t read_pos = 0;
-
-	//using reverse locking strategy
-	_THREAD_SAFE_LOCK_
-
-	if (flushing) {
-		_THREAD_SAFE_UNLOCK_
+	{
+		MutexLock lock(buffers_mutex);
 		ERR_FAIL_COND(flushing); //already flushing, you did something odd
+		flushing = true;
 	}
-	flushing = true;
-
-	while (read_pos < buffer_end) {
-		//lock on each iteration, so a call can re-add itself to the message queue
 
-		Message *message = (Message *)&buffer[read_pos];
+	while (true) {
+		// Take the messages queued by all the threads. Messages pushed while
+		// these are processed are taken by the next iteration.
+		// The buffers are all locked at once, and messages get their order with the buffer locked, so
+		// the messages taken were pushed before any of those left for the next iteration.
+		uint32_t used = 0;
+		flush_cursors.clear();
+		buffers_mutex.lock();
+		for (uint32_t i = 0; i < buffers.size(); i++) {
+			buffers[i]->lock.lock();
+		}
+		for (uint32_t i = 0; i < buffers.size(); i++) {
+			ThreadBuffer *buffer = buffers[i];
+			if (buffer->first) {
+				FlushCursor cursor;
+				cursor.page = buffer->first;
+				flush_cursors.push_back(cursor);
+				used += buffer->used;
+				buffer->first = nullptr;
+				buffer->last = nullptr;
+				buffer->used = 0;
+			}
+		}
+		for (uint32_t i = 0; i < buffers.size(); i++) {
+			buffers[i]->lock.unlock();
+		}
+		for (uint32_t i = 0; i < buffers.size();) {
+			if (buffers[i]->thread_ended) {
+				memdelete(buffers[i]);
+				buffers.remove_at_unordered(i);
+			} else {
+				i++;
+			}
+		}
+		buffers_mutex.unlock();
 
-		uint32_t advance = sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			advance += sizeof(Variant) * message->args;
+		if (flush_cursors.is_empty()) {
+			break;
 		}
 
-		//pre-advance so this function is reentrant
-		read_pos += advance;
+		if (used > buffer_max_used) {
+			buffer_max_used = used;
+		}
+		if (used > buffer_warning_size) {
+			WARN_PRINT_ONCE("The message queue holds more than 'memory/limits/message_queue/max_size_kb' of deferred calls. Something may be deferring calls in a loop.");
+		}
 
-		_THREAD_SAFE_UNLOCK_
+		while (true) {
+			// Merge the messages of all the threads in the order they were pushed.
+			FlushCursor *cursor = nullptr;
+			uint64_t order = UINT64_MAX;
+			for (uint32_t i = 0; i < flush_cursors.size(); i++) {
+				if (flush_cursors[i].page) {
+					const Message *message = (const Message *)&flush_cursors[i].page->get_data()[flush_cursors[i].offset];
+					if (message->order < order) {
+						order = message->order;
+						cursor = &flush_cursors[i];
+					}
+				}
+			}
+			if (!cursor) {
+				break;
+			}
 
-		Object *target = message->callable.get_object();
+			Message *message = (Message *)&cursor->page->get_data()[cursor->offset];
+			Object *target = message->callable.get_object();
 
-		if (target != nullptr) {
-			switch (message->type & FLAG_MASK) {
-				case TYPE_CALL: {
-					Variant *args = (Variant *)(message + 1);
+			if (target != nullptr) {
+				switch (message->type & FLAG_MASK) {
+					case TYPE_CALL: {
+						Variant *args = (Variant *)(message + 1);
 
-					// messages don't expect a return value
+						// messages don't expect a return value
 
-					_call_function(message->callable, args, message->args, message->type & FLAG_SHOW_ERROR);
+						_call_function(message->callable, args, message->args, message->type & FLAG_SHOW_ERROR);
 
-				} break;
-				case TYPE_NOTIFICATION: {
-					// messages don't expect a return value
-					target->notification(message->notification);
+					} break;
+					case TYPE_NOTIFICATION: {
+						// messages don't expect a return value
+						target->notification(message->notification);
 
-				} break;
-				case TYPE_SET: {
-					Variant *arg = (Variant *)(message + 1);
-					// messages don't expect a return value
-					target->set(message->callable.get_method(), *arg);
+					} break;
+					case TYPE_SET: {
+						Variant *arg = (Variant *)(message + 1);
+						// messages don't expect a return value
+						target->set(message->callable.get_method(), *arg);
 
-				} break;
+					} break;
+				}
 			}
-		}
 
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			Variant *args = (Variant *)(message + 1);
-			for (int i = 0; i < message->args; i++) {
-				args[i].~Variant();
+			cursor->offset += _get_message_size(message);
+			_destroy_message(message);
+
+			if (cursor->offset >= cursor->page->used) {
+				Page *page = cursor->page;
+				cursor->page = page->next;
+				cursor->offset = 0;
+				page->next = nullptr;
+				_free_pages(page);
 			}
 		}
-
-		message->~Message();
-
-		_THREAD_SAFE_LOCK_
 	}
 
-	buffer_end = 0; // reset buffer
+	MutexLock lock(buffers_mutex);
 	flushing = false;
-	_THREAD_SAFE_UNLOCK_
 }
 
 bool MessageQueue::is_flushing() const {
+	MutexLock lock(buffers_mutex);
 	return flushing;
 }
 
 MessageQueue::MessageQueue() {
 	ERR_FAIL_COND_MSG(singleton != nullptr, "A MessageQueue singleton already exists.");
 	singleton = this;
+	id = ++last_id;
 
-	buffer_size = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_kb", DEFAULT_QUEUE_SIZE_KB);
+	buffer_warning_size = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_kb", DEFAULT_QUEUE_SIZE_KB);
 	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/message_queue/max_size_kb", PropertyInfo(Variant::INT, "memory/limits/message_queue/max_size_kb", PROPERTY_HINT_RANGE, "1024,4096,1,or_greater"));
-	buffer_size *= 1024;
-	buffer = memnew_arr(uint8_t, buffer_size);
+	buffer_warning_size *= 1024;
 }
 
 MessageQueue::~MessageQueue() {
-	uint32_t read_pos = 0;
-
-	while (read_pos < buffer_end) {
-		Message *message = (Message *)&buffer[read_pos];
-		Variant *args = (Variant *)(message + 1);
-		int argc = message->args;
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			for (int i = 0; i < argc; i++) {
-				args[i].~Variant();
+	for (uint32_t i = 0; i < buffers.size(); i++) {
+		ThreadBuffer *buffer = buffers[i];
+		for (Page *page = buffer->first; page; page = page->next) {
+			uint32_t read_pos = 0;
+			while (read_pos < page->used) {
+				Message *message = (Message *)&page->get_data()[read_pos];
+				read_pos += _get_message_size(message);
+				_destroy_message(message);
 			}
 		}
-		message->~Message();
+		_free_pages(buffer->first);
+		memdelete(buffer);
+	}
 
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			read_pos += sizeof(Variant) * message->args;
-		}
+	while (free_pages) {
+		Page *next = free_pages->next;
+		memfree(free_pages);
+		free_pages = next;
 	}
 
 	singleton = nullptr;
-	memdelete_arr(buffer);
 }
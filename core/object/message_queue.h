@@ -32,16 +32,19 @@
 #define MESSAGE_QUEUE_H
 
 #include "core/object/object_id.h"
-#include "core/os/thread_safe.h"
+#include "core/os/mutex.h"
+#include "core/os/spin_lock.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
 #include "core/variant/variant.h"
 
 class Object;
 
 class MessageQueue {
-	_THREAD_SAFE_CLASS_
-
 	enum {
-		DEFAULT_QUEUE_SIZE_KB = 4096
+		DEFAULT_QUEUE_SIZE_KB = 4096,
+		PAGE_SIZE = 64 * 1024,
+		MAX_FREE_PAGES = 16,
 	};
 
 	enum {
@@ -55,6 +58,8 @@ class MessageQueue {
 
 	struct Message {
 		Callable callable;
+		// Order in which the messages of all the threads were pushed, followed when flushing.
+		uint64_t order = 0;
 		int16_t type;
 		union {
 			int16_t notification;
@@ -62,10 +67,63 @@ class MessageQueue {
 		};
 	};
 
-	uint8_t *buffer = nullptr;
-	uint32_t buffer_end = 0;
+	// Messages are stored in chains of pages, so the queue grows without moving them.
+	struct Page {
+		Page *next = nullptr;
+		uint32_t size = 0;
+		uint32_t used = 0;
+
+		_FORCE_INLINE_ uint8_t *get_data() { return reinterpret_cast<uint8_t *>(this + 1); }
+	};
+
+	// Each thread pushes to its own buffer, so threads don't wait for each other.
+	// The lock is only shared with flush() taking the pages of the buffer.
+	struct ThreadBuffer {
+		SpinLock lock;
+		Page *first = nullptr;
+		Page *last = nullptr;
+		uint32_t used = 0;
+		bool thread_ended = false; // Deleted by the next flush, once its messages are taken.
+	};
+
+	// Gives up the buffer of the thread when it ends.
+	struct ThreadBufferRef {
+		ThreadBuffer *buffer = nullptr;
+		uint64_t queue_id = 0; // In case the queue is recreated.
+
+		~ThreadBufferRef();
+	};
+
+	struct FlushCursor {
+		Page *page = nullptr;
+		uint32_t offset = 0;
+	};
+
+	// Also guards flushing.
+	Mutex buffers_mutex;
+	LocalVector<ThreadBuffer *> buffers;
+	SafeNumeric<uint64_t> next_order;
+
+	SpinLock free_pages_lock;
+	Page *free_pages = nullptr;
+	uint32_t free_page_count = 0;
+
+	/// Only used by the thread flushing, kept between flushes to reuse its memory.
+	LocalVector<FlushCursor> flush_cursors;
+
 	uint32_t buffer_max_used = 0;
-	uint32_t buffer_size = 0;
+	uint32_t buffer_warning_size = 0;
+
+	uint64_t id = 0;
+	static uint64_t last_id;
+	static thread_local ThreadBufferRef thread_buffer;
+
+	ThreadBuffer *_get_thread_buffer();
+	Page *_alloc_page(uint32_t p_size);
+	void _free_pages(Page *p_page);
+	Message *_alloc_message(ThreadBuffer *p_buffer, uint32_t p_size);
+	static uint32_t _get_message_size(const Message *p_message);
+	static void _destroy_message(Message *p_message);
 
 	void _call_function(const Callable &p_callable, const Variant *p_args, int p_argcount, bool p_show_error);
 
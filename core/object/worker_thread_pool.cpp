@@ -41,12 +41,43 @@ void WorkerThreadPool::Task::free_template_userdata() {
 
 WorkerThreadPool *WorkerThreadPool::singleton = nullptr;
 
+thread_local WorkerThreadPool::ThreadData *WorkerThreadPool::current_thread = nullptr;
+
+WorkerThreadPool::Task *WorkerThreadPool::_take_task() {
+	// The caller consumed a post of task_available_semaphore, so a task is guaranteed
+	// to be queued somewhere. Own queue first (most recent, likely hot in cache),
+	// then the shared queue, then steal the oldest task from another thread.
+	Task *task = nullptr;
+	if (current_thread && current_thread->local_queue.pop(task)) {
+		return task;
+	}
+
+	uint32_t thread_count = threads.size();
+	uint32_t first_victim = current_thread ? current_thread->index + 1 : 0;
+
+	while (true) {
+		task_mutex.lock();
+		if (task_queue.first()) {
+			task = task_queue.first()->self();
+			task_queue.remove(task_queue.first());
+		}
+		task_mutex.unlock();
+
+		if (task) {
+			return task;
+		}
+
+		for (uint32_t i = 0; i < thread_count; i++) {
+			ThreadData *victim = &threads[(first_victim + i) % thread_count];
+			if (victim != current_thread && victim->local_queue.steal(task)) {
+				return task;
+			}
+		}
+	}
+}
+
 void WorkerThreadPool::_process_task_queue() {
-	task_mutex.lock();
-	Task *task = task_queue.first()->self();
-	task_queue.remove(task_queue.first());
-	task_mutex.unlock();
-	_process_task(task);
+	_process_task(_take_task());
 }
 
 void WorkerThreadPool::_process_task(Task *p_task) {
@@ -54,31 +85,45 @@ void WorkerThreadPool::_process_task(Task *p_task) {
 
 	if (p_task->group) {
 		// Handling a group
-		bool do_post = false;
+		bool do_post = p_task->group->max == 0; // Empty groups only get a task when they have dependencies.
 		Callable::CallError ce;
 		Variant ret;
 		Variant arg;
 		Variant *argptr = &arg;
 
+		uint32_t max = p_task->group->max;
+		uint32_t chunk_divisor = MAX(p_task->group->tasks_used, 1u) * GROUP_CHUNK_SPLIT;
+
 		while (true) {
-			uint32_t work_index = p_task->group->index.postincrement();
+			// Claim elements in chunks proportional to what is left, so the shared index is touched
+			// rarely while there is plenty of work, and load still balances at the tail.
+			uint32_t claimed = p_task->group->index.get();
+			if (claimed >= max) {
+				break;
+			}
+			uint32_t chunk = CLAMP((max - claimed) / chunk_divisor, 1u, (uint32_t)GROUP_CHUNK_MAX);
+			uint32_t from = p_task->group->index.postadd(chunk);
 
-			if (work_index >= p_task->group->max) {
+			if (from >= max) {
 				break;
 			}
-			if (p_task->native_group_func) {
-				p_task->native_group_func(p_task->native_func_userdata, work_index);
-			} else if (p_task->template_userdata) {
-				p_task->template_userdata->callback_indexed(work_index);
-			} else {
-				arg = work_index;
-				p_task->callable.callp((const Variant **)&argptr, 1, ret, ce);
+			uint32_t to = MIN(from + chunk, max);
+
+			for (uint32_t work_index = from; work_index < to; work_index++) {
+				if (p_task->native_group_func) {
+					p_task->native_group_func(p_task->native_func_userdata, work_index);
+				} else if (p_task->template_userdata) {
+					p_task->template_userdata->callback_indexed(work_index);
+				} else {
+					arg = work_index;
+					p_task->callable.callp((const Variant **)&argptr, 1, ret, ce);
+				}
 			}
 
 			// This is the only way to ensure posting is done when all tasks are really complete.
-			uint32_t completed_amount = p_task->group->completed_index.increment();
+			uint32_t completed_amount = p_task->group->completed_index.add(to - from);
 
-			if (completed_amount == p_task->group->max) {
+			if (completed_amount == max) {
 				do_post = true;
 			}
 		}
@@ -88,15 +133,15 @@ void WorkerThreadPool::_process_task(Task *p_task) {
 		}
 
 		if (low_priority && use_native_low_priority_threads) {
-			p_task->completed = true;
-			p_task->done_semaphore.post();
 			if (do_post) {
-				p_task->group->completed.set_to(true);
+				_complete_group(p_task->group);
 			}
+			p_task->completed = true;
+			p_task->done_semaphore.post();
 		} else {
 			if (do_post) {
+				_complete_group(p_task->group);
 				p_task->group->done_semaphore.post();
-				p_task->group->completed.set_to(true);
 			}
 			uint32_t max_users = p_task->group->tasks_used + 1; // Add 1 because the thread waiting for it is also user. Read before to avoid another thread freeing task after increment.
 			uint32_t finished_users = p_task->group->finished.increment();
@@ -126,7 +171,11 @@ void WorkerThreadPool::_process_task(Task *p_task) {
 			p_task->callable.callp(nullptr, 0, ret, ce);
 		}
 
+		task_mutex.lock();
 		p_task->completed = true;
+		task_mutex.unlock();
+		// Nothing can be added to dependents once completed, so it's safe to go through them unlocked.
+		_release_dependents(p_task->dependents);
 		p_task->done_semaphore.post();
 	}
 
@@ -142,7 +191,7 @@ void WorkerThreadPool::_process_task(Task *p_task) {
 		} else {
 			low_priority_threads_used.decrement();
 		}
-		task_mutex.lock();
+		task_mutex.unlock();
 		if (post) {
 			task_available_semaphore.post();
 		}
@@ -150,6 +199,7 @@ void WorkerThreadPool::_process_task(Task *p_task) {
 }
 
 void WorkerThreadPool::_thread_function(void *p_user) {
+	current_thread = (ThreadData *)p_user;
 	while (true) {
 		singleton->task_available_semaphore.wait();
 		if (singleton->exit_threads.is_set()) {
@@ -165,8 +215,16 @@ void WorkerThreadPool::_native_low_priority_thread_function(void *p_user) {
 }
 
 void WorkerThreadPool::_post_task(Task *p_task, bool p_high_priority) {
-	task_mutex.lock();
 	p_task->low_priority = !p_high_priority;
+
+	if (p_high_priority && current_thread && current_thread->local_queue.push(p_task)) {
+		// Posted from within a task, keep it in this thread's queue so it is likely processed
+		// right here (LIFO) unless an idle thread steals it first.
+		task_available_semaphore.post();
+		return;
+	}
+
+	task_mutex.lock();
 	if (!p_high_priority && use_native_low_priority_threads) {
 		task_mutex.unlock();
 		p_task->low_priority_thread = native_thread_allocator.alloc();
@@ -186,11 +244,55 @@ void WorkerThreadPool::_post_task(Task *p_task, bool p_high_priority) {
 	}
 }
 
+uint32_t WorkerThreadPool::_add_dependencies(Task *p_task, const Vector<TaskID> &p_dependencies) {
+	// Must be called with task_mutex locked, returns how many dependencies are still pending.
+	uint32_t pending = 0;
+	for (int i = 0; i < p_dependencies.size(); i++) {
+		TaskID dependency = p_dependencies[i];
+		Task **taskp = tasks.getptr(dependency);
+		if (taskp) {
+			if (!(*taskp)->completed) {
+				(*taskp)->dependents.push_back(p_task);
+				pending++;
+			}
+			continue;
+		}
+		Group **groupp = groups.getptr(dependency);
+		if (groupp) {
+			if (!(*groupp)->completed.is_set()) {
+				(*groupp)->dependents.push_back(p_task);
+				pending++;
+			}
+			continue;
+		}
+		ERR_PRINT("Invalid Task or Group ID in dependencies: " + itos(dependency));
+	}
+	return pending;
+}
+
+void WorkerThreadPool::_release_dependents(TightLocalVector<Task *> &p_dependents) {
+	for (uint32_t i = 0; i < p_dependents.size(); i++) {
+		Task *dependent = p_dependents[i];
+		if (dependent->pending_dependencies.decrement() == 0) {
+			_post_task(dependent, !dependent->low_priority);
+		}
+	}
+	p_dependents.clear();
+}
+
+void WorkerThreadPool::_complete_group(Group *p_group) {
+	task_mutex.lock();
+	p_group->completed.set_to(true);
+	task_mutex.unlock();
+	// Nothing can be added to dependents once completed, so it's safe to go through them unlocked.
+	_release_dependents(p_group->dependents);
+}
+
 WorkerThreadPool::TaskID WorkerThreadPool::add_native_task(void (*p_func)(void *), void *p_userdata, bool p_high_priority, const String &p_description) {
-	return _add_task(Callable(), p_func, p_userdata, nullptr, p_high_priority, p_description);
+	return _add_task(Callable(), p_func, p_userdata, nullptr, p_high_priority, p_description, Vector<TaskID>());
 }
 
-WorkerThreadPool::TaskID WorkerThreadPool::_add_task(const Callable &p_callable, void (*p_func)(void *), void *p_userdata, BaseTemplateUserdata *p_template_userdata, bool p_high_priority, const String &p_description) {
+WorkerThreadPool::TaskID WorkerThreadPool::_add_task(const Callable &p_callable, void (*p_func)(void *), void *p_userdata, BaseTemplateUserdata *p_template_userdata, bool p_high_priority, const String &p_description, const Vector<TaskID> &p_dependencies) {
 	task_mutex.lock();
 	// Get a free task
 	Task *task = task_allocator.alloc();
@@ -200,16 +302,29 @@ WorkerThreadPool::TaskID WorkerThreadPool::_add_task(const Callable &p_callable,
 	task->native_func_userdata = p_userdata;
 	task->description = p_description;
 	task->template_userdata = p_template_userdata;
+	task->low_priority = !p_high_priority;
+	uint32_t pending = _add_dependencies(task, p_dependencies);
+	task->pending_dependencies.set(pending);
 	tasks.insert(id, task);
 	task_mutex.unlock();
 
-	_post_task(task, p_high_priority);
+	if (pending == 0) {
+		_post_task(task, p_high_priority);
+	}
 
 	return id;
 }
 
 WorkerThreadPool::TaskID WorkerThreadPool::add_task(const Callable &p_action, bool p_high_priority, const String &p_description) {
-	return _add_task(p_action, nullptr, nullptr, nullptr, p_high_priority, p_description);
+	return _add_task(p_action, nullptr, nullptr, nullptr, p_high_priority, p_description, Vector<TaskID>());
+}
+
+WorkerThreadPool::TaskID WorkerThreadPool::add_dependent_native_task(void (*p_func)(void *), void *p_userdata, const Vector<TaskID> &p_dependencies, bool p_high_priority, const String &p_description) {
+	return _add_task(Callable(), p_func, p_userdata, nullptr, p_high_priority, p_description, p_dependencies);
+}
+
+WorkerThreadPool::TaskID WorkerThreadPool::add_dependent_task(const Callable &p_action, const Vector<TaskID> &p_dependencies, bool p_high_priority, const String &p_description) {
+	return _add_task(p_action, nullptr, nullptr, nullptr, p_high_priority, p_description, p_dependencies);
 }
 
 bool WorkerThreadPool::is_task_completed(TaskID p_task_id) const {
@@ -250,28 +365,12 @@ void WorkerThreadPool::wait_for_task_completion(TaskID p_task_id) {
 	task_mutex.unlock();
 
 	if (use_native_low_priority_threads && task->low_priority) {
+		// The thread may not even be started yet if the task has pending dependencies.
+		task->done_semaphore.wait();
 		task->low_priority_thread->wait_to_finish();
 		native_thread_allocator.free(task->low_priority_thread);
 	} else {
-		int *index = thread_ids.getptr(Thread::get_caller_id());
-
-		if (index) {
-			// We are an actual process thread, we must not be blocked so continue processing stuff if available.
-			while (true) {
-				if (task->done_semaphore.try_wait()) {
-					// If done, exit
-					break;
-				}
-				if (task_available_semaphore.try_wait()) {
-					// Solve tasks while they are around.
-					_process_task_queue();
-					continue;
-				}
-				OS::get_singleton()->delay_usec(1); // Microsleep, this could be converted to waiting for multiple objects in supported platforms for a bit more performance.
-			}
-		} else {
-			task->done_semaphore.wait();
-		}
+		_wait_processing_tasks(task->done_semaphore);
 	}
 
 	task_mutex.lock();
@@ -280,11 +379,34 @@ void WorkerThreadPool::wait_for_task_completion(TaskID p_task_id) {
 	task_mutex.unlock();
 }
 
-WorkerThreadPool::GroupID WorkerThreadPool::_add_group_task(const Callable &p_callable, void (*p_func)(void *, uint32_t), void *p_userdata, BaseTemplateUserdata *p_template_userdata, int p_elements, int p_tasks, bool p_high_priority, const String &p_description) {
+void WorkerThreadPool::_wait_processing_tasks(Semaphore &p_done_semaphore) {
+	if (!current_thread) {
+		p_done_semaphore.wait();
+		return;
+	}
+
+	// We are an actual process thread, we must not be blocked so continue processing stuff if available.
+	while (true) {
+		if (p_done_semaphore.try_wait()) {
+			// If done, exit
+			break;
+		}
+		if (task_available_semaphore.try_wait()) {
+			// Solve tasks while they are around.
+			_process_task_queue();
+			continue;
+		}
+		OS::get_singleton()->delay_usec(1); // Microsleep, this could be converted to waiting for multiple objects in supported platforms for a bit more performance.
+	}
+}
+
+WorkerThreadPool::GroupID WorkerThreadPool::_add_group_task(const Callable &p_callable, void (*p_func)(void *, uint32_t), void *p_userdata, BaseTemplateUserdata *p_template_userdata, int p_elements, int p_tasks, bool p_high_priority, const String &p_description, const Vector<TaskID> &p_dependencies) {
 	ERR_FAIL_COND_V(p_elements < 0, INVALID_TASK_ID);
 	if (p_tasks < 0) {
 		p_tasks = threads.size();
 	}
+	// No point in having more tasks than elements, they would just exit right away.
+	p_tasks = CLAMP(p_tasks, 1, MAX(p_elements, 1));
 
 	task_mutex.lock();
 	Group *group = group_allocator.alloc();
@@ -293,7 +415,8 @@ WorkerThreadPool::GroupID WorkerThreadPool::_add_group_task(const Callable &p_ca
 	group->self = id;
 
 	Task **tasks_posted = nullptr;
-	if (p_elements == 0) {
+	uint32_t pending = 0;
+	if (p_elements == 0 && p_dependencies.is_empty()) {
 		// Should really not call it with zero Elements, but at least it should work.
 		group->completed.set_to(true);
 		group->done_semaphore.post();
@@ -314,22 +437,28 @@ WorkerThreadPool::GroupID WorkerThreadPool::_add_group_task(const Callable &p_ca
 			task->group = group;
 			task->callable = p_callable;
 			task->template_userdata = p_template_userdata;
+			task->low_priority = !p_high_priority;
+			// All tasks share the same dependencies, so they are all pending the same amount.
+			pending = _add_dependencies(task, p_dependencies);
+			task->pending_dependencies.set(pending);
 			tasks_posted[i] = task;
 			// No task ID is used.
 		}
 	}
 
-	groups[id] = group;
-	task_mutex.unlock();
-
 	if (!p_high_priority && use_native_low_priority_threads) {
 		group->low_priority_native_tasks.resize(p_tasks);
+		for (int i = 0; i < p_tasks; i++) {
+			group->low_priority_native_tasks[i] = tasks_posted[i];
+		}
 	}
 
-	for (int i = 0; i < p_tasks; i++) {
-		_post_task(tasks_posted[i], p_high_priority);
-		if (!p_high_priority && use_native_low_priority_threads) {
-			group->low_priority_native_tasks[i] = tasks_posted[i];
+	groups[id] = group;
+	task_mutex.unlock();
+
+	if (pending == 0) {
+		for (int i = 0; i < p_tasks; i++) {
+			_post_task(tasks_posted[i], p_high_priority);
 		}
 	}
 
@@ -337,11 +466,19 @@ WorkerThreadPool::GroupID WorkerThreadPool::_add_group_task(const Callable &p_ca
 }
 
 WorkerThreadPool::GroupID WorkerThreadPool::add_native_group_task(void (*p_func)(void *, uint32_t), void *p_userdata, int p_elements, int p_tasks, bool p_high_priority, const String &p_description) {
-	return _add_group_task(Callable(), p_func, p_userdata, nullptr, p_elements, p_tasks, p_high_priority, p_description);
+	return _add_group_task(Callable(), p_func, p_userdata, nullptr, p_elements, p_tasks, p_high_priority, p_description, Vector<TaskID>());
 }
 
 WorkerThreadPool::GroupID WorkerThreadPool::add_group_task(const Callable &p_action, int p_elements, int p_tasks, bool p_high_priority, const String &p_description) {
-	return _add_group_task(p_action, nullptr, nullptr, nullptr, p_elements, p_tasks, p_high_priority, p_description);
+	return _add_group_task(p_action, nullptr, nullptr, nullptr, p_elements, p_tasks, p_high_priority, p_description, Vector<TaskID>());
+}
+
+WorkerThreadPool::GroupID WorkerThreadPool::add_dependent_native_group_task(void (*p_func)(void *, uint32_t), void *p_userdata, int p_elements, const Vector<TaskID> &p_dependencies, int p_tasks, bool p_high_priority, const String &p_description) {
+	return _add_group_task(Callable(), p_func, p_userdata, nullptr, p_elements, p_tasks, p_high_priority, p_description, p_dependencies);
+}
+
+WorkerThreadPool::GroupID WorkerThreadPool::add_dependent_group_task(const Callable &p_action, int p_elements, const Vector<TaskID> &p_dependencies, int p_tasks, bool p_high_priority, const String &p_description) {
+	return _add_group_task(p_action, nullptr, nullptr, nullptr, p_elements, p_tasks, p_high_priority, p_description, p_dependencies);
 }
 
 uint32_t WorkerThreadPool::get_group_processed_element_count(GroupID p_group) const {
@@ -370,14 +507,17 @@ bool WorkerThreadPool::is_group_task_completed(GroupID p_group) const {
 void WorkerThreadPool::wait_for_group_task_completion(GroupID p_group) {
 	task_mutex.lock();
 	Group **groupp = groups.getptr(p_group);
-	task_mutex.unlock();
 	if (!groupp) {
+		task_mutex.unlock();
 		ERR_FAIL_MSG("Invalid Group ID");
 	}
 	Group *group = *groupp;
+	task_mutex.unlock();
 
 	if (group->low_priority_native_tasks.size() > 0) {
 		for (uint32_t i = 0; i < group->low_priority_native_tasks.size(); i++) {
+			// The thread may not even be started yet if the group has pending dependencies.
+			group->low_priority_native_tasks[i]->done_semaphore.wait();
 			group->low_priority_native_tasks[i]->low_priority_thread->wait_to_finish();
 			native_thread_allocator.free(group->low_priority_native_tasks[i]->low_priority_thread);
 			task_mutex.lock();
@@ -386,10 +526,16 @@ void WorkerThreadPool::wait_for_group_task_completion(GroupID p_group) {
 		}
 
 		task_mutex.lock();
+		groups.erase(p_group);
 		group_allocator.free(group);
 		task_mutex.unlock();
 	} else {
-		group->done_semaphore.wait();
+		_wait_processing_tasks(group->done_semaphore);
+
+		// Must be erased before releasing our use of the group, as other threads look it up when adding dependencies.
+		task_mutex.lock();
+		groups.erase(p_group);
+		task_mutex.unlock();
 
 		uint32_t max_users = group->tasks_used + 1; // Add 1 because the thread waiting for it is also user. Read before to avoid another thread freeing task after increment.
 		uint32_t finished_users = group->finished.increment(); // fetch happens before inc, so increment later.
@@ -401,8 +547,6 @@ void WorkerThreadPool::wait_for_group_task_completion(GroupID p_group) {
 			task_mutex.unlock();
 		}
 	}
-
-	groups.erase(p_group); // Threads do not access this, so safe to erase here.
 }
 
 void WorkerThreadPool::init(int p_thread_count, bool p_use_native_threads_low_priority, float p_low_priority_task_ratio) {
@@ -423,8 +567,11 @@ void WorkerThreadPool::init(int p_thread_count, bool p_use_native_threads_low_pr
 
 	for (uint32_t i = 0; i < threads.size(); i++) {
 		threads[i].index = i;
+		threads[i].local_queue.init(LOCAL_QUEUE_SIZE);
+	}
+
+	for (uint32_t i = 0; i < threads.size(); i++) {
 		threads[i].thread.start(&WorkerThreadPool::_thread_function, &threads[i]);
-		thread_ids.insert(threads[i].thread.get_id(), i);
 	}
 }
 
@@ -458,11 +605,13 @@ void WorkerThreadPool::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("add_task", "action", "high_priority", "description"), &WorkerThreadPool::add_task, DEFVAL(false), DEFVAL(String()));
 	ClassDB::bind_method(D_METHOD("is_task_completed", "task_id"), &WorkerThreadPool::is_task_completed);
 	ClassDB::bind_method(D_METHOD("wait_for_task_completion", "task_id"), &WorkerThreadPool::wait_for_task_completion);
+	ClassDB::bind_method(D_METHOD("add_dependent_task", "action", "dependencies", "high_priority", "description"), &WorkerThreadPool::add_dependent_task, DEFVAL(false), DEFVAL(String()));
 
 	ClassDB::bind_method(D_METHOD("add_group_task", "action", "elements", "tasks_needed", "high_priority", "description"), &WorkerThreadPool::add_group_task, DEFVAL(-1), DEFVAL(false), DEFVAL(String()));
 	ClassDB::bind_method(D_METHOD("is_group_task_completed", "group_id"), &WorkerThreadPool::is_group_task_completed);
 	ClassDB::bind_method(D_METHOD("get_group_processed_element_count", "group_id"), &WorkerThreadPool::get_group_processed_element_count);
 	ClassDB::bind_method(D_METHOD("wait_for_group_task_completion", "group_id"), &WorkerThreadPool::wait_for_group_task_completion);
+	ClassDB::bind_method(D_METHOD("add_dependent_group_task", "action", "elements", "dependencies", "tasks_needed", "high_priority", "description"), &WorkerThreadPool::add_dependent_group_task, DEFVAL(-1), DEFVAL(false), DEFVAL(String()));
 }
 
 WorkerThreadPool::WorkerThreadPool() {
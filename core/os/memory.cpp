@@ -31,10 +31,12 @@
 #include "memory.h"
 
 #include "core/error/error_macros.h"
+#include "core/os/spin_lock.h"
 #include "core/templates/safe_refcount.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void *operator new(size_t p_size, const char *p_description) {
 	return Memory::alloc_static(p_size, false);
@@ -65,6 +67,195 @@ SafeNumeric<uint64_t> Memory::max_usage;
 
 SafeNumeric<uint64_t> Memory::alloc_count;
 
+// Padded allocations of up to MEMORY_POOL_MAX_SIZE bytes are taken from size classes, which keep
+// the freed blocks for reuse instead of giving them back to malloc. The size stored before a padded
+// allocation is flagged when its block belongs to a pool.
+// Each thread keeps some free blocks of each class to allocate and free them without locking, the
+// rest is shared by all the threads. A thread gives its blocks to the others when it ends.
+// The pools take slabs from malloc until they reserve MEMORY_POOL_MAX_RESERVED bytes and keep them
+// for the lifetime of the program, so that is what they can hold on to after a peak of allocations.
+
+#define POOL_FLAG (uint64_t(1) << 63)
+
+static constexpr uint32_t _get_pool_class(size_t p_bytes) {
+	if (p_bytes <= 32) {
+		return p_bytes <= 16 ? 0 : 1;
+	}
+	// Two classes for each power of 2 from 32 bytes on, the 1.5 times and 2 times multiples.
+	uint32_t shift = 5;
+	while ((size_t(1) << (shift + 1)) < p_bytes) {
+		shift++;
+	}
+	return 2 + (shift - 5) * 2 + (p_bytes > (size_t(3) << (shift - 1)) ? 1 : 0);
+}
+
+static constexpr size_t _get_pool_class_size(uint32_t p_class) {
+	if (p_class < 2) {
+		return size_t(16) << p_class;
+	}
+	const uint32_t shift = 5 + (p_class - 2) / 2;
+	return (p_class & 1) ? (size_t(1) << (shift + 1)) : (size_t(3) << (shift - 1));
+}
+
+static constexpr bool _is_pooled(size_t p_bytes) {
+	return MEMORY_POOL_MAX_SIZE > 0 && p_bytes <= MEMORY_POOL_MAX_SIZE;
+}
+
+enum {
+	POOL_CLASS_COUNT = _get_pool_class(MEMORY_POOL_MAX_SIZE) + 1,
+	POOL_SLAB_SIZE = 16 * 1024,
+	POOL_THREAD_CACHE_SIZE = 32 * 1024,
+};
+
+struct PoolBlock {
+	PoolBlock *next;
+};
+
+// Trivially destructible, so it can still be used while the thread or the program exits.
+struct ThreadPools {
+	PoolBlock *blocks[POOL_CLASS_COUNT];
+	uint32_t count[POOL_CLASS_COUNT];
+	bool released; // The thread is ending, blocks freed from now on go straight to the other threads.
+};
+
+// Releases the blocks of the thread when it ends. Only the thread locals which are used get destroyed,
+// so it is used whenever the thread starts caching blocks of a class.
+struct ThreadPoolsReleaser {
+	bool used = false;
+
+	~ThreadPoolsReleaser() {
+		Memory::release_thread_pools();
+	}
+};
+
+struct SharedPool {
+	SpinLock lock;
+	PoolBlock *blocks = nullptr;
+};
+
+static thread_local ThreadPools thread_pools;
+static thread_local ThreadPoolsReleaser thread_pools_releaser;
+static SharedPool shared_pools[POOL_CLASS_COUNT];
+static SafeNumeric<uint64_t> pool_usage;
+
+static void _pool_share(uint32_t p_class, PoolBlock *p_first) {
+	PoolBlock *last = p_first;
+	while (last->next) {
+		last = last->next;
+	}
+
+	SharedPool &shared = shared_pools[p_class];
+	shared.lock.lock();
+	last->next = shared.blocks;
+	shared.blocks = p_first;
+	shared.lock.unlock();
+}
+
+static _FORCE_INLINE_ uint32_t _get_pool_thread_max_count(uint32_t p_class) {
+	return CLAMP(POOL_THREAD_CACHE_SIZE / _get_pool_class_size(p_class), 8u, 256u);
+}
+
+static uint8_t *_pool_alloc(uint32_t p_class) {
+	ThreadPools &pools = thread_pools;
+	PoolBlock *block = pools.blocks[p_class];
+	if (unlikely(!block)) {
+		// Take half a cache of blocks from the other threads.
+		const uint32_t max_count = _get_pool_thread_max_count(p_class) / 2;
+		SharedPool &shared = shared_pools[p_class];
+		shared.lock.lock();
+		block = shared.blocks;
+		PoolBlock *last = block;
+		uint32_t count = block ? 1 : 0;
+		while (count < max_count && last && last->next) {
+			last = last->next;
+			count++;
+		}
+		if (last) {
+			shared.blocks = last->next;
+			last->next = nullptr;
+		}
+		shared.lock.unlock();
+
+		if (!block) {
+			// Split a new slab in blocks, unless the pools are full.
+			const size_t block_size = PAD_ALIGN + _get_pool_class_size(p_class);
+			const uint32_t slab_count = MAX(POOL_SLAB_SIZE / block_size, size_t(1));
+			if (pool_usage.add(block_size * slab_count) > MEMORY_POOL_MAX_RESERVED) {
+				pool_usage.sub(block_size * slab_count);
+				return nullptr;
+			}
+			uint8_t *slab = (uint8_t *)malloc(block_size * slab_count);
+			if (!slab) {
+				pool_usage.sub(block_size * slab_count);
+				return nullptr;
+			}
+
+			for (uint32_t i = 0; i < slab_count; i++) {
+				PoolBlock *slab_block = (PoolBlock *)(slab + block_size * i);
+				slab_block->next = i + 1 < slab_count ? (PoolBlock *)(slab + block_size * (i + 1)) : nullptr;
+			}
+			block = (PoolBlock *)slab;
+			count = slab_count;
+		}
+
+		if (unlikely(pools.released)) {
+			if (block->next) {
+				_pool_share(p_class, block->next);
+			}
+			return (uint8_t *)block;
+		}
+
+		pools.count[p_class] = count;
+		thread_pools_releaser.used = true;
+	}
+
+	pools.blocks[p_class] = block->next;
+	pools.count[p_class]--;
+	return (uint8_t *)block;
+}
+
+static void _pool_free(uint8_t *p_block, uint32_t p_class) {
+	ThreadPools &pools = thread_pools;
+	PoolBlock *block = (PoolBlock *)p_block;
+	if (unlikely(pools.released)) {
+		block->next = nullptr;
+		_pool_share(p_class, block);
+		return;
+	}
+
+	block->next = pools.blocks[p_class];
+	pools.blocks[p_class] = block;
+	pools.count[p_class]++;
+	if (unlikely(!block->next)) {
+		thread_pools_releaser.used = true;
+	}
+
+	const uint32_t max_count = _get_pool_thread_max_count(p_class);
+	if (unlikely(pools.count[p_class] > max_count)) {
+		// Give the older half of the cache to the other threads.
+		PoolBlock *last = block;
+		for (uint32_t i = 1; i < max_count / 2; i++) {
+			last = last->next;
+		}
+		PoolBlock *released = last->next;
+		last->next = nullptr;
+		pools.count[p_class] = max_count / 2;
+		_pool_share(p_class, released);
+	}
+}
+
+void Memory::release_thread_pools() {
+	ThreadPools &pools = thread_pools;
+	pools.released = true;
+	for (uint32_t i = 0; i < POOL_CLASS_COUNT; i++) {
+		if (pools.blocks[i]) {
+			_pool_share(i, pools.blocks[i]);
+		}
+		pools.blocks[i] = nullptr;
+		pools.count[i] = 0;
+	}
+}
+
 void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 #ifdef DEBUG_ENABLED
 	bool prepad = true;
@@ -72,7 +263,17 @@ void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 	bool prepad = p_pad_align;
 #endif
 
-	void *mem = malloc(p_bytes + (prepad ? PAD_ALIGN : 0));
+	void *mem = nullptr;
+	uint64_t header = p_bytes;
+	if (prepad && _is_pooled(p_bytes)) {
+		mem = _pool_alloc(_get_pool_class(p_bytes));
+		if (mem) {
+			header |= POOL_FLAG;
+		}
+	}
+	if (!mem) {
+		mem = malloc(p_bytes + (prepad ? PAD_ALIGN : 0));
+	}
 
 	ERR_FAIL_COND_V(!mem, nullptr);
 
@@ -80,7 +281,7 @@ void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 
 	if (prepad) {
 		uint64_t *s = (uint64_t *)mem;
-		*s = p_bytes;
+		*s = header;
 
 		uint8_t *s8 = (uint8_t *)mem;
 
@@ -110,17 +311,55 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 	if (prepad) {
 		mem -= PAD_ALIGN;
 		uint64_t *s = (uint64_t *)mem;
+		const uint64_t old_bytes = *s & ~POOL_FLAG;
 
 #ifdef DEBUG_ENABLED
-		if (p_bytes > *s) {
-			uint64_t new_mem_usage = mem_usage.add(p_bytes - *s);
+		if (p_bytes > old_bytes) {
+			uint64_t new_mem_usage = mem_usage.add(p_bytes - old_bytes);
 			max_usage.exchange_if_greater(new_mem_usage);
 		} else {
-			mem_usage.sub(*s - p_bytes);
+			mem_usage.sub(old_bytes - p_bytes);
 		}
 #endif
 
+		if (*s & POOL_FLAG) {
+			const uint32_t old_class = _get_pool_class(old_bytes);
+			if (p_bytes == 0) {
+				alloc_count.decrement();
+				_pool_free(mem, old_class);
+				return nullptr;
+			}
+			if (_is_pooled(p_bytes) && _get_pool_class(p_bytes) == old_class) {
+				// Still fits in the same block.
+				*s = p_bytes | POOL_FLAG;
+				return mem + PAD_ALIGN;
+			}
+
+			// Move to a block of another class, or out of the pools. The padding is copied too, as
+			// CowData keeps its header there.
+			uint8_t *new_mem = nullptr;
+			uint64_t header = p_bytes;
+			if (_is_pooled(p_bytes)) {
+				new_mem = _pool_alloc(_get_pool_class(p_bytes));
+				if (new_mem) {
+					header |= POOL_FLAG;
+				}
+			}
+			if (!new_mem) {
+				new_mem = (uint8_t *)malloc(p_bytes + PAD_ALIGN);
+			}
+			ERR_FAIL_COND_V(!new_mem, nullptr);
+
+			memcpy(new_mem, mem, PAD_ALIGN + MIN(old_bytes, (uint64_t)p_bytes));
+			_pool_free(mem, old_class);
+
+			s = (uint64_t *)new_mem;
+			*s = header;
+			return new_mem + PAD_ALIGN;
+		}
+
 		if (p_bytes == 0) {
+			alloc_count.decrement();
 			free(mem);
 			return nullptr;
 		} else {
@@ -136,6 +375,12 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 			return mem + PAD_ALIGN;
 		}
 	} else {
+		if (p_bytes == 0) {
+			alloc_count.decrement();
+			free(mem);
+			return nullptr;
+		}
+
 		mem = (uint8_t *)realloc(mem, p_bytes);
 
 		ERR_FAIL_COND_V(mem == nullptr && p_bytes > 0, nullptr);
@@ -160,12 +405,16 @@ void Memory::free_static(void *p_ptr, bool p_pad_align) {
 	if (prepad) {
 		mem -= PAD_ALIGN;
 
-#ifdef DEBUG_ENABLED
 		uint64_t *s = (uint64_t *)mem;
-		mem_usage.sub(*s);
+#ifdef DEBUG_ENABLED
+		mem_usage.sub(*s & ~POOL_FLAG);
 #endif
 
-		free(mem);
+		if (*s & POOL_FLAG) {
+			_pool_free(mem, _get_pool_class(*s & ~POOL_FLAG));
+		} else {
+			free(mem);
+		}
 	} else {
 		free(mem);
 	}
@@ -191,6 +440,14 @@ uint64_t Memory::get_mem_max_usage() {
 #endif
 }
 
+uint64_t Memory::get_alloc_count() {
+	return alloc_count.get();
+}
+
+uint64_t Memory::get_mem_pooled() {
+	return pool_usage.get();
+}
+
 _GlobalNil::_GlobalNil() {
 	left = this;
 	right = this;
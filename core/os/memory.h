@@ -42,6 +42,25 @@
 #define PAD_ALIGN 16 //must always be greater than this at much
 #endif
 
+// Sanitizers have to see every allocation and free, which the reuse of pooled blocks hides.
+#if !defined(MEMORY_POOL_MAX_SIZE) && (defined(SANITIZERS_ENABLED) || defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__))
+#define MEMORY_POOL_MAX_SIZE 0
+#endif
+#if !defined(MEMORY_POOL_MAX_SIZE) && defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) || __has_feature(thread_sanitizer)
+#define MEMORY_POOL_MAX_SIZE 0
+#endif
+#endif
+
+#ifndef MEMORY_POOL_MAX_SIZE
+#define MEMORY_POOL_MAX_SIZE 1024 // Largest padded allocation served by the memory pools, 0 disables them.
+#endif
+
+#ifndef MEMORY_POOL_MAX_RESERVED
+// Memory the pools may take from the system, allocations go to malloc past it. It is never given back.
+#define MEMORY_POOL_MAX_RESERVED (64 * 1024 * 1024)
+#endif
+
 class Memory {
 #ifdef DEBUG_ENABLED
 	static SafeNumeric<uint64_t> mem_usage;
@@ -58,6 +77,11 @@ public:
 	static uint64_t get_mem_available();
 	static uint64_t get_mem_usage();
 	static uint64_t get_mem_max_usage();
+	static uint64_t get_alloc_count();
+	static uint64_t get_mem_pooled();
+
+	// Gives the free blocks kept by the calling thread back to the other threads, done when the thread ends.
+	static void release_thread_pools();
 };
 
 class DefaultAllocator {
@@ -46,7 +46,7 @@ StringName _scs_create(const char *p_chr, bool p_static) {
 }
 
 bool StringName::configured = false;
-Mutex StringName::mutex;
+StringName::_TableLock StringName::_table_locks[STRING_TABLE_LOCK_LEN];
 
 #ifdef DEBUG_ENABLED
 bool StringName::debug_stringname = false;
@@ -61,8 +61,7 @@ void StringName::setup() {
 }
 
 void StringName::cleanup() {
-	MutexLock lock(mutex);
-
+	// Only called on exit, when no other threads can be creating StringNames anymore.
 #ifdef DEBUG_ENABLED
 	if (unlikely(debug_stringname)) {
 		Vector<_Data *> data;
@@ -94,6 +93,7 @@ void StringName::cleanup() {
 #endif
 	int lost_strings = 0;
 	for (int i = 0; i < STRING_TABLE_LEN; i++) {
+		MutexLock lock(_get_table_mutex(i));
 		while (_table[i]) {
 			_Data *d = _table[i];
 			if (d->static_count.get() != d->refcount.get()) {
@@ -118,11 +118,78 @@ void StringName::cleanup() {
 	configured = false;
 }
 
+bool StringName::_name_equals(const _Data *p_data, const char *p_name) {
+	// Avoid building a String out of cname just to compare it.
+	return p_data->cname ? strcmp(p_data->cname, p_name) == 0 : p_data->name == p_name;
+}
+
+bool StringName::_name_equals(const _Data *p_data, const char32_t *p_name) {
+	return p_data->cname ? String(p_data->cname) == p_name : p_data->name == p_name;
+}
+
+bool StringName::_name_equals(const _Data *p_data, const String &p_name) {
+	return p_data->cname ? p_name == p_data->cname : p_data->name == p_name;
+}
+
+template <class T>
+StringName::_Data *StringName::_find(const T &p_name, uint32_t p_hash, uint32_t p_idx) {
+	// Must be called with the table mutex for p_idx locked.
+	_Data *data = _table[p_idx];
+
+	while (data) {
+		// compare hash first
+		if (data->hash == p_hash && _name_equals(data, p_name)) {
+			break;
+		}
+		data = data->next;
+	}
+
+	return data;
+}
+
+bool StringName::_ref_existing(_Data *p_data, bool p_static) {
+	// Fails if the data is being freed by another thread (reached zero references, but is not unlinked yet).
+	if (!p_data->refcount.ref()) {
+		return false;
+	}
+	if (p_static) {
+		p_data->static_count.increment();
+	}
+#ifdef DEBUG_ENABLED
+	if (unlikely(debug_stringname)) {
+		p_data->debug_references++;
+	}
+#endif
+	return true;
+}
+
+void StringName::_insert(_Data *p_data, uint32_t p_hash, uint32_t p_idx, bool p_static) {
+	// Must be called with the table mutex for p_idx locked.
+	p_data->refcount.init();
+	p_data->static_count.set(p_static ? 1 : 0);
+	p_data->hash = p_hash;
+	p_data->idx = p_idx;
+	p_data->next = _table[p_idx];
+	p_data->prev = nullptr;
+#ifdef DEBUG_ENABLED
+	if (unlikely(debug_stringname)) {
+		// Keep in memory, force static.
+		p_data->refcount.ref();
+		p_data->static_count.increment();
+	}
+#endif
+
+	if (_table[p_idx]) {
+		_table[p_idx]->prev = p_data;
+	}
+	_table[p_idx] = p_data;
+}
+
 void StringName::unref() {
 	ERR_FAIL_COND(!configured);
 
 	if (_data && _data->refcount.unref()) {
-		MutexLock lock(mutex);
+		MutexLock lock(_get_table_mutex(_data->idx));
 
 		if (_data->static_count.get() > 0) {
 			if (_data->cname) {
@@ -154,7 +221,7 @@ bool StringName::operator==(const String &p_name) const {
 		return (p_name.length() == 0);
 	}
 
-	return (_data->get_name() == p_name);
+	return _name_equals(_data, p_name);
 }
 
 bool StringName::operator==(const char *p_name) const {
@@ -162,7 +229,7 @@ bool StringName::operator==(const char *p_name) const {
 		return (p_name[0] == 0);
 	}
 
-	return (_data->get_name() == p_name);
+	return _name_equals(_data, p_name);
 }
 
 bool StringName::operator!=(const String &p_name) const {
@@ -206,59 +273,21 @@ StringName::StringName(const char *p_name, bool p_static) {
 		return; //empty, ignore
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_name);
-
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
-	_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
+	MutexLock lock(_get_table_mutex(idx));
 
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			if (p_static) {
-				_data->static_count.increment();
-			}
-#ifdef DEBUG_ENABLED
-			if (unlikely(debug_stringname)) {
-				_data->debug_references++;
-			}
-#endif
-		}
+	_data = _find(p_name, hash, idx);
 
+	if (_data && _ref_existing(_data, p_static)) {
 		return;
 	}
 
 	_data = memnew(_Data);
 	_data->name = p_name;
-	_data->refcount.init();
-	_data->static_count.set(p_static ? 1 : 0);
-	_data->hash = hash;
-	_data->idx = idx;
 	_data->cname = nullptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-
-#ifdef DEBUG_ENABLED
-	if (unlikely(debug_stringname)) {
-		// Keep in memory, force static.
-		_data->refcount.ref();
-		_data->static_count.increment();
-	}
-#endif
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
-	}
-	_table[idx] = _data;
+	_insert(_data, hash, idx, p_static);
 }
 
 StringName::StringName(const StaticCString &p_static_string, bool p_static) {
@@ -268,57 +297,20 @@ StringName::StringName(const StaticCString &p_static_string, bool p_static) {
 
 	ERR_FAIL_COND(!p_static_string.ptr || !p_static_string.ptr[0]);
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_static_string.ptr);
-
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
-	_data = _table[idx];
+	MutexLock lock(_get_table_mutex(idx));
 
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_static_string.ptr) {
-			break;
-		}
-		_data = _data->next;
-	}
+	_data = _find(p_static_string.ptr, hash, idx);
 
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			if (p_static) {
-				_data->static_count.increment();
-			}
-#ifdef DEBUG_ENABLED
-			if (unlikely(debug_stringname)) {
-				_data->debug_references++;
-			}
-#endif
-			return;
-		}
+	if (_data && _ref_existing(_data, p_static)) {
+		return;
 	}
 
 	_data = memnew(_Data);
-
-	_data->refcount.init();
-	_data->static_count.set(p_static ? 1 : 0);
-	_data->hash = hash;
-	_data->idx = idx;
 	_data->cname = p_static_string.ptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-#ifdef DEBUG_ENABLED
-	if (unlikely(debug_stringname)) {
-		// Keep in memory, force static.
-		_data->refcount.ref();
-		_data->static_count.increment();
-	}
-#endif
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
-	}
-	_table[idx] = _data;
+	_insert(_data, hash, idx, p_static);
 }
 
 StringName::StringName(const String &p_name, bool p_static) {
@@ -330,56 +322,21 @@ StringName::StringName(const String &p_name, bool p_static) {
 		return;
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = p_name.hash();
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
-	_data = _table[idx];
+	MutexLock lock(_get_table_mutex(idx));
 
-	while (_data) {
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
+	_data = _find(p_name, hash, idx);
 
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			if (p_static) {
-				_data->static_count.increment();
-			}
-#ifdef DEBUG_ENABLED
-			if (unlikely(debug_stringname)) {
-				_data->debug_references++;
-			}
-#endif
-			return;
-		}
+	if (_data && _ref_existing(_data, p_static)) {
+		return;
 	}
 
 	_data = memnew(_Data);
 	_data->name = p_name;
-	_data->refcount.init();
-	_data->static_count.set(p_static ? 1 : 0);
-	_data->hash = hash;
-	_data->idx = idx;
 	_data->cname = nullptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-#ifdef DEBUG_ENABLED
-	if (unlikely(debug_stringname)) {
-		// Keep in memory, force static.
-		_data->refcount.ref();
-		_data->static_count.increment();
-	}
-#endif
-
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
-	}
-	_table[idx] = _data;
+	_insert(_data, hash, idx, p_static);
 }
 
 StringName StringName::search(const char *p_name) {
@@ -390,28 +347,14 @@ StringName StringName::search(const char *p_name) {
 		return StringName();
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_name);
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
-	_Data *_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
+	MutexLock lock(_get_table_mutex(idx));
 
-	if (_data && _data->refcount.ref()) {
-#ifdef DEBUG_ENABLED
-		if (unlikely(debug_stringname)) {
-			_data->debug_references++;
-		}
-#endif
+	_Data *_data = _find(p_name, hash, idx);
 
+	if (_data && _ref_existing(_data, false)) {
 		return StringName(_data);
 	}
 
@@ -426,21 +369,12 @@ StringName StringName::search(const char32_t *p_name) {
 		return StringName();
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_name);
-
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
-	_Data *_data = _table[idx];
+	MutexLock lock(_get_table_mutex(idx));
 
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
+	_Data *_data = _find(p_name, hash, idx);
 
 	if (_data && _data->refcount.ref()) {
 		return StringName(_data);
@@ -452,28 +386,14 @@ StringName StringName::search(const char32_t *p_name) {
 StringName StringName::search(const String &p_name) {
 	ERR_FAIL_COND_V(p_name.is_empty(), StringName());
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = p_name.hash();
-
 	uint32_t idx = hash & STRING_TABLE_MASK;
 
-	_Data *_data = _table[idx];
+	MutexLock lock(_get_table_mutex(idx));
 
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && p_name == _data->get_name()) {
-			break;
-		}
-		_data = _data->next;
-	}
+	_Data *_data = _find(p_name, hash, idx);
 
-	if (_data && _data->refcount.ref()) {
-#ifdef DEBUG_ENABLED
-		if (unlikely(debug_stringname)) {
-			_data->debug_references++;
-		}
-#endif
+	if (_data && _ref_existing(_data, false)) {
 		return StringName(_data);
 	}
 
@@ -48,7 +48,11 @@ class StringName {
 	enum {
 		STRING_TABLE_BITS = 16,
 		STRING_TABLE_LEN = 1 << STRING_TABLE_BITS,
-		STRING_TABLE_MASK = STRING_TABLE_LEN - 1
+		STRING_TABLE_MASK = STRING_TABLE_LEN - 1,
+		// Buckets are spread over several locks, so threads interning unrelated names rarely contend.
+		STRING_TABLE_LOCK_BITS = 6,
+		STRING_TABLE_LOCK_LEN = 1 << STRING_TABLE_LOCK_BITS,
+		STRING_TABLE_LOCK_MASK = STRING_TABLE_LOCK_LEN - 1
 	};
 
 	struct _Data {
@@ -76,11 +80,28 @@ class StringName {
 		uint32_t hash;
 	};
 
+	struct alignas(64) _TableLock {
+		Mutex mutex;
+	};
+
+	static _TableLock _table_locks[STRING_TABLE_LOCK_LEN];
+
+	_FORCE_INLINE_ static Mutex &_get_table_mutex(uint32_t p_idx) {
+		return _table_locks[p_idx & STRING_TABLE_LOCK_MASK].mutex;
+	}
+
+	static bool _name_equals(const _Data *p_data, const char *p_name);
+	static bool _name_equals(const _Data *p_data, const char32_t *p_name);
+	static bool _name_equals(const _Data *p_data, const String &p_name);
+	template <class T>
+	static _Data *_find(const T &p_name, uint32_t p_hash, uint32_t p_idx);
+	static bool _ref_existing(_Data *p_data, bool p_static);
+	static void _insert(_Data *p_data, uint32_t p_hash, uint32_t p_idx, bool p_static);
+
 	void unref();
 	friend void register_core_types();
 	friend void unregister_core_types();
 	friend class Main;
-	static Mutex mutex;
 	static void setup();
 	static void cleanup();
 	static bool configured;
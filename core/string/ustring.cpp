@@ -1369,28 +1369,44 @@ char32_t String::char_lowercase(char32_t p_char) {
 }
 
 String String::to_upper() const {
-	String upper = *this;
+	const char32_t *src = get_data();
+	const int len = length();
 
-	for (int i = 0; i < upper.size(); i++) {
-		const char32_t s = upper[i];
-		const char32_t t = _find_upper(s);
-		if (s != t) { // avoid copy on write
-			upper[i] = t;
-		}
+	// Share the data until a character changes, to avoid copy on write.
+	int i = 0;
+	while (i < len && (char32_t)_find_upper(src[i]) == src[i]) {
+		i++;
+	}
+	if (i == len) {
+		return *this;
+	}
+
+	String upper = *this;
+	char32_t *dst = upper.ptrw();
+	for (; i < len; i++) {
+		dst[i] = _find_upper(dst[i]);
 	}
 
 	return upper;
 }
 
 String String::to_lower() const {
-	String lower = *this;
+	const char32_t *src = get_data();
+	const int len = length();
 
-	for (int i = 0; i < lower.size(); i++) {
-		const char32_t s = lower[i];
-		const char32_t t = _find_lower(s);
-		if (s != t) { // avoid copy on write
-			lower[i] = t;
-		}
+	// Share the data until a character changes, to avoid copy on write.
+	int i = 0;
+	while (i < len && (char32_t)_find_lower(src[i]) == src[i]) {
+		i++;
+	}
+	if (i == len) {
+		return *this;
+	}
+
+	String lower = *this;
+	char32_t *dst = lower.ptrw();
+	for (; i < len; i++) {
+		dst[i] = _find_lower(dst[i]);
 	}
 
 	return lower;
@@ -2830,18 +2846,16 @@ int String::find(const String &p_str, int p_from) const {
 
 	const char32_t *src = get_data();
 	const char32_t *str = p_str.get_data();
+	const char32_t first = str[0];
 
 	for (int i = p_from; i <= (len - src_len); i++) {
-		bool found = true;
-		for (int j = 0; j < src_len; j++) {
-			int read_pos = i + j;
-
-			if (read_pos >= len) {
-				ERR_PRINT("read_pos>=len");
-				return -1;
-			}
+		if (src[i] != first) {
+			continue;
+		}
 
-			if (src[read_pos] != str[j]) {
+		bool found = true;
+		for (int j = 1; j < src_len; j++) {
+			if (src[i + j] != str[j]) {
 				found = false;
 				break;
 			}
@@ -3386,21 +3400,40 @@ String String::format(const Variant &values, String placeholder) const {
 }
 
 String String::replace(const String &p_key, const String &p_with) const {
-	String new_string;
-	int search_from = 0;
-	int result = 0;
+	const int key_length = p_key.length();
+	const int with_length = p_with.length();
 
-	while ((result = find(p_key, search_from)) >= 0) {
-		new_string += substr(search_from, result - search_from);
-		new_string += p_with;
-		search_from = result + p_key.length();
+	int count = 0;
+	for (int result = find(p_key); result >= 0; result = find(p_key, result + key_length)) {
+		count++;
 	}
 
-	if (search_from == 0) {
+	if (count == 0) {
 		return *this;
 	}
 
-	new_string += substr(search_from, length() - search_from);
+	const int new_length = length() + count * (with_length - key_length);
+	if (new_length == 0) {
+		return String();
+	}
+
+	// Allocate once instead of concatenating each part.
+	String new_string;
+	new_string.resize(new_length + 1);
+	char32_t *dst = new_string.ptrw();
+	const char32_t *src = get_data();
+	const char32_t *with = p_with.get_data();
+
+	int search_from = 0;
+	for (int result = find(p_key); result >= 0; result = find(p_key, result + key_length)) {
+		memcpy(dst, src + search_from, (result - search_from) * sizeof(char32_t));
+		dst += result - search_from;
+		memcpy(dst, with, with_length * sizeof(char32_t));
+		dst += with_length;
+		search_from = result + key_length;
+	}
+	memcpy(dst, src + search_from, (length() - search_from) * sizeof(char32_t));
+	dst[length() - search_from] = 0;
 
 	return new_string;
 }
@@ -30,7 +30,6 @@
 
 #include "dictionary.h"
 
-#include "core/templates/hash_map.h"
 #include "core/templates/safe_refcount.h"
 #include "core/variant/variant.h"
 // required in this order by VariantInternal, do not remove this comment.
@@ -39,10 +38,369 @@
 #include "core/variant/type_info.h"
 #include "core/variant/variant_internal.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Storage of the dictionaries, a compact ordered hash map. The entries are appended in insertion
+// order to blocks that never move, and an open addressing index maps the hashes to them. Iterating
+// walks the blocks linearly. The index and the first block of a small dictionary share a single
+// allocation.
+// The keys and values handed out stay valid while the dictionary grows and when other keys are
+// erased. Once most entries are erased, the next insertion compacts the rest to the front, which
+// moves them.
+class VariantOrderedMap {
+public:
+	struct Entry {
+		Variant key;
+		Variant value;
+		uint32_t hash = 0;
+		bool erased = false;
+	};
+
+private:
+	enum {
+		FIRST_BLOCK_SIZE_SHIFT = 3,
+		FIRST_BLOCK_SIZE = 1 << FIRST_BLOCK_SIZE_SHIFT,
+		FIRST_INDEX_SIZE = FIRST_BLOCK_SIZE * 2,
+		MIN_ERASED_TO_COMPACT = 8,
+		// Enough blocks for every position a uint32_t can hold.
+		MAX_BLOCKS = 32 - FIRST_BLOCK_SIZE_SHIFT,
+	};
+
+	// Slots point to their entry, erased entries keep their slot until the index is rebuilt.
+	Entry **index = nullptr;
+	uint32_t index_size = 0;
+	uint32_t index_used = 0;
+
+	// Holds the first index and the first block, block i holds FIRST_BLOCK_SIZE << i entries.
+	uint8_t *first_alloc = nullptr;
+	Entry *blocks[MAX_BLOCKS] = {};
+	uint32_t block_count = 0;
+	uint32_t capacity = 0;
+
+	// Entries appended, including the erased ones.
+	uint32_t used = 0;
+	uint32_t erased = 0;
+
+	_FORCE_INLINE_ static uint32_t _get_block_size(uint32_t p_block) {
+		return FIRST_BLOCK_SIZE << p_block;
+	}
+
+	_FORCE_INLINE_ Entry **_get_first_index() const {
+		return (Entry **)first_alloc;
+	}
+
+	_FORCE_INLINE_ static uint32_t _get_highest_bit(uint32_t p_value) {
+#if defined(__GNUC__)
+		return 31 - __builtin_clz(p_value);
+#elif defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, p_value);
+		return index;
+#else
+		uint32_t bit = 0;
+		while (p_value >>= 1) {
+			bit++;
+		}
+		return bit;
+#endif
+	}
+
+	_FORCE_INLINE_ Entry *_get_entry(uint32_t p_pos) const {
+		// Block i starts at position FIRST_BLOCK_SIZE * (2^i - 1).
+		const uint32_t block = _get_highest_bit((p_pos >> FIRST_BLOCK_SIZE_SHIFT) + 1);
+		return &blocks[block][p_pos - (_get_block_size(block) - FIRST_BLOCK_SIZE)];
+	}
+
+	Entry *_lookup(const Variant &p_key, uint32_t p_hash) const {
+		if (unlikely(!index)) {
+			return nullptr;
+		}
+
+		const uint32_t mask = index_size - 1;
+		for (uint32_t i = p_hash & mask;; i = (i + 1) & mask) {
+			Entry *entry = index[i];
+			if (!entry) {
+				return nullptr;
+			}
+			if (!entry->erased && entry->hash == p_hash && VariantComparator::compare(entry->key, p_key)) {
+				return entry;
+			}
+		}
+	}
+
+	_FORCE_INLINE_ void _insert_in_index(Entry *p_entry) {
+		const uint32_t mask = index_size - 1;
+		uint32_t i = p_entry->hash & mask;
+		while (index[i]) {
+			i = (i + 1) & mask;
+		}
+		index[i] = p_entry;
+		index_used++;
+	}
+
+	void _rebuild_index(uint32_t p_size) {
+		if (p_size != index_size) {
+			if (index != _get_first_index()) {
+				memfree(index);
+			}
+			index = p_size == FIRST_INDEX_SIZE ? _get_first_index() : (Entry **)memalloc(sizeof(Entry *) * p_size);
+			index_size = p_size;
+		}
+		memset(index, 0, sizeof(Entry *) * index_size);
+		index_used = 0;
+
+		uint32_t block = 0;
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < used; i++) {
+			Entry *entry = &blocks[block][offset];
+			if (!entry->erased) {
+				_insert_in_index(entry);
+			}
+			if (++offset == _get_block_size(block)) {
+				block++;
+				offset = 0;
+			}
+		}
+	}
+
+	Entry *_append(const Variant &p_key, uint32_t p_hash) {
+		if (unlikely(!first_alloc)) {
+			first_alloc = (uint8_t *)memalloc(sizeof(Entry *) * FIRST_INDEX_SIZE + sizeof(Entry) * FIRST_BLOCK_SIZE);
+			blocks[0] = (Entry *)(first_alloc + sizeof(Entry *) * FIRST_INDEX_SIZE);
+			block_count = 1;
+			capacity = FIRST_BLOCK_SIZE;
+			index = _get_first_index();
+			index_size = FIRST_INDEX_SIZE;
+			memset(index, 0, sizeof(Entry *) * index_size);
+		} else if (erased >= MIN_ERASED_TO_COMPACT && erased > used - erased) {
+			// Mostly erased entries, which slow down the iterations. Done here rather than in erase(),
+			// so erasing never moves the other entries.
+			_compact();
+		}
+		if (used == capacity) {
+			CRASH_COND_MSG(block_count == MAX_BLOCKS, "Dictionary is full.");
+			const uint32_t block_size = _get_block_size(block_count);
+			blocks[block_count++] = (Entry *)memalloc(sizeof(Entry) * block_size);
+			capacity += block_size;
+		}
+
+		// Keep the index at most half full, counting the slots of erased entries.
+		if ((index_used + 1) * 2 > index_size) {
+			const uint32_t live = used - erased;
+			_rebuild_index((live + 1) * 2 > index_size / 2 ? index_size * 2 : index_size);
+		}
+
+		Entry *entry = memnew_placement(_get_entry(used), Entry);
+		entry->key = p_key;
+		entry->hash = p_hash;
+		used++;
+		_insert_in_index(entry);
+		return entry;
+	}
+
+	void _compact() {
+		// Move the entries left over to the front, keeping their order.
+		uint32_t read_block = 0;
+		uint32_t read_offset = 0;
+		uint32_t write_block = 0;
+		uint32_t write_offset = 0;
+		for (uint32_t i = 0; i < used; i++) {
+			Entry *read = &blocks[read_block][read_offset];
+			if (!read->erased) {
+				Entry *write = &blocks[write_block][write_offset];
+				if (write != read) {
+					write->key = read->key;
+					write->value = read->value;
+					write->hash = read->hash;
+					write->erased = false;
+				}
+				if (++write_offset == _get_block_size(write_block)) {
+					write_block++;
+					write_offset = 0;
+				}
+			}
+			if (++read_offset == _get_block_size(read_block)) {
+				read_block++;
+				read_offset = 0;
+			}
+		}
+
+		const uint32_t live = used - erased;
+		for (uint32_t i = live; i < used; i++) {
+			_get_entry(i)->~Entry();
+		}
+		used = live;
+		erased = 0;
+		_rebuild_index(index_size);
+	}
+
+public:
+	struct ConstIterator {
+		const VariantOrderedMap *map = nullptr;
+		uint32_t pos = 0;
+		uint32_t block = 0;
+		uint32_t offset = 0;
+
+		_FORCE_INLINE_ const Entry &operator*() const { return map->blocks[block][offset]; }
+		_FORCE_INLINE_ const Entry *operator->() const { return &map->blocks[block][offset]; }
+
+		void skip_erased() {
+			while (pos < map->used && map->blocks[block][offset].erased) {
+				advance();
+			}
+		}
+		_FORCE_INLINE_ void advance() {
+			pos++;
+			if (++offset == _get_block_size(block)) {
+				block++;
+				offset = 0;
+			}
+		}
+		_FORCE_INLINE_ ConstIterator &operator++() {
+			advance();
+			skip_erased();
+			return *this;
+		}
+
+		_FORCE_INLINE_ bool operator==(const ConstIterator &p_it) const { return pos == p_it.pos; }
+		_FORCE_INLINE_ bool operator!=(const ConstIterator &p_it) const { return pos != p_it.pos; }
+	};
+
+	ConstIterator begin() const {
+		ConstIterator it;
+		it.map = this;
+		it.skip_erased();
+		return it;
+	}
+
+	ConstIterator end() const {
+		ConstIterator it;
+		it.map = this;
+		it.pos = used;
+		return it;
+	}
+
+	_FORCE_INLINE_ uint32_t size() const { return used - erased; }
+	_FORCE_INLINE_ bool is_empty() const { return used == erased; }
+
+	_FORCE_INLINE_ Entry *find(const Variant &p_key) const {
+		return _lookup(p_key, VariantHasher::hash(p_key));
+	}
+
+	_FORCE_INLINE_ bool has(const Variant &p_key) const {
+		return find(p_key) != nullptr;
+	}
+
+	Variant &operator[](const Variant &p_key) {
+		const uint32_t hash = VariantHasher::hash(p_key);
+		Entry *entry = _lookup(p_key, hash);
+		if (!entry) {
+			entry = _append(p_key, hash);
+		}
+		return entry->value;
+	}
+
+	bool erase(const Variant &p_key) {
+		Entry *entry = find(p_key);
+		if (!entry) {
+			return false;
+		}
+
+		entry->erased = true;
+		erased++;
+		entry->key = Variant();
+		entry->value = Variant();
+
+		if (erased == used) {
+			clear();
+		}
+		return true;
+	}
+
+	// Returns the entry at the given position in insertion order.
+	const Entry *get_at_index(uint32_t p_index) const {
+		if (p_index >= size()) {
+			return nullptr;
+		}
+		if (erased == 0) {
+			return _get_entry(p_index);
+		}
+
+		ConstIterator it = begin();
+		for (uint32_t i = 0; i < p_index; i++) {
+			++it;
+		}
+		return &*it;
+	}
+
+	// Returns the entry after the given one in insertion order.
+	const Entry *get_next(const Entry *p_entry) const {
+		ConstIterator it;
+		it.map = this;
+		for (uint32_t block = 0; block < block_count; block++) {
+			const uint32_t block_size = _get_block_size(block);
+			if (p_entry >= blocks[block] && p_entry < blocks[block] + block_size) {
+				it.block = block;
+				it.offset = p_entry - blocks[block];
+				break;
+			}
+			it.pos += block_size;
+		}
+		it.pos += it.offset;
+		ERR_FAIL_COND_V(it.pos >= used, nullptr);
+
+		++it;
+		return it.pos < used ? &*it : nullptr;
+	}
+
+	void clear() {
+		uint32_t block = 0;
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < used; i++) {
+			blocks[block][offset].~Entry();
+			if (++offset == _get_block_size(block)) {
+				block++;
+				offset = 0;
+			}
+		}
+		used = 0;
+		erased = 0;
+		if (index) {
+			memset(index, 0, sizeof(Entry *) * index_size);
+			index_used = 0;
+		}
+	}
+
+	void operator=(const VariantOrderedMap &p_from) {
+		clear();
+		for (const Entry &E : p_from) {
+			_append(E.key, E.hash)->value = E.value;
+		}
+	}
+
+	VariantOrderedMap() {}
+	VariantOrderedMap(const VariantOrderedMap &p_from) = delete;
+
+	~VariantOrderedMap() {
+		clear();
+		if (index != _get_first_index()) {
+			memfree(index);
+		}
+		for (uint32_t i = 1; i < block_count; i++) {
+			memfree(blocks[i]);
+		}
+		if (first_alloc) {
+			memfree(first_alloc);
+		}
+	}
+};
+
 struct DictionaryPrivate {
 	SafeRefCount refcount;
 	Variant *read_only = nullptr; // If enabled, a pointer is used to a temporary value that is used to return read-only values.
-	HashMap<Variant, Variant, VariantHasher, VariantComparator> variant_map;
+	VariantOrderedMap variant_map;
 };
 
 void Dictionary::get_key_list(List<Variant> *p_keys) const {
@@ -50,33 +408,25 @@ void Dictionary::get_key_list(List<Variant> *p_keys) const {
 		return;
 	}
 
-	for (const KeyValue<Variant, Variant> &E : _p->variant_map) {
+	for (const VariantOrderedMap::Entry &E : _p->variant_map) {
 		p_keys->push_back(E.key);
 	}
 }
 
 Variant Dictionary::get_key_at_index(int p_index) const {
-	int index = 0;
-	for (const KeyValue<Variant, Variant> &E : _p->variant_map) {
-		if (index == p_index) {
-			return E.key;
-		}
-		index++;
+	const VariantOrderedMap::Entry *E = _p->variant_map.get_at_index(p_index);
+	if (!E) {
+		return Variant();
 	}
-
-	return Variant();
+	return E->key;
 }
 
 Variant Dictionary::get_value_at_index(int p_index) const {
-	int index = 0;
-	for (const KeyValue<Variant, Variant> &E : _p->variant_map) {
-		if (index == p_index) {
-			return E.value;
-		}
-		index++;
+	const VariantOrderedMap::Entry *E = _p->variant_map.get_at_index(p_index);
+	if (!E) {
+		return Variant();
 	}
-
-	return Variant();
+	return E->value;
 }
 
 Variant &Dictionary::operator[](const Variant &p_key) {
@@ -109,13 +459,13 @@ const Variant &Dictionary::operator[](const Variant &p_key) const {
 }
 
 const Variant *Dictionary::getptr(const Variant &p_key) const {
-	HashMap<Variant, Variant, VariantHasher, VariantComparator>::ConstIterator E;
+	const VariantOrderedMap::Entry *E;
 
 	if (p_key.get_type() == Variant::STRING_NAME) {
 		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		E = ((const HashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(sn->operator String());
+		E = _p->variant_map.find(sn->operator String());
 	} else {
-		E = ((const HashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(p_key);
+		E = _p->variant_map.find(p_key);
 	}
 
 	if (!E) {
@@ -125,13 +475,13 @@ const Variant *Dictionary::getptr(const Variant &p_key) const {
 }
 
 Variant *Dictionary::getptr(const Variant &p_key) {
-	HashMap<Variant, Variant, VariantHasher, VariantComparator>::Iterator E;
+	VariantOrderedMap::Entry *E;
 
 	if (p_key.get_type() == Variant::STRING_NAME) {
 		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		E = ((HashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(sn->operator String());
+		E = _p->variant_map.find(sn->operator String());
 	} else {
-		E = ((HashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(p_key);
+		E = _p->variant_map.find(p_key);
 	}
 	if (!E) {
 		return nullptr;
@@ -145,13 +495,13 @@ Variant *Dictionary::getptr(const Variant &p_key) {
 }
 
 Variant Dictionary::get_valid(const Variant &p_key) const {
-	HashMap<Variant, Variant, VariantHasher, VariantComparator>::ConstIterator E;
+	const VariantOrderedMap::Entry *E;
 
 	if (p_key.get_type() == Variant::STRING_NAME) {
 		const StringName *sn = VariantInternal::get_string_name(&p_key);
-		E = ((const HashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(sn->operator String());
+		E = _p->variant_map.find(sn->operator String());
 	} else {
-		E = ((const HashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(p_key);
+		E = _p->variant_map.find(p_key);
 	}
 
 	if (!E) {
@@ -196,7 +546,7 @@ bool Dictionary::has_all(const Array &p_keys) const {
 }
 
 Variant Dictionary::find_key(const Variant &p_value) const {
-	for (const KeyValue<Variant, Variant> &E : _p->variant_map) {
+	for (const VariantOrderedMap::Entry &E : _p->variant_map) {
 		if (E.value == p_value) {
 			return E.key;
 		}
@@ -237,8 +587,8 @@ bool Dictionary::recursive_equal(const Dictionary &p_dictionary, int recursion_c
 		return true;
 	}
 	recursion_count++;
-	for (const KeyValue<Variant, Variant> &this_E : _p->variant_map) {
-		HashMap<Variant, Variant, VariantHasher, VariantComparator>::ConstIterator other_E = ((const HashMap<Variant, Variant, VariantHasher, VariantComparator> *)&p_dictionary._p->variant_map)->find(this_E.key);
+	for (const VariantOrderedMap::Entry &this_E : _p->variant_map) {
+		const VariantOrderedMap::Entry *other_E = p_dictionary._p->variant_map.find(this_E.key);
 		if (!other_E || !this_E.value.hash_compare(other_E->value, recursion_count)) {
 			return false;
 		}
@@ -279,7 +629,7 @@ void Dictionary::clear() {
 }
 
 void Dictionary::merge(const Dictionary &p_dictionary, bool p_overwrite) {
-	for (const KeyValue<Variant, Variant> &E : p_dictionary._p->variant_map) {
+	for (const VariantOrderedMap::Entry &E : p_dictionary._p->variant_map) {
 		if (p_overwrite || !has(E.key)) {
 			this->operator[](E.key) = E.value;
 		}
@@ -310,7 +660,7 @@ uint32_t Dictionary::recursive_hash(int recursion_count) const {
 	uint32_t h = hash_murmur3_one_32(Variant::DICTIONARY);
 
 	recursion_count++;
-	for (const KeyValue<Variant, Variant> &E : _p->variant_map) {
+	for (const VariantOrderedMap::Entry &E : _p->variant_map) {
 		h = hash_murmur3_one_32(E.key.recursive_hash(recursion_count), h);
 		h = hash_murmur3_one_32(E.value.recursive_hash(recursion_count), h);
 	}
@@ -327,7 +677,7 @@ Array Dictionary::keys() const {
 	varr.resize(size());
 
 	int i = 0;
-	for (const KeyValue<Variant, Variant> &E : _p->variant_map) {
+	for (const VariantOrderedMap::Entry &E : _p->variant_map) {
 		varr[i] = E.key;
 		i++;
 	}
@@ -344,7 +694,7 @@ Array Dictionary::values() const {
 	varr.resize(size());
 
 	int i = 0;
-	for (const KeyValue<Variant, Variant> &E : _p->variant_map) {
+	for (const VariantOrderedMap::Entry &E : _p->variant_map) {
 		varr[i] = E.value;
 		i++;
 	}
@@ -355,18 +705,18 @@ Array Dictionary::values() const {
 const Variant *Dictionary::next(const Variant *p_key) const {
 	if (p_key == nullptr) {
 		// caller wants to get the first element
-		if (_p->variant_map.begin()) {
+		if (!_p->variant_map.is_empty()) {
 			return &_p->variant_map.begin()->key;
 		}
 		return nullptr;
 	}
-	HashMap<Variant, Variant, VariantHasher, VariantComparator>::Iterator E = _p->variant_map.find(*p_key);
+	const VariantOrderedMap::Entry *E = _p->variant_map.find(*p_key);
 
 	if (!E) {
 		return nullptr;
 	}
 
-	++E;
+	E = _p->variant_map.get_next(E);
 
 	if (E) {
 		return &E->key;
@@ -404,11 +754,11 @@ Dictionary Dictionary::recursive_duplicate(bool p_deep, int recursion_count) con
 
 	if (p_deep) {
 		recursion_count++;
-		for (const KeyValue<Variant, Variant> &E : _p->variant_map) {
+		for (const VariantOrderedMap::Entry &E : _p->variant_map) {
 			n[E.key.recursive_duplicate(true, recursion_count)] = E.value.recursive_duplicate(true, recursion_count);
 		}
 	} else {
-		for (const KeyValue<Variant, Variant> &E : _p->variant_map) {
+		for (const VariantOrderedMap::Entry &E : _p->variant_map) {
 			n[E.key] = E.value;
 		}
 	}
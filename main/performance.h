@@ -89,6 +89,8 @@ public:
 		PHYSICS_3D_COLLISION_PAIRS,
 		PHYSICS_3D_ISLAND_COUNT,
 		AUDIO_OUTPUT_LATENCY,
+		MEMORY_ALLOCATION_COUNT,
+		MEMORY_POOLED,
 		MONITOR_MAX
 	};
 
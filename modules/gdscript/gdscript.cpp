@@ -40,6 +40,7 @@
 #include "core/io/file_access_encrypted.h"
 #include "core/os/os.h"
 #include "gdscript_analyzer.h"
+#include "gdscript_bytecode_cache.h"
 #include "gdscript_cache.h"
 #include "gdscript_compiler.h"
 #include "gdscript_parser.h"
@@ -881,26 +882,40 @@ Error GDScript::reload(bool p_keep_state) {
 	}
 
 	valid = false;
+
+	// The cache may have parsed this script on a worker thread while resolving the dependencies of another one.
+	Error parse_err = OK;
+	// Its tree is shared with the parser the analyzer of the dependents uses, and owned by the cache.
+	GDScriptParser *prefetched_parser = GDScriptCache::get_prefetched_parser(path, source, parse_err);
+	if (prefetched_parser) {
+		return _reload_parsed(*prefetched_parser, parse_err, p_keep_state);
+	}
+
 	GDScriptParser parser;
-	Error err = parser.parse(source, path, false);
+	parse_err = parser.parse(source, path, false);
+	return _reload_parsed(parser, parse_err, p_keep_state);
+}
+
+Error GDScript::_reload_parsed(GDScriptParser &p_parser, Error p_parse_err, bool p_keep_state) {
+	Error err = p_parse_err;
 	if (err) {
 		if (EngineDebugger::is_active()) {
-			GDScriptLanguage::get_singleton()->debug_break_parse(_get_debug_path(), parser.get_errors().front()->get().line, "Parser Error: " + parser.get_errors().front()->get().message);
+			GDScriptLanguage::get_singleton()->debug_break_parse(_get_debug_path(), p_parser.get_errors().front()->get().line, "Parser Error: " + p_parser.get_errors().front()->get().message);
 		}
 		// TODO: Show all error messages.
-		_err_print_error("GDScript::reload", path.is_empty() ? "built-in" : (const char *)path.utf8().get_data(), parser.get_errors().front()->get().line, ("Parse Error: " + parser.get_errors().front()->get().message).utf8().get_data(), false, ERR_HANDLER_SCRIPT);
+		_err_print_error("GDScript::reload", path.is_empty() ? "built-in" : (const char *)path.utf8().get_data(), p_parser.get_errors().front()->get().line, ("Parse Error: " + p_parser.get_errors().front()->get().message).utf8().get_data(), false, ERR_HANDLER_SCRIPT);
 		return ERR_PARSE_ERROR;
 	}
 
-	GDScriptAnalyzer analyzer(&parser);
+	GDScriptAnalyzer analyzer(&p_parser);
 	err = analyzer.analyze();
 
 	if (err) {
 		if (EngineDebugger::is_active()) {
-			GDScriptLanguage::get_singleton()->debug_break_parse(_get_debug_path(), parser.get_errors().front()->get().line, "Parser Error: " + parser.get_errors().front()->get().message);
+			GDScriptLanguage::get_singleton()->debug_break_parse(_get_debug_path(), p_parser.get_errors().front()->get().line, "Parser Error: " + p_parser.get_errors().front()->get().message);
 		}
 
-		const List<GDScriptParser::ParserError>::Element *e = parser.get_errors().front();
+		const List<GDScriptParser::ParserError>::Element *e = p_parser.get_errors().front();
 		while (e != nullptr) {
 			_err_print_error("GDScript::reload", path.is_empty() ? "built-in" : (const char *)path.utf8().get_data(), e->get().line, ("Parse Error: " + e->get().message).utf8().get_data(), false, ERR_HANDLER_SCRIPT);
 			e = e->next();
@@ -908,10 +923,10 @@ Error GDScript::reload(bool p_keep_state) {
 		return ERR_PARSE_ERROR;
 	}
 
-	bool can_run = ScriptServer::is_scripting_enabled() || parser.is_tool();
+	bool can_run = ScriptServer::is_scripting_enabled() || p_parser.is_tool();
 
 	GDScriptCompiler compiler;
-	err = compiler.compile(&parser, this, p_keep_state);
+	err = compiler.compile(&p_parser, this, p_keep_state);
 
 #ifdef TOOLS_ENABLED
 	_update_doc();
@@ -929,7 +944,7 @@ Error GDScript::reload(bool p_keep_state) {
 		}
 	}
 #ifdef DEBUG_ENABLED
-	for (const GDScriptWarning &warning : parser.get_warnings()) {
+	for (const GDScriptWarning &warning : p_parser.get_warnings()) {
 		if (EngineDebugger::is_active()) {
 			Vector<ScriptLanguage::StackInfo> si;
 			EngineDebugger::get_script_debugger()->send_error("", get_path(), warning.start_line, warning.get_name(), warning.get_message(), false, ERR_HANDLER_WARNING, si);
@@ -1042,12 +1057,57 @@ void GDScript::_bind_methods() {
 }
 
 Vector<uint8_t> GDScript::get_as_byte_code() const {
-	return Vector<uint8_t>();
+	Vector<uint8_t> buffer;
+	if (GDScriptBytecodeCache::save(this, buffer) != OK) {
+		return Vector<uint8_t>();
+	}
+	return buffer;
 };
 
-// TODO: Fully remove this. There's not this kind of "bytecode" anymore.
 Error GDScript::load_byte_code(const String &p_path) {
-	return ERR_COMPILATION_FAILED;
+	bool has_instances;
+	{
+		MutexLock lock(GDScriptLanguage::singleton->lock);
+
+		has_instances = instances.size();
+	}
+
+	ERR_FAIL_COND_V(has_instances, ERR_ALREADY_IN_USE);
+
+	Error err;
+	Vector<uint8_t> buffer = FileAccess::get_file_as_array(p_path, &err);
+	if (err) {
+		return err;
+	}
+
+	String source_path = path;
+	if (source_path.is_empty()) {
+		source_path = get_path();
+	}
+	if (!source_path.is_empty()) {
+		MutexLock lock(GDScriptCache::singleton->lock);
+		if (!GDScriptCache::singleton->shallow_gdscript_cache.has(source_path)) {
+			GDScriptCache::singleton->shallow_gdscript_cache[source_path] = this;
+		}
+	}
+
+	// Caches that don't match this build or the source are expected after updates, the caller compiles instead.
+	err = GDScriptBytecodeCache::load(this, buffer);
+	if (err) {
+		print_verbose("GDScript: Can't use compiled cache '" + p_path + "' (" + error_names[err] + "), compiling the source instead.");
+		return err;
+	}
+
+	for (KeyValue<StringName, Ref<GDScript>> &E : subclasses) {
+		_set_subclass_path(E.value, path);
+	}
+
+	_init_rpc_methods_properties();
+
+	if (!get_path().is_empty()) {
+		return GDScriptCache::finish_compiling(get_path());
+	}
+	return OK;
 }
 
 Error GDScript::load_source_code(const String &p_path) {
@@ -1266,6 +1326,7 @@ GDScript::~GDScript() {
 		}
 	}
 
+	GDScriptInlineCache::invalidate_all();
 	for (const KeyValue<StringName, GDScriptFunction *> &E : member_functions) {
 		memdelete(E.value);
 	}
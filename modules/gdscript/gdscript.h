@@ -40,6 +40,8 @@
 #include "core/templates/rb_set.h"
 #include "gdscript_function.h"
 
+class GDScriptParser;
+
 class GDScriptNativeClass : public RefCounted {
 	GDCLASS(GDScriptNativeClass, RefCounted);
 
@@ -72,6 +74,7 @@ class GDScript : public Script {
 	friend class GDScriptInstance;
 	friend class GDScriptFunction;
 	friend class GDScriptAnalyzer;
+	friend class GDScriptBytecodeCache;
 	friend class GDScriptCompiler;
 	friend class GDScriptLanguage;
 	friend struct GDScriptUtilityFunctionsDefinitions;
@@ -153,6 +156,7 @@ class GDScript : public Script {
 #endif
 
 	bool _update_exports(bool *r_err = nullptr, bool p_recursive_call = false, PlaceHolderScriptInstance *p_instance_to_update = nullptr);
+	Error _reload_parsed(GDScriptParser &p_parser, Error p_parse_err, bool p_keep_state);
 
 	void _save_orphaned_subclasses();
 	void _init_rpc_methods_properties();
@@ -133,8 +133,9 @@ uint32_t GDScriptByteCodeGenerator::add_temporary(const GDScriptDataType &p_type
 		pool.push_back(idx);
 		temporaries.push_back(new_temp);
 	}
-	int slot = pool.front()->get();
-	pool.pop_front();
+	// Reuse the most recently released slot first, it's the one most likely to still be in cache.
+	int slot = pool.back()->get();
+	pool.pop_back();
 	used_temporaries.push_back(slot);
 	return slot;
 }
@@ -185,15 +186,29 @@ GDScriptFunction *GDScriptByteCodeGenerator::write_end() {
 #endif
 	append(GDScriptFunction::OPCODE_END, 0);
 
-	for (int i = 0; i < temporaries.size(); i++) {
-		int stack_index = i + max_locals + RESERVED_STACK;
-		for (int j = 0; j < temporaries[i].bytecode_indices.size(); j++) {
-			opcodes.write[temporaries[i].bytecode_indices[j]] = stack_index | (GDScriptFunction::ADDR_TYPE_STACK << GDScriptFunction::ADDR_BITS);
+	// Lay out the temporaries after the locals. Temporaries never referenced by any instruction don't
+	// get a slot at all. Untyped ones come first, so the VM can construct them as null together with
+	// the locals, and typed ones are packed at the end, where they are initialized to their type in place.
+	int stack_index = max_locals + RESERVED_STACK;
+	for (int pass = 0; pass < 2; pass++) {
+		if (pass == 1) {
+			function->_typed_stack_start = stack_index;
 		}
-		if (temporaries[i].type != Variant::NIL) {
-			function->temporary_slots[stack_index] = temporaries[i].type;
+		for (int i = 0; i < temporaries.size(); i++) {
+			const StackSlot &slot = temporaries[i];
+			if (slot.bytecode_indices.is_empty() || (slot.type != Variant::NIL) != (pass == 1)) {
+				continue;
+			}
+			for (int j = 0; j < slot.bytecode_indices.size(); j++) {
+				opcodes.write[slot.bytecode_indices[j]] = stack_index | (GDScriptFunction::ADDR_TYPE_STACK << GDScriptFunction::ADDR_BITS);
+			}
+			if (slot.type != Variant::NIL) {
+				function->typed_temporary_slots.push_back(slot.type);
+			}
+			stack_index++;
 		}
 	}
+	function->_stack_size = stack_index;
 
 	if (constant_map.size()) {
 		function->_constant_count = constant_map.size();
@@ -397,8 +412,11 @@ GDScriptFunction *GDScriptByteCodeGenerator::write_end() {
 	if (debug_stack) {
 		function->stack_debug = stack_debug;
 	}
-	function->_stack_size = RESERVED_STACK + max_locals + temporaries.size();
 	function->_instruction_args_size = instr_args_max;
+	if (inline_cache_count) {
+		function->_inline_caches_count = inline_cache_count;
+		function->_inline_caches_ptr = memnew_arr(GDScriptInlineCache, inline_cache_count);
+	}
 	function->_ptrcall_args_size = ptrcall_max;
 
 	ended = true;
@@ -562,6 +580,42 @@ void GDScriptByteCodeGenerator::write_unary_operator(const Address &p_target, Va
 	append(p_operator);
 }
 
+static bool _is_comparison_operator(Variant::Operator p_operator) {
+	switch (p_operator) {
+		case Variant::OP_EQUAL:
+		case Variant::OP_NOT_EQUAL:
+		case Variant::OP_LESS:
+		case Variant::OP_LESS_EQUAL:
+		case Variant::OP_GREATER:
+		case Variant::OP_GREATER_EQUAL:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// Operators the VM evaluates inline for OPCODE_OPERATOR_INT and OPCODE_OPERATOR_FLOAT.
+// Integer division and modulo are left to the validated evaluators, as they need to check for zero.
+static bool _is_typed_operator_inlined(Variant::Operator p_operator, Variant::Type p_type) {
+	if (_is_comparison_operator(p_operator)) {
+		return true;
+	}
+	switch (p_operator) {
+		case Variant::OP_ADD:
+		case Variant::OP_SUBTRACT:
+		case Variant::OP_MULTIPLY:
+			return true;
+		case Variant::OP_DIVIDE:
+			return p_type == Variant::FLOAT;
+		case Variant::OP_BIT_AND:
+		case Variant::OP_BIT_OR:
+		case Variant::OP_BIT_XOR:
+			return p_type == Variant::INT;
+		default:
+			return false;
+	}
+}
+
 void GDScriptByteCodeGenerator::write_binary_operator(const Address &p_target, Variant::Operator p_operator, const Address &p_left_operand, const Address &p_right_operand) {
 	if (HAS_BUILTIN_TYPE(p_left_operand) && HAS_BUILTIN_TYPE(p_right_operand)) {
 		if (p_target.mode == Address::TEMPORARY) {
@@ -572,6 +626,19 @@ void GDScriptByteCodeGenerator::write_binary_operator(const Address &p_target, V
 			}
 		}
 
+		Variant::Type operand_type = p_left_operand.type.builtin_type;
+		if ((operand_type == Variant::INT || operand_type == Variant::FLOAT) && p_right_operand.type.builtin_type == operand_type && _is_typed_operator_inlined(p_operator, operand_type)) {
+			// Avoid the indirect call for the most common arithmetic and comparisons.
+			last_typed_operator_pos = opcodes.size();
+			last_typed_operator_target = p_target;
+			append(operand_type == Variant::INT ? GDScriptFunction::OPCODE_OPERATOR_INT : GDScriptFunction::OPCODE_OPERATOR_FLOAT, 3);
+			append(p_left_operand);
+			append(p_right_operand);
+			append(p_target);
+			append(p_operator);
+			return;
+		}
+
 		// Gather specific operator.
 		Variant::ValidatedOperatorEvaluator op_func = Variant::get_validated_operator_evaluator(p_operator, p_left_operand.type.builtin_type, p_right_operand.type.builtin_type);
 
@@ -771,6 +838,7 @@ void GDScriptByteCodeGenerator::write_set_named(const Address &p_target, const S
 	append(p_target);
 	append(p_source);
 	append(p_name);
+	append(inline_cache_count++);
 }
 
 void GDScriptByteCodeGenerator::write_get_named(const Address &p_target, const StringName &p_name, const Address &p_source) {
@@ -786,6 +854,7 @@ void GDScriptByteCodeGenerator::write_get_named(const Address &p_target, const S
 	append(p_source);
 	append(p_target);
 	append(p_name);
+	append(inline_cache_count++);
 }
 
 void GDScriptByteCodeGenerator::write_set_member(const Address &p_value, const StringName &p_name) {
@@ -795,6 +864,8 @@ void GDScriptByteCodeGenerator::write_set_member(const Address &p_value, const S
 }
 
 void GDScriptByteCodeGenerator::write_get_member(const Address &p_target, const StringName &p_name) {
+	last_get_member_pos = opcodes.size();
+	last_get_member_target = p_target;
 	append(GDScriptFunction::OPCODE_GET_MEMBER, 1);
 	append(p_target);
 	append(p_name);
@@ -878,12 +949,14 @@ void GDScriptByteCodeGenerator::write_assign_default_parameter(const Address &p_
 }
 
 void GDScriptByteCodeGenerator::write_store_global(const Address &p_dst, int p_global_index) {
+	function->global_stores.push_back(opcodes.size());
 	append(GDScriptFunction::OPCODE_STORE_GLOBAL, 1);
 	append(p_dst);
 	append(p_global_index);
 }
 
 void GDScriptByteCodeGenerator::write_store_named_global(const Address &p_dst, const StringName &p_global) {
+	function->global_stores.push_back(opcodes.size());
 	append(GDScriptFunction::OPCODE_STORE_NAMED_GLOBAL, 1);
 	append(p_dst);
 	append(p_global);
@@ -929,6 +1002,7 @@ void GDScriptByteCodeGenerator::write_call(const Address &p_target, const Addres
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(inline_cache_count++);
 }
 
 void GDScriptByteCodeGenerator::write_super_call(const Address &p_target, const StringName &p_function_name, const Vector<Address> &p_arguments) {
@@ -950,6 +1024,7 @@ void GDScriptByteCodeGenerator::write_call_async(const Address &p_target, const
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(inline_cache_count++);
 }
 
 void GDScriptByteCodeGenerator::write_call_gdscript_utility(const Address &p_target, GDScriptUtilityFunctions::FunctionPtr p_function, const Vector<Address> &p_arguments) {
@@ -1109,6 +1184,7 @@ void GDScriptByteCodeGenerator::write_call_native_static(const Address &p_target
 }
 
 void GDScriptByteCodeGenerator::write_call_method_bind(const Address &p_target, const Address &p_base, MethodBind *p_method, const Vector<Address> &p_arguments) {
+	fuse_get_member(p_base);
 	append(p_target.mode == Address::NIL ? GDScriptFunction::OPCODE_CALL_METHOD_BIND : GDScriptFunction::OPCODE_CALL_METHOD_BIND_RET, 2 + p_arguments.size());
 	for (int i = 0; i < p_arguments.size(); i++) {
 		append(p_arguments[i]);
@@ -1166,6 +1242,7 @@ void GDScriptByteCodeGenerator::write_call_ptrcall(const Address &p_target, cons
 			CASE_TYPE(PACKED_VECTOR3_ARRAY);
 			CASE_TYPE(PACKED_COLOR_ARRAY);
 			default:
+				fuse_get_member(p_base);
 				append(p_target.mode == Address::NIL ? GDScriptFunction::OPCODE_CALL_METHOD_BIND : GDScriptFunction::OPCODE_CALL_METHOD_BIND_RET, 2 + p_arguments.size());
 				is_ptrcall = false;
 				break;
@@ -1197,6 +1274,7 @@ void GDScriptByteCodeGenerator::write_call_self(const Address &p_target, const S
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(inline_cache_count++);
 }
 
 void GDScriptByteCodeGenerator::write_call_self_async(const Address &p_target, const StringName &p_function_name, const Vector<Address> &p_arguments) {
@@ -1208,6 +1286,7 @@ void GDScriptByteCodeGenerator::write_call_self_async(const Address &p_target, c
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(inline_cache_count++);
 }
 
 void GDScriptByteCodeGenerator::write_call_script_function(const Address &p_target, const Address &p_base, const StringName &p_function_name, const Vector<Address> &p_arguments) {
@@ -1219,6 +1298,7 @@ void GDScriptByteCodeGenerator::write_call_script_function(const Address &p_targ
 	append(p_target);
 	append(p_arguments.size());
 	append(p_function_name);
+	append(inline_cache_count++);
 }
 
 void GDScriptByteCodeGenerator::write_lambda(const Address &p_target, GDScriptFunction *p_function, const Vector<Address> &p_captures, bool p_use_self) {
@@ -1326,11 +1406,53 @@ void GDScriptByteCodeGenerator::write_await(const Address &p_target, const Addre
 	append(p_target);
 }
 
-void GDScriptByteCodeGenerator::write_if(const Address &p_condition) {
-	append(GDScriptFunction::OPCODE_JUMP_IF_NOT, 1);
-	append(p_condition);
-	if_jmp_addrs.push_back(opcodes.size());
+int GDScriptByteCodeGenerator::fuse_jump_if_not(const Address &p_condition) {
+	// Only a temporary is guaranteed to be written by the condition expression itself, so no jump can
+	// land between the comparison and the jump that would be fused.
+	if (p_condition.mode != Address::TEMPORARY || last_typed_operator_pos < 0 || last_typed_operator_pos + 5 != opcodes.size()) {
+		return -1;
+	}
+	if (last_typed_operator_target.mode != p_condition.mode || last_typed_operator_target.address != p_condition.address) {
+		return -1;
+	}
+	if (!_is_comparison_operator(Variant::Operator(opcodes[last_typed_operator_pos + 4]))) {
+		return -1;
+	}
+
+	// Same operand layout, so addresses of temporaries recorded for patching are still valid.
+	GDScriptFunction::Opcode code = GDScriptFunction::Opcode(opcodes[last_typed_operator_pos] & GDScriptFunction::INSTR_MASK);
+	GDScriptFunction::Opcode fused = code == GDScriptFunction::OPCODE_OPERATOR_INT ? GDScriptFunction::OPCODE_JUMP_IF_NOT_OPERATOR_INT : GDScriptFunction::OPCODE_JUMP_IF_NOT_OPERATOR_FLOAT;
+	opcodes.write[last_typed_operator_pos] = (fused & GDScriptFunction::INSTR_MASK) | (opcodes[last_typed_operator_pos] & GDScriptFunction::INSTR_ARGS_MASK);
+	last_typed_operator_pos = -1;
+
+	int jump_pos = opcodes.size();
 	append(0); // Jump destination, will be patched.
+	return jump_pos;
+}
+
+void GDScriptByteCodeGenerator::fuse_get_member(const Address &p_base) {
+	// Only fuse when the call comes right after the getter and uses its temporary as base, which is the
+	// `member.method()` pattern. The call instruction is kept as is, the fused opcode just enters it directly.
+	if (p_base.mode != Address::TEMPORARY || last_get_member_pos < 0 || last_get_member_pos + 3 != opcodes.size()) {
+		return;
+	}
+	if (last_get_member_target.mode != p_base.mode || last_get_member_target.address != p_base.address) {
+		return;
+	}
+
+	opcodes.write[last_get_member_pos] = (GDScriptFunction::OPCODE_GET_MEMBER_CALL_METHOD_BIND & GDScriptFunction::INSTR_MASK) | (opcodes[last_get_member_pos] & GDScriptFunction::INSTR_ARGS_MASK);
+	last_get_member_pos = -1;
+}
+
+void GDScriptByteCodeGenerator::write_if(const Address &p_condition) {
+	int jump_pos = fuse_jump_if_not(p_condition);
+	if (jump_pos < 0) {
+		append(GDScriptFunction::OPCODE_JUMP_IF_NOT, 1);
+		append(p_condition);
+		jump_pos = opcodes.size();
+		append(0); // Jump destination, will be patched.
+	}
+	if_jmp_addrs.push_back(jump_pos);
 }
 
 void GDScriptByteCodeGenerator::write_else() {
@@ -1526,10 +1648,14 @@ void GDScriptByteCodeGenerator::start_while_condition() {
 
 void GDScriptByteCodeGenerator::write_while(const Address &p_condition) {
 	// Condition check.
-	append(GDScriptFunction::OPCODE_JUMP_IF_NOT, 1);
-	append(p_condition);
-	while_jmp_addrs.push_back(opcodes.size());
-	append(0); // End of loop address, will be patched.
+	int jump_pos = fuse_jump_if_not(p_condition);
+	if (jump_pos < 0) {
+		append(GDScriptFunction::OPCODE_JUMP_IF_NOT, 1);
+		append(p_condition);
+		jump_pos = opcodes.size();
+		append(0); // End of loop address, will be patched.
+	}
+	while_jmp_addrs.push_back(jump_pos);
 }
 
 void GDScriptByteCodeGenerator::write_endwhile() {
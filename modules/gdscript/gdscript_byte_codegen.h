@@ -68,6 +68,7 @@ class GDScriptByteCodeGenerator : public GDScriptCodeGenerator {
 	RBMap<StringName, int> block_identifiers;
 
 	int max_locals = 0;
+	int inline_cache_count = 0;
 	int current_line = 0;
 	int instr_args_max = 0;
 	int ptrcall_max = 0;
@@ -115,6 +116,14 @@ class GDScriptByteCodeGenerator : public GDScriptCodeGenerator {
 	List<List<int>> current_breaks_to_patch;
 	List<List<int>> match_continues_to_patch;
 
+	// Last OPCODE_OPERATOR_INT/FLOAT written, so a following conditional jump on its result can be fused with it.
+	int last_typed_operator_pos = -1;
+	Address last_typed_operator_target;
+
+	// Last OPCODE_GET_MEMBER written, so a following method bind call on its result can be fused with it.
+	int last_get_member_pos = -1;
+	Address last_get_member_target;
+
 	void add_stack_identifier(const StringName &p_id, int p_stackpos) {
 		if (locals.size() > max_locals) {
 			max_locals = locals.size();
@@ -303,6 +312,9 @@ class GDScriptByteCodeGenerator : public GDScriptCodeGenerator {
 		return pos;
 	}
 
+	int fuse_jump_if_not(const Address &p_condition);
+	void fuse_get_member(const Address &p_base);
+
 	void alloc_ptrcall(int p_params) {
 		if (p_params >= ptrcall_max) {
 			ptrcall_max = p_params;
@@ -0,0 +1,1296 @@
+/*************************************************************************/
+/*  gdscript_bytecode_cache.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_bytecode_cache.h"
+
+#include "core/io/marshalls.h"
+#include "core/io/resource_loader.h"
+#include "core/templates/rb_map.h"
+#include "core/version.h"
+#include "gdscript.h"
+#include "gdscript_cache.h"
+
+struct GDScriptBytecodeCache::SaveContext {
+	const GDScript *root = nullptr;
+	Vector<uint8_t> buffer;
+
+	// Function tables hold pointers into the Variant and utility APIs, which are stored by what they resolve from.
+	RBMap<Variant::ValidatedOperatorEvaluator, uint32_t> operator_funcs;
+	RBMap<Variant::ValidatedSetter, Pair<Variant::Type, StringName>> setters;
+	RBMap<Variant::ValidatedGetter, Pair<Variant::Type, StringName>> getters;
+	RBMap<Variant::ValidatedKeyedSetter, Variant::Type> keyed_setters;
+	RBMap<Variant::ValidatedKeyedGetter, Variant::Type> keyed_getters;
+	RBMap<Variant::ValidatedIndexedSetter, Variant::Type> indexed_setters;
+	RBMap<Variant::ValidatedIndexedGetter, Variant::Type> indexed_getters;
+	RBMap<Variant::ValidatedBuiltInMethod, Pair<Variant::Type, StringName>> builtin_methods;
+	RBMap<Variant::ValidatedConstructor, Pair<Variant::Type, int>> constructors;
+	RBMap<Variant::ValidatedUtilityFunction, StringName> utilities;
+	RBMap<GDScriptUtilityFunctions::FunctionPtr, StringName> gds_utilities;
+	HashMap<int, StringName> global_names;
+	HashMap<const Object *, StringName> global_objects;
+
+	void put_8(uint8_t p_value) {
+		buffer.push_back(p_value);
+	}
+
+	void put_32(uint32_t p_value) {
+		int ofs = buffer.size();
+		buffer.resize(ofs + 4);
+		encode_uint32(p_value, &buffer.write[ofs]);
+	}
+
+	void put_string(const String &p_string) {
+		CharString utf8 = p_string.utf8();
+		put_32(utf8.length());
+		if (utf8.length()) {
+			int ofs = buffer.size();
+			buffer.resize(ofs + utf8.length());
+			memcpy(&buffer.write[ofs], utf8.get_data(), utf8.length());
+		}
+	}
+};
+
+struct GDScriptBytecodeCache::LoadContext {
+	GDScript *root = nullptr;
+	const uint8_t *data = nullptr;
+	int size = 0;
+	int pos = 0;
+	bool failed = false;
+
+	uint8_t get_8() {
+		if (pos + 1 > size) {
+			failed = true;
+			return 0;
+		}
+		return data[pos++];
+	}
+
+	uint32_t get_32() {
+		if (pos + 4 > size) {
+			failed = true;
+			return 0;
+		}
+		uint32_t value = decode_uint32(&data[pos]);
+		pos += 4;
+		return value;
+	}
+
+	// Element counts are checked against the remaining data, so a damaged file can't request huge allocations.
+	int get_count() {
+		uint32_t count = get_32();
+		if (count > uint32_t(size - pos)) {
+			failed = true;
+			return 0;
+		}
+		return count;
+	}
+
+	String get_string() {
+		int length = get_count();
+		if (failed) {
+			return String();
+		}
+		String string;
+		string.parse_utf8((const char *)&data[pos], length);
+		pos += length;
+		return string;
+	}
+};
+
+static String _get_engine_fingerprint(bool p_debug_build) {
+	return String(VERSION_FULL_BUILD) + "." + String(VERSION_HASH) + "/" + itos(Variant::VARIANT_MAX) + "/" + itos(Variant::OP_MAX) + "/" + itos(GDScriptFunction::OPCODE_END) + (p_debug_build ? "/debug" : "/release");
+}
+
+void GDScriptBytecodeCache::_build_reverse_tables(SaveContext &p_ctx) {
+	for (int i = 0; i < Variant::VARIANT_MAX; i++) {
+		Variant::Type type = Variant::Type(i);
+
+		for (int op = 0; op < Variant::OP_MAX; op++) {
+			for (int j = 0; j < Variant::VARIANT_MAX; j++) {
+				Variant::ValidatedOperatorEvaluator evaluator = Variant::get_validated_operator_evaluator(Variant::Operator(op), type, Variant::Type(j));
+				if (evaluator && !p_ctx.operator_funcs.has(evaluator)) {
+					p_ctx.operator_funcs.insert(evaluator, (op << 16) | (i << 8) | j);
+				}
+			}
+		}
+
+		List<StringName> members;
+		Variant::get_member_list(type, &members);
+		for (const StringName &E : members) {
+			Variant::ValidatedSetter setter = Variant::get_member_validated_setter(type, E);
+			if (setter && !p_ctx.setters.has(setter)) {
+				p_ctx.setters.insert(setter, Pair<Variant::Type, StringName>(type, E));
+			}
+			Variant::ValidatedGetter getter = Variant::get_member_validated_getter(type, E);
+			if (getter && !p_ctx.getters.has(getter)) {
+				p_ctx.getters.insert(getter, Pair<Variant::Type, StringName>(type, E));
+			}
+		}
+
+		Variant::ValidatedKeyedSetter keyed_setter = Variant::get_member_validated_keyed_setter(type);
+		if (keyed_setter && !p_ctx.keyed_setters.has(keyed_setter)) {
+			p_ctx.keyed_setters.insert(keyed_setter, type);
+		}
+		Variant::ValidatedKeyedGetter keyed_getter = Variant::get_member_validated_keyed_getter(type);
+		if (keyed_getter && !p_ctx.keyed_getters.has(keyed_getter)) {
+			p_ctx.keyed_getters.insert(keyed_getter, type);
+		}
+		Variant::ValidatedIndexedSetter indexed_setter = Variant::get_member_validated_indexed_setter(type);
+		if (indexed_setter && !p_ctx.indexed_setters.has(indexed_setter)) {
+			p_ctx.indexed_setters.insert(indexed_setter, type);
+		}
+		Variant::ValidatedIndexedGetter indexed_getter = Variant::get_member_validated_indexed_getter(type);
+		if (indexed_getter && !p_ctx.indexed_getters.has(indexed_getter)) {
+			p_ctx.indexed_getters.insert(indexed_getter, type);
+		}
+
+		List<StringName> methods;
+		Variant::get_builtin_method_list(type, &methods);
+		for (const StringName &E : methods) {
+			Variant::ValidatedBuiltInMethod method = Variant::get_validated_builtin_method(type, E);
+			if (method && !p_ctx.builtin_methods.has(method)) {
+				p_ctx.builtin_methods.insert(method, Pair<Variant::Type, StringName>(type, E));
+			}
+		}
+
+		for (int j = 0; j < Variant::get_constructor_count(type); j++) {
+			Variant::ValidatedConstructor constructor = Variant::get_validated_constructor(type, j);
+			if (constructor && !p_ctx.constructors.has(constructor)) {
+				p_ctx.constructors.insert(constructor, Pair<Variant::Type, int>(type, j));
+			}
+		}
+	}
+
+	List<StringName> utilities;
+	Variant::get_utility_function_list(&utilities);
+	for (const StringName &E : utilities) {
+		Variant::ValidatedUtilityFunction utility = Variant::get_validated_utility_function(E);
+		if (utility && !p_ctx.utilities.has(utility)) {
+			p_ctx.utilities.insert(utility, E);
+		}
+	}
+
+	List<StringName> gds_utilities;
+	GDScriptUtilityFunctions::get_function_list(&gds_utilities);
+	for (const StringName &E : gds_utilities) {
+		GDScriptUtilityFunctions::FunctionPtr utility = GDScriptUtilityFunctions::get_function(E);
+		if (utility && !p_ctx.gds_utilities.has(utility)) {
+			p_ctx.gds_utilities.insert(utility, E);
+		}
+	}
+
+	const Variant *global_array = GDScriptLanguage::get_singleton()->get_global_array();
+	for (const KeyValue<StringName, int> &E : GDScriptLanguage::get_singleton()->get_global_map()) {
+		p_ctx.global_names.insert(E.value, E.key);
+		const Variant &global = global_array[E.value];
+		if (global.get_type() == Variant::OBJECT) {
+			Object *object = global.get_validated_object();
+			if (object && !p_ctx.global_objects.has(object)) {
+				p_ctx.global_objects.insert(object, E.key);
+			}
+		}
+	}
+}
+
+Error GDScriptBytecodeCache::_save_object(SaveContext &p_ctx, const Object *p_object) {
+	if (!p_object) {
+		p_ctx.put_8(OBJECT_NULL);
+		return OK;
+	}
+
+	const GDScript *script = Object::cast_to<GDScript>(p_object);
+	if (script) {
+		// Inner classes are reached from the outermost script through their names.
+		Vector<StringName> names;
+		const GDScript *outer = script;
+		while (outer->_owner) {
+			names.insert(0, outer->name);
+			outer = outer->_owner;
+		}
+
+		if (outer == p_ctx.root) {
+			p_ctx.put_8(OBJECT_LOCAL_SCRIPT);
+		} else {
+			const String &path = outer->get_path();
+			if (path.is_empty() || path.contains("::")) {
+				return ERR_UNAVAILABLE; // Built-in scripts can't be loaded on their own.
+			}
+			p_ctx.put_8(OBJECT_SCRIPT);
+			p_ctx.put_string(path);
+		}
+		p_ctx.put_32(names.size());
+		for (int i = 0; i < names.size(); i++) {
+			p_ctx.put_string(names[i]);
+		}
+		return OK;
+	}
+
+	HashMap<const Object *, StringName>::Iterator global = p_ctx.global_objects.find(p_object);
+	if (global) {
+		p_ctx.put_8(OBJECT_GLOBAL);
+		p_ctx.put_string(global->value);
+		return OK;
+	}
+
+	const Resource *resource = Object::cast_to<Resource>(p_object);
+	if (resource && !resource->get_path().is_empty() && !resource->get_path().contains("::")) {
+		p_ctx.put_8(OBJECT_RESOURCE);
+		p_ctx.put_string(resource->get_path());
+		return OK;
+	}
+
+	return ERR_UNAVAILABLE;
+}
+
+Error GDScriptBytecodeCache::_save_variant(SaveContext &p_ctx, const Variant &p_value, int p_depth) {
+	ERR_FAIL_COND_V(p_depth > Variant::MAX_RECURSION_DEPTH, ERR_OUT_OF_MEMORY);
+
+	switch (p_value.get_type()) {
+		case Variant::OBJECT: {
+			p_ctx.put_8(VARIANT_OBJECT);
+			return _save_object(p_ctx, p_value.get_validated_object());
+		}
+		case Variant::ARRAY: {
+			Array array = p_value;
+			p_ctx.put_8(VARIANT_ARRAY);
+			p_ctx.put_8(array.is_read_only());
+			p_ctx.put_8(array.is_typed());
+			if (array.is_typed()) {
+				p_ctx.put_32(array.get_typed_builtin());
+				p_ctx.put_string(array.get_typed_class_name());
+				Error err = _save_object(p_ctx, array.get_typed_script().get_validated_object());
+				if (err) {
+					return err;
+				}
+			}
+			p_ctx.put_32(array.size());
+			for (int i = 0; i < array.size(); i++) {
+				Error err = _save_variant(p_ctx, array[i], p_depth + 1);
+				if (err) {
+					return err;
+				}
+			}
+			return OK;
+		}
+		case Variant::DICTIONARY: {
+			Dictionary dictionary = p_value;
+			List<Variant> keys;
+			dictionary.get_key_list(&keys);
+			p_ctx.put_8(VARIANT_DICTIONARY);
+			p_ctx.put_8(dictionary.is_read_only());
+			p_ctx.put_32(keys.size());
+			for (const Variant &E : keys) {
+				Error err = _save_variant(p_ctx, E, p_depth + 1);
+				if (err) {
+					return err;
+				}
+				err = _save_variant(p_ctx, dictionary[E], p_depth + 1);
+				if (err) {
+					return err;
+				}
+			}
+			return OK;
+		}
+		case Variant::RID:
+		case Variant::CALLABLE:
+		case Variant::SIGNAL: {
+			return ERR_UNAVAILABLE; // Only meaningful in the running instance.
+		}
+		default: {
+			int length = 0;
+			Error err = encode_variant(p_value, nullptr, length, false);
+			if (err) {
+				return err;
+			}
+			p_ctx.put_8(VARIANT_VALUE);
+			p_ctx.put_32(length);
+			int ofs = p_ctx.buffer.size();
+			p_ctx.buffer.resize(ofs + length);
+			return encode_variant(p_value, &p_ctx.buffer.write[ofs], length, false);
+		}
+	}
+}
+
+Error GDScriptBytecodeCache::_save_data_type(SaveContext &p_ctx, const GDScriptDataType &p_type) {
+	p_ctx.put_8(p_type.has_type);
+	p_ctx.put_8(p_type.kind);
+	p_ctx.put_32(p_type.builtin_type);
+	p_ctx.put_string(p_type.native_type);
+	if (p_type.kind == GDScriptDataType::SCRIPT || p_type.kind == GDScriptDataType::GDSCRIPT) {
+		Error err = _save_object(p_ctx, p_type.script_type);
+		if (err) {
+			return err;
+		}
+	}
+	p_ctx.put_8(p_type.has_container_element_type());
+	if (p_type.has_container_element_type()) {
+		return _save_data_type(p_ctx, p_type.get_container_element_type());
+	}
+	return OK;
+}
+
+Error GDScriptBytecodeCache::_save_function(SaveContext &p_ctx, const GDScriptFunction *p_function) {
+	Error err = OK;
+
+	p_ctx.put_string(p_function->name);
+	p_ctx.put_string(p_function->source);
+	p_ctx.put_8(p_function->_static);
+	p_ctx.put_32(p_function->_initial_line);
+	err = _save_variant(p_ctx, p_function->rpc_config);
+	if (err) {
+		return err;
+	}
+
+	err = _save_data_type(p_ctx, p_function->return_type);
+	if (err) {
+		return err;
+	}
+	p_ctx.put_32(p_function->_argument_count);
+	for (int i = 0; i < p_function->argument_types.size(); i++) {
+		err = _save_data_type(p_ctx, p_function->argument_types[i]);
+		if (err) {
+			return err;
+		}
+	}
+#ifdef TOOLS_ENABLED
+	p_ctx.put_32(p_function->arg_names.size());
+	for (int i = 0; i < p_function->arg_names.size(); i++) {
+		p_ctx.put_string(p_function->arg_names[i]);
+	}
+#else
+	p_ctx.put_32(0);
+#endif
+	p_ctx.put_32(p_function->_default_arg_count);
+	p_ctx.put_32(p_function->default_arguments.size());
+	for (int i = 0; i < p_function->default_arguments.size(); i++) {
+		p_ctx.put_32(p_function->default_arguments[i]);
+	}
+
+	p_ctx.put_32(p_function->_stack_size);
+	p_ctx.put_32(p_function->_typed_stack_start);
+	p_ctx.put_32(p_function->typed_temporary_slots.size());
+	for (int i = 0; i < p_function->typed_temporary_slots.size(); i++) {
+		p_ctx.put_32(p_function->typed_temporary_slots[i]);
+	}
+	p_ctx.put_32(p_function->_instruction_args_size);
+	p_ctx.put_32(p_function->_ptrcall_args_size);
+	p_ctx.put_32(p_function->_inline_caches_count);
+
+	p_ctx.put_32(p_function->code.size());
+	for (int i = 0; i < p_function->code.size(); i++) {
+		p_ctx.put_32(p_function->code[i]);
+	}
+
+	p_ctx.put_32(p_function->constants.size());
+	for (int i = 0; i < p_function->constants.size(); i++) {
+		err = _save_variant(p_ctx, p_function->constants[i]);
+		if (err) {
+			return err;
+		}
+	}
+
+	p_ctx.put_32(p_function->global_names.size());
+	for (int i = 0; i < p_function->global_names.size(); i++) {
+		p_ctx.put_string(p_function->global_names[i]);
+	}
+
+	// Global indices depend on what was registered in this run, so those are stored by name.
+	p_ctx.put_32(p_function->global_stores.size());
+	for (int i = 0; i < p_function->global_stores.size(); i++) {
+		int pos = p_function->global_stores[i];
+		StringName global;
+		if ((p_function->code[pos] & GDScriptFunction::INSTR_MASK) == GDScriptFunction::OPCODE_STORE_GLOBAL) {
+			HashMap<int, StringName>::Iterator E = p_ctx.global_names.find(p_function->code[pos + 2]);
+			if (!E) {
+				return ERR_UNAVAILABLE;
+			}
+			global = E->value;
+		} else {
+			global = p_function->global_names[p_function->code[pos + 2]];
+		}
+		p_ctx.put_32(pos);
+		p_ctx.put_string(global);
+	}
+
+#define SAVE_TABLE(m_table, m_write)                                      \
+	p_ctx.put_32(p_function->m_table.size());                             \
+	for (int i = 0; i < p_function->m_table.size(); i++) {                \
+		auto E = p_ctx.m_table.find(p_function->m_table[i]);              \
+		if (!E) {                                                         \
+			ERR_FAIL_V_MSG(ERR_BUG, "Unknown entry in " #m_table " table."); \
+		}                                                                 \
+		m_write;                                                          \
+	}
+
+	SAVE_TABLE(operator_funcs, p_ctx.put_32(E->value()));
+	SAVE_TABLE(setters, p_ctx.put_32(E->value().first); p_ctx.put_string(E->value().second));
+	SAVE_TABLE(getters, p_ctx.put_32(E->value().first); p_ctx.put_string(E->value().second));
+	SAVE_TABLE(keyed_setters, p_ctx.put_32(E->value()));
+	SAVE_TABLE(keyed_getters, p_ctx.put_32(E->value()));
+	SAVE_TABLE(indexed_setters, p_ctx.put_32(E->value()));
+	SAVE_TABLE(indexed_getters, p_ctx.put_32(E->value()));
+	SAVE_TABLE(builtin_methods, p_ctx.put_32(E->value().first); p_ctx.put_string(E->value().second));
+	SAVE_TABLE(constructors, p_ctx.put_32(E->value().first); p_ctx.put_32(E->value().second));
+	SAVE_TABLE(utilities, p_ctx.put_string(E->value()));
+	SAVE_TABLE(gds_utilities, p_ctx.put_string(E->value()));
+
+#undef SAVE_TABLE
+
+	p_ctx.put_32(p_function->methods.size());
+	for (int i = 0; i < p_function->methods.size(); i++) {
+		p_ctx.put_string(p_function->methods[i]->get_instance_class());
+		p_ctx.put_string(p_function->methods[i]->get_name());
+	}
+
+	p_ctx.put_32(p_function->lambdas.size());
+	for (int i = 0; i < p_function->lambdas.size(); i++) {
+		err = _save_function(p_ctx, p_function->lambdas[i]);
+		if (err) {
+			return err;
+		}
+	}
+
+	p_ctx.put_32(p_function->stack_debug.size());
+	for (const GDScriptFunction::StackDebug &E : p_function->stack_debug) {
+		p_ctx.put_32(E.line);
+		p_ctx.put_32(E.pos);
+		p_ctx.put_8(E.added);
+		p_ctx.put_string(E.identifier);
+	}
+
+	return OK;
+}
+
+void GDScriptBytecodeCache::_save_class_tree(SaveContext &p_ctx, const GDScript *p_script) {
+	p_ctx.put_32(p_script->subclasses.size());
+	for (const KeyValue<StringName, Ref<GDScript>> &E : p_script->subclasses) {
+		p_ctx.put_string(E.key);
+		_save_class_tree(p_ctx, E.value.ptr());
+	}
+}
+
+Error GDScriptBytecodeCache::_save_class(SaveContext &p_ctx, const GDScript *p_script) {
+	Error err = OK;
+
+	p_ctx.put_8(p_script->tool);
+	p_ctx.put_string(p_script->name);
+	err = _save_object(p_ctx, p_script->native.ptr());
+	if (err) {
+		return err;
+	}
+	err = _save_object(p_ctx, p_script->base.ptr());
+	if (err) {
+		return err;
+	}
+
+	p_ctx.put_32(p_script->members.size());
+	for (const StringName &E : p_script->members) {
+		p_ctx.put_string(E);
+	}
+
+	p_ctx.put_32(p_script->member_indices.size());
+	for (const KeyValue<StringName, GDScript::MemberInfo> &E : p_script->member_indices) {
+		p_ctx.put_string(E.key);
+		p_ctx.put_32(E.value.index);
+		p_ctx.put_string(E.value.setter);
+		p_ctx.put_string(E.value.getter);
+		err = _save_data_type(p_ctx, E.value.data_type);
+		if (err) {
+			return err;
+		}
+	}
+
+	p_ctx.put_32(p_script->member_info.size());
+	for (const KeyValue<StringName, PropertyInfo> &E : p_script->member_info) {
+		p_ctx.put_string(E.key);
+		p_ctx.put_32(E.value.type);
+		p_ctx.put_string(E.value.name);
+		p_ctx.put_string(E.value.class_name);
+		p_ctx.put_32(E.value.hint);
+		p_ctx.put_string(E.value.hint_string);
+		p_ctx.put_32(E.value.usage);
+	}
+
+	p_ctx.put_32(p_script->constants.size());
+	for (const KeyValue<StringName, Variant> &E : p_script->constants) {
+		p_ctx.put_string(E.key);
+		err = _save_variant(p_ctx, E.value);
+		if (err) {
+			return err;
+		}
+	}
+
+	p_ctx.put_32(p_script->_signals.size());
+	for (const KeyValue<StringName, Vector<StringName>> &E : p_script->_signals) {
+		p_ctx.put_string(E.key);
+		p_ctx.put_32(E.value.size());
+		for (int i = 0; i < E.value.size(); i++) {
+			p_ctx.put_string(E.value[i]);
+		}
+	}
+
+	p_ctx.put_32(p_script->member_functions.size());
+	for (const KeyValue<StringName, GDScriptFunction *> &E : p_script->member_functions) {
+		p_ctx.put_string(E.key);
+		err = _save_function(p_ctx, E.value);
+		if (err) {
+			return err;
+		}
+	}
+
+	const GDScriptFunction *implicit_functions[2] = { p_script->implicit_initializer, p_script->implicit_ready };
+	for (const GDScriptFunction *function : implicit_functions) {
+		p_ctx.put_8(function != nullptr);
+		if (function) {
+			err = _save_function(p_ctx, function);
+			if (err) {
+				return err;
+			}
+		}
+	}
+
+	for (const KeyValue<StringName, Ref<GDScript>> &E : p_script->subclasses) {
+		err = _save_class(p_ctx, E.value.ptr());
+		if (err) {
+			return err;
+		}
+	}
+
+	return OK;
+}
+
+Error GDScriptBytecodeCache::_load_object(LoadContext &p_ctx, Variant &r_object, bool &r_local) {
+	r_object = Variant();
+	r_local = false;
+
+	uint8_t tag = p_ctx.get_8();
+	switch (tag) {
+		case OBJECT_NULL: {
+			return OK;
+		}
+		case OBJECT_GLOBAL: {
+			StringName name = p_ctx.get_string();
+			HashMap<StringName, int>::ConstIterator E = GDScriptLanguage::get_singleton()->get_global_map().find(name);
+			if (!E) {
+				return ERR_CANT_RESOLVE;
+			}
+			r_object = GDScriptLanguage::get_singleton()->get_global_array()[E->value];
+			return OK;
+		}
+		case OBJECT_LOCAL_SCRIPT:
+		case OBJECT_SCRIPT: {
+			String path = tag == OBJECT_SCRIPT ? p_ctx.get_string() : String();
+			Vector<StringName> names;
+			names.resize(p_ctx.get_count());
+			for (int i = 0; i < names.size(); i++) {
+				names.write[i] = p_ctx.get_string();
+			}
+			if (p_ctx.failed) {
+				return ERR_FILE_CORRUPT;
+			}
+
+			Ref<GDScript> script;
+			if (tag == OBJECT_LOCAL_SCRIPT) {
+				script = Ref<GDScript>(p_ctx.root);
+				r_local = true;
+			} else if (names.is_empty()) {
+				// Like in the compiler, other scripts only need to be complete once the owner is.
+				script = GDScriptCache::get_shallow_script(path, p_ctx.root->get_path());
+			} else {
+				Error err = OK;
+				script = GDScriptCache::get_full_script(path, err, p_ctx.root->get_path());
+				if (err) {
+					return err;
+				}
+			}
+			for (int i = 0; i < names.size() && script.is_valid(); i++) {
+				HashMap<StringName, Ref<GDScript>>::Iterator E = script->subclasses.find(names[i]);
+				script = E ? E->value : Ref<GDScript>();
+			}
+			if (script.is_null()) {
+				return ERR_CANT_RESOLVE;
+			}
+			r_object = script;
+			return OK;
+		}
+		case OBJECT_RESOURCE: {
+			String path = p_ctx.get_string();
+			if (p_ctx.failed) {
+				return ERR_FILE_CORRUPT;
+			}
+			Ref<Resource> resource = ResourceLoader::load(path);
+			if (resource.is_null()) {
+				return ERR_CANT_RESOLVE;
+			}
+			r_object = resource;
+			return OK;
+		}
+	}
+
+	return ERR_FILE_CORRUPT;
+}
+
+Error GDScriptBytecodeCache::_load_variant(LoadContext &p_ctx, Variant &r_value, int p_depth) {
+	ERR_FAIL_COND_V(p_depth > Variant::MAX_RECURSION_DEPTH, ERR_FILE_CORRUPT);
+
+	switch (p_ctx.get_8()) {
+		case VARIANT_VALUE: {
+			int length = p_ctx.get_count();
+			if (p_ctx.failed) {
+				return ERR_FILE_CORRUPT;
+			}
+			int used = 0;
+			Error err = decode_variant(r_value, &p_ctx.data[p_ctx.pos], length, &used, false);
+			p_ctx.pos += length;
+			return err;
+		}
+		case VARIANT_OBJECT: {
+			bool local = false;
+			return _load_object(p_ctx, r_value, local);
+		}
+		case VARIANT_ARRAY: {
+			Array array;
+			bool read_only = p_ctx.get_8();
+			if (p_ctx.get_8()) {
+				uint32_t type = p_ctx.get_32();
+				StringName class_name = p_ctx.get_string();
+				Variant script;
+				bool local = false;
+				Error err = _load_object(p_ctx, script, local);
+				if (err) {
+					return err;
+				}
+				array.set_typed(type, class_name, script);
+			}
+			int size = p_ctx.get_count();
+			for (int i = 0; i < size; i++) {
+				Variant element;
+				Error err = _load_variant(p_ctx, element, p_depth + 1);
+				if (err) {
+					return err;
+				}
+				array.push_back(element);
+			}
+			array.set_read_only(read_only);
+			r_value = array;
+			return p_ctx.failed ? ERR_FILE_CORRUPT : OK;
+		}
+		case VARIANT_DICTIONARY: {
+			Dictionary dictionary;
+			bool read_only = p_ctx.get_8();
+			int size = p_ctx.get_count();
+			for (int i = 0; i < size; i++) {
+				Variant key;
+				Variant value;
+				Error err = _load_variant(p_ctx, key, p_depth + 1);
+				if (err) {
+					return err;
+				}
+				err = _load_variant(p_ctx, value, p_depth + 1);
+				if (err) {
+					return err;
+				}
+				dictionary[key] = value;
+			}
+			dictionary.set_read_only(read_only);
+			r_value = dictionary;
+			return p_ctx.failed ? ERR_FILE_CORRUPT : OK;
+		}
+	}
+
+	return ERR_FILE_CORRUPT;
+}
+
+Error GDScriptBytecodeCache::_load_data_type(LoadContext &p_ctx, GDScriptDataType &r_type) {
+	r_type.has_type = p_ctx.get_8();
+	r_type.kind = GDScriptDataType::Kind(p_ctx.get_8());
+	r_type.builtin_type = Variant::Type(p_ctx.get_32());
+	r_type.native_type = p_ctx.get_string();
+	if (r_type.kind > GDScriptDataType::GDSCRIPT || r_type.builtin_type >= Variant::VARIANT_MAX) {
+		return ERR_FILE_CORRUPT;
+	}
+	if (r_type.kind == GDScriptDataType::SCRIPT || r_type.kind == GDScriptDataType::GDSCRIPT) {
+		Variant script;
+		bool local = false;
+		Error err = _load_object(p_ctx, script, local);
+		if (err) {
+			return err;
+		}
+		// Like the compiler, classes of the same script are not referenced, or they would never be freed.
+		r_type.script_type = Object::cast_to<Script>(script.get_validated_object());
+		if (!local) {
+			r_type.script_type_ref = Ref<Script>(r_type.script_type);
+		}
+	}
+	if (p_ctx.get_8()) {
+		GDScriptDataType element_type;
+		Error err = _load_data_type(p_ctx, element_type);
+		if (err) {
+			return err;
+		}
+		r_type.set_container_element_type(element_type);
+	}
+	return p_ctx.failed ? ERR_FILE_CORRUPT : OK;
+}
+
+Error GDScriptBytecodeCache::_load_function(LoadContext &p_ctx, GDScript *p_script, GDScriptFunction *p_function) {
+	Error err = OK;
+
+	p_function->_script = p_script;
+	p_function->name = p_ctx.get_string();
+	p_function->source = p_ctx.get_string();
+	p_function->_static = p_ctx.get_8();
+	p_function->_initial_line = p_ctx.get_32();
+	err = _load_variant(p_ctx, p_function->rpc_config);
+	if (err) {
+		return err;
+	}
+
+	err = _load_data_type(p_ctx, p_function->return_type);
+	if (err) {
+		return err;
+	}
+	p_function->_argument_count = p_ctx.get_count();
+	p_function->argument_types.resize(p_function->_argument_count);
+	for (int i = 0; i < p_function->_argument_count; i++) {
+		err = _load_data_type(p_ctx, p_function->argument_types.write[i]);
+		if (err) {
+			return err;
+		}
+	}
+	int arg_name_count = p_ctx.get_count();
+	for (int i = 0; i < arg_name_count; i++) {
+		StringName arg_name = p_ctx.get_string();
+#ifdef TOOLS_ENABLED
+		p_function->arg_names.push_back(arg_name);
+#endif
+	}
+	p_function->_default_arg_count = p_ctx.get_32();
+	p_function->default_arguments.resize(p_ctx.get_count());
+	for (int i = 0; i < p_function->default_arguments.size(); i++) {
+		p_function->default_arguments.write[i] = p_ctx.get_32();
+	}
+
+	p_function->_stack_size = p_ctx.get_32();
+	p_function->_typed_stack_start = p_ctx.get_32();
+	p_function->typed_temporary_slots.resize(p_ctx.get_count());
+	for (int i = 0; i < p_function->typed_temporary_slots.size(); i++) {
+		uint32_t type = p_ctx.get_32();
+		if (type >= Variant::VARIANT_MAX) {
+			return ERR_FILE_CORRUPT;
+		}
+		p_function->typed_temporary_slots.write[i] = Variant::Type(type);
+	}
+	if (p_function->_typed_stack_start + p_function->typed_temporary_slots.size() != p_function->_stack_size) {
+		return ERR_FILE_CORRUPT;
+	}
+	p_function->_instruction_args_size = p_ctx.get_32();
+	p_function->_ptrcall_args_size = p_ctx.get_32();
+	p_function->_inline_caches_count = p_ctx.get_count();
+
+	p_function->code.resize(p_ctx.get_count());
+	for (int i = 0; i < p_function->code.size(); i++) {
+		p_function->code.write[i] = p_ctx.get_32();
+	}
+
+	p_function->constants.resize(p_ctx.get_count());
+	for (int i = 0; i < p_function->constants.size(); i++) {
+		err = _load_variant(p_ctx, p_function->constants.write[i]);
+		if (err) {
+			return err;
+		}
+	}
+
+	p_function->global_names.resize(p_ctx.get_count());
+	for (int i = 0; i < p_function->global_names.size(); i++) {
+		p_function->global_names.write[i] = p_ctx.get_string();
+	}
+
+	// Prefer the runtime global table, as the compiler would in this run. Named globals only exist in the editor.
+	int global_store_count = p_ctx.get_count();
+	for (int i = 0; i < global_store_count; i++) {
+		int pos = p_ctx.get_32();
+		StringName global = p_ctx.get_string();
+		if (p_ctx.failed || pos < 0 || pos + 2 >= p_function->code.size()) {
+			return ERR_FILE_CORRUPT;
+		}
+
+		int *code = p_function->code.ptrw();
+		HashMap<StringName, int>::ConstIterator E = GDScriptLanguage::get_singleton()->get_global_map().find(global);
+		if (E) {
+			code[pos] = (code[pos] & GDScriptFunction::INSTR_ARGS_MASK) | GDScriptFunction::OPCODE_STORE_GLOBAL;
+			code[pos + 2] = E->value;
+		} else if (GDScriptLanguage::get_singleton()->get_named_globals_map().has(global)) {
+			int name_index = p_function->global_names.find(global);
+			if (name_index == -1) {
+				name_index = p_function->global_names.size();
+				p_function->global_names.push_back(global);
+			}
+			code[pos] = (code[pos] & GDScriptFunction::INSTR_ARGS_MASK) | GDScriptFunction::OPCODE_STORE_NAMED_GLOBAL;
+			code[pos + 2] = name_index;
+		} else {
+			return ERR_CANT_RESOLVE;
+		}
+		p_function->global_stores.push_back(pos);
+	}
+
+	int count = p_ctx.get_count();
+	p_function->operator_funcs.resize(count);
+	for (int i = 0; i < count; i++) {
+		uint32_t key = p_ctx.get_32();
+		uint32_t op = key >> 16;
+		uint32_t type_a = (key >> 8) & 0xFF;
+		uint32_t type_b = key & 0xFF;
+		if (op >= Variant::OP_MAX || type_a >= Variant::VARIANT_MAX || type_b >= Variant::VARIANT_MAX) {
+			return ERR_FILE_CORRUPT;
+		}
+		p_function->operator_funcs.write[i] = Variant::get_validated_operator_evaluator(Variant::Operator(op), Variant::Type(type_a), Variant::Type(type_b));
+		if (!p_function->operator_funcs[i]) {
+			return ERR_CANT_RESOLVE;
+		}
+	}
+
+	count = p_ctx.get_count();
+	p_function->setters.resize(count);
+	for (int i = 0; i < count; i++) {
+		Variant::Type type = Variant::Type(p_ctx.get_32());
+		StringName member = p_ctx.get_string();
+		if (type >= Variant::VARIANT_MAX || !Variant::has_member(type, member)) {
+			return ERR_CANT_RESOLVE;
+		}
+		p_function->setters.write[i] = Variant::get_member_validated_setter(type, member);
+	}
+
+	count = p_ctx.get_count();
+	p_function->getters.resize(count);
+	for (int i = 0; i < count; i++) {
+		Variant::Type type = Variant::Type(p_ctx.get_32());
+		StringName member = p_ctx.get_string();
+		if (type >= Variant::VARIANT_MAX || !Variant::has_member(type, member)) {
+			return ERR_CANT_RESOLVE;
+		}
+		p_function->getters.write[i] = Variant::get_member_validated_getter(type, member);
+	}
+
+#define LOAD_TYPE_TABLE(m_table, m_getter)                        \
+	count = p_ctx.get_count();                                    \
+	p_function->m_table.resize(count);                            \
+	for (int i = 0; i < count; i++) {                             \
+		uint32_t type = p_ctx.get_32();                           \
+		if (type >= Variant::VARIANT_MAX) {                       \
+			return ERR_FILE_CORRUPT;                              \
+		}                                                         \
+		p_function->m_table.write[i] = m_getter(Variant::Type(type)); \
+		if (!p_function->m_table[i]) {                            \
+			return ERR_CANT_RESOLVE;                              \
+		}                                                         \
+	}
+
+	LOAD_TYPE_TABLE(keyed_setters, Variant::get_member_validated_keyed_setter);
+	LOAD_TYPE_TABLE(keyed_getters, Variant::get_member_validated_keyed_getter);
+	LOAD_TYPE_TABLE(indexed_setters, Variant::get_member_validated_indexed_setter);
+	LOAD_TYPE_TABLE(indexed_getters, Variant::get_member_validated_indexed_getter);
+
+#undef LOAD_TYPE_TABLE
+
+	count = p_ctx.get_count();
+	p_function->builtin_methods.resize(count);
+	for (int i = 0; i < count; i++) {
+		Variant::Type type = Variant::Type(p_ctx.get_32());
+		StringName method = p_ctx.get_string();
+		if (type >= Variant::VARIANT_MAX || !Variant::has_builtin_method(type, method)) {
+			return ERR_CANT_RESOLVE;
+		}
+		p_function->builtin_methods.write[i] = Variant::get_validated_builtin_method(type, method);
+	}
+
+	count = p_ctx.get_count();
+	p_function->constructors.resize(count);
+	for (int i = 0; i < count; i++) {
+		Variant::Type type = Variant::Type(p_ctx.get_32());
+		int constructor = p_ctx.get_32();
+		if (type >= Variant::VARIANT_MAX || constructor < 0 || constructor >= Variant::get_constructor_count(type)) {
+			return ERR_CANT_RESOLVE;
+		}
+		p_function->constructors.write[i] = Variant::get_validated_constructor(type, constructor);
+	}
+
+	count = p_ctx.get_count();
+	p_function->utilities.resize(count);
+	for (int i = 0; i < count; i++) {
+		p_function->utilities.write[i] = Variant::get_validated_utility_function(p_ctx.get_string());
+		if (!p_function->utilities[i]) {
+			return ERR_CANT_RESOLVE;
+		}
+	}
+
+	count = p_ctx.get_count();
+	p_function->gds_utilities.resize(count);
+	for (int i = 0; i < count; i++) {
+		StringName utility = p_ctx.get_string();
+		if (!GDScriptUtilityFunctions::function_exists(utility)) {
+			return ERR_CANT_RESOLVE;
+		}
+		p_function->gds_utilities.write[i] = GDScriptUtilityFunctions::get_function(utility);
+	}
+
+	count = p_ctx.get_count();
+	p_function->methods.resize(count);
+	for (int i = 0; i < count; i++) {
+		StringName class_name = p_ctx.get_string();
+		StringName method = p_ctx.get_string();
+		p_function->methods.write[i] = ClassDB::get_method(class_name, method);
+		if (!p_function->methods[i]) {
+			return ERR_CANT_RESOLVE;
+		}
+	}
+
+	count = p_ctx.get_count();
+	for (int i = 0; i < count; i++) {
+		// Owned by the function right away, so it's freed along with it if loading fails.
+		GDScriptFunction *lambda = memnew(GDScriptFunction);
+		p_function->lambdas.push_back(lambda);
+		err = _load_function(p_ctx, p_script, lambda);
+		if (err) {
+			return err;
+		}
+	}
+
+	count = p_ctx.get_count();
+	for (int i = 0; i < count; i++) {
+		GDScriptFunction::StackDebug stack_debug;
+		stack_debug.line = p_ctx.get_32();
+		stack_debug.pos = p_ctx.get_32();
+		stack_debug.added = p_ctx.get_8();
+		stack_debug.identifier = p_ctx.get_string();
+		p_function->stack_debug.push_back(stack_debug);
+	}
+
+	if (p_ctx.failed) {
+		return ERR_FILE_CORRUPT;
+	}
+
+	_finalize_function(p_function);
+	return OK;
+}
+
+void GDScriptBytecodeCache::_finalize_function(GDScriptFunction *p_function) {
+	// Same as the end of GDScriptByteCodeGenerator::write_end().
+#ifdef DEBUG_ENABLED
+	p_function->func_cname = (String(p_function->source) + " - " + String(p_function->name)).utf8();
+	p_function->_func_cname = p_function->func_cname.get_data();
+	if (EngineDebugger::is_active()) {
+		p_function->profile.signature = String(p_function->source) + "::" + itos(p_function->_initial_line) + "::" + String(p_function->name);
+	}
+#endif
+
+	p_function->_constant_count = p_function->constants.size();
+	p_function->_constants_ptr = p_function->constants.is_empty() ? nullptr : p_function->constants.ptrw();
+	p_function->_global_names_count = p_function->global_names.size();
+	p_function->_global_names_ptr = p_function->global_names.is_empty() ? nullptr : p_function->global_names.ptr();
+	p_function->_code_size = p_function->code.size();
+	p_function->_code_ptr = p_function->code.is_empty() ? nullptr : p_function->code.ptr();
+	p_function->_default_arg_ptr = p_function->default_arguments.is_empty() ? nullptr : p_function->default_arguments.ptr();
+
+#define SET_TABLE(m_table)                                                                                 \
+	p_function->_##m_table##_count = p_function->m_table.size();                                           \
+	p_function->_##m_table##_ptr = p_function->m_table.is_empty() ? nullptr : p_function->m_table.ptrw();
+
+	SET_TABLE(operator_funcs);
+	SET_TABLE(setters);
+	SET_TABLE(getters);
+	SET_TABLE(keyed_setters);
+	SET_TABLE(keyed_getters);
+	SET_TABLE(indexed_setters);
+	SET_TABLE(indexed_getters);
+	SET_TABLE(builtin_methods);
+	SET_TABLE(constructors);
+	SET_TABLE(utilities);
+	SET_TABLE(gds_utilities);
+	SET_TABLE(methods);
+	SET_TABLE(lambdas);
+
+#undef SET_TABLE
+
+	if (p_function->_inline_caches_count) {
+		p_function->_inline_caches_ptr = memnew_arr(GDScriptInlineCache, p_function->_inline_caches_count);
+	}
+}
+
+Error GDScriptBytecodeCache::_load_class_tree(LoadContext &p_ctx, GDScript *p_script) {
+	// Same as GDScriptCompiler::_make_scripts(), all classes must exist before anything can reference them.
+	p_script->subclasses.clear();
+
+	int count = p_ctx.get_count();
+	for (int i = 0; i < count; i++) {
+		StringName name = p_ctx.get_string();
+		if (p_ctx.failed) {
+			return ERR_FILE_CORRUPT;
+		}
+
+		String fully_qualified_name = p_script->fully_qualified_name + "::" + name;
+		Ref<GDScript> subclass = GDScriptLanguage::get_singleton()->get_orphan_subclass(fully_qualified_name);
+		if (subclass.is_null()) {
+			subclass.instantiate();
+		}
+		subclass->_owner = p_script;
+		subclass->fully_qualified_name = fully_qualified_name;
+		p_script->subclasses.insert(name, subclass);
+
+		Error err = _load_class_tree(p_ctx, subclass.ptr());
+		if (err) {
+			return err;
+		}
+	}
+	return OK;
+}
+
+void GDScriptBytecodeCache::_clear_class(GDScript *p_script) {
+	p_script->native = Ref<GDScriptNativeClass>();
+	p_script->base = Ref<GDScript>();
+	p_script->_base = nullptr;
+	p_script->members.clear();
+	p_script->constants.clear();
+	GDScriptInlineCache::invalidate_all();
+	for (const KeyValue<StringName, GDScriptFunction *> &E : p_script->member_functions) {
+		memdelete(E.value);
+	}
+	if (p_script->implicit_initializer) {
+		memdelete(p_script->implicit_initializer);
+	}
+	if (p_script->implicit_ready) {
+		memdelete(p_script->implicit_ready);
+	}
+	p_script->member_functions.clear();
+	p_script->member_indices.clear();
+	p_script->member_info.clear();
+	p_script->_signals.clear();
+	p_script->initializer = nullptr;
+	p_script->implicit_initializer = nullptr;
+	p_script->implicit_ready = nullptr;
+}
+
+Error GDScriptBytecodeCache::_load_class(LoadContext &p_ctx, GDScript *p_script) {
+	Error err = OK;
+
+	_clear_class(p_script);
+
+	p_script->tool = p_ctx.get_8();
+	p_script->name = p_ctx.get_string();
+
+	Variant native;
+	Variant base;
+	bool local = false;
+	err = _load_object(p_ctx, native, local);
+	if (err) {
+		return err;
+	}
+	err = _load_object(p_ctx, base, local);
+	if (err) {
+		return err;
+	}
+	p_script->native = native;
+	p_script->base = base;
+	p_script->_base = p_script->base.ptr();
+	if (p_script->native.is_null()) {
+		return ERR_FILE_CORRUPT;
+	}
+
+	int count = p_ctx.get_count();
+	for (int i = 0; i < count; i++) {
+		p_script->members.insert(p_ctx.get_string());
+	}
+
+	count = p_ctx.get_count();
+	for (int i = 0; i < count; i++) {
+		StringName name = p_ctx.get_string();
+		GDScript::MemberInfo info;
+		info.index = p_ctx.get_32();
+		info.setter = p_ctx.get_string();
+		info.getter = p_ctx.get_string();
+		err = _load_data_type(p_ctx, info.data_type);
+		if (err) {
+			return err;
+		}
+		p_script->member_indices[name] = info;
+	}
+
+	count = p_ctx.get_count();
+	for (int i = 0; i < count; i++) {
+		StringName name = p_ctx.get_string();
+		PropertyInfo info;
+		info.type = Variant::Type(p_ctx.get_32());
+		info.name = p_ctx.get_string();
+		info.class_name = p_ctx.get_string();
+		info.hint = PropertyHint(p_ctx.get_32());
+		info.hint_string = p_ctx.get_string();
+		info.usage = p_ctx.get_32();
+		p_script->member_info[name] = info;
+	}
+
+	count = p_ctx.get_count();
+	for (int i = 0; i < count; i++) {
+		StringName name = p_ctx.get_string();
+		Variant value;
+		err = _load_variant(p_ctx, value);
+		if (err) {
+			return err;
+		}
+		p_script->constants.insert(name, value);
+	}
+
+	count = p_ctx.get_count();
+	for (int i = 0; i < count; i++) {
+		StringName name = p_ctx.get_string();
+		Vector<StringName> parameters;
+		parameters.resize(p_ctx.get_count());
+		for (int j = 0; j < parameters.size(); j++) {
+			parameters.write[j] = p_ctx.get_string();
+		}
+		p_script->_signals[name] = parameters;
+	}
+
+	count = p_ctx.get_count();
+	for (int i = 0; i < count; i++) {
+		StringName name = p_ctx.get_string();
+		if (p_ctx.failed || p_script->member_functions.has(name)) {
+			return ERR_FILE_CORRUPT;
+		}
+		GDScriptFunction *function = memnew(GDScriptFunction);
+		p_script->member_functions[name] = function;
+		err = _load_function(p_ctx, p_script, function);
+		if (err) {
+			return err;
+		}
+	}
+	HashMap<StringName, GDScriptFunction *>::Iterator initializer = p_script->member_functions.find(GDScriptLanguage::get_singleton()->strings._init);
+	if (initializer) {
+		p_script->initializer = initializer->value;
+	}
+
+	GDScriptFunction **implicit_functions[2] = { &p_script->implicit_initializer, &p_script->implicit_ready };
+	for (GDScriptFunction **function : implicit_functions) {
+		if (p_ctx.get_8()) {
+			*function = memnew(GDScriptFunction);
+			err = _load_function(p_ctx, p_script, *function);
+			if (err) {
+				return err;
+			}
+		}
+	}
+
+	for (KeyValue<StringName, Ref<GDScript>> &E : p_script->subclasses) {
+		err = _load_class(p_ctx, E.value.ptr());
+		if (err) {
+			return err;
+		}
+	}
+
+	if (p_ctx.failed) {
+		return ERR_FILE_CORRUPT;
+	}
+
+	p_script->valid = true;
+	return OK;
+}
+
+String GDScriptBytecodeCache::get_cache_path(const String &p_source_path) {
+	return p_source_path.get_basename() + ".gdc";
+}
+
+Error GDScriptBytecodeCache::save(const GDScript *p_script, Vector<uint8_t> &r_buffer) {
+	ERR_FAIL_NULL_V(p_script, ERR_INVALID_PARAMETER);
+	ERR_FAIL_COND_V_MSG(p_script->_owner, ERR_INVALID_PARAMETER, "Only outermost classes can be cached.");
+	if (!p_script->valid) {
+		return ERR_UNCONFIGURED;
+	}
+
+	SaveContext ctx;
+	ctx.root = p_script;
+	_build_reverse_tables(ctx);
+
+	ctx.put_8('G');
+	ctx.put_8('D');
+	ctx.put_8('S');
+	ctx.put_8('C');
+	ctx.put_32(FORMAT_VERSION);
+	ctx.put_string(_get_engine_fingerprint(DEBUG_BUILD));
+	ctx.put_32(p_script->source.hash());
+
+	_save_class_tree(ctx, p_script);
+	Error err = _save_class(ctx, p_script);
+	if (err) {
+		return err;
+	}
+
+	r_buffer = ctx.buffer;
+	return OK;
+}
+
+Error GDScriptBytecodeCache::load(GDScript *p_script, const Vector<uint8_t> &p_buffer, bool p_debug_build) {
+	ERR_FAIL_NULL_V(p_script, ERR_INVALID_PARAMETER);
+
+	LoadContext ctx;
+	ctx.root = p_script;
+	ctx.data = p_buffer.ptr();
+	ctx.size = p_buffer.size();
+
+	// Anything but an exact match means the cache is stale, not broken, so this fails quietly.
+	if (ctx.get_8() != 'G' || ctx.get_8() != 'D' || ctx.get_8() != 'S' || ctx.get_8() != 'C') {
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	if (ctx.get_32() != FORMAT_VERSION || ctx.get_string() != _get_engine_fingerprint(p_debug_build)) {
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	uint32_t source_hash = ctx.get_32();
+	if (!p_script->source.is_empty() && source_hash != p_script->source.hash()) {
+		return ERR_FILE_UNRECOGNIZED;
+	}
+
+	p_script->valid = false;
+	p_script->fully_qualified_name = p_script->path;
+	p_script->_owner = nullptr;
+
+	Error err = _load_class_tree(ctx, p_script);
+	if (err) {
+		return err;
+	}
+	err = _load_class(ctx, p_script);
+	if (err) {
+		p_script->valid = false;
+		return err;
+	}
+	if (ctx.pos != ctx.size) {
+		p_script->valid = false;
+		return ERR_FILE_CORRUPT;
+	}
+
+	return OK;
+}
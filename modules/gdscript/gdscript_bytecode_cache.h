@@ -0,0 +1,101 @@
+/*************************************************************************/
+/*  gdscript_bytecode_cache.h                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_BYTECODE_CACHE_H
+#define GDSCRIPT_BYTECODE_CACHE_H
+
+#include "core/templates/vector.h"
+#include "core/variant/variant.h"
+
+class GDScript;
+class GDScriptDataType;
+class GDScriptFunction;
+
+// Serializes compiled scripts, so exported projects can skip parsing, analyzing and compiling them.
+// The cache is only valid for the exact engine build and source it was made from; loading fails
+// otherwise and callers are expected to compile the source instead.
+class GDScriptBytecodeCache {
+public:
+	enum {
+		FORMAT_VERSION = 1,
+	};
+
+	// Debug builds compile line, assert and breakpoint opcodes in, so a cache only runs on the same kind of build.
+#ifdef DEBUG_ENABLED
+	static constexpr bool DEBUG_BUILD = true;
+#else
+	static constexpr bool DEBUG_BUILD = false;
+#endif
+
+private:
+	enum ObjectTag {
+		OBJECT_NULL,
+		OBJECT_GLOBAL, // Native class or singleton, by global name.
+		OBJECT_LOCAL_SCRIPT, // Class in the script being cached, by inner class names.
+		OBJECT_SCRIPT, // Class in another script, by path and inner class names.
+		OBJECT_RESOURCE, // Any other resource, by path.
+	};
+
+	enum VariantTag {
+		VARIANT_VALUE,
+		VARIANT_OBJECT,
+		VARIANT_ARRAY,
+		VARIANT_DICTIONARY,
+	};
+
+	struct SaveContext;
+	struct LoadContext;
+
+	static void _build_reverse_tables(SaveContext &p_ctx);
+
+	static Error _save_object(SaveContext &p_ctx, const Object *p_object);
+	static Error _save_variant(SaveContext &p_ctx, const Variant &p_value, int p_depth = 0);
+	static Error _save_data_type(SaveContext &p_ctx, const GDScriptDataType &p_type);
+	static Error _save_function(SaveContext &p_ctx, const GDScriptFunction *p_function);
+	static void _save_class_tree(SaveContext &p_ctx, const GDScript *p_script);
+	static Error _save_class(SaveContext &p_ctx, const GDScript *p_script);
+
+	static Error _load_object(LoadContext &p_ctx, Variant &r_object, bool &r_local);
+	static Error _load_variant(LoadContext &p_ctx, Variant &r_value, int p_depth = 0);
+	static Error _load_data_type(LoadContext &p_ctx, GDScriptDataType &r_type);
+	static Error _load_function(LoadContext &p_ctx, GDScript *p_script, GDScriptFunction *p_function);
+	static void _finalize_function(GDScriptFunction *p_function);
+	static Error _load_class_tree(LoadContext &p_ctx, GDScript *p_script);
+	static Error _load_class(LoadContext &p_ctx, GDScript *p_script);
+	static void _clear_class(GDScript *p_script);
+
+public:
+	static String get_cache_path(const String &p_source_path);
+
+	static Error save(const GDScript *p_script, Vector<uint8_t> &r_buffer);
+	static Error load(GDScript *p_script, const Vector<uint8_t> &p_buffer, bool p_debug_build = DEBUG_BUILD);
+};
+
+#endif // GDSCRIPT_BYTECODE_CACHE_H
@@ -30,10 +30,16 @@
 
 #include "gdscript_cache.h"
 
+#include "core/config/engine.h"
 #include "core/io/file_access.h"
+#include "core/object/script_language.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/os/thread.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/vector.h"
 #include "gdscript.h"
 #include "gdscript_analyzer.h"
+#include "gdscript_bytecode_cache.h"
 #include "gdscript_parser.h"
 
 bool GDScriptParserRef::is_valid() const {
@@ -206,9 +212,31 @@ Ref<GDScript> GDScriptCache::get_full_script(const String &p_path, Error &r_erro
 		return script;
 	}
 
-	r_error = script->reload();
-	if (r_error) {
-		return script;
+	// Exported projects may ship compiled scripts next to their source. Those are never used in the editor,
+	// where the source changes, and are ignored when stale.
+	bool loaded_byte_code = false;
+	if (!Engine::get_singleton()->is_editor_hint()) {
+		String cache_path = GDScriptBytecodeCache::get_cache_path(p_path);
+		loaded_byte_code = FileAccess::exists(cache_path) && script->load_byte_code(cache_path) == OK;
+	}
+
+	if (!loaded_byte_code) {
+		// Dependencies are parsed in parallel up front; analysis and compilation stay serialized below.
+		bool outermost = singleton->compile_depth == 0;
+		if (outermost && Thread::get_caller_id() == Thread::get_main_id() && WorkerThreadPool::get_singleton() && WorkerThreadPool::get_singleton()->get_thread_count() > 1) {
+			singleton->_prefetch_dependencies(p_path);
+		}
+
+		singleton->compile_depth++;
+		r_error = script->reload();
+		singleton->compile_depth--;
+
+		if (outermost) {
+			singleton->_clear_prefetched();
+		}
+		if (r_error) {
+			return script;
+		}
 	}
 
 	singleton->full_gdscript_cache[p_path] = script.ptr();
@@ -241,11 +269,110 @@ Error GDScriptCache::finish_compiling(const String &p_owner) {
 	return err;
 }
 
+void GDScriptCache::_prefetch_parse(void *p_userdata, uint32_t p_index) {
+	PrefetchJob &job = static_cast<PrefetchJob *>(p_userdata)[p_index];
+	job.source = get_source_code(job.path);
+	if (job.source.is_empty()) {
+		return;
+	}
+	job.result = job.parser->parse(job.source, job.path, false);
+}
+
+void GDScriptCache::_prefetch_dependencies(const String &p_path) {
+	// The builtin type table is built lazily, make sure workers only ever read it.
+	GDScriptParser::get_builtin_type(StringName());
+
+	HashSet<String> visited;
+	visited.insert(p_path);
+
+	LocalVector<PrefetchJob> wave;
+	wave.push_back(PrefetchJob());
+	wave[0].path = p_path;
+
+	while (!wave.is_empty()) {
+		// Parsers register their annotations on construction, so they are created here.
+		for (uint32_t i = 0; i < wave.size(); i++) {
+			wave[i].parser = memnew(GDScriptParser);
+		}
+
+		// The workers don't touch the cache, other threads can use it meanwhile.
+		WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_native_group_task(&_prefetch_parse, wave.ptr(), wave.size(), -1, true, "GDScript dependency parsing");
+		lock.unlock();
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+		lock.lock();
+
+		LocalVector<PrefetchJob> next_wave;
+		for (uint32_t i = 0; i < wave.size(); i++) {
+			PrefetchJob &job = wave[i];
+			if (job.source.is_empty()) {
+				memdelete(job.parser);
+				continue;
+			}
+
+			HashSet<String> found = job.parser->get_dependencies();
+			for (const StringName &E : job.parser->get_referenced_identifiers()) {
+				if (ScriptServer::is_global_class(E)) {
+					found.insert(ScriptServer::get_global_class_path(E));
+				}
+			}
+			for (const String &E : found) {
+				if (visited.has(E) || E.get_extension() != "gd" || full_gdscript_cache.has(E) || !FileAccess::exists(E)) {
+					continue;
+				}
+				visited.insert(E);
+				next_wave.push_back(PrefetchJob());
+				next_wave[next_wave.size() - 1].path = E;
+			}
+
+			if (parser_map.has(job.path) || prefetched_parsers.has(job.path)) {
+				memdelete(job.parser);
+			} else {
+				Ref<GDScriptParserRef> ref;
+				ref.instantiate();
+				ref->parser = job.parser;
+				ref->path = job.path;
+				ref->status = GDScriptParserRef::PARSED;
+				ref->result = job.result;
+				parser_map[job.path] = ref.ptr();
+
+				PrefetchedParser &prefetched = prefetched_parsers[job.path];
+				prefetched.ref = ref;
+				prefetched.source = job.source;
+			}
+		}
+
+		wave = next_wave;
+	}
+}
+
+void GDScriptCache::_clear_prefetched() {
+	prefetched_parsers.clear();
+}
+
+GDScriptParser *GDScriptCache::get_prefetched_parser(const String &p_path, const String &p_source, Error &r_result) {
+	MutexLock lock(singleton->lock);
+	HashMap<String, PrefetchedParser>::Iterator E = singleton->prefetched_parsers.find(p_path);
+	if (!E || E->value.source != p_source) {
+		// Not prefetched, or edited since it was read from disk.
+		return nullptr;
+	}
+
+	// Analysis only completes the tree, so analyzing it again for compilation is cheap. When analyzing it for a
+	// dependent failed though, the new analysis would clear those errors without finding them again.
+	const Ref<GDScriptParserRef> &ref = E->value.ref;
+	if (ref->status != GDScriptParserRef::PARSED && ref->result != OK) {
+		return nullptr;
+	}
+	r_result = ref->result;
+	return ref->parser;
+}
+
 GDScriptCache::GDScriptCache() {
 	singleton = this;
 }
 
 GDScriptCache::~GDScriptCache() {
+	_clear_prefetched();
 	parser_map.clear();
 	shallow_gdscript_cache.clear();
 	full_gdscript_cache.clear();
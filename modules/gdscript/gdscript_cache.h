@@ -76,6 +76,24 @@ class GDScriptCache {
 	HashMap<String, GDScript *> full_gdscript_cache;
 	HashMap<String, HashSet<String>> dependencies;
 
+	struct PrefetchJob {
+		String path;
+		String source;
+		GDScriptParser *parser = nullptr;
+		Error result = OK;
+	};
+
+	struct PrefetchedParser {
+		// Registered in parser_map for the analyzer of dependents, and compiled from by GDScript::reload.
+		Ref<GDScriptParserRef> ref;
+		String source;
+	};
+
+	// Dependencies parsed on worker threads before the outermost compilation starts.
+	// Released once that compilation ends, whether they were claimed or not.
+	HashMap<String, PrefetchedParser> prefetched_parsers;
+	int compile_depth = 0;
+
 	friend class GDScript;
 	friend class GDScriptParserRef;
 
@@ -84,6 +102,11 @@ class GDScriptCache {
 	Mutex lock;
 	static void remove_script(const String &p_path);
 
+	static void _prefetch_parse(void *p_userdata, uint32_t p_index);
+	void _prefetch_dependencies(const String &p_path);
+	void _clear_prefetched();
+	static GDScriptParser *get_prefetched_parser(const String &p_path, const String &p_source, Error &r_result);
+
 public:
 	static Ref<GDScriptParserRef> get_parser(const String &p_path, GDScriptParserRef::Status status, Error &r_error, const String &p_owner = String());
 	static String get_source_code(const String &p_path);
@@ -270,7 +270,12 @@ GDScriptCodeGenerator::Address GDScriptCompiler::_parse_expression(CodeGen &code
 			// Try class members.
 			if (_is_class_member_property(codegen, identifier)) {
 				// Get property.
-				GDScriptCodeGenerator::Address temp = codegen.add_temporary(); // TODO: Could get the type of the class member here.
+				// Native object members keep their class, so method calls on them can be bound at compile time.
+				GDScriptDataType member_type;
+				if (in->get_datatype().kind == GDScriptParser::DataType::NATIVE) {
+					member_type = _gdtype_from_datatype(in->get_datatype());
+				}
+				GDScriptCodeGenerator::Address temp = codegen.add_temporary(member_type); // TODO: Could get the type of other class members here.
 				gen->write_get_member(temp, identifier);
 				return temp;
 			}
@@ -2235,6 +2240,8 @@ Error GDScriptCompiler::_parse_class_level(GDScript *p_script, const GDScriptPar
 	p_script->_base = nullptr;
 	p_script->members.clear();
 	p_script->constants.clear();
+	// Call sites may have cached functions and member layouts of this script.
+	GDScriptInlineCache::invalidate_all();
 	for (const KeyValue<StringName, GDScriptFunction *> &E : p_script->member_functions) {
 		memdelete(E.value);
 	}
@@ -32,6 +32,245 @@
 
 #include "gdscript.h"
 
+#include "core/core_string_names.h"
+
+SafeNumeric<uint32_t> GDScriptInlineCache::epoch(1);
+
+void GDScriptInlineCache::store(const Entry &p_entry) {
+	uint32_t seq = sequence.load(std::memory_order_relaxed);
+	if ((seq & 1) || !sequence.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+		return; // Another thread is updating this site, the lookup will just be redone next time.
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+
+	// Prefer replacing an entry made stale by a recompilation, otherwise recycle the oldest one.
+	int slot = -1;
+	for (int i = 0; i < ENTRY_COUNT; i++) {
+		if (entries[i].epoch != p_entry.epoch) {
+			slot = i;
+			break;
+		}
+	}
+	if (slot == -1) {
+		slot = next_entry;
+		next_entry = (next_entry + 1) % ENTRY_COUNT;
+	}
+	entries[slot] = p_entry;
+
+	sequence.store(seq + 2, std::memory_order_release);
+}
+
+GDScriptInstance *GDScriptFunction::_get_cacheable_instance(Object *p_object, bool &r_cacheable) {
+	ScriptInstance *si = p_object->get_script_instance();
+	if (!si) {
+		r_cacheable = true;
+		return nullptr;
+	}
+	// Other languages and placeholders resolve names their own way, leave them to the uncached path.
+	r_cacheable = !si->is_placeholder() && si->get_language() == GDScriptLanguage::get_singleton();
+	return r_cacheable ? static_cast<GDScriptInstance *>(si) : nullptr;
+}
+
+bool GDScriptFunction::_call_cached(GDScriptInlineCache &p_cache, const Variant *p_base, const StringName &p_method, const Variant **p_args, int p_argcount, Variant &r_ret, Callable::CallError &r_err) {
+	if (p_base->get_type() != Variant::OBJECT) {
+		return false;
+	}
+#ifdef DEBUG_ENABLED
+	Object *obj = p_base->get_validated_object();
+#else
+	Object *obj = p_base->operator Object *();
+#endif
+	if (!obj) {
+		return false; // Let the regular path report the error.
+	}
+
+	bool cacheable = false;
+	GDScriptInstance *instance = _get_cacheable_instance(obj, cacheable);
+	if (!cacheable) {
+		return false;
+	}
+
+	const void *script = instance ? instance->script.ptr() : nullptr;
+	const void *type = obj->get_class_name().data_unique_pointer();
+	uint32_t epoch = GDScriptInlineCache::get_epoch();
+
+	GDScriptInlineCache::Entry entry;
+	if (!p_cache.lookup(script, type, epoch, entry)) {
+		// Same resolution order as Object::callp(), minus the special cases it handles by name.
+		if (p_method == CoreStringNames::get_singleton()->_free || p_method == SNAME("_ready")) {
+			return false;
+		}
+
+		entry.epoch = epoch;
+		entry.script = script;
+		entry.type = type;
+
+		for (GDScript *sptr = instance ? instance->script.ptr() : nullptr; sptr; sptr = sptr->_base) {
+			HashMap<StringName, GDScriptFunction *>::Iterator E = sptr->member_functions.find(p_method);
+			if (E) {
+				entry.kind = GDScriptInlineCache::KIND_SCRIPT_FUNCTION;
+				entry.function = E->value;
+				break;
+			}
+		}
+		if (entry.kind == GDScriptInlineCache::KIND_NONE) {
+			MethodBind *method = ClassDB::get_method(obj->get_class_name(), p_method);
+			if (!method) {
+				return false;
+			}
+			entry.kind = GDScriptInlineCache::KIND_METHOD_BIND;
+			entry.method = method;
+		}
+		p_cache.store(entry);
+	}
+
+#ifdef DEBUG_ENABLED
+	_ObjectDebugLock debug_lock(obj);
+#endif
+	r_err.error = Callable::CallError::CALL_OK;
+	switch (entry.kind) {
+		case GDScriptInlineCache::KIND_SCRIPT_FUNCTION:
+			r_ret = entry.function->call(instance, p_args, p_argcount, r_err);
+			return true;
+		case GDScriptInlineCache::KIND_METHOD_BIND:
+			r_ret = entry.method->call(obj, p_args, p_argcount, r_err);
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool GDScriptFunction::_get_named_cached(GDScriptInlineCache &p_cache, const Variant *p_base, const StringName &p_name, Variant *r_dst) {
+	GDScriptInlineCache::Entry entry;
+	uint32_t epoch = GDScriptInlineCache::get_epoch();
+
+	if (p_base->get_type() == Variant::OBJECT) {
+		Object *obj = p_base->get_validated_object();
+		if (!obj) {
+			return false;
+		}
+		bool cacheable = false;
+		GDScriptInstance *instance = _get_cacheable_instance(obj, cacheable);
+		if (!instance) {
+			return false; // Only script members are cached, native properties go through ClassDB.
+		}
+
+		const GDScript *script = instance->script.ptr();
+		if (!p_cache.lookup(script, nullptr, epoch, entry)) {
+			// Mirrors GDScriptInstance::get(), which checks members first.
+			const GDScript::MemberInfo *member = script->member_indices.getptr(p_name);
+			if (!member || member->getter) {
+				return false;
+			}
+			entry.epoch = epoch;
+			entry.script = script;
+			entry.kind = GDScriptInlineCache::KIND_SCRIPT_MEMBER;
+			entry.member_index = member->index;
+			entry.member_type = &member->data_type;
+			p_cache.store(entry);
+		}
+		if (entry.kind != GDScriptInlineCache::KIND_SCRIPT_MEMBER) {
+			return false;
+		}
+
+		if (unlikely(p_base == r_dst)) {
+			// The destination may hold the last reference to the instance.
+			Variant value = instance->members[entry.member_index];
+			*r_dst = value;
+		} else {
+			*r_dst = instance->members[entry.member_index];
+		}
+		return true;
+	}
+
+	if (p_base == r_dst) {
+		return false; // Validated getters can't read from their own destination.
+	}
+
+	const void *type = reinterpret_cast<const void *>(uintptr_t(p_base->get_type()));
+	if (!p_cache.lookup(nullptr, type, epoch, entry)) {
+		Variant::ValidatedGetter getter = Variant::get_member_validated_getter(p_base->get_type(), p_name);
+		if (!getter) {
+			return false;
+		}
+		entry.epoch = epoch;
+		entry.type = type;
+		entry.kind = GDScriptInlineCache::KIND_BUILTIN_GETTER;
+		entry.getter = getter;
+		p_cache.store(entry);
+	}
+	if (entry.kind != GDScriptInlineCache::KIND_BUILTIN_GETTER) {
+		return false;
+	}
+
+	entry.getter(p_base, r_dst);
+	return true;
+}
+
+bool GDScriptFunction::_set_named_cached(GDScriptInlineCache &p_cache, Variant *p_base, const StringName &p_name, const Variant *p_value) {
+	GDScriptInlineCache::Entry entry;
+	uint32_t epoch = GDScriptInlineCache::get_epoch();
+
+	if (p_base->get_type() == Variant::OBJECT) {
+		Object *obj = p_base->get_validated_object();
+		if (!obj) {
+			return false;
+		}
+		bool cacheable = false;
+		GDScriptInstance *instance = _get_cacheable_instance(obj, cacheable);
+		if (!instance) {
+			return false;
+		}
+
+		const GDScript *script = instance->script.ptr();
+		if (!p_cache.lookup(script, nullptr, epoch, entry)) {
+			// Mirrors GDScriptInstance::set(). Setters and typed arrays keep going through it.
+			const GDScript::MemberInfo *member = script->member_indices.getptr(p_name);
+			if (!member || member->setter || (member->data_type.builtin_type == Variant::ARRAY && member->data_type.has_container_element_type())) {
+				return false;
+			}
+			entry.epoch = epoch;
+			entry.script = script;
+			entry.kind = GDScriptInlineCache::KIND_SCRIPT_MEMBER;
+			entry.member_index = member->index;
+			entry.member_type = &member->data_type;
+			p_cache.store(entry);
+		}
+		if (entry.kind != GDScriptInlineCache::KIND_SCRIPT_MEMBER) {
+			return false;
+		}
+		if (entry.member_type->has_type && !entry.member_type->is_type(*p_value)) {
+			return false; // Needs a conversion, which the regular path does.
+		}
+
+#ifdef TOOLS_ENABLED
+		obj->mark_edited();
+#endif
+		instance->members.write[entry.member_index] = *p_value;
+		return true;
+	}
+
+	const void *type = reinterpret_cast<const void *>(uintptr_t(p_base->get_type()));
+	if (!p_cache.lookup(nullptr, type, epoch, entry)) {
+		Variant::ValidatedSetter setter = Variant::get_member_validated_setter(p_base->get_type(), p_name);
+		if (!setter) {
+			return false;
+		}
+		entry.epoch = epoch;
+		entry.type = type;
+		entry.kind = GDScriptInlineCache::KIND_BUILTIN_SETTER;
+		entry.setter = setter;
+		entry.value_type = Variant::get_member_type(p_base->get_type(), p_name);
+		p_cache.store(entry);
+	}
+	if (entry.kind != GDScriptInlineCache::KIND_BUILTIN_SETTER || p_value->get_type() != entry.value_type) {
+		return false;
+	}
+
+	entry.setter(p_base, p_value);
+	return true;
+}
+
 const int *GDScriptFunction::get_code() const {
 	return _code_ptr;
 }
@@ -153,6 +392,10 @@ GDScriptFunction::~GDScriptFunction() {
 		memdelete(lambdas[i]);
 	}
 
+	if (_inline_caches_ptr) {
+		memdelete_arr(_inline_caches_ptr);
+	}
+
 #ifdef DEBUG_ENABLED
 
 	MutexLock lock(GDScriptLanguage::get_singleton()->lock);
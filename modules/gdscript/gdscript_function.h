@@ -36,12 +36,17 @@
 #include "core/os/thread.h"
 #include "core/string/string_name.h"
 #include "core/templates/pair.h"
+#include "core/templates/safe_refcount.h"
 #include "core/templates/self_list.h"
 #include "core/variant/variant.h"
 #include "gdscript_utility_functions.h"
 
+#include <atomic>
+
 class GDScriptInstance;
 class GDScript;
+class GDScriptFunction;
+class MethodBind;
 
 class GDScriptDataType {
 private:
@@ -214,11 +219,75 @@ public:
 	}
 };
 
+// Per call site cache for named lookups on receivers whose type isn't known at compile time.
+// Entries are keyed on the receiver's script and native class (or builtin type) and all of them
+// become stale whenever a script is compiled or freed. Threads running the same function may race
+// on a site; the sequence counter makes readers fall back to the uncached path in that case.
+struct GDScriptInlineCache {
+	enum {
+		ENTRY_COUNT = 4, // Polymorphic up to this many receiver types, entries are recycled after that.
+	};
+
+	enum Kind {
+		KIND_NONE,
+		KIND_SCRIPT_FUNCTION,
+		KIND_METHOD_BIND,
+		KIND_SCRIPT_MEMBER,
+		KIND_BUILTIN_GETTER,
+		KIND_BUILTIN_SETTER,
+	};
+
+	struct Entry {
+		uint32_t epoch = 0;
+		Kind kind = KIND_NONE;
+		const void *script = nullptr;
+		const void *type = nullptr;
+		union {
+			GDScriptFunction *function = nullptr;
+			MethodBind *method;
+			const GDScriptDataType *member_type;
+			Variant::ValidatedGetter getter;
+			Variant::ValidatedSetter setter;
+		};
+		int member_index = 0;
+		Variant::Type value_type = Variant::NIL;
+	};
+
+	std::atomic<uint32_t> sequence = { 0 };
+	uint32_t next_entry = 0;
+	Entry entries[ENTRY_COUNT];
+
+	static SafeNumeric<uint32_t> epoch;
+
+	_FORCE_INLINE_ static uint32_t get_epoch() { return epoch.get(); }
+	static void invalidate_all() { epoch.increment(); }
+
+	_FORCE_INLINE_ bool lookup(const void *p_script, const void *p_type, uint32_t p_epoch, Entry &r_entry) const {
+		uint32_t seq = sequence.load(std::memory_order_acquire);
+		if (seq & 1) {
+			return false;
+		}
+		for (int i = 0; i < ENTRY_COUNT; i++) {
+			const Entry &e = entries[i];
+			if (e.epoch == p_epoch && e.script == p_script && e.type == p_type) {
+				r_entry = e;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				return sequence.load(std::memory_order_relaxed) == seq;
+			}
+		}
+		return false;
+	}
+
+	void store(const Entry &p_entry);
+};
+
 class GDScriptFunction {
 public:
 	enum Opcode {
 		OPCODE_OPERATOR,
 		OPCODE_OPERATOR_VALIDATED,
+		OPCODE_OPERATOR_INT, // Both operands int, operator inlined in the VM.
+		OPCODE_OPERATOR_FLOAT, // Both operands float, operator inlined in the VM.
 		OPCODE_EXTENDS_TEST,
 		OPCODE_IS_BUILTIN,
 		OPCODE_SET_KEYED,
@@ -233,6 +302,7 @@ public:
 		OPCODE_GET_NAMED_VALIDATED,
 		OPCODE_SET_MEMBER,
 		OPCODE_GET_MEMBER,
+		OPCODE_GET_MEMBER_CALL_METHOD_BIND, // OPCODE_GET_MEMBER whose result is the base of the following OPCODE_CALL_METHOD_BIND(_RET).
 		OPCODE_ASSIGN,
 		OPCODE_ASSIGN_TRUE,
 		OPCODE_ASSIGN_FALSE,
@@ -306,6 +376,8 @@ public:
 		OPCODE_JUMP,
 		OPCODE_JUMP_IF,
 		OPCODE_JUMP_IF_NOT,
+		OPCODE_JUMP_IF_NOT_OPERATOR_INT, // Fused OPCODE_OPERATOR_INT comparison + OPCODE_JUMP_IF_NOT.
+		OPCODE_JUMP_IF_NOT_OPERATOR_FLOAT, // Fused OPCODE_OPERATOR_FLOAT comparison + OPCODE_JUMP_IF_NOT.
 		OPCODE_JUMP_TO_DEF_ARGUMENT,
 		OPCODE_JUMP_IF_SHARED,
 		OPCODE_RETURN,
@@ -430,6 +502,7 @@ public:
 	};
 
 private:
+	friend class GDScriptBytecodeCache;
 	friend class GDScriptCompiler;
 	friend class GDScriptByteCodeGenerator;
 
@@ -468,10 +541,13 @@ private:
 	MethodBind **_methods_ptr = nullptr;
 	int _lambdas_count = 0;
 	GDScriptFunction **_lambdas_ptr = nullptr;
+	int _inline_caches_count = 0;
+	GDScriptInlineCache *_inline_caches_ptr = nullptr;
 	const int *_code_ptr = nullptr;
 	int _code_size = 0;
 	int _argument_count = 0;
 	int _stack_size = 0;
+	int _typed_stack_start = 0; // Typed temporaries live in [_typed_stack_start, _stack_size).
 	int _instruction_args_size = 0;
 	int _ptrcall_args_size = 0;
 
@@ -502,7 +578,8 @@ private:
 	Vector<GDScriptDataType> argument_types;
 	GDScriptDataType return_type;
 
-	HashMap<int, Variant::Type> temporary_slots;
+	Vector<Variant::Type> typed_temporary_slots;
+	Vector<int> global_stores; // Code positions of global loads, their operands are only valid in this run.
 
 #ifdef TOOLS_ENABLED
 	Vector<StringName> arg_names;
@@ -516,6 +593,11 @@ private:
 	_FORCE_INLINE_ Variant *_get_variant(int p_address, GDScriptInstance *p_instance, Variant *p_stack, String &r_error) const;
 	_FORCE_INLINE_ String _get_call_error(const Callable::CallError &p_err, const String &p_where, const Variant **argptrs) const;
 
+	static GDScriptInstance *_get_cacheable_instance(Object *p_object, bool &r_cacheable);
+	static bool _call_cached(GDScriptInlineCache &p_cache, const Variant *p_base, const StringName &p_method, const Variant **p_args, int p_argcount, Variant &r_ret, Callable::CallError &r_err);
+	static bool _get_named_cached(GDScriptInlineCache &p_cache, const Variant *p_base, const StringName &p_name, Variant *r_dst);
+	static bool _set_named_cached(GDScriptInlineCache &p_cache, Variant *p_base, const StringName &p_name, const Variant *p_value);
+
 	friend class GDScriptLanguage;
 
 	SelfList<GDScriptFunction> function_list{ this };
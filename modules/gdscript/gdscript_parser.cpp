@@ -167,6 +167,19 @@ void GDScriptParser::clear() {
 	errors.clear();
 	multiline_stack.clear();
 	nodes_in_progress.clear();
+	depended_paths.clear();
+	referenced_identifiers.clear();
+}
+
+void GDScriptParser::add_dependency(const String &p_path) {
+	if (p_path.is_empty()) {
+		return;
+	}
+	String path = p_path;
+	if (path.is_relative_path()) {
+		path = script_path.get_base_dir().path_join(path);
+	}
+	depended_paths.insert(path.simplify_path());
 }
 
 void GDScriptParser::push_error(const String &p_message, const Node *p_origin) {
@@ -705,6 +718,7 @@ void GDScriptParser::parse_extends() {
 			push_error(vformat(R"(Only strings or identifiers can be used after "extends", found "%s" instead.)", Variant::get_type_name(previous.literal.get_type())));
 		}
 		current_class->extends_path = previous.literal;
+		add_dependency(current_class->extends_path);
 
 		if (!match(GDScriptTokenizer::Token::PERIOD)) {
 			return;
@@ -717,6 +731,7 @@ void GDScriptParser::parse_extends() {
 		return;
 	}
 	current_class->extends.push_back(previous.literal);
+	referenced_identifiers.insert(previous.literal);
 
 	while (match(GDScriptTokenizer::Token::PERIOD)) {
 		make_completion_context(COMPLETION_INHERIT_TYPE, current_class, chain_index++);
@@ -2263,6 +2278,8 @@ GDScriptParser::ExpressionNode *GDScriptParser::parse_identifier(ExpressionNode
 			case SuiteNode::Local::UNDEFINED:
 				ERR_FAIL_V_MSG(nullptr, "Undefined local found.");
 		}
+	} else {
+		referenced_identifiers.insert(identifier->name);
 	}
 
 	return identifier;
@@ -3062,6 +3079,8 @@ GDScriptParser::ExpressionNode *GDScriptParser::parse_preload(ExpressionNode *p_
 
 	if (preload->path == nullptr) {
 		push_error(R"(Expected resource path after "(".)");
+	} else if (preload->path->type == Node::LITERAL && static_cast<LiteralNode *>(preload->path)->value.get_type() == Variant::STRING) {
+		add_dependency(static_cast<LiteralNode *>(preload->path)->value);
 	}
 
 	pop_completion_call();
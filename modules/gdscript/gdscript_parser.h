@@ -1222,6 +1222,10 @@ private:
 	ClassNode *head = nullptr;
 	Node *list = nullptr;
 	List<ParserError> errors;
+
+	// What this script refers to, gathered while parsing so dependencies can be found before analysis.
+	HashSet<String> depended_paths;
+	HashSet<StringName> referenced_identifiers;
 #ifdef DEBUG_ENABLED
 	List<GDScriptWarning> warnings;
 	HashSet<String> ignored_warnings;
@@ -1320,6 +1324,7 @@ private:
 	}
 	void clear();
 	void push_error(const String &p_message, const Node *p_origin = nullptr);
+	void add_dependency(const String &p_path);
 #ifdef DEBUG_ENABLED
 	void push_warning(const Node *p_source, GDScriptWarning::Code p_code, const String &p_symbol1 = String(), const String &p_symbol2 = String(), const String &p_symbol3 = String(), const String &p_symbol4 = String());
 	void push_warning(const Node *p_source, GDScriptWarning::Code p_code, const Vector<String> &p_symbols);
@@ -1436,10 +1441,10 @@ public:
 	bool annotation_exists(const String &p_annotation_name) const;
 
 	const List<ParserError> &get_errors() const { return errors; }
-	const List<String> get_dependencies() const {
-		// TODO: Keep track of deps.
-		return List<String>();
-	}
+	// Literal paths used by `extends` and `preload()`, resolved against the script path.
+	const HashSet<String> &get_dependencies() const { return depended_paths; }
+	// Non-local identifiers, some of which may name global classes.
+	const HashSet<StringName> &get_referenced_identifiers() const { return referenced_identifiers; }
 #ifdef DEBUG_ENABLED
 	const List<GDScriptWarning> &get_warnings() const { return warnings; }
 	const HashSet<int> &get_unsafe_lines() const { return unsafe_lines; }
@@ -227,11 +227,99 @@ void (*type_init_function_table[])(Variant *) = {
 	&VariantInitializer<PackedColorArray>::init, // PACKED_COLOR_ARRAY.
 };
 
+// Inlined evaluation of the operators the compiler emits OPCODE_OPERATOR_INT and
+// OPCODE_OPERATOR_FLOAT for (see GDScriptByteCodeGenerator::write_binary_operator()),
+// other operators are never emitted for those opcodes.
+template <class T>
+static _FORCE_INLINE_ bool _typed_comparison(Variant::Operator p_op, T p_left, T p_right) {
+	switch (p_op) {
+		case Variant::OP_EQUAL:
+			return p_left == p_right;
+		case Variant::OP_NOT_EQUAL:
+			return p_left != p_right;
+		case Variant::OP_LESS:
+			return p_left < p_right;
+		case Variant::OP_LESS_EQUAL:
+			return p_left <= p_right;
+		case Variant::OP_GREATER:
+			return p_left > p_right;
+		case Variant::OP_GREATER_EQUAL:
+			return p_left >= p_right;
+		default:
+			return false;
+	}
+}
+
+template <class T>
+static _FORCE_INLINE_ bool _typed_arithmetic(Variant::Operator p_op, T p_left, T p_right, T &r_result);
+
+template <>
+_FORCE_INLINE_ bool _typed_arithmetic<int64_t>(Variant::Operator p_op, int64_t p_left, int64_t p_right, int64_t &r_result) {
+	switch (p_op) {
+		case Variant::OP_ADD:
+			r_result = p_left + p_right;
+			return true;
+		case Variant::OP_SUBTRACT:
+			r_result = p_left - p_right;
+			return true;
+		case Variant::OP_MULTIPLY:
+			r_result = p_left * p_right;
+			return true;
+		case Variant::OP_BIT_AND:
+			r_result = p_left & p_right;
+			return true;
+		case Variant::OP_BIT_OR:
+			r_result = p_left | p_right;
+			return true;
+		case Variant::OP_BIT_XOR:
+			r_result = p_left ^ p_right;
+			return true;
+		default:
+			return false;
+	}
+}
+
+template <>
+_FORCE_INLINE_ bool _typed_arithmetic<double>(Variant::Operator p_op, double p_left, double p_right, double &r_result) {
+	switch (p_op) {
+		case Variant::OP_ADD:
+			r_result = p_left + p_right;
+			return true;
+		case Variant::OP_SUBTRACT:
+			r_result = p_left - p_right;
+			return true;
+		case Variant::OP_MULTIPLY:
+			r_result = p_left * p_right;
+			return true;
+		case Variant::OP_DIVIDE:
+			r_result = p_left / p_right;
+			return true;
+		default:
+			return false;
+	}
+}
+
+template <class T>
+static _FORCE_INLINE_ void _typed_operator(Variant::Operator p_op, const Variant *p_left, const Variant *p_right, Variant *r_dst) {
+	const T left = *VariantGetInternalPtr<T>::get_ptr(p_left);
+	const T right = *VariantGetInternalPtr<T>::get_ptr(p_right);
+	T result;
+	if (_typed_arithmetic<T>(p_op, left, right, result)) {
+		VariantTypeChanger<T>::change(r_dst);
+		*VariantGetInternalPtr<T>::get_ptr(r_dst) = result;
+	} else {
+		VariantTypeChanger<bool>::change(r_dst);
+		*VariantInternal::get_bool(r_dst) = _typed_comparison<T>(p_op, left, right);
+	}
+}
+
 #if defined(__GNUC__)
 #define OPCODES_TABLE                                \
 	static const void *switch_table_ops[] = {        \
 		&&OPCODE_OPERATOR,                           \
 		&&OPCODE_OPERATOR_VALIDATED,                 \
+		&&OPCODE_OPERATOR_INT,                       \
+		&&OPCODE_OPERATOR_FLOAT,                     \
 		&&OPCODE_EXTENDS_TEST,                       \
 		&&OPCODE_IS_BUILTIN,                         \
 		&&OPCODE_SET_KEYED,                          \
@@ -246,6 +334,7 @@ void (*type_init_function_table[])(Variant *) = {
 		&&OPCODE_GET_NAMED_VALIDATED,                \
 		&&OPCODE_SET_MEMBER,                         \
 		&&OPCODE_GET_MEMBER,                         \
+		&&OPCODE_GET_MEMBER_CALL_METHOD_BIND,        \
 		&&OPCODE_ASSIGN,                             \
 		&&OPCODE_ASSIGN_TRUE,                        \
 		&&OPCODE_ASSIGN_FALSE,                       \
@@ -318,6 +407,8 @@ void (*type_init_function_table[])(Variant *) = {
 		&&OPCODE_JUMP,                               \
 		&&OPCODE_JUMP_IF,                            \
 		&&OPCODE_JUMP_IF_NOT,                        \
+		&&OPCODE_JUMP_IF_NOT_OPERATOR_INT,           \
+		&&OPCODE_JUMP_IF_NOT_OPERATOR_FLOAT,         \
 		&&OPCODE_JUMP_TO_DEF_ARGUMENT,               \
 		&&OPCODE_JUMP_IF_SHARED,                     \
 		&&OPCODE_RETURN,                             \
@@ -557,9 +648,14 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				memnew_placement(&stack[i + 3], Variant(*p_args[i]));
 			}
 		}
-		for (int i = p_argcount + 3; i < _stack_size; i++) {
+		for (int i = p_argcount + 3; i < _typed_stack_start; i++) {
 			memnew_placement(&stack[i], Variant);
 		}
+		// Typed temporaries are initialized straight to their type, without being constructed as null first.
+		const Variant::Type *typed_slots = typed_temporary_slots.ptr();
+		for (int i = _typed_stack_start; i < _stack_size; i++) {
+			type_init_function_table[typed_slots[i - _typed_stack_start]](&stack[i]);
+		}
 
 		if (_instruction_args_size) {
 			instruction_args = (Variant **)&aptr[sizeof(Variant) * _stack_size];
@@ -567,9 +663,6 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			instruction_args = nullptr;
 		}
 
-		for (const KeyValue<int, Variant::Type> &E : temporary_slots) {
-			type_init_function_table[E.value](&stack[E.key]);
-		}
 	}
 
 	if (_ptrcall_args_size) {
@@ -706,6 +799,32 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_OPERATOR_INT) {
+				CHECK_SPACE(5);
+
+				GET_INSTRUCTION_ARG(a, 0);
+				GET_INSTRUCTION_ARG(b, 1);
+				GET_INSTRUCTION_ARG(dst, 2);
+
+				_typed_operator<int64_t>((Variant::Operator)_code_ptr[ip + 4], a, b, dst);
+
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_OPERATOR_FLOAT) {
+				CHECK_SPACE(5);
+
+				GET_INSTRUCTION_ARG(a, 0);
+				GET_INSTRUCTION_ARG(b, 1);
+				GET_INSTRUCTION_ARG(dst, 2);
+
+				_typed_operator<double>((Variant::Operator)_code_ptr[ip + 4], a, b, dst);
+
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_EXTENDS_TEST) {
 				CHECK_SPACE(4);
 
@@ -984,7 +1103,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_SET_NAMED) {
-				CHECK_SPACE(3);
+				CHECK_SPACE(4);
 
 				GET_INSTRUCTION_ARG(dst, 0);
 				GET_INSTRUCTION_ARG(value, 1);
@@ -994,17 +1113,22 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
-				bool valid;
-				dst->set_named(*index, *value, valid);
+				int cache_idx = _code_ptr[ip + 4];
+				GD_ERR_BREAK(cache_idx < 0 || cache_idx >= _inline_caches_count);
+
+				if (!_set_named_cached(_inline_caches_ptr[cache_idx], dst, *index, value)) {
+					bool valid;
+					dst->set_named(*index, *value, valid);
 
 #ifdef DEBUG_ENABLED
-				if (!valid) {
-					String err_type;
-					err_text = "Invalid set index '" + String(*index) + "' (on base: '" + _get_var_type(dst) + "') with value of type '" + _get_var_type(value) + "'.";
-					OPCODE_BREAK;
-				}
+					if (!valid) {
+						String err_type;
+						err_text = "Invalid set index '" + String(*index) + "' (on base: '" + _get_var_type(dst) + "') with value of type '" + _get_var_type(value) + "'.";
+						OPCODE_BREAK;
+					}
 #endif
-				ip += 4;
+				}
+				ip += 5;
 			}
 			DISPATCH_OPCODE;
 
@@ -1024,7 +1148,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_GET_NAMED) {
-				CHECK_SPACE(4);
+				CHECK_SPACE(5);
 
 				GET_INSTRUCTION_ARG(src, 0);
 				GET_INSTRUCTION_ARG(dst, 1);
@@ -1034,22 +1158,27 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
-				bool valid;
+				int cache_idx = _code_ptr[ip + 4];
+				GD_ERR_BREAK(cache_idx < 0 || cache_idx >= _inline_caches_count);
+
+				if (!_get_named_cached(_inline_caches_ptr[cache_idx], src, *index, dst)) {
+					bool valid;
 #ifdef DEBUG_ENABLED
-				//allow better error message in cases where src and dst are the same stack position
-				Variant ret = src->get_named(*index, valid);
+					//allow better error message in cases where src and dst are the same stack position
+					Variant ret = src->get_named(*index, valid);
 
 #else
-				*dst = src->get_named(*index, valid);
+					*dst = src->get_named(*index, valid);
 #endif
 #ifdef DEBUG_ENABLED
-				if (!valid) {
-					err_text = "Invalid get index '" + index->operator String() + "' (on base: '" + _get_var_type(src) + "').";
-					OPCODE_BREAK;
-				}
-				*dst = ret;
+					if (!valid) {
+						err_text = "Invalid get index '" + index->operator String() + "' (on base: '" + _get_var_type(src) + "').";
+						OPCODE_BREAK;
+					}
+					*dst = ret;
 #endif
-				ip += 4;
+				}
+				ip += 5;
 			}
 			DISPATCH_OPCODE;
 
@@ -1111,6 +1240,34 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_GET_MEMBER_CALL_METHOD_BIND) {
+				CHECK_SPACE(3);
+				GET_INSTRUCTION_ARG(dst, 0);
+				int indexname = _code_ptr[ip + 2];
+				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
+				const StringName *index = &_global_names_ptr[indexname];
+#ifndef DEBUG_ENABLED
+				ClassDB::get_property(p_instance->owner, *index, *dst);
+#else
+				bool ok = ClassDB::get_property(p_instance->owner, *index, *dst);
+				if (!ok) {
+					err_text = "Internal error getting property: " + String(*index);
+					OPCODE_BREAK;
+				}
+#endif
+				ip += 3;
+
+				// The call follows right away, so load its arguments and enter it without going through dispatch.
+				CHECK_SPACE(1);
+				GD_ERR_BREAK((_code_ptr[ip] & INSTR_MASK) != OPCODE_CALL_METHOD_BIND && (_code_ptr[ip] & INSTR_MASK) != OPCODE_CALL_METHOD_BIND_RET);
+				instr_arg_count = ((_code_ptr[ip]) & INSTR_ARGS_MASK) >> INSTR_BITS;
+				for (int i = 0; i < instr_arg_count; i++) {
+					GET_VARIANT_PTR(v, i + 1);
+					instruction_args[i] = v;
+				}
+			}
+			goto call_method_bind;
+
 			OPCODE(OPCODE_ASSIGN) {
 				CHECK_SPACE(3);
 				GET_INSTRUCTION_ARG(dst, 0);
@@ -1504,7 +1661,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_CALL_ASYNC)
 			OPCODE(OPCODE_CALL_RETURN)
 			OPCODE(OPCODE_CALL) {
-				CHECK_SPACE(3 + instr_arg_count);
+				CHECK_SPACE(4 + instr_arg_count);
 				bool call_ret = (_code_ptr[ip] & INSTR_MASK) != OPCODE_CALL;
 #ifdef DEBUG_ENABLED
 				bool call_async = (_code_ptr[ip] & INSTR_MASK) == OPCODE_CALL_ASYNC;
@@ -1519,6 +1676,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GD_ERR_BREAK(methodname_idx < 0 || methodname_idx >= _global_names_count);
 				const StringName *methodname = &_global_names_ptr[methodname_idx];
 
+				int cache_idx = _code_ptr[ip + 3];
+				GD_ERR_BREAK(cache_idx < 0 || cache_idx >= _inline_caches_count);
+				GDScriptInlineCache &cache = _inline_caches_ptr[cache_idx];
+
 				GET_INSTRUCTION_ARG(base, argc);
 				Variant **argptrs = instruction_args;
 
@@ -1533,7 +1694,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				Callable::CallError err;
 				if (call_ret) {
 					GET_INSTRUCTION_ARG(ret, argc + 1);
-					base->callp(*methodname, (const Variant **)argptrs, argc, *ret, err);
+					if (!_call_cached(cache, base, *methodname, (const Variant **)argptrs, argc, *ret, err)) {
+						base->callp(*methodname, (const Variant **)argptrs, argc, *ret, err);
+					}
 #ifdef DEBUG_ENABLED
 					if (!call_async && ret->get_type() == Variant::OBJECT) {
 						// Check if getting a function state without await.
@@ -1552,7 +1715,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 #endif
 				} else {
 					Variant ret;
-					base->callp(*methodname, (const Variant **)argptrs, argc, ret, err);
+					if (!_call_cached(cache, base, *methodname, (const Variant **)argptrs, argc, ret, err)) {
+						base->callp(*methodname, (const Variant **)argptrs, argc, ret, err);
+					}
 				}
 #ifdef DEBUG_ENABLED
 				if (GDScriptLanguage::get_singleton()->profiling) {
@@ -1597,12 +1762,13 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				}
 #endif
 
-				ip += 3;
+				ip += 4;
 			}
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_CALL_METHOD_BIND)
 			OPCODE(OPCODE_CALL_METHOD_BIND_RET) {
+			call_method_bind:
 				CHECK_SPACE(3 + instr_arg_count);
 				bool call_ret = (_code_ptr[ip] & INSTR_MASK) == OPCODE_CALL_METHOD_BIND_RET;
 
@@ -2369,6 +2535,52 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_JUMP_IF_NOT_OPERATOR_INT) {
+				CHECK_SPACE(6);
+
+				GET_INSTRUCTION_ARG(a, 0);
+				GET_INSTRUCTION_ARG(b, 1);
+				GET_INSTRUCTION_ARG(dst, 2);
+
+				bool result = _typed_comparison<int64_t>((Variant::Operator)_code_ptr[ip + 4], *VariantInternal::get_int(a), *VariantInternal::get_int(b));
+
+				// The comparison result is still stored, as the compiler may read it afterwards.
+				VariantTypeChanger<bool>::change(dst);
+				*VariantInternal::get_bool(dst) = result;
+
+				if (!result) {
+					int to = _code_ptr[ip + 5];
+					GD_ERR_BREAK(to < 0 || to > _code_size);
+					ip = to;
+				} else {
+					ip += 6;
+				}
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_JUMP_IF_NOT_OPERATOR_FLOAT) {
+				CHECK_SPACE(6);
+
+				GET_INSTRUCTION_ARG(a, 0);
+				GET_INSTRUCTION_ARG(b, 1);
+				GET_INSTRUCTION_ARG(dst, 2);
+
+				bool result = _typed_comparison<double>((Variant::Operator)_code_ptr[ip + 4], *VariantInternal::get_float(a), *VariantInternal::get_float(b));
+
+				// The comparison result is still stored, as the compiler may read it afterwards.
+				VariantTypeChanger<bool>::change(dst);
+				*VariantInternal::get_bool(dst) = result;
+
+				if (!result) {
+					int to = _code_ptr[ip + 5];
+					GD_ERR_BREAK(to < 0 || to > _code_size);
+					ip = to;
+				} else {
+					ip += 6;
+				}
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_JUMP_TO_DEF_ARGUMENT) {
 				CHECK_SPACE(2);
 				ip = _default_arg_ptr[defarg];
@@ -36,6 +36,7 @@
 #include "core/io/resource_loader.h"
 #include "gdscript.h"
 #include "gdscript_analyzer.h"
+#include "gdscript_bytecode_cache.h"
 #include "gdscript_cache.h"
 #include "gdscript_tokenizer.h"
 #include "gdscript_utility_functions.h"
@@ -85,8 +86,25 @@ public:
 			return;
 		}
 
-		// TODO: Re-add compiled GDScript on export.
-		return;
+		// The cache has the debug opcodes this build compiles in, which builds of the other kind reject.
+		if (p_features.has(GDScriptBytecodeCache::DEBUG_BUILD ? "release" : "debug")) {
+			return;
+		}
+
+		// The source is exported as well, the compiled form is only a cache of it. Other scripts still
+		// analyze it when they are compiled, and it's used instead if the cache turns out to be stale.
+		Ref<GDScript> script = ResourceLoader::load(p_path, "GDScript");
+		if (script.is_null() || !script->is_valid()) {
+			return;
+		}
+
+		Vector<uint8_t> byte_code;
+		Error err = GDScriptBytecodeCache::save(script.ptr(), byte_code);
+		if (err == OK) {
+			add_file(GDScriptBytecodeCache::get_cache_path(p_path), byte_code, false);
+		} else {
+			print_verbose("GDScript: Not exporting '" + p_path + "' compiled, it references data that can't be cached.");
+		}
 	}
 
 	virtual String _get_name() const override { return "GDScript"; }
@@ -31,7 +31,14 @@
 #ifndef GDSCRIPT_TEST_RUNNER_SUITE_H
 #define GDSCRIPT_TEST_RUNNER_SUITE_H
 
+#include "../gdscript_bytecode_cache.h"
+#include "../gdscript_cache.h"
 #include "gdscript_test_runner.h"
+
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+#include "core/os/os.h"
+#include "scene/main/node.h"
 #include "tests/test_macros.h"
 
 namespace GDScriptTests {
@@ -69,6 +76,263 @@ func _init():
 	CHECK_MESSAGE(int(ref_counted->get_meta("result")) == 42, "The script should assign object metadata successfully.");
 }
 
+TEST_CASE("[Modules][GDScript] Load compiled bytecode cache and run it") {
+	Ref<GDScript> gdscript = memnew(GDScript);
+	gdscript->set_source_code(R"(
+extends RefCounted
+
+const OFFSETS = [1, 2, 3]
+
+class Counter:
+	var value := 0
+
+	func add(amount: int) -> int:
+		value += amount
+		return value
+
+var total: int = 10
+
+func _init():
+	var counter := Counter.new()
+	for offset in OFFSETS:
+		counter.add(offset * 2)
+	var scale := func(x): return x * 1.5
+	var text := "%d" % counter.value
+	total += int(scale.call(counter.value)) + text.length() + absi(-3) + len(OFFSETS)
+	total += int(Vector2(3, 4).length())
+	set_meta("result", total)
+)");
+	ERR_PRINT_OFF;
+	const Error error = gdscript->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The script should compile successfully.");
+
+	const Vector<uint8_t> byte_code = gdscript->get_as_byte_code();
+	REQUIRE_MESSAGE(!byte_code.is_empty(), "The compiled script should be serializable.");
+
+	Ref<GDScript> cached = memnew(GDScript);
+	CHECK_MESSAGE(GDScriptBytecodeCache::load(cached.ptr(), byte_code) == OK, "The cache should load without the source.");
+	CHECK(cached->is_valid());
+	CHECK(cached->get_subclasses().has("Counter"));
+
+	Ref<RefCounted> ref_counted = memnew(RefCounted);
+	ref_counted->set_script(cached);
+	CHECK_MESSAGE(int(ref_counted->get_meta("result")) == 41, "The cached script should run like the compiled one.");
+
+	Ref<GDScript> other_source = memnew(GDScript);
+	other_source->set_source_code("extends RefCounted\n");
+	CHECK_MESSAGE(GDScriptBytecodeCache::load(other_source.ptr(), byte_code) == ERR_FILE_UNRECOGNIZED, "A cache made from a different source should be rejected.");
+
+	Vector<uint8_t> other_format = byte_code;
+	other_format.write[4] += 1;
+	Ref<GDScript> other_format_script = memnew(GDScript);
+	CHECK_MESSAGE(GDScriptBytecodeCache::load(other_format_script.ptr(), other_format) == ERR_FILE_UNRECOGNIZED, "A cache in another format version should be rejected.");
+	CHECK_FALSE(other_format_script->is_valid());
+
+	Ref<GDScript> other_build_script = memnew(GDScript);
+	CHECK_MESSAGE(GDScriptBytecodeCache::load(other_build_script.ptr(), byte_code, !GDScriptBytecodeCache::DEBUG_BUILD) == ERR_FILE_UNRECOGNIZED, "A cache made by a debug build should be rejected by a release build, and the other way around.");
+	CHECK_FALSE(other_build_script->is_valid());
+}
+
+TEST_CASE("[Modules][GDScript][Benchmark] Load hundreds of interdependent scripts" * doctest::skip()) {
+	const int script_count = 500;
+	const String dir = OS::get_singleton()->get_cache_path().path_join("gdscript_dependency_benchmark");
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	REQUIRE(da->make_dir_recursive(dir) == OK);
+
+	// Every script preloads two others, forming a tree rooted at the first one, and has some body to parse.
+	for (int i = 0; i < script_count; i++) {
+		String source = "extends RefCounted\n\n";
+		for (int child = i * 2 + 1; child <= i * 2 + 2 && child < script_count; child++) {
+			source += vformat("const Child%d = preload(\"script_%d.gd\")\n", child, child);
+		}
+		for (int f = 0; f < 20; f++) {
+			source += vformat("\nfunc method_%d(a: int, b: float) -> float:\n\tvar total := 0.0\n\tfor i in range(a):\n\t\ttotal += i * b + %d\n\treturn total\n", f, f);
+		}
+		Ref<FileAccess> file = FileAccess::open(dir.path_join(vformat("script_%d.gd", i)), FileAccess::WRITE);
+		REQUIRE(file.is_valid());
+		file->store_string(source);
+	}
+
+	const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	Error err = OK;
+	Ref<GDScript> root = GDScriptCache::get_full_script(dir.path_join("script_0.gd"), err);
+	const uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+	CHECK(err == OK);
+	REQUIRE(root.is_valid());
+	CHECK(root->is_valid());
+	print_line(vformat("Loaded %d interdependent scripts in %d ms.", script_count, elapsed / 1000));
+
+	root.unref();
+	for (int i = 0; i < script_count; i++) {
+		da->remove(dir.path_join(vformat("script_%d.gd", i)));
+	}
+	da->remove(dir);
+}
+
+TEST_CASE("[Modules][GDScript] Inline caches are invalidated when a script is reloaded") {
+	Ref<GDScript> caller_script = memnew(GDScript);
+	caller_script->set_source_code(R"(
+extends RefCounted
+
+func read(target):
+	return target.value
+
+func write(target, value):
+	target.value = value
+)");
+	ERR_PRINT_OFF;
+	Error error = caller_script->reload();
+	ERR_PRINT_ON;
+	REQUIRE(error == OK);
+	Ref<RefCounted> caller = memnew(RefCounted);
+	caller->set_script(caller_script);
+
+	Ref<GDScript> target_script = memnew(GDScript);
+	target_script->set_source_code(R"(
+extends RefCounted
+
+var value = 1
+)");
+	ERR_PRINT_OFF;
+	error = target_script->reload();
+	ERR_PRINT_ON;
+	REQUIRE(error == OK);
+
+	Ref<RefCounted> target = memnew(RefCounted);
+	target->set_script(target_script);
+	// Twice, so the second access of each site goes through its cache.
+	CHECK(int(caller->call(SNAME("read"), target)) == 1);
+	CHECK(int(caller->call(SNAME("read"), target)) == 1);
+#ifdef TOOLS_ENABLED
+	const uint32_t edited_version = target->get_edited_version();
+#endif
+	caller->call(SNAME("write"), target, 3);
+	caller->call(SNAME("write"), target, 4);
+	CHECK(int(target->get("value")) == 4);
+#ifdef TOOLS_ENABLED
+	CHECK_MESSAGE(target->is_edited(), "Cached sets should flag the object as edited, like Object::set().");
+	CHECK_MESSAGE(target->get_edited_version() == edited_version, "Cached sets should not bump the edited version, like Object::set().");
+#endif
+	target.unref();
+
+	// Same script object, but `value` moves to another member index.
+	target_script->set_source_code(R"(
+extends RefCounted
+
+var other = 5
+var value = 2
+)");
+	ERR_PRINT_OFF;
+	error = target_script->reload();
+	ERR_PRINT_ON;
+	REQUIRE(error == OK);
+
+	target.instantiate();
+	target->set_script(target_script);
+	CHECK_MESSAGE(int(caller->call(SNAME("read"), target)) == 2, "A get cached before the reload should not use the old member index.");
+	caller->call(SNAME("write"), target, 6);
+	CHECK_MESSAGE(int(target->get("value")) == 6, "A set cached before the reload should not use the old member index.");
+	CHECK(int(target->get("other")) == 5);
+}
+
+// Runs the `run()` method of a script extending Node and prints how long it took.
+static void run_script_benchmark(const String &p_name, const String &p_source) {
+	Ref<GDScript> gdscript = memnew(GDScript);
+	gdscript->set_source_code(p_source);
+	ERR_PRINT_OFF;
+	const Error error = gdscript->reload();
+	ERR_PRINT_ON;
+	REQUIRE_MESSAGE(error == OK, "The benchmark script should parse successfully.");
+
+	Node *node = memnew(Node);
+	node->set_script(gdscript);
+	const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	const Variant result = node->call(SNAME("run"));
+	const uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+	CHECK(result.get_type() != Variant::NIL);
+	print_line(vformat("%s: %d ms (result: %s).", p_name, elapsed / 1000, result));
+	memdelete(node);
+}
+
+TEST_CASE("[Modules][GDScript][Benchmark] Tight loops" * doctest::skip()) {
+	run_script_benchmark("Tight loops", R"(
+extends Node
+
+func run():
+	var total := 0
+	for i in 5000000:
+		total += i % 7
+	var j := 0
+	while j < 5000000:
+		if j & 1 == 0:
+			total -= 1
+		j += 1
+	return total
+)");
+}
+
+TEST_CASE("[Modules][GDScript][Benchmark] Vector math" * doctest::skip()) {
+	run_script_benchmark("Vector math", R"(
+extends Node
+
+func run():
+	var position := Vector2()
+	var velocity := Vector2(1.5, -0.5)
+	var point := Vector3(1, 2, 3)
+	var axis := Vector3(0, 1, 0)
+	for i in 1000000:
+		velocity = velocity * 0.99 + Vector2(0.01, 0.02)
+		position += velocity
+		point = point.cross(axis) + point * 0.5
+		point = point.normalized()
+	return position.length() + point.dot(axis)
+)");
+}
+
+TEST_CASE("[Modules][GDScript][Benchmark] Array iteration" * doctest::skip()) {
+	run_script_benchmark("Array iteration", R"(
+extends Node
+
+func run():
+	var values := []
+	for i in 1000000:
+		values.push_back(i)
+	var total := 0
+	for value in values:
+		total += value
+	for i in values.size():
+		total -= values[i] >> 1
+	var ints: Array[int] = []
+	ints.resize(1000000)
+	for i in ints.size():
+		ints[i] = i * 2
+	for value in ints:
+		total += value
+	return total
+)");
+}
+
+TEST_CASE("[Modules][GDScript][Benchmark] Method calls on native members" * doctest::skip()) {
+	run_script_benchmark("Method calls on native members", R"(
+extends Node
+
+func run():
+	var parent := Node.new()
+	parent.add_child(self)
+	owner = parent
+	var total := 0
+	for i in 1000000:
+		total += owner.get_child_count()
+		if owner.has_method("get_child_count"):
+			total += 1
+	owner = null
+	parent.remove_child(self)
+	parent.free()
+	return total
+)");
+}
+
 TEST_CASE("[Modules][GDScript] Validate built-in API") {
 	GDScriptLanguage *lang = GDScriptLanguage::get_singleton();
 
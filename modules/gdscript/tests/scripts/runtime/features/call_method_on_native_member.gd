@@ -0,0 +1,18 @@
+extends Node
+
+# Methods called on a native member right after reading it run through
+# the fused getter and call opcode.
+
+func test():
+	var parent = Node.new()
+	parent.add_child(self)
+	owner = parent
+
+	print(owner.get_child_count())
+	print(owner.has_method("add_child"))
+	for i in 3:
+		print(owner.get_child_count() + i)
+
+	owner = null
+	parent.remove_child(self)
+	parent.free()
@@ -0,0 +1,50 @@
+# Untyped call and property sites see several receiver types, so their
+# inline caches have to tell them apart.
+
+class Walker:
+	var speed = 1
+
+	func move(t):
+		return speed * t
+
+class Runner:
+	var speed := 3
+	var name_tag: String = "runner"
+
+	func move(t):
+		return speed * t * 2
+
+class Flyer extends Walker:
+	func move(t):
+		return super.move(t) + 100
+
+func describe(entity):
+	return entity.move(2)
+
+func test():
+	var entities = [Walker.new(), Runner.new(), Flyer.new(), Walker.new(), Runner.new()]
+	var total = 0
+	for e in entities:
+		total += describe(e)
+		e.speed = e.speed + 1
+	print(total)
+	for e in entities:
+		print(e.speed, " ", describe(e))
+
+	var things = [Node.new(), RefCounted.new()]
+	for thing in things:
+		print(thing.get_class())
+	things[0].free()
+
+	var vectors = [Vector2(1, 2), Vector3(3, 4, 5)]
+	for v in vectors:
+		print(v.x + v.y)
+		v.x = 10.0
+		print(v.x)
+
+	# Typed member assigned a value that needs a conversion.
+	var runner = Runner.new()
+	runner.speed = 2.5
+	print(runner.speed)
+	runner.name_tag = "fast"
+	print(runner.name_tag)
@@ -0,0 +1,34 @@
+func test():
+	var sum: int = 0
+	var i: int = 0
+	while i < 10:
+		if i % 2 == 0:
+			sum += i * 3
+		else:
+			sum -= i
+		i += 1
+	print(sum)
+
+	var bits: int = 0b1100
+	print(bits & 0b1010, " ", bits | 0b0011, " ", bits ^ 0b1111)
+
+	var total: float = 0.0
+	var f: float = 0.5
+	while f <= 4.0:
+		total += f * 2.0 - f / 2.0
+		f += 0.5
+	print(total)
+
+	var a: int = 7
+	var b: int = 7
+	if a == b:
+		print("equal")
+	if a != b:
+		print("not equal")
+	if a >= b and a <= b:
+		print("both")
+
+	var x: float = 1.5
+	var y: float = 2.5
+	var less: bool = x < y
+	print(less, " ", x > y)
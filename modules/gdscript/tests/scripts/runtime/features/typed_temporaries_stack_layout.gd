@@ -0,0 +1,29 @@
+# Mixes typed and untyped temporaries of several types in the same function,
+# so they end up sharing the stack with locals from sibling blocks.
+
+func make_vector(x: float, y: float) -> Vector2:
+	return Vector2(x, y) * 2.0
+
+func test():
+	var a := 3
+	var b := 1.5
+	var v := make_vector(a * b, b + 0.5) + Vector2(a, a)
+	print(v)
+
+	var s := str(a) + "-" + str(b) + "-" + str(v.x)
+	print(s)
+
+	var untyped = [a, b, s]
+	var length: int = untyped.size() + s.length() * a
+	print(length)
+
+	for i in 3:
+		var w := Vector2(i, i) + v * float(i)
+		print(w)
+
+	if length > 0:
+		var inner := "inner " + str(length * 2)
+		print(inner)
+	else:
+		var other := 0.25 * b
+		print(other)
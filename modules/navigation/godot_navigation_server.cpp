@@ -31,6 +31,7 @@
 #include "godot_navigation_server.h"
 
 #include "core/os/mutex.h"
+#include "core/os/os.h"
 
 #ifndef _3D_DISABLED
 #include "navigation_mesh_generator.h"
@@ -113,6 +114,14 @@ GodotNavigationServer::GodotNavigationServer() {}
 
 GodotNavigationServer::~GodotNavigationServer() {
 	flush_queries();
+
+	// Drop the results nobody will receive anymore.
+	for (uint32_t i = 0; i < running_path_batches.size(); i++) {
+		memdelete(running_path_batches[i]);
+	}
+	for (uint32_t i = 0; i < pending_path_batches.size(); i++) {
+		memdelete(pending_path_batches[i]);
+	}
 }
 
 void GodotNavigationServer::add_command(SetCommand *command) const {
@@ -224,6 +233,27 @@ real_t GodotNavigationServer::map_get_link_connection_radius(RID p_map) const {
 	return map->get_link_connection_radius();
 }
 
+COMMAND_2(map_set_use_hierarchical_paths, RID, p_map, bool, p_enabled) {
+	NavMap *map = map_owner.get_or_null(p_map);
+	ERR_FAIL_COND(map == nullptr);
+
+	map->set_use_hierarchical_paths(p_enabled);
+}
+
+bool GodotNavigationServer::map_get_use_hierarchical_paths(RID p_map) const {
+	const NavMap *map = map_owner.get_or_null(p_map);
+	ERR_FAIL_COND_V(map == nullptr, false);
+
+	return map->get_use_hierarchical_paths();
+}
+
+COMMAND_2(map_set_avoidance_callback, RID, p_map, Callable, p_callback) {
+	NavMap *map = map_owner.get_or_null(p_map);
+	ERR_FAIL_COND(map == nullptr);
+
+	map->set_avoidance_callback(p_callback);
+}
+
 Vector<Vector3> GodotNavigationServer::map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers) const {
 	const NavMap *map = map_owner.get_or_null(p_map);
 	ERR_FAIL_COND_V(map == nullptr, Vector<Vector3>());
@@ -231,6 +261,24 @@ Vector<Vector3> GodotNavigationServer::map_get_path(RID p_map, Vector3 p_origin,
 	return map->get_path(p_origin, p_destination, p_optimize, p_navigation_layers);
 }
 
+void GodotNavigationServer::map_get_paths_async(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, const Vector<int32_t> &p_navigation_layers, bool p_optimize, const Callable &p_callback) const {
+	ERR_FAIL_COND(map_owner.get_or_null(p_map) == nullptr);
+	ERR_FAIL_COND_MSG(p_origins.size() != p_destinations.size(), "Each path query needs an origin and a destination.");
+	ERR_FAIL_COND_MSG(!p_navigation_layers.is_empty() && p_navigation_layers.size() != p_origins.size(), "The navigation layers must be empty or given for each path query.");
+
+	PathQueryBatch *batch = memnew(PathQueryBatch);
+	batch->map = p_map;
+	batch->origins = p_origins;
+	batch->destinations = p_destinations;
+	batch->navigation_layers = p_navigation_layers;
+	batch->optimize = p_optimize;
+	batch->callback = p_callback;
+
+	GodotNavigationServer *mut_this = const_cast<GodotNavigationServer *>(this);
+	MutexLock lock(mut_this->path_queries_mutex);
+	mut_this->pending_path_batches.push_back(batch);
+}
+
 Vector3 GodotNavigationServer::map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
 	const NavMap *map = map_owner.get_or_null(p_map);
 	ERR_FAIL_COND_V(map == nullptr, Vector3());
@@ -770,6 +818,9 @@ void GodotNavigationServer::flush_queries() {
 	// even with mutable functions.
 	MutexLock lock(commands_mutex);
 	MutexLock lock2(operations_mutex);
+
+	// The commands may change the maps the path queries are reading.
+	_wait_path_queries();
 	for (size_t i(0); i < commands.size(); i++) {
 		commands[i]->exec(this);
 		memdelete(commands[i]);
@@ -786,8 +837,101 @@ void GodotNavigationServer::map_force_update(RID p_map) {
 	map->sync();
 }
 
+void GodotNavigationServer::_start_path_queries() {
+	{
+		MutexLock lock(path_queries_mutex);
+		running_path_batches = pending_path_batches;
+		pending_path_batches.clear();
+	}
+
+	running_path_queries.clear();
+	for (uint32_t i = 0; i < running_path_batches.size(); i++) {
+		PathQueryBatch *batch = running_path_batches[i];
+		batch->paths.resize(batch->origins.size());
+
+		// The map may have been freed since the batch was queued, its paths stay empty.
+		const NavMap *map = map_owner.get_or_null(batch->map);
+		if (map == nullptr) {
+			continue;
+		}
+
+		for (int j = 0; j < batch->origins.size(); j++) {
+			PathQuery query;
+			query.map = map;
+			query.batch = batch;
+			query.index = j;
+			running_path_queries.push_back(query);
+		}
+	}
+
+	if (running_path_queries.is_empty()) {
+		return;
+	}
+
+	// Each worker takes queries until none are left, so long searches don't hold up the others.
+	const uint32_t worker_count = MIN(uint32_t(WorkerThreadPool::get_singleton()->get_thread_count()), running_path_queries.size());
+	if (path_query_scratch.size() < worker_count) {
+		path_query_scratch.resize(worker_count);
+	}
+	next_path_query.set(0);
+	path_queries_group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &GodotNavigationServer::_run_path_queries, nullptr, worker_count, -1, true, SNAME("NavigationPathQueries"));
+}
+
+void GodotNavigationServer::_run_path_queries(uint32_t p_worker, void *p_userdata) {
+	gd::PathQueryScratch &scratch = path_query_scratch[p_worker];
+
+	while (true) {
+		const uint32_t query_index = next_path_query.postincrement();
+		if (query_index >= running_path_queries.size()) {
+			break;
+		}
+
+		const PathQuery &query = running_path_queries[query_index];
+		const PathQueryBatch *batch = query.batch;
+		const uint32_t navigation_layers = batch->navigation_layers.is_empty() ? 1 : uint32_t(batch->navigation_layers[query.index]);
+		query.batch->paths[query.index] = query.map->get_path(batch->origins[query.index], batch->destinations[query.index], batch->optimize, navigation_layers, scratch);
+	}
+}
+
+void GodotNavigationServer::_wait_path_queries() {
+	if (path_queries_group_task != -1) {
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(path_queries_group_task);
+		path_queries_group_task = -1;
+	}
+}
+
+void GodotNavigationServer::_dispatch_path_queries() {
+	// flush_queries() already waited for the searches to finish.
+	// Take the batches first, the callbacks may queue new ones.
+	LocalVector<PathQueryBatch *> batches = running_path_batches;
+	running_path_batches.clear();
+	running_path_queries.clear();
+
+	for (uint32_t i = 0; i < batches.size(); i++) {
+		PathQueryBatch *batch = batches[i];
+
+		Array paths;
+		paths.resize(batch->paths.size());
+		for (uint32_t j = 0; j < batch->paths.size(); j++) {
+			paths[j] = batch->paths[j];
+		}
+		const Callable callback = batch->callback;
+		memdelete(batch);
+
+		const Variant paths_arg = paths;
+		const Variant *args[1] = { &paths_arg };
+		Variant ret;
+		Callable::CallError ce;
+		callback.callp(args, 1, ret, ce);
+		if (ce.error != Callable::CallError::CALL_OK) {
+			ERR_PRINT("Error calling the path query callback: " + Variant::get_callable_error_text(callback, args, 1, ce) + ".");
+		}
+	}
+}
+
 void GodotNavigationServer::process(real_t p_delta_time) {
 	flush_queries();
+	_dispatch_path_queries();
 
 	if (!active) {
 		return;
@@ -796,8 +940,21 @@ void GodotNavigationServer::process(real_t p_delta_time) {
 	// In c++ we can't be sure that this is performed in the main thread
 	// even with mutable functions.
 	MutexLock lock(operations_mutex);
+	pm_region_count = 0;
+	pm_polygon_count = 0;
+	pm_edge_free_count = 0;
+	pm_rebuilt_region_count = 0;
+	pm_sync_time_usec = 0;
 	for (uint32_t i(0); i < active_maps.size(); i++) {
+		const uint64_t sync_begin_usec = OS::get_singleton()->get_ticks_usec();
 		active_maps[i]->sync();
+		pm_sync_time_usec += OS::get_singleton()->get_ticks_usec() - sync_begin_usec;
+
+		pm_region_count += active_maps[i]->get_regions().size();
+		pm_polygon_count += active_maps[i]->get_polygon_count();
+		pm_edge_free_count += active_maps[i]->get_free_edge_count();
+		pm_rebuilt_region_count += active_maps[i]->get_rebuilt_region_count();
+
 		active_maps[i]->step(p_delta_time);
 		active_maps[i]->dispatch_callbacks();
 
@@ -808,6 +965,34 @@ void GodotNavigationServer::process(real_t p_delta_time) {
 			active_maps_update_id[i] = new_map_update_id;
 		}
 	}
+
+	// Search the queued paths on the updated maps until the next process.
+	_start_path_queries();
+}
+
+int GodotNavigationServer::get_process_info(ProcessInfo p_info) {
+	switch (p_info) {
+		case INFO_ACTIVE_MAPS: {
+			return active_maps.size();
+		} break;
+		case INFO_REGION_COUNT: {
+			return pm_region_count;
+		} break;
+		case INFO_POLYGON_COUNT: {
+			return pm_polygon_count;
+		} break;
+		case INFO_EDGE_FREE_COUNT: {
+			return pm_edge_free_count;
+		} break;
+		case INFO_REBUILT_REGION_COUNT: {
+			return pm_rebuilt_region_count;
+		} break;
+		case INFO_SYNC_TIME_USEC: {
+			return pm_sync_time_usec;
+		} break;
+	}
+
+	return 0;
 }
 
 #undef COMMAND_1
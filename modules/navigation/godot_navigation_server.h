@@ -66,6 +66,24 @@ struct SetCommand {
 };
 
 class GodotNavigationServer : public NavigationServer3D {
+	struct PathQueryBatch {
+		RID map;
+		Vector<Vector3> origins;
+		Vector<Vector3> destinations;
+		Vector<int32_t> navigation_layers;
+		bool optimize = false;
+		Callable callback;
+
+		/// Filled by the worker threads, one path per query.
+		LocalVector<Vector<Vector3>> paths;
+	};
+
+	struct PathQuery {
+		const NavMap *map = nullptr;
+		PathQueryBatch *batch = nullptr;
+		uint32_t index = 0;
+	};
+
 	Mutex commands_mutex;
 	/// Mutex used to make any operation threadsafe.
 	Mutex operations_mutex;
@@ -81,6 +99,31 @@ class GodotNavigationServer : public NavigationServer3D {
 	LocalVector<NavMap *> active_maps;
 	LocalVector<uint32_t> active_maps_update_id;
 
+	/// Statistics of the last `process`.
+	int pm_region_count = 0;
+	int pm_polygon_count = 0;
+	int pm_edge_free_count = 0;
+	int pm_rebuilt_region_count = 0;
+	int pm_sync_time_usec = 0;
+
+	/// Path query batches waiting for the next `process`.
+	Mutex path_queries_mutex;
+	LocalVector<PathQueryBatch *> pending_path_batches;
+
+	/// Path query batches searched on the WorkerThreadPool between two `process` calls.
+	LocalVector<PathQueryBatch *> running_path_batches;
+	LocalVector<PathQuery> running_path_queries;
+	SafeNumeric<uint32_t> next_path_query;
+	WorkerThreadPool::GroupID path_queries_group_task = -1;
+
+	/// One set of search buffers per worker, kept to reuse their memory.
+	LocalVector<gd::PathQueryScratch> path_query_scratch;
+
+	void _start_path_queries();
+	void _run_path_queries(uint32_t p_worker, void *p_userdata);
+	void _wait_path_queries();
+	void _dispatch_path_queries();
+
 public:
 	GodotNavigationServer();
 	virtual ~GodotNavigationServer();
@@ -105,7 +148,13 @@ public:
 	COMMAND_2(map_set_link_connection_radius, RID, p_map, real_t, p_connection_radius);
 	virtual real_t map_get_link_connection_radius(RID p_map) const override;
 
+	COMMAND_2(map_set_use_hierarchical_paths, RID, p_map, bool, p_enabled);
+	virtual bool map_get_use_hierarchical_paths(RID p_map) const override;
+
+	COMMAND_2(map_set_avoidance_callback, RID, p_map, Callable, p_callback);
+
 	virtual Vector<Vector3> map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers = 1) const override;
+	virtual void map_get_paths_async(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, const Vector<int32_t> &p_navigation_layers, bool p_optimize, const Callable &p_callback) const override;
 
 	virtual Vector3 map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision = false) const override;
 	virtual Vector3 map_get_closest_point(RID p_map, const Vector3 &p_point) const override;
@@ -175,6 +224,8 @@ public:
 
 	void flush_queries();
 	virtual void process(real_t p_delta_time) override;
+
+	virtual int get_process_info(ProcessInfo p_info) override;
 };
 
 #undef COMMAND_1
@@ -31,6 +31,7 @@
 #include "nav_map.h"
 
 #include "core/object/worker_thread_pool.h"
+#include "core/templates/sort_array.h"
 #include "nav_link.h"
 #include "nav_region.h"
 #include "rvo_agent.h"
@@ -38,6 +39,123 @@
 
 #define THREE_POINTS_CROSS_PRODUCT(m_a, m_b, m_c) (((m_c) - (m_a)).cross((m_b) - (m_a)))
 
+// Polygon BVH queries. Each one gives a lower bound of its distance to anything in a node,
+// and the polygons of nodes that could still beat the best distance found are visited.
+
+struct NavMapClosestPointQuery {
+	const LocalVector<gd::Polygon *> *polygons = nullptr;
+	Vector3 point;
+	uint32_t navigation_layers = 0;
+	bool filter_layers = false;
+
+	// Squared distance to the closest point.
+	real_t best = 1e20;
+	uint32_t polygon = UINT32_MAX;
+	Vector3 closest_point;
+	Face3 closest_face;
+
+	real_t get_bound(const AABB &p_aabb) const {
+		return point.clamp(p_aabb.position, p_aabb.position + p_aabb.size).distance_squared_to(point);
+	}
+
+	void visit(uint32_t p_polygon) {
+		const gd::Polygon &p = *(*polygons)[p_polygon];
+
+		// Only consider the polygon if it in a region with compatible layers.
+		if (filter_layers && (navigation_layers & p.owner->get_navigation_layers()) == 0) {
+			return;
+		}
+
+		for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
+			const Face3 face(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
+			const Vector3 inters = face.get_closest_point_to(point);
+			const real_t ds = inters.distance_squared_to(point);
+			if (ds < best) {
+				best = ds;
+				polygon = p_polygon;
+				closest_point = inters;
+				closest_face = face;
+			}
+		}
+	}
+};
+
+struct NavMapSegmentIntersectionQuery {
+	const LocalVector<gd::Polygon *> *polygons = nullptr;
+	Vector3 from;
+	Vector3 to;
+
+	// Distance from `from` to the closest intersection.
+	real_t best = 1e20;
+	bool found = false;
+	Vector3 closest_point;
+
+	real_t get_bound(const AABB &p_aabb) const {
+		// Grown a little, as faces accept intersections slightly outside their edges.
+		if (!p_aabb.grow(CMP_EPSILON).intersects_segment(from, to)) {
+			return 1e30;
+		}
+		return from.clamp(p_aabb.position, p_aabb.position + p_aabb.size).distance_to(from);
+	}
+
+	void visit(uint32_t p_polygon) {
+		const gd::Polygon &p = *(*polygons)[p_polygon];
+
+		for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
+			const Face3 f(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
+			Vector3 inters;
+			if (f.intersects_segment(from, to, &inters)) {
+				const real_t d = from.distance_to(inters);
+				if (d < best) {
+					best = d;
+					found = true;
+					closest_point = inters;
+				}
+			}
+		}
+	}
+};
+
+struct NavMapSegmentClosestEdgeQuery {
+	const LocalVector<gd::Polygon *> *polygons = nullptr;
+	Vector3 from;
+	Vector3 to;
+	AABB segment_aabb;
+
+	// Distance between the segment and the closest edge.
+	real_t best = 1e20;
+	Vector3 closest_point;
+
+	real_t get_bound(const AABB &p_aabb) const {
+		// The gap between the boxes bounds the distance between anything inside them.
+		const Vector3 gap_a = p_aabb.position - segment_aabb.get_end();
+		const Vector3 gap_b = segment_aabb.position - p_aabb.get_end();
+		return Vector3(MAX(MAX(gap_a.x, gap_b.x), 0), MAX(MAX(gap_a.y, gap_b.y), 0), MAX(MAX(gap_a.z, gap_b.z), 0)).length();
+	}
+
+	void visit(uint32_t p_polygon) {
+		const gd::Polygon &p = *(*polygons)[p_polygon];
+
+		for (size_t point_id = 0; point_id < p.points.size(); point_id++) {
+			Vector3 a, b;
+
+			Geometry3D::get_closest_points_between_segments(
+					from,
+					to,
+					p.points[point_id].pos,
+					p.points[(point_id + 1) % p.points.size()].pos,
+					a,
+					b);
+
+			const real_t d = a.distance_to(b);
+			if (d < best) {
+				best = d;
+				closest_point = b;
+			}
+		}
+	}
+};
+
 void NavMap::set_up(Vector3 p_up) {
 	up = p_up;
 	regenerate_polygons = true;
@@ -45,11 +163,13 @@ void NavMap::set_up(Vector3 p_up) {
 
 void NavMap::set_cell_size(float p_cell_size) {
 	cell_size = p_cell_size;
+	regenerate_free_edges = true;
 	regenerate_polygons = true;
 }
 
 void NavMap::set_edge_connection_margin(float p_edge_connection_margin) {
 	edge_connection_margin = p_edge_connection_margin;
+	regenerate_free_edges = true;
 	regenerate_links = true;
 }
 
@@ -58,6 +178,11 @@ void NavMap::set_link_connection_radius(float p_link_connection_radius) {
 	regenerate_links = true;
 }
 
+void NavMap::set_use_hierarchical_paths(bool p_enabled) {
+	use_hierarchical_paths = p_enabled;
+	regenerate_links = true;
+}
+
 gd::PointKey NavMap::get_point_key(const Vector3 &p_pos) const {
 	const int x = int(Math::floor(p_pos.x / cell_size));
 	const int y = int(Math::floor(p_pos.y / cell_size));
@@ -71,44 +196,135 @@ gd::PointKey NavMap::get_point_key(const Vector3 &p_pos) const {
 	return p;
 }
 
-Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers) const {
-	// Find the start poly and the end poly on this map.
-	const gd::Polygon *begin_poly = nullptr;
-	const gd::Polygon *end_poly = nullptr;
-	Vector3 begin_point;
-	Vector3 end_point;
-	float begin_d = 1e20;
-	float end_d = 1e20;
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+struct NavMapPolygonCenterComparator {
+	const LocalVector<AABB> *aabbs = nullptr;
+	int axis = 0;
 
-		// Only consider the polygon if it in a region with compatible layers.
-		if ((p_navigation_layers & p.owner->get_navigation_layers()) == 0) {
-			continue;
-		}
+	_FORCE_INLINE_ bool operator()(uint32_t p_a, uint32_t p_b) const {
+		const AABB &a = (*aabbs)[p_a];
+		const AABB &b = (*aabbs)[p_b];
+		return a.position[axis] * 2.0 + a.size[axis] < b.position[axis] * 2.0 + b.size[axis];
+	}
+};
 
-		// For each face check the distance between the origin/destination
-		for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
-			const Face3 face(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
+static void _build_polygon_bvh_node(LocalVector<gd::PolygonBVHNode> &r_nodes, LocalVector<uint32_t> &r_items, uint32_t p_node, uint32_t p_begin, uint32_t p_end, const LocalVector<AABB> &p_aabbs) {
+	const uint32_t max_leaf_polygons = 4;
 
-			Vector3 point = face.get_closest_point_to(p_origin);
-			float distance_to_point = point.distance_to(p_origin);
-			if (distance_to_point < begin_d) {
-				begin_d = distance_to_point;
-				begin_poly = &p;
-				begin_point = point;
-			}
+	AABB aabb = p_aabbs[r_items[p_begin]];
+	AABB centers(aabb.get_center(), Vector3());
+	for (uint32_t i = p_begin + 1; i < p_end; i++) {
+		const AABB &item_aabb = p_aabbs[r_items[i]];
+		aabb.merge_with(item_aabb);
+		centers.expand_to(item_aabb.get_center());
+	}
+	r_nodes[p_node].aabb = aabb;
+
+	if (p_end - p_begin <= max_leaf_polygons) {
+		r_nodes[p_node].first = p_begin;
+		r_nodes[p_node].count = p_end - p_begin;
+		return;
+	}
+
+	// Split at the median item along the longest axis of the item centers.
+	SortArray<uint32_t, NavMapPolygonCenterComparator> sorter;
+	sorter.compare.aabbs = &p_aabbs;
+	sorter.compare.axis = centers.get_longest_axis_index();
+	const uint32_t middle = (p_begin + p_end) / 2;
+	sorter.nth_element(p_begin, p_end, middle, r_items.ptr());
+
+	const uint32_t first_child = r_nodes.size();
+	r_nodes.resize(first_child + 2);
+	r_nodes[p_node].first = first_child;
+	r_nodes[p_node].count = 0;
+
+	_build_polygon_bvh_node(r_nodes, r_items, first_child, p_begin, middle, p_aabbs);
+	_build_polygon_bvh_node(r_nodes, r_items, first_child + 1, middle, p_end, p_aabbs);
+}
+
+// Builds a hierarchy over boxes, its leaves hold the indices of the boxes.
+static void _build_polygon_bvh(const LocalVector<AABB> &p_aabbs, LocalVector<gd::PolygonBVHNode> &r_nodes, LocalVector<uint32_t> &r_items) {
+	r_nodes.clear();
+	r_items.resize(p_aabbs.size());
+	if (p_aabbs.is_empty()) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < p_aabbs.size(); i++) {
+		r_items[i] = i;
+	}
+
+	r_nodes.push_back(gd::PolygonBVHNode());
+	_build_polygon_bvh_node(r_nodes, r_items, 0, 0, p_aabbs.size(), p_aabbs);
+}
 
-			point = face.get_closest_point_to(p_destination);
-			distance_to_point = point.distance_to(p_destination);
-			if (distance_to_point < end_d) {
-				end_d = distance_to_point;
-				end_poly = &p;
-				end_point = point;
+template <class T>
+void NavMap::_query_polygon_bvh(T &r_query) const {
+	if (region_bvh.is_empty()) {
+		return;
+	}
+
+	// Nodes of the region hierarchy (without region), then of the polygon hierarchy of each region.
+	// Median splits keep the depth of both well below the stack size.
+	const gd::MapRegion *stack_regions[128];
+	uint32_t stack_nodes[128];
+	uint32_t stack_size = 0;
+	stack_regions[stack_size] = nullptr;
+	stack_nodes[stack_size++] = 0;
+
+	while (stack_size) {
+		stack_size--;
+		const gd::MapRegion *map_region = stack_regions[stack_size];
+		const LocalVector<gd::PolygonBVHNode> &nodes = map_region ? map_region->bvh : region_bvh;
+		const gd::PolygonBVHNode &node = nodes[stack_nodes[stack_size]];
+		if (r_query.get_bound(node.aabb) >= r_query.best) {
+			continue;
+		}
+
+		if (node.count) {
+			for (uint32_t i = 0; i < node.count; i++) {
+				if (map_region) {
+					r_query.visit(map_region->polygon_offset + map_region->bvh_items[node.first + i]);
+				} else {
+					stack_regions[stack_size] = map_regions[region_bvh_items[node.first + i]];
+					stack_nodes[stack_size++] = 0;
+				}
 			}
+			continue;
 		}
+
+		// Push the farther child first, so the closer one is visited first and tightens the bound.
+		const bool first_closer = r_query.get_bound(nodes[node.first].aabb) < r_query.get_bound(nodes[node.first + 1].aabb);
+		stack_regions[stack_size] = map_region;
+		stack_nodes[stack_size++] = first_closer ? node.first + 1 : node.first;
+		stack_regions[stack_size] = map_region;
+		stack_nodes[stack_size++] = first_closer ? node.first : node.first + 1;
 	}
+}
+
+Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers) const {
+	gd::PathQueryScratch scratch;
+	scratch.navigation_polys.reserve(polygons.size() * 0.75);
+	return get_path(p_origin, p_destination, p_optimize, p_navigation_layers, scratch);
+}
+
+Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers, gd::PathQueryScratch &r_scratch) const {
+	// Find the start poly and the end poly on this map.
+	NavMapClosestPointQuery begin_query;
+	begin_query.polygons = &polygons;
+	begin_query.point = p_origin;
+	begin_query.navigation_layers = p_navigation_layers;
+	begin_query.filter_layers = true;
+	_query_polygon_bvh(begin_query);
+
+	NavMapClosestPointQuery end_query = begin_query;
+	end_query.point = p_destination;
+	_query_polygon_bvh(end_query);
+
+	const gd::Polygon *begin_poly = begin_query.polygon != UINT32_MAX ? polygons[begin_query.polygon] : nullptr;
+	const gd::Polygon *end_poly = end_query.polygon != UINT32_MAX ? polygons[end_query.polygon] : nullptr;
+	Vector3 begin_point = begin_query.closest_point;
+	Vector3 end_point = end_query.closest_point;
+	float end_d = 1e20;
 
 	// Check for trivial cases
 	if (!begin_poly || !end_poly) {
@@ -122,9 +338,15 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 		return path;
 	}
 
+	// Plan long paths region by region first, then only search the polygons of the regions on the way.
+	const HashSet<const NavBase *> *corridor = nullptr;
+	if (use_hierarchical_paths && begin_poly->owner != end_poly->owner && _find_path_corridor(begin_poly, end_poly, p_navigation_layers, r_scratch)) {
+		corridor = &r_scratch.corridor;
+	}
+
 	// List of all reachable navigation polys.
-	LocalVector<gd::NavigationPoly> navigation_polys;
-	navigation_polys.reserve(polygons.size() * 0.75);
+	LocalVector<gd::NavigationPoly> &navigation_polys = r_scratch.navigation_polys;
+	navigation_polys.clear();
 
 	// Add the start polygon to the reachable navigation polygons.
 	gd::NavigationPoly begin_navigation_poly = gd::NavigationPoly(begin_poly);
@@ -135,7 +357,8 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 	navigation_polys.push_back(begin_navigation_poly);
 
 	// List of polygon IDs to visit.
-	List<uint32_t> to_visit;
+	LocalVector<uint32_t> &to_visit = r_scratch.to_visit;
+	to_visit.clear();
 	to_visit.push_back(0);
 
 	// This is an implementation of the A* algorithm.
@@ -164,6 +387,11 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 					continue;
 				}
 
+				// Stay in the regions and links planned by the hierarchical search.
+				if (corridor && !corridor->has(connection.polygon->owner)) {
+					continue;
+				}
+
 				float poly_enter_cost = 0.0;
 				float poly_travel_cost = least_cost_poly->poly->owner->get_travel_cost();
 
@@ -212,6 +440,20 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 
 		// When the list of polygons to visit is empty at this point it means the End Polygon is not reachable
 		if (to_visit.size() == 0) {
+			if (corridor) {
+				// The planned regions don't lead to the end polygon, search the whole map instead.
+				corridor = nullptr;
+				gd::NavigationPoly np = navigation_polys[0];
+				navigation_polys.clear();
+				navigation_polys.push_back(np);
+				to_visit.push_back(0);
+				least_cost_id = 0;
+				prev_least_cost_poly = nullptr;
+				reachable_end = nullptr;
+				reachable_d = 1e30;
+				continue;
+			}
+
 			// Thus use the further reachable polygon
 			ERR_BREAK_MSG(is_reachable == false, "It's not expect to not find the most reachable polygons");
 			is_reachable = false;
@@ -249,8 +491,8 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 		// Find the polygon with the minimum cost from the list of polygons to visit.
 		least_cost_id = -1;
 		float least_cost = 1e30;
-		for (List<uint32_t>::Element *element = to_visit.front(); element != nullptr; element = element->next()) {
-			gd::NavigationPoly *np = &navigation_polys[element->get()];
+		for (uint32_t i = 0; i < to_visit.size(); i++) {
+			gd::NavigationPoly *np = &navigation_polys[to_visit[i]];
 			float cost = np->traveled_distance;
 			cost += (np->entry.distance_to(end_point) * np->poly->owner->get_travel_cost());
 			if (cost < least_cost) {
@@ -386,52 +628,27 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 }
 
 Vector3 NavMap::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
-	bool use_collision = p_use_collision;
-	Vector3 closest_point;
-	real_t closest_point_d = 1e20;
-
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// For each face check the distance to the segment
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			Vector3 inters;
-			if (f.intersects_segment(p_from, p_to, &inters)) {
-				const real_t d = closest_point_d = p_from.distance_to(inters);
-				if (use_collision == false) {
-					closest_point = inters;
-					use_collision = true;
-					closest_point_d = d;
-				} else if (closest_point_d > d) {
-					closest_point = inters;
-					closest_point_d = d;
-				}
-			}
-		}
-
-		if (use_collision == false) {
-			for (size_t point_id = 0; point_id < p.points.size(); point_id += 1) {
-				Vector3 a, b;
-
-				Geometry3D::get_closest_points_between_segments(
-						p_from,
-						p_to,
-						p.points[point_id].pos,
-						p.points[(point_id + 1) % p.points.size()].pos,
-						a,
-						b);
-
-				const real_t d = a.distance_to(b);
-				if (d < closest_point_d) {
-					closest_point_d = d;
-					closest_point = b;
-				}
-			}
-		}
+	// Prefer the closest point where the segment crosses the navigation mesh.
+	NavMapSegmentIntersectionQuery intersection_query;
+	intersection_query.polygons = &polygons;
+	intersection_query.from = p_from;
+	intersection_query.to = p_to;
+	_query_polygon_bvh(intersection_query);
+
+	if (intersection_query.found || p_use_collision) {
+		return intersection_query.closest_point;
 	}
 
-	return closest_point;
+	// Otherwise use the point of the polygon edges closest to the segment.
+	NavMapSegmentClosestEdgeQuery edge_query;
+	edge_query.polygons = &polygons;
+	edge_query.from = p_from;
+	edge_query.to = p_to;
+	edge_query.segment_aabb = AABB(p_from, Vector3());
+	edge_query.segment_aabb.expand_to(p_to);
+	_query_polygon_bvh(edge_query);
+
+	return edge_query.closest_point;
 }
 
 Vector3 NavMap::get_closest_point(const Vector3 &p_point) const {
@@ -451,23 +668,16 @@ RID NavMap::get_closest_point_owner(const Vector3 &p_point) const {
 
 gd::ClosestPointQueryResult NavMap::get_closest_point_info(const Vector3 &p_point) const {
 	gd::ClosestPointQueryResult result;
-	real_t closest_point_ds = 1e20;
 
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+	NavMapClosestPointQuery query;
+	query.polygons = &polygons;
+	query.point = p_point;
+	_query_polygon_bvh(query);
 
-		// For each face check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t ds = inters.distance_squared_to(p_point);
-			if (ds < closest_point_ds) {
-				result.point = inters;
-				result.normal = f.get_plane().normal;
-				result.owner = p.owner->get_self();
-				closest_point_ds = ds;
-			}
-		}
+	if (query.polygon != UINT32_MAX) {
+		result.point = query.closest_point;
+		result.normal = query.closest_face.get_plane().normal;
+		result.owner = polygons[query.polygon]->owner->get_self();
 	}
 
 	return result;
@@ -483,6 +693,15 @@ void NavMap::remove_region(NavRegion *p_region) {
 	if (region_index != -1) {
 		regions.remove_at_unordered(region_index);
 		regenerate_links = true;
+
+		// The map polygons, connections and links point into the polygons of the region, which can be
+		// freed before the next sync (that never comes for an inactive map), so drop them right away.
+		for (uint32_t r = 0; r < map_regions.size(); r++) {
+			if (map_regions[r]->region == p_region) {
+				_update_map();
+				break;
+			}
+		}
 	}
 }
 
@@ -536,6 +755,8 @@ void NavMap::remove_agent_as_controlled(RvoAgent *agent) {
 }
 
 void NavMap::sync() {
+	rebuilt_region_count = 0;
+
 	// Check if we need to update the links.
 	if (regenerate_polygons) {
 		for (uint32_t r = 0; r < regions.size(); r++) {
@@ -557,277 +778,1010 @@ void NavMap::sync() {
 	}
 
 	if (regenerate_links) {
-		// Remove regions connections.
-		for (uint32_t r = 0; r < regions.size(); r++) {
-			regions[r]->get_connections().clear();
+		_update_map();
+
+		// Update the update ID.
+		map_update_id = (map_update_id + 1) % 9999999;
+	}
+
+	regenerate_polygons = false;
+	regenerate_links = false;
+}
+
+void NavMap::_update_map() {
+	_update_map_regions();
+	_update_links();
+
+	if (use_hierarchical_paths) {
+		_update_clusters();
+	} else {
+		for (uint32_t r = 0; r < map_regions.size(); r++) {
+			map_regions[r]->boundary.clear();
+			map_regions[r]->boundary_distances.clear();
 		}
+		polygon_boundary_ids.clear();
+	}
+}
 
-		// Resize the polygon count.
-		int count = 0;
-		for (uint32_t r = 0; r < regions.size(); r++) {
-			count += regions[r]->get_polygons().size();
+static _FORCE_INLINE_ Vector3i _get_free_edge_cell(const Vector3 &p_position, real_t p_cell_size) {
+	return Vector3i(Math::floor(p_position.x / p_cell_size), Math::floor(p_position.y / p_cell_size), Math::floor(p_position.z / p_cell_size));
+}
+
+// The stale ranges hold the begin and end of each range of polygons going away.
+static _FORCE_INLINE_ bool _is_stale_polygon(const gd::Polygon *p_polygon, const LocalVector<const gd::Polygon *> &p_stale_ranges) {
+	for (uint32_t i = 0; i < p_stale_ranges.size(); i += 2) {
+		if (p_polygon >= p_stale_ranges[i] && p_polygon < p_stale_ranges[i + 1]) {
+			return true;
 		}
-		polygons.resize(count);
+	}
+	return false;
+}
 
-		// Copy all region polygons in the map.
-		count = 0;
-		for (uint32_t r = 0; r < regions.size(); r++) {
-			const LocalVector<gd::Polygon> &polygons_source = regions[r]->get_polygons();
-			for (uint32_t n = 0; n < polygons_source.size(); n++) {
-				polygons[count + n] = polygons_source[n];
+static void _remove_stale_connections(Vector<gd::Edge::Connection> &r_connections, const LocalVector<const gd::Polygon *> &p_stale_ranges) {
+	for (int i = r_connections.size() - 1; i >= 0; i--) {
+		if (_is_stale_polygon(r_connections[i].polygon, p_stale_ranges)) {
+			r_connections.remove_at(i);
+		}
+	}
+}
+
+static void _remove_stale_free_edge_connections(const LocalVector<gd::FreeEdgeRef> &p_refs, const LocalVector<const gd::Polygon *> &p_stale_ranges, HashSet<gd::MapRegion *> &r_map_regions) {
+	for (uint32_t i = 0; i < p_refs.size(); i++) {
+		const gd::FreeEdge &free_edge = p_refs[i].region->free_edges[p_refs[i].free_edge];
+		gd::Polygon &poly = p_refs[i].region->region->get_polygons()[free_edge.polygon];
+		_remove_stale_connections(poly.edges[free_edge.edge].connections, p_stale_ranges);
+		r_map_regions.insert(p_refs[i].region);
+	}
+}
+
+static void _remove_free_edge_ref(LocalVector<gd::FreeEdgeRef> &r_refs, const gd::FreeEdgeRef &p_ref) {
+	const int64_t index = r_refs.find(p_ref);
+	if (index != -1) {
+		r_refs.remove_at_unordered(index);
+	}
+}
+
+// Checks if an edge of another region runs along the edge, within the margin, and computes the pathway between them.
+static bool _get_near_edge_connection(const gd::Polygon &p_polygon, uint32_t p_edge, gd::Polygon &p_other, uint32_t p_other_edge, real_t p_margin, gd::Edge::Connection &r_connection) {
+	Vector3 edge_p1 = p_polygon.points[p_edge].pos;
+	Vector3 edge_p2 = p_polygon.points[(p_edge + 1) % p_polygon.points.size()].pos;
+	Vector3 other_edge_p1 = p_other.points[p_other_edge].pos;
+	Vector3 other_edge_p2 = p_other.points[(p_other_edge + 1) % p_other.points.size()].pos;
+
+	// Compute the projection of the opposite edge on the current one
+	Vector3 edge_vector = edge_p2 - edge_p1;
+	float projected_p1_ratio = edge_vector.dot(other_edge_p1 - edge_p1) / (edge_vector.length_squared());
+	float projected_p2_ratio = edge_vector.dot(other_edge_p2 - edge_p1) / (edge_vector.length_squared());
+	if ((projected_p1_ratio < 0.0 && projected_p2_ratio < 0.0) || (projected_p1_ratio > 1.0 && projected_p2_ratio > 1.0)) {
+		return false;
+	}
+
+	// Check if the two edges are close to each other enough and compute a pathway between the two regions.
+	Vector3 self1 = edge_vector * CLAMP(projected_p1_ratio, 0.0, 1.0) + edge_p1;
+	Vector3 other1;
+	if (projected_p1_ratio >= 0.0 && projected_p1_ratio <= 1.0) {
+		other1 = other_edge_p1;
+	} else {
+		other1 = other_edge_p1.lerp(other_edge_p2, (1.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
+	}
+	if (other1.distance_to(self1) > p_margin) {
+		return false;
+	}
+
+	Vector3 self2 = edge_vector * CLAMP(projected_p2_ratio, 0.0, 1.0) + edge_p1;
+	Vector3 other2;
+	if (projected_p2_ratio >= 0.0 && projected_p2_ratio <= 1.0) {
+		other2 = other_edge_p2;
+	} else {
+		other2 = other_edge_p1.lerp(other_edge_p2, (0.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
+	}
+	if (other2.distance_to(self2) > p_margin) {
+		return false;
+	}
+
+	// The edges can now be connected.
+	r_connection.polygon = &p_other;
+	r_connection.edge = p_other_edge;
+	r_connection.pathway_start = (self1 + other1) / 2.0;
+	r_connection.pathway_end = (self2 + other2) / 2.0;
+	return true;
+}
+
+void NavMap::_update_map_regions() {
+	HashMap<const NavRegion *, gd::MapRegion *> previous_map_regions;
+	for (uint32_t r = 0; r < map_regions.size(); r++) {
+		previous_map_regions.insert(map_regions[r]->region, map_regions[r]);
+	}
+
+	// Keep what was built for the regions whose polygons didn't change.
+	LocalVector<gd::MapRegion *> rebuilt_map_regions;
+	LocalVector<gd::MapRegion *> stale_map_regions;
+	map_regions.resize(regions.size());
+	for (uint32_t r = 0; r < regions.size(); r++) {
+		HashMap<const NavRegion *, gd::MapRegion *>::Iterator E = previous_map_regions.find(regions[r]);
+		gd::MapRegion *map_region = nullptr;
+		if (E) {
+			map_region = E->value;
+			previous_map_regions.remove(E);
+			if (map_region->polygons_version != regions[r]->get_polygons_version()) {
+				stale_map_regions.push_back(map_region);
+				rebuilt_map_regions.push_back(map_region);
 			}
-			count += regions[r]->get_polygons().size();
+		} else {
+			map_region = memnew(gd::MapRegion);
+			map_region->region = regions[r];
+			rebuilt_map_regions.push_back(map_region);
 		}
+		map_regions[r] = map_region;
+	}
 
-		// Group all edges per key.
-		HashMap<gd::EdgeKey, Vector<gd::Edge::Connection>, gd::EdgeKey> connections;
-		for (uint32_t poly_id = 0; poly_id < polygons.size(); poly_id++) {
-			gd::Polygon &poly(polygons[poly_id]);
+	LocalVector<gd::MapRegion *> removed_map_regions;
+	for (const KeyValue<const NavRegion *, gd::MapRegion *> &E : previous_map_regions) {
+		stale_map_regions.push_back(E.value);
+		removed_map_regions.push_back(E.value);
+	}
 
-			for (uint32_t p = 0; p < poly.points.size(); p++) {
-				int next_point = (p + 1) % poly.points.size();
-				gd::EdgeKey ek(poly.points[p].key, poly.points[next_point].key);
+	// The polygons going away, the link polygons are always rebuilt.
+	LocalVector<const gd::Polygon *> stale_ranges;
+	for (uint32_t i = 0; i < stale_map_regions.size(); i++) {
+		stale_ranges.push_back(stale_map_regions[i]->polygons_begin);
+		stale_ranges.push_back(stale_map_regions[i]->polygons_end);
+	}
+	stale_ranges.push_back(link_polygons.ptr());
+	stale_ranges.push_back(link_polygons.ptr() + link_polygons.size());
 
-				HashMap<gd::EdgeKey, Vector<gd::Edge::Connection>, gd::EdgeKey>::Iterator connection = connections.find(ek);
-				if (!connection) {
-					connections[ek] = Vector<gd::Edge::Connection>();
+	for (uint32_t i = 0; i < link_anchors.size(); i++) {
+		if (!_is_stale_polygon(link_anchors[i], stale_ranges)) {
+			_remove_stale_connections(link_anchors[i]->edges[0].connections, stale_ranges);
+		}
+	}
+	link_anchors.clear();
+
+	// The regions whose free edges get connected to the other regions.
+	HashSet<gd::MapRegion *> connected_map_regions;
+
+	if (regenerate_free_edges) {
+		// Another margin changes which edges connect, connect all the regions again.
+		free_edges_by_key.clear();
+		free_edges_by_cell.clear();
+		free_edge_cell_size = MAX(edge_connection_margin, cell_size) * 8.0;
+
+		for (uint32_t r = 0; r < map_regions.size(); r++) {
+			gd::MapRegion *map_region = map_regions[r];
+			if (map_region->polygons_version == map_region->region->get_polygons_version()) {
+				LocalVector<gd::Polygon> &region_polygons = map_region->region->get_polygons();
+				for (uint32_t i = 0; i < map_region->free_edges.size(); i++) {
+					const gd::FreeEdge &free_edge = map_region->free_edges[i];
+					region_polygons[free_edge.polygon].edges[free_edge.edge].connections.clear();
 				}
-				if (connections[ek].size() <= 1) {
-					// Add the polygon/edge tuple to this key.
-					gd::Edge::Connection new_connection;
-					new_connection.polygon = &poly;
-					new_connection.edge = p;
-					new_connection.pathway_start = poly.points[p].pos;
-					new_connection.pathway_end = poly.points[next_point].pos;
-					connections[ek].push_back(new_connection);
-				} else {
-					// The edge is already connected with another edge, skip.
-					ERR_PRINT_ONCE("Attempted to merge a navigation mesh triangle edge with another already-merged edge. This happens when the current `cell_size` is different from the one used to generate the navigation mesh. This will cause navigation problems.");
+				map_region->region->get_connections().clear();
+			}
+			connected_map_regions.insert(map_region);
+		}
+	} else {
+		for (uint32_t i = 0; i < stale_map_regions.size(); i++) {
+			_remove_free_edges(stale_map_regions[i]);
+		}
+
+		// Only the free edges sharing a key or a grid cell with the ones going away can be connected to them.
+		HashSet<gd::MapRegion *> neighbor_map_regions;
+		for (uint32_t i = 0; i < stale_map_regions.size(); i++) {
+			const gd::MapRegion *map_region = stale_map_regions[i];
+			for (uint32_t j = 0; j < map_region->free_edges.size(); j++) {
+				const gd::FreeEdge &free_edge = map_region->free_edges[j];
+				const LocalVector<gd::FreeEdgeRef> *same_key = free_edges_by_key.getptr(free_edge.key);
+				if (same_key) {
+					_remove_stale_free_edge_connections(*same_key, stale_ranges, neighbor_map_regions);
+				}
+
+				for (int x = free_edge.cell_begin.x; x <= free_edge.cell_end.x; x++) {
+					for (int y = free_edge.cell_begin.y; y <= free_edge.cell_end.y; y++) {
+						for (int z = free_edge.cell_begin.z; z <= free_edge.cell_end.z; z++) {
+							const LocalVector<gd::FreeEdgeRef> *cell = free_edges_by_cell.getptr(Vector3i(x, y, z));
+							if (cell) {
+								_remove_stale_free_edge_connections(*cell, stale_ranges, neighbor_map_regions);
+							}
+						}
+					}
 				}
 			}
 		}
 
-		Vector<gd::Edge::Connection> free_edges;
-		for (KeyValue<gd::EdgeKey, Vector<gd::Edge::Connection>> &E : connections) {
-			if (E.value.size() == 2) {
-				// Connect edge that are shared in different polygons.
-				gd::Edge::Connection &c1 = E.value.write[0];
-				gd::Edge::Connection &c2 = E.value.write[1];
-				c1.polygon->edges[c1.edge].connections.push_back(c2);
-				c2.polygon->edges[c2.edge].connections.push_back(c1);
-				// Note: The pathway_start/end are full for those connection and do not need to be modified.
+		for (gd::MapRegion *E : neighbor_map_regions) {
+			_remove_stale_connections(E->region->get_connections(), stale_ranges);
+		}
+
+		for (uint32_t i = 0; i < rebuilt_map_regions.size(); i++) {
+			connected_map_regions.insert(rebuilt_map_regions[i]);
+		}
+	}
+
+	for (uint32_t i = 0; i < removed_map_regions.size(); i++) {
+		memdelete(removed_map_regions[i]);
+	}
+
+	// Each region only touches its own polygons, so they can be rebuilt in parallel.
+	rebuilt_region_count = rebuilt_map_regions.size();
+	if (rebuilt_map_regions.size() > 0) {
+		WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &NavMap::_build_map_region, rebuilt_map_regions.ptr(), rebuilt_map_regions.size(), -1, true, SNAME("NavigationMapRegions"));
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+	}
+
+	for (gd::MapRegion *E : connected_map_regions) {
+		_add_free_edges(E);
+	}
+
+	LocalVector<gd::FreeEdgeRef> candidates;
+	for (gd::MapRegion *E : connected_map_regions) {
+		for (uint32_t i = 0; i < E->free_edges.size(); i++) {
+			_connect_free_edge(E, i, connected_map_regions, candidates);
+		}
+	}
+
+	if (rebuilt_map_regions.size() > 0 || removed_map_regions.size() > 0) {
+		// The map polygons point into the region polygons, only the list is rebuilt.
+		polygons.clear();
+		polygon_regions.clear();
+
+		LocalVector<AABB> region_aabbs;
+		LocalVector<uint32_t> region_ids;
+		for (uint32_t r = 0; r < map_regions.size(); r++) {
+			gd::MapRegion *map_region = map_regions[r];
+			LocalVector<gd::Polygon> &region_polygons = map_region->region->get_polygons();
+			map_region->polygon_offset = polygons.size();
+			for (uint32_t i = 0; i < region_polygons.size(); i++) {
+				region_polygons[i].id = polygons.size();
+				polygons.push_back(&region_polygons[i]);
+				polygon_regions.push_back(r);
+			}
+
+			if (!map_region->bvh.is_empty()) {
+				region_aabbs.push_back(map_region->bvh[0].aabb);
+				region_ids.push_back(r);
+			}
+		}
+
+		_build_polygon_bvh(region_aabbs, region_bvh, region_bvh_items);
+		for (uint32_t i = 0; i < region_bvh_items.size(); i++) {
+			region_bvh_items[i] = region_ids[region_bvh_items[i]];
+		}
+	}
+
+	free_edge_count = 0;
+	for (uint32_t r = 0; r < map_regions.size(); r++) {
+		free_edge_count += map_regions[r]->free_edges.size();
+	}
+	regenerate_free_edges = false;
+}
+
+void NavMap::_build_map_region(uint32_t p_index, gd::MapRegion **p_map_regions) {
+	gd::MapRegion &map_region = *p_map_regions[p_index];
+	LocalVector<gd::Polygon> &region_polygons = map_region.region->get_polygons();
+	map_region.polygons_version = map_region.region->get_polygons_version();
+	map_region.polygons_begin = region_polygons.ptr();
+	map_region.polygons_end = region_polygons.ptr() + region_polygons.size();
+	map_region.polygon_count = region_polygons.size();
+	map_region.free_edges.clear();
+	map_region.boundary.clear();
+	map_region.boundary_distances.clear();
+	map_region.region->get_connections().clear();
+
+	// Group all edges per key.
+	HashMap<gd::EdgeKey, Vector<gd::Edge::Connection>, gd::EdgeKey> connections;
+	for (uint32_t poly_id = 0; poly_id < region_polygons.size(); poly_id++) {
+		gd::Polygon &poly(region_polygons[poly_id]);
+
+		for (uint32_t p = 0; p < poly.points.size(); p++) {
+			int next_point = (p + 1) % poly.points.size();
+			gd::EdgeKey ek(poly.points[p].key, poly.points[next_point].key);
+
+			HashMap<gd::EdgeKey, Vector<gd::Edge::Connection>, gd::EdgeKey>::Iterator connection = connections.find(ek);
+			if (!connection) {
+				connections[ek] = Vector<gd::Edge::Connection>();
+			}
+			if (connections[ek].size() <= 1) {
+				// Add the polygon/edge tuple to this key.
+				gd::Edge::Connection new_connection;
+				new_connection.polygon = &poly;
+				new_connection.edge = p;
+				new_connection.pathway_start = poly.points[p].pos;
+				new_connection.pathway_end = poly.points[next_point].pos;
+				connections[ek].push_back(new_connection);
 			} else {
-				CRASH_COND_MSG(E.value.size() != 1, vformat("Number of connection != 1. Found: %d", E.value.size()));
-				free_edges.push_back(E.value[0]);
-			}
-		}
-
-		// Find the compatible near edges.
-		//
-		// Note:
-		// Considering that the edges must be compatible (for obvious reasons)
-		// to be connected, create new polygons to remove that small gap is
-		// not really useful and would result in wasteful computation during
-		// connection, integration and path finding.
-		for (int i = 0; i < free_edges.size(); i++) {
-			const gd::Edge::Connection &free_edge = free_edges[i];
-			Vector3 edge_p1 = free_edge.polygon->points[free_edge.edge].pos;
-			Vector3 edge_p2 = free_edge.polygon->points[(free_edge.edge + 1) % free_edge.polygon->points.size()].pos;
-
-			for (int j = 0; j < free_edges.size(); j++) {
-				const gd::Edge::Connection &other_edge = free_edges[j];
-				if (i == j || free_edge.polygon->owner == other_edge.polygon->owner) {
-					continue;
-				}
+				// The edge is already connected with another edge, skip.
+				ERR_PRINT_ONCE("Attempted to merge a navigation mesh triangle edge with another already-merged edge. This happens when the current `cell_size` is different from the one used to generate the navigation mesh. This will cause navigation problems.");
+			}
+		}
+	}
 
-				Vector3 other_edge_p1 = other_edge.polygon->points[other_edge.edge].pos;
-				Vector3 other_edge_p2 = other_edge.polygon->points[(other_edge.edge + 1) % other_edge.polygon->points.size()].pos;
+	for (KeyValue<gd::EdgeKey, Vector<gd::Edge::Connection>> &E : connections) {
+		if (E.value.size() == 2) {
+			// Connect edge that are shared in different polygons.
+			gd::Edge::Connection &c1 = E.value.write[0];
+			gd::Edge::Connection &c2 = E.value.write[1];
+			c1.polygon->edges[c1.edge].connections.push_back(c2);
+			c2.polygon->edges[c2.edge].connections.push_back(c1);
+			// Note: The pathway_start/end are full for those connection and do not need to be modified.
+		} else {
+			CRASH_COND_MSG(E.value.size() != 1, vformat("Number of connection != 1. Found: %d", E.value.size()));
+			// The edge may be shared with, or near to, an edge of another region.
+			gd::FreeEdge free_edge;
+			free_edge.polygon = E.value[0].polygon - region_polygons.ptr();
+			free_edge.edge = E.value[0].edge;
+			free_edge.key = E.key;
+			map_region.free_edges.push_back(free_edge);
+		}
+	}
 
-				// Compute the projection of the opposite edge on the current one
-				Vector3 edge_vector = edge_p2 - edge_p1;
-				float projected_p1_ratio = edge_vector.dot(other_edge_p1 - edge_p1) / (edge_vector.length_squared());
-				float projected_p2_ratio = edge_vector.dot(other_edge_p2 - edge_p1) / (edge_vector.length_squared());
-				if ((projected_p1_ratio < 0.0 && projected_p2_ratio < 0.0) || (projected_p1_ratio > 1.0 && projected_p2_ratio > 1.0)) {
-					continue;
-				}
+	LocalVector<AABB> polygon_aabbs;
+	polygon_aabbs.resize(region_polygons.size());
+	for (uint32_t i = 0; i < region_polygons.size(); i++) {
+		const gd::Polygon &p = region_polygons[i];
+		AABB aabb(p.points.is_empty() ? Vector3() : p.points[0].pos, Vector3());
+		for (uint32_t point_id = 1; point_id < p.points.size(); point_id++) {
+			aabb.expand_to(p.points[point_id].pos);
+		}
+		polygon_aabbs[i] = aabb;
+	}
+	_build_polygon_bvh(polygon_aabbs, map_region.bvh, map_region.bvh_items);
+}
 
-				// Check if the two edges are close to each other enough and compute a pathway between the two regions.
-				Vector3 self1 = edge_vector * CLAMP(projected_p1_ratio, 0.0, 1.0) + edge_p1;
-				Vector3 other1;
-				if (projected_p1_ratio >= 0.0 && projected_p1_ratio <= 1.0) {
-					other1 = other_edge_p1;
-				} else {
-					other1 = other_edge_p1.lerp(other_edge_p2, (1.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
-				}
-				if (other1.distance_to(self1) > edge_connection_margin) {
-					continue;
+void NavMap::_add_free_edges(gd::MapRegion *p_map_region) {
+	const LocalVector<gd::Polygon> &region_polygons = p_map_region->region->get_polygons();
+	for (uint32_t i = 0; i < p_map_region->free_edges.size(); i++) {
+		gd::FreeEdge &free_edge = p_map_region->free_edges[i];
+		const gd::Polygon &poly = region_polygons[free_edge.polygon];
+
+		// Register the edge in all the cells where another edge could be close enough to connect.
+		AABB edge_aabb(poly.points[free_edge.edge].pos, Vector3());
+		edge_aabb.expand_to(poly.points[(free_edge.edge + 1) % poly.points.size()].pos);
+		edge_aabb = edge_aabb.grow(edge_connection_margin);
+		free_edge.cell_begin = _get_free_edge_cell(edge_aabb.position, free_edge_cell_size);
+		free_edge.cell_end = _get_free_edge_cell(edge_aabb.get_end(), free_edge_cell_size);
+
+		gd::FreeEdgeRef ref;
+		ref.region = p_map_region;
+		ref.free_edge = i;
+		free_edges_by_key[free_edge.key].push_back(ref);
+		for (int x = free_edge.cell_begin.x; x <= free_edge.cell_end.x; x++) {
+			for (int y = free_edge.cell_begin.y; y <= free_edge.cell_end.y; y++) {
+				for (int z = free_edge.cell_begin.z; z <= free_edge.cell_end.z; z++) {
+					free_edges_by_cell[Vector3i(x, y, z)].push_back(ref);
 				}
+			}
+		}
+	}
+}
 
-				Vector3 self2 = edge_vector * CLAMP(projected_p2_ratio, 0.0, 1.0) + edge_p1;
-				Vector3 other2;
-				if (projected_p2_ratio >= 0.0 && projected_p2_ratio <= 1.0) {
-					other2 = other_edge_p2;
-				} else {
-					other2 = other_edge_p1.lerp(other_edge_p2, (0.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
+void NavMap::_remove_free_edges(gd::MapRegion *p_map_region) {
+	for (uint32_t i = 0; i < p_map_region->free_edges.size(); i++) {
+		const gd::FreeEdge &free_edge = p_map_region->free_edges[i];
+		gd::FreeEdgeRef ref;
+		ref.region = p_map_region;
+		ref.free_edge = i;
+
+		HashMap<gd::EdgeKey, LocalVector<gd::FreeEdgeRef>, gd::EdgeKey>::Iterator K = free_edges_by_key.find(free_edge.key);
+		if (K) {
+			_remove_free_edge_ref(K->value, ref);
+			if (K->value.is_empty()) {
+				free_edges_by_key.remove(K);
+			}
+		}
+
+		for (int x = free_edge.cell_begin.x; x <= free_edge.cell_end.x; x++) {
+			for (int y = free_edge.cell_begin.y; y <= free_edge.cell_end.y; y++) {
+				for (int z = free_edge.cell_begin.z; z <= free_edge.cell_end.z; z++) {
+					HashMap<Vector3i, LocalVector<gd::FreeEdgeRef>>::Iterator C = free_edges_by_cell.find(Vector3i(x, y, z));
+					if (C) {
+						_remove_free_edge_ref(C->value, ref);
+						if (C->value.is_empty()) {
+							free_edges_by_cell.remove(C);
+						}
+					}
 				}
-				if (other2.distance_to(self2) > edge_connection_margin) {
+			}
+		}
+	}
+}
+
+void NavMap::_connect_free_edge(gd::MapRegion *p_map_region, uint32_t p_free_edge, const HashSet<gd::MapRegion *> &p_connected_map_regions, LocalVector<gd::FreeEdgeRef> &r_candidates) {
+	const gd::FreeEdge &free_edge = p_map_region->free_edges[p_free_edge];
+	gd::Polygon &poly = p_map_region->region->get_polygons()[free_edge.polygon];
+	gd::Edge &edge = poly.edges[free_edge.edge];
+
+	gd::FreeEdgeRef self;
+	self.region = p_map_region;
+	self.free_edge = p_free_edge;
+
+	// Connect the edge shared with another region. The other edge gets its connection back here,
+	// unless its own region is connected in this sync too.
+	const LocalVector<gd::FreeEdgeRef> &same_key = free_edges_by_key[free_edge.key];
+	if (same_key.size() > 2) {
+		// The edge is already connected with another edge, skip.
+		ERR_PRINT_ONCE("Attempted to merge a navigation mesh triangle edge with another already-merged edge. This happens when the current `cell_size` is different from the one used to generate the navigation mesh. This will cause navigation problems.");
+		return;
+	}
+	if (same_key.size() == 2) {
+		const gd::FreeEdgeRef &other = same_key[0] == self ? same_key[1] : same_key[0];
+		const gd::FreeEdge &other_free_edge = other.region->free_edges[other.free_edge];
+		gd::Polygon &other_poly = other.region->region->get_polygons()[other_free_edge.polygon];
+
+		gd::Edge::Connection connection;
+		connection.polygon = &other_poly;
+		connection.edge = other_free_edge.edge;
+		connection.pathway_start = other_poly.points[other_free_edge.edge].pos;
+		connection.pathway_end = other_poly.points[(other_free_edge.edge + 1) % other_poly.points.size()].pos;
+		edge.connections.push_back(connection);
+
+		if (!p_connected_map_regions.has(other.region)) {
+			gd::Edge::Connection back_connection;
+			back_connection.polygon = &poly;
+			back_connection.edge = free_edge.edge;
+			back_connection.pathway_start = poly.points[free_edge.edge].pos;
+			back_connection.pathway_end = poly.points[(free_edge.edge + 1) % poly.points.size()].pos;
+			other_poly.edges[other_free_edge.edge].connections.push_back(back_connection);
+		}
+		return;
+	}
+
+	// Find the compatible near edges, among the free edges of other regions in the same grid cells.
+	//
+	// Note:
+	// Considering that the edges must be compatible (for obvious reasons)
+	// to be connected, create new polygons to remove that small gap is
+	// not really useful and would result in wasteful computation during
+	// connection, integration and path finding.
+	r_candidates.clear();
+	for (int x = free_edge.cell_begin.x; x <= free_edge.cell_end.x; x++) {
+		for (int y = free_edge.cell_begin.y; y <= free_edge.cell_end.y; y++) {
+			for (int z = free_edge.cell_begin.z; z <= free_edge.cell_end.z; z++) {
+				const LocalVector<gd::FreeEdgeRef> *cell = free_edges_by_cell.getptr(Vector3i(x, y, z));
+				if (!cell) {
 					continue;
 				}
+				for (uint32_t i = 0; i < cell->size(); i++) {
+					const gd::FreeEdgeRef &ref = (*cell)[i];
+					if (ref.region != p_map_region && r_candidates.find(ref) == -1) {
+						r_candidates.push_back(ref);
+					}
+				}
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < r_candidates.size(); i++) {
+		const gd::FreeEdgeRef &other = r_candidates[i];
+		const gd::FreeEdge &other_free_edge = other.region->free_edges[other.free_edge];
+		if (free_edges_by_key[other_free_edge.key].size() != 1) {
+			// Shared with an edge of another region, so not free.
+			continue;
+		}
+		gd::Polygon &other_poly = other.region->region->get_polygons()[other_free_edge.polygon];
+
+		gd::Edge::Connection connection;
+		if (_get_near_edge_connection(poly, free_edge.edge, other_poly, other_free_edge.edge, edge_connection_margin, connection)) {
+			edge.connections.push_back(connection);
 
-				// The edges can now be connected.
-				gd::Edge::Connection new_connection = other_edge;
-				new_connection.pathway_start = (self1 + other1) / 2.0;
-				new_connection.pathway_end = (self2 + other2) / 2.0;
-				free_edge.polygon->edges[free_edge.edge].connections.push_back(new_connection);
+			// Add the connection to the region_connection map.
+			p_map_region->region->get_connections().push_back(connection);
+		}
+
+		if (!p_connected_map_regions.has(other.region) && _get_near_edge_connection(other_poly, other_free_edge.edge, poly, free_edge.edge, edge_connection_margin, connection)) {
+			other_poly.edges[other_free_edge.edge].connections.push_back(connection);
+			other.region->region->get_connections().push_back(connection);
+		}
+	}
+}
+
+void NavMap::_update_links() {
+	uint32_t link_poly_idx = 0;
+	link_polygons.resize(links.size());
 
-				// Add the connection to the region_connection map.
-				((NavRegion *)free_edge.polygon->owner)->get_connections().push_back(new_connection);
+	// Search for polygons within range of a nav link.
+	for (uint32_t l = 0; l < links.size(); l++) {
+		const NavLink *link = links[l];
+		const Vector3 start = link->get_start_location();
+		const Vector3 end = link->get_end_location();
+
+		// Find the closest polygons within the search radius of the start and end points.
+		NavMapClosestPointQuery start_query;
+		start_query.polygons = &polygons;
+		start_query.point = start;
+		start_query.best = link_connection_radius * link_connection_radius;
+		_query_polygon_bvh(start_query);
+
+		NavMapClosestPointQuery end_query = start_query;
+		end_query.point = end;
+		_query_polygon_bvh(end_query);
+
+		gd::Polygon *closest_start_polygon = start_query.polygon != UINT32_MAX ? polygons[start_query.polygon] : nullptr;
+		const Vector3 closest_start_point = start_query.closest_point;
+		gd::Polygon *closest_end_polygon = end_query.polygon != UINT32_MAX ? polygons[end_query.polygon] : nullptr;
+		const Vector3 closest_end_point = end_query.closest_point;
+
+		// If we have both a start and end point, then create a synthetic polygon to route through.
+		if (closest_start_polygon && closest_end_polygon) {
+			gd::Polygon &new_polygon = link_polygons[link_poly_idx++];
+			new_polygon.owner = link;
+
+			new_polygon.edges.clear();
+			new_polygon.edges.resize(4);
+			new_polygon.points.clear();
+			new_polygon.points.reserve(4);
+
+			// Build a set of vertices that create a thin polygon going from the start to the end point.
+			new_polygon.points.push_back({ closest_start_point, get_point_key(closest_start_point) });
+			new_polygon.points.push_back({ closest_start_point, get_point_key(closest_start_point) });
+			new_polygon.points.push_back({ closest_end_point, get_point_key(closest_end_point) });
+			new_polygon.points.push_back({ closest_end_point, get_point_key(closest_end_point) });
+
+			Vector3 center;
+			for (int p = 0; p < 4; ++p) {
+				center += new_polygon.points[p].pos;
+			}
+			new_polygon.center = center / real_t(new_polygon.points.size());
+			new_polygon.clockwise = true;
+
+			// Setup connections to go forward in the link.
+			{
+				gd::Edge::Connection entry_connection;
+				entry_connection.polygon = &new_polygon;
+				entry_connection.edge = -1;
+				entry_connection.pathway_start = new_polygon.points[0].pos;
+				entry_connection.pathway_end = new_polygon.points[1].pos;
+				closest_start_polygon->edges[0].connections.push_back(entry_connection);
+				link_anchors.push_back(closest_start_polygon);
+
+				gd::Edge::Connection exit_connection;
+				exit_connection.polygon = closest_end_polygon;
+				exit_connection.edge = -1;
+				exit_connection.pathway_start = new_polygon.points[2].pos;
+				exit_connection.pathway_end = new_polygon.points[3].pos;
+				new_polygon.edges[2].connections.push_back(exit_connection);
+			}
+
+			// If the link is bi-directional, create connections from the end to the start.
+			if (link->is_bidirectional()) {
+				gd::Edge::Connection entry_connection;
+				entry_connection.polygon = &new_polygon;
+				entry_connection.edge = -1;
+				entry_connection.pathway_start = new_polygon.points[2].pos;
+				entry_connection.pathway_end = new_polygon.points[3].pos;
+				closest_end_polygon->edges[0].connections.push_back(entry_connection);
+				link_anchors.push_back(closest_end_polygon);
+
+				gd::Edge::Connection exit_connection;
+				exit_connection.polygon = closest_start_polygon;
+				exit_connection.edge = -1;
+				exit_connection.pathway_start = new_polygon.points[0].pos;
+				exit_connection.pathway_end = new_polygon.points[1].pos;
+				new_polygon.edges[0].connections.push_back(exit_connection);
 			}
 		}
+	}
+}
 
-		uint32_t link_poly_idx = 0;
-		link_polygons.resize(links.size());
+struct NavMapClusterSearchCompare {
+	_FORCE_INLINE_ bool operator()(const gd::ClusterSearchEntry &p_a, const gd::ClusterSearchEntry &p_b) const {
+		// Keeps the lowest cost on top of the heap.
+		return p_a.cost > p_b.cost;
+	}
+};
 
-		// Search for polygons within range of a nav link.
-		for (uint32_t l = 0; l < links.size(); l++) {
-			const NavLink *link = links[l];
-			const Vector3 start = link->get_start_location();
-			const Vector3 end = link->get_end_location();
+static void _cluster_heap_push(LocalVector<gd::ClusterSearchEntry> &r_heap, float p_cost, uint32_t p_polygon) {
+	gd::ClusterSearchEntry entry;
+	entry.cost = p_cost;
+	entry.polygon = p_polygon;
+	r_heap.push_back(entry);
 
-			gd::Polygon *closest_start_polygon = nullptr;
-			real_t closest_start_distance = link_connection_radius;
-			Vector3 closest_start_point;
+	SortArray<gd::ClusterSearchEntry, NavMapClusterSearchCompare> sorter;
+	sorter.push_heap(0, r_heap.size() - 1, 0, entry, r_heap.ptr());
+}
 
-			gd::Polygon *closest_end_polygon = nullptr;
-			real_t closest_end_distance = link_connection_radius;
-			Vector3 closest_end_point;
+static gd::ClusterSearchEntry _cluster_heap_pop(LocalVector<gd::ClusterSearchEntry> &r_heap) {
+	SortArray<gd::ClusterSearchEntry, NavMapClusterSearchCompare> sorter;
+	sorter.pop_heap(0, r_heap.size(), r_heap.ptr());
 
-			// Create link to any polygons within the search radius of the start point.
-			for (uint32_t start_index = 0; start_index < polygons.size(); start_index++) {
-				gd::Polygon &start_poly = polygons[start_index];
+	const gd::ClusterSearchEntry entry = r_heap[r_heap.size() - 1];
+	r_heap.resize(r_heap.size() - 1);
+	return entry;
+}
 
-				// For each face check the distance to the start
-				for (uint32_t start_point_id = 2; start_point_id < start_poly.points.size(); start_point_id += 1) {
-					const Face3 start_face(start_poly.points[0].pos, start_poly.points[start_point_id - 1].pos, start_poly.points[start_point_id].pos);
-					const Vector3 start_point = start_face.get_closest_point_to(start);
-					const real_t start_distance = start_point.distance_to(start);
+static void _cluster_search_reach(HashMap<uint32_t, gd::ClusterSearchNode> &r_nodes, LocalVector<gd::ClusterSearchEntry> &r_heap, uint32_t p_polygon, float p_cost, int64_t p_previous, const NavBase *p_link) {
+	HashMap<uint32_t, gd::ClusterSearchNode>::Iterator E = r_nodes.find(p_polygon);
+	if (E && E->value.cost <= p_cost) {
+		return;
+	}
 
-					// Pick the polygon that is within our radius and is closer than anything we've seen yet.
-					if (start_distance <= link_connection_radius && start_distance < closest_start_distance) {
-						closest_start_distance = start_distance;
-						closest_start_point = start_point;
-						closest_start_polygon = &start_poly;
-					}
+	gd::ClusterSearchNode node;
+	node.cost = p_cost;
+	node.previous = p_previous;
+	node.link = p_link;
+	r_nodes.insert(p_polygon, node);
+	_cluster_heap_push(r_heap, p_cost, p_polygon);
+}
+
+void NavMap::_get_cluster_distances(const gd::MapRegion &p_map_region, uint32_t p_from, LocalVector<float> &r_distances, LocalVector<gd::ClusterSearchEntry> &r_heap) const {
+	r_distances.resize(p_map_region.polygon_count);
+	for (uint32_t i = 0; i < p_map_region.polygon_count; i++) {
+		r_distances[i] = 1e30;
+	}
+
+	// Dijkstra over the polygon centers, without leaving the region.
+	r_heap.clear();
+	r_distances[p_from] = 0.0;
+	_cluster_heap_push(r_heap, 0.0, p_from);
+
+	while (!r_heap.is_empty()) {
+		const gd::ClusterSearchEntry entry = _cluster_heap_pop(r_heap);
+		if (entry.cost > r_distances[entry.polygon]) {
+			continue;
+		}
+
+		const gd::Polygon &poly = *polygons[p_map_region.polygon_offset + entry.polygon];
+		for (uint32_t i = 0; i < poly.edges.size(); i++) {
+			const gd::Edge &edge = poly.edges[i];
+			for (int j = 0; j < edge.connections.size(); j++) {
+				const gd::Polygon *next = edge.connections[j].polygon;
+				if (next->owner != p_map_region.region) {
+					continue;
 				}
-			}
 
-			// Find any polygons within the search radius of the end point.
-			for (uint32_t end_index = 0; end_index < polygons.size(); end_index++) {
-				gd::Polygon &end_poly = polygons[end_index];
+				const uint32_t next_id = next->id - p_map_region.polygon_offset;
+				const float cost = entry.cost + poly.center.distance_to(next->center);
+				if (cost < r_distances[next_id]) {
+					r_distances[next_id] = cost;
+					_cluster_heap_push(r_heap, cost, next_id);
+				}
+			}
+		}
+	}
+}
 
-				// For each face check the distance to the end
-				for (uint32_t end_point_id = 2; end_point_id < end_poly.points.size(); end_point_id += 1) {
-					const Face3 end_face(end_poly.points[0].pos, end_poly.points[end_point_id - 1].pos, end_poly.points[end_point_id].pos);
-					const Vector3 end_point = end_face.get_closest_point_to(end);
-					const real_t end_distance = end_point.distance_to(end);
+void NavMap::_compute_cluster_distances(uint32_t p_index, gd::MapRegion **p_map_regions) {
+	gd::MapRegion &map_region = *p_map_regions[p_index];
+	const uint32_t boundary_count = map_region.boundary.size();
+	map_region.boundary_distances.resize(boundary_count * boundary_count);
+
+	LocalVector<float> distances;
+	LocalVector<gd::ClusterSearchEntry> heap;
+	for (uint32_t i = 0; i < boundary_count; i++) {
+		_get_cluster_distances(map_region, map_region.boundary[i], distances, heap);
+		for (uint32_t j = 0; j < boundary_count; j++) {
+			map_region.boundary_distances[i * boundary_count + j] = distances[map_region.boundary[j]];
+		}
+	}
+}
 
-					// Pick the polygon that is within our radius and is closer than anything we've seen yet.
-					if (end_distance <= link_connection_radius && end_distance < closest_end_distance) {
-						closest_end_distance = end_distance;
-						closest_end_point = end_point;
-						closest_end_polygon = &end_poly;
+void NavMap::_update_clusters() {
+	// Above this, the boundary distance table would cost more than searching the region polygons.
+	const uint32_t max_boundary_polygons = 256;
+
+	// Polygons with a connection to another region or to a link, and the polygons links lead to, are boundary polygons.
+	// Only the free edges connect to other regions, and the links start from their anchors.
+	LocalVector<uint32_t> boundary_polygons;
+	for (uint32_t r = 0; r < map_regions.size(); r++) {
+		const gd::MapRegion *map_region = map_regions[r];
+		const LocalVector<gd::Polygon> &region_polygons = map_region->region->get_polygons();
+		for (uint32_t i = 0; i < map_region->free_edges.size(); i++) {
+			const gd::FreeEdge &free_edge = map_region->free_edges[i];
+			if (!region_polygons[free_edge.polygon].edges[free_edge.edge].connections.is_empty()) {
+				boundary_polygons.push_back(map_region->polygon_offset + free_edge.polygon);
+			}
+		}
+	}
+	for (uint32_t i = 0; i < link_anchors.size(); i++) {
+		boundary_polygons.push_back(link_anchors[i]->id);
+
+		const gd::Edge &edge = link_anchors[i]->edges[0];
+		for (int j = 0; j < edge.connections.size(); j++) {
+			const gd::Polygon *other = edge.connections[j].polygon;
+			if (_is_map_polygon(other)) {
+				continue;
+			}
+			for (uint32_t k = 0; k < other->edges.size(); k++) {
+				const gd::Edge &link_edge = other->edges[k];
+				for (int l = 0; l < link_edge.connections.size(); l++) {
+					const gd::Polygon *link_exit = link_edge.connections[l].polygon;
+					if (_is_map_polygon(link_exit)) {
+						boundary_polygons.push_back(link_exit->id);
 					}
 				}
 			}
+		}
+	}
+	boundary_polygons.sort();
+
+	// The map polygons of a region are contiguous, so the region boundaries come out sorted.
+	LocalVector<LocalVector<uint32_t>> boundaries;
+	boundaries.resize(map_regions.size());
+	polygon_boundary_ids.resize(polygons.size());
+	for (uint32_t i = 0; i < polygons.size(); i++) {
+		polygon_boundary_ids[i] = UINT32_MAX;
+	}
+	for (uint32_t i = 0; i < boundary_polygons.size(); i++) {
+		const uint32_t poly_id = boundary_polygons[i];
+		if (i > 0 && boundary_polygons[i - 1] == poly_id) {
+			continue;
+		}
+		LocalVector<uint32_t> &boundary = boundaries[polygon_regions[poly_id]];
+		polygon_boundary_ids[poly_id] = boundary.size();
+		boundary.push_back(poly_id - map_regions[polygon_regions[poly_id]]->polygon_offset);
+	}
+
+	LocalVector<gd::MapRegion *> dirty_map_regions;
+	for (uint32_t r = 0; r < map_regions.size(); r++) {
+		gd::MapRegion *map_region = map_regions[r];
+		const LocalVector<uint32_t> &boundary = boundaries[r];
+
+		// The distances only depend on the region polygons, keep them while those and the boundary don't change.
+		bool same_boundary = map_region->boundary.size() == boundary.size();
+		for (uint32_t i = 0; same_boundary && i < boundary.size(); i++) {
+			same_boundary = map_region->boundary[i] == boundary[i];
+		}
+		if (!same_boundary) {
+			map_region->boundary = boundary;
+			map_region->boundary_distances.clear();
+		}
+
+		if (map_region->boundary.size() > max_boundary_polygons) {
+			map_region->boundary_distances.clear();
+			continue;
+		}
+		if (map_region->boundary_distances.is_empty() && !map_region->boundary.is_empty()) {
+			dirty_map_regions.push_back(map_region);
+		}
+	}
+
+	if (dirty_map_regions.size() > 0) {
+		WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &NavMap::_compute_cluster_distances, dirty_map_regions.ptr(), dirty_map_regions.size(), -1, true, SNAME("NavigationMapClusters"));
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+	}
+}
+
+bool NavMap::_find_path_corridor(const gd::Polygon *p_begin_poly, const gd::Polygon *p_end_poly, uint32_t p_navigation_layers, gd::PathQueryScratch &r_scratch) const {
+	if (polygon_boundary_ids.size() != polygons.size()) {
+		return false;
+	}
+
+	const uint32_t begin_id = p_begin_poly->id;
+	const uint32_t end_id = p_end_poly->id;
+	const gd::MapRegion &begin_cluster = *map_regions[polygon_regions[begin_id]];
+	const gd::MapRegion &end_cluster = *map_regions[polygon_regions[end_id]];
+
+	_get_cluster_distances(begin_cluster, begin_id - begin_cluster.polygon_offset, r_scratch.begin_distances, r_scratch.cluster_heap);
+	_get_cluster_distances(end_cluster, end_id - end_cluster.polygon_offset, r_scratch.end_distances, r_scratch.cluster_heap);
+
+	// Dijkstra over the boundary polygons, using the precomputed distances inside each region.
+	HashMap<uint32_t, gd::ClusterSearchNode> &nodes = r_scratch.cluster_nodes;
+	LocalVector<gd::ClusterSearchEntry> &heap = r_scratch.cluster_heap;
+	nodes.clear();
+	heap.clear();
+
+	const float begin_travel_cost = begin_cluster.region->get_travel_cost();
+	for (uint32_t i = 0; i < begin_cluster.boundary.size(); i++) {
+		const float distance = r_scratch.begin_distances[begin_cluster.boundary[i]];
+		if (distance < 1e30) {
+			_cluster_search_reach(nodes, heap, begin_cluster.polygon_offset + begin_cluster.boundary[i], distance * begin_travel_cost, -1, nullptr);
+		}
+	}
+
+	const float end_travel_cost = end_cluster.region->get_travel_cost();
+	float best_cost = 1e30;
+	int64_t best_poly_id = -1;
 
-			// If we have both a start and end point, then create a synthetic polygon to route through.
-			if (closest_start_polygon && closest_end_polygon) {
-				gd::Polygon &new_polygon = link_polygons[link_poly_idx++];
-				new_polygon.owner = link;
+	while (!heap.is_empty()) {
+		const gd::ClusterSearchEntry entry = _cluster_heap_pop(heap);
+		if (entry.cost >= best_cost) {
+			break;
+		}
+		if (entry.cost > nodes[entry.polygon].cost) {
+			continue;
+		}
 
-				new_polygon.edges.clear();
-				new_polygon.edges.resize(4);
-				new_polygon.points.clear();
-				new_polygon.points.reserve(4);
+		const gd::MapRegion &cluster = *map_regions[polygon_regions[entry.polygon]];
+		if (&cluster == &end_cluster) {
+			const float distance = r_scratch.end_distances[entry.polygon - cluster.polygon_offset];
+			if (distance < 1e30 && entry.cost + distance * end_travel_cost < best_cost) {
+				best_cost = entry.cost + distance * end_travel_cost;
+				best_poly_id = entry.polygon;
+			}
+		}
 
-				// Build a set of vertices that create a thin polygon going from the start to the end point.
-				new_polygon.points.push_back({ closest_start_point, get_point_key(closest_start_point) });
-				new_polygon.points.push_back({ closest_start_point, get_point_key(closest_start_point) });
-				new_polygon.points.push_back({ closest_end_point, get_point_key(closest_end_point) });
-				new_polygon.points.push_back({ closest_end_point, get_point_key(closest_end_point) });
+		// Reach the other boundary polygons of the region.
+		const uint32_t boundary_id = polygon_boundary_ids[entry.polygon];
+		if (boundary_id != UINT32_MAX && !cluster.boundary_distances.is_empty()) {
+			const uint32_t boundary_count = cluster.boundary.size();
+			const float travel_cost = cluster.region->get_travel_cost();
+			for (uint32_t i = 0; i < boundary_count; i++) {
+				const float distance = cluster.boundary_distances[boundary_id * boundary_count + i];
+				if (i != boundary_id && distance < 1e30) {
+					_cluster_search_reach(nodes, heap, cluster.polygon_offset + cluster.boundary[i], entry.cost + distance * travel_cost, entry.polygon, nullptr);
+				}
+			}
+		}
 
-				Vector3 center;
-				for (int p = 0; p < 4; ++p) {
-					center += new_polygon.points[p].pos;
+		// Leave the region, either directly or through a link.
+		const gd::Polygon &poly = *polygons[entry.polygon];
+		for (uint32_t i = 0; i < poly.edges.size(); i++) {
+			const gd::Edge &edge = poly.edges[i];
+			for (int j = 0; j < edge.connections.size(); j++) {
+				const gd::Polygon *other = edge.connections[j].polygon;
+				if (other->owner == poly.owner || (p_navigation_layers & other->owner->get_navigation_layers()) == 0) {
+					continue;
 				}
-				new_polygon.center = center / real_t(new_polygon.points.size());
-				new_polygon.clockwise = true;
-
-				// Setup connections to go forward in the link.
-				{
-					gd::Edge::Connection entry_connection;
-					entry_connection.polygon = &new_polygon;
-					entry_connection.edge = -1;
-					entry_connection.pathway_start = new_polygon.points[0].pos;
-					entry_connection.pathway_end = new_polygon.points[1].pos;
-					closest_start_polygon->edges[0].connections.push_back(entry_connection);
-
-					gd::Edge::Connection exit_connection;
-					exit_connection.polygon = closest_end_polygon;
-					exit_connection.edge = -1;
-					exit_connection.pathway_start = new_polygon.points[2].pos;
-					exit_connection.pathway_end = new_polygon.points[3].pos;
-					new_polygon.edges[2].connections.push_back(exit_connection);
+
+				if (_is_map_polygon(other)) {
+					const float cost = entry.cost + poly.center.distance_to(other->center) * other->owner->get_travel_cost() + other->owner->get_enter_cost();
+					_cluster_search_reach(nodes, heap, other->id, cost, entry.polygon, nullptr);
+					continue;
 				}
 
-				// If the link is bi-directional, create connections from the end to the start.
-				if (link->is_bidirectional()) {
-					gd::Edge::Connection entry_connection;
-					entry_connection.polygon = &new_polygon;
-					entry_connection.edge = -1;
-					entry_connection.pathway_start = new_polygon.points[2].pos;
-					entry_connection.pathway_end = new_polygon.points[3].pos;
-					closest_end_polygon->edges[0].connections.push_back(entry_connection);
-
-					gd::Edge::Connection exit_connection;
-					exit_connection.polygon = closest_start_polygon;
-					exit_connection.edge = -1;
-					exit_connection.pathway_start = new_polygon.points[0].pos;
-					exit_connection.pathway_end = new_polygon.points[1].pos;
-					new_polygon.edges[0].connections.push_back(exit_connection);
+				const float link_cost = entry.cost + other->points[0].pos.distance_to(other->points[2].pos) * other->owner->get_travel_cost() + other->owner->get_enter_cost();
+				for (uint32_t k = 0; k < other->edges.size(); k++) {
+					const gd::Edge &link_edge = other->edges[k];
+					for (int l = 0; l < link_edge.connections.size(); l++) {
+						const gd::Polygon *link_exit = link_edge.connections[l].polygon;
+						if (link_exit == &poly || !_is_map_polygon(link_exit) || (p_navigation_layers & link_exit->owner->get_navigation_layers()) == 0) {
+							continue;
+						}
+						_cluster_search_reach(nodes, heap, link_exit->id, link_cost + link_exit->owner->get_enter_cost(), entry.polygon, other->owner);
+					}
 				}
 			}
 		}
+	}
 
-		// Update the update ID.
-		map_update_id = (map_update_id + 1) % 9999999;
+	if (best_poly_id == -1) {
+		return false;
 	}
 
-	// Update agents tree.
-	if (agents_dirty) {
-		// cannot use LocalVector here as RVO library expects std::vector to build KdTree
-		std::vector<RVO::Agent *> raw_agents;
-		raw_agents.reserve(agents.size());
-		for (size_t i(0); i < agents.size(); i++) {
-			raw_agents.push_back(agents[i]->get_agent());
+	HashSet<const NavBase *> &corridor = r_scratch.corridor;
+	corridor.clear();
+	corridor.insert(begin_cluster.region);
+	corridor.insert(end_cluster.region);
+	for (int64_t poly_id = best_poly_id; poly_id != -1; poly_id = nodes[poly_id].previous) {
+		const gd::ClusterSearchNode &node = nodes[poly_id];
+		corridor.insert(polygons[poly_id]->owner);
+		if (node.link) {
+			corridor.insert(node.link);
 		}
-		rvo.buildAgentTree(raw_agents);
 	}
+	return true;
+}
 
-	regenerate_polygons = false;
-	regenerate_links = false;
-	agents_dirty = false;
+void NavMap::_insert_avoidance_agent(uint32_t p_index, const Vector2i &p_cell) {
+	LocalVector<uint32_t> &cell_agents = avoidance_cells[p_cell];
+	agent_cells[p_index] = p_cell;
+	agent_cell_slots[p_index] = cell_agents.size();
+	cell_agents.push_back(p_index);
+}
+
+void NavMap::_remove_avoidance_agent(uint32_t p_index) {
+	HashMap<Vector2i, LocalVector<uint32_t>>::Iterator E = avoidance_cells.find(agent_cells[p_index]);
+	ERR_FAIL_COND(!E);
+	LocalVector<uint32_t> &cell_agents = E->value;
+
+	// Fill the slot with the last agent of the cell.
+	const uint32_t slot = agent_cell_slots[p_index];
+	const uint32_t moved = cell_agents[cell_agents.size() - 1];
+	cell_agents[slot] = moved;
+	agent_cell_slots[moved] = slot;
+	cell_agents.resize(cell_agents.size() - 1);
+
+	if (cell_agents.is_empty()) {
+		avoidance_cells.remove(E);
+	}
+}
+
+void NavMap::_update_avoidance_cells() {
+	// Cells as wide as the largest neighbor distance let any search visit at most two rings of cells,
+	// however small the agents are compared to how far they look.
+	real_t max_neighbor_distance = 0.0;
+	for (uint32_t i = 0; i < agents.size(); i++) {
+		max_neighbor_distance = MAX(max_neighbor_distance, agents[i]->get_agent()->neighborDist_);
+	}
+	const real_t cell_size = MAX(max_neighbor_distance, (real_t)0.1);
+
+	if (agents_dirty || cell_size != avoidance_cell_size) {
+		avoidance_cell_size = cell_size;
+		avoidance_cells.clear();
+		agent_positions.resize(agents.size());
+		agent_cells.resize(agents.size());
+		agent_cell_slots.resize(agents.size());
+		for (uint32_t i = 0; i < agents.size(); i++) {
+			const RVO::Vector3 &position = agents[i]->get_agent()->position_;
+			agent_positions[i] = Vector3(position.x(), position.y(), position.z());
+			_insert_avoidance_agent(i, _get_avoidance_cell(agent_positions[i]));
+		}
+		agents_dirty = false;
+	} else {
+		for (uint32_t i = 0; i < agents.size(); i++) {
+			const RVO::Vector3 &position = agents[i]->get_agent()->position_;
+			agent_positions[i] = Vector3(position.x(), position.y(), position.z());
+			const Vector2i cell = _get_avoidance_cell(agent_positions[i]);
+			if (cell != agent_cells[i]) {
+				_remove_avoidance_agent(i);
+				_insert_avoidance_agent(i, cell);
+			}
+		}
+	}
+
+	if (agents.size() > 0) {
+		avoidance_cells_min = agent_cells[0];
+		avoidance_cells_max = agent_cells[0];
+		for (uint32_t i = 1; i < agents.size(); i++) {
+			avoidance_cells_min.x = MIN(avoidance_cells_min.x, agent_cells[i].x);
+			avoidance_cells_min.y = MIN(avoidance_cells_min.y, agent_cells[i].y);
+			avoidance_cells_max.x = MAX(avoidance_cells_max.x, agent_cells[i].x);
+			avoidance_cells_max.y = MAX(avoidance_cells_max.y, agent_cells[i].y);
+		}
+	}
+}
+
+void NavMap::_compute_avoidance_neighbors(RVO::Agent *p_agent) const {
+	p_agent->agentNeighbors_.clear();
+	if (p_agent->maxNeighbors_ == 0) {
+		return;
+	}
+
+	const Vector3 position(p_agent->position_.x(), p_agent->position_.y(), p_agent->position_.z());
+	const Vector2i center = _get_avoidance_cell(position);
+	float range_sq = p_agent->neighborDist_ * p_agent->neighborDist_;
+
+	// Visit square rings of cells around the agent, until the rings are farther than the range.
+	// The range shrinks to the farthest neighbor once the agent has as many neighbors as it can have.
+	for (int ring = 0;; ring++) {
+		if (ring > 0) {
+			const real_t ring_distance = (ring - 1) * avoidance_cell_size;
+			if (ring_distance * ring_distance >= range_sq) {
+				break;
+			}
+		}
+
+		const Vector2i ring_min = center - Vector2i(ring, ring);
+		const Vector2i ring_max = center + Vector2i(ring, ring);
+		for (int z = MAX(ring_min.y, avoidance_cells_min.y); z <= MIN(ring_max.y, avoidance_cells_max.y); z++) {
+			// Only the first and last rows of the ring are full, the other rows have a cell at each end.
+			const int x_step = (z == ring_min.y || z == ring_max.y) ? 1 : ring * 2;
+			for (int x = ring_min.x; x <= ring_max.x; x += x_step) {
+				if (x < avoidance_cells_min.x || x > avoidance_cells_max.x) {
+					continue;
+				}
+				const LocalVector<uint32_t> *cell_agents = avoidance_cells.getptr(Vector2i(x, z));
+				if (!cell_agents) {
+					continue;
+				}
+				for (uint32_t i = 0; i < cell_agents->size(); i++) {
+					const uint32_t other = (*cell_agents)[i];
+					if (agent_positions[other].distance_squared_to(position) < range_sq) {
+						p_agent->insertAgentNeighbor(agents[other]->get_agent(), range_sq);
+					}
+				}
+			}
+		}
+
+		if (ring_min.x <= avoidance_cells_min.x && ring_min.y <= avoidance_cells_min.y && ring_max.x >= avoidance_cells_max.x && ring_max.y >= avoidance_cells_max.y) {
+			// All the agents have been visited.
+			break;
+		}
+	}
 }
 
 void NavMap::compute_single_step(uint32_t index, RvoAgent **agent) {
-	(*(agent + index))->get_agent()->computeNeighbors(&rvo);
-	(*(agent + index))->get_agent()->computeNewVelocity(deltatime);
+	RVO::Agent *rvo_agent = (*(agent + index))->get_agent();
+	_compute_avoidance_neighbors(rvo_agent);
+	rvo_agent->computeNewVelocity(deltatime);
 }
 
 void NavMap::step(real_t p_deltatime) {
 	deltatime = p_deltatime;
-	if (controlled_agents.size() > 0) {
-		WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &NavMap::compute_single_step, controlled_agents.ptr(), controlled_agents.size(), -1, true, SNAME("NavigationMapAgents"));
+	_update_avoidance_cells();
+
+	// The avoidance callback wants the velocities of all the agents, not only the controlled ones.
+	LocalVector<RvoAgent *> &stepped_agents = avoidance_callback.is_valid() ? agents : controlled_agents;
+	if (stepped_agents.size() > 0) {
+		WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &NavMap::compute_single_step, stepped_agents.ptr(), stepped_agents.size(), -1, true, SNAME("NavigationMapAgents"));
 		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
 	}
 }
@@ -836,6 +1790,32 @@ void NavMap::dispatch_callbacks() {
 	for (int i(0); i < static_cast<int>(controlled_agents.size()); i++) {
 		controlled_agents[i]->dispatch_callback();
 	}
+
+	if (!avoidance_callback.is_valid() || agents.is_empty()) {
+		return;
+	}
+
+	// All the velocities are delivered with a single call.
+	TypedArray<RID> agent_rids;
+	PackedVector3Array velocities;
+	agent_rids.resize(agents.size());
+	velocities.resize(agents.size());
+	Vector3 *velocities_ptrw = velocities.ptrw();
+	for (uint32_t i = 0; i < agents.size(); i++) {
+		const RVO::Vector3 &velocity = agents[i]->get_agent()->newVelocity_;
+		agent_rids[i] = agents[i]->get_self();
+		velocities_ptrw[i] = Vector3(velocity.x(), velocity.y(), velocity.z());
+	}
+
+	const Variant agents_arg = agent_rids;
+	const Variant velocities_arg = velocities;
+	const Variant *args[2] = { &agents_arg, &velocities_arg };
+	Variant ret;
+	Callable::CallError ce;
+	avoidance_callback.callp(args, 2, ret, ce);
+	if (ce.error != Callable::CallError::CALL_OK) {
+		ERR_PRINT("Error calling the avoidance callback: " + Variant::get_callable_error_text(avoidance_callback, args, 2, ce) + ".");
+	}
 }
 
 void NavMap::clip_path(const LocalVector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const {
@@ -874,4 +1854,7 @@ NavMap::NavMap() {
 }
 
 NavMap::~NavMap() {
+	for (uint32_t r = 0; r < map_regions.size(); r++) {
+		memdelete(map_regions[r]);
+	}
 }
@@ -38,12 +38,14 @@
 #include "core/templates/rb_map.h"
 #include "nav_utils.h"
 
-#include <KdTree.h>
-
 class NavLink;
 class NavRegion;
 class RvoAgent;
 
+namespace RVO {
+class Agent;
+}
+
 class NavMap : public NavRid {
 	/// Map Up
 	Vector3 up = Vector3(0, 1, 0);
@@ -68,11 +70,36 @@ class NavMap : public NavRid {
 	LocalVector<NavLink *> links;
 	LocalVector<gd::Polygon> link_polygons;
 
-	/// Map polygons
-	LocalVector<gd::Polygon> polygons;
+	/// Map polygons, pointing into the polygons of the regions.
+	LocalVector<gd::Polygon *> polygons;
+
+	/// What the map keeps about each region, in the same order as `regions`.
+	LocalVector<gd::MapRegion *> map_regions;
+	/// For each map polygon, the index of its region.
+	LocalVector<uint32_t> polygon_regions;
+
+	/// The region free edges by key and by grid cell, to find the edges of other regions to connect them to.
+	HashMap<gd::EdgeKey, LocalVector<gd::FreeEdgeRef>, gd::EdgeKey> free_edges_by_key;
+	HashMap<Vector3i, LocalVector<gd::FreeEdgeRef>> free_edges_by_cell;
+	real_t free_edge_cell_size = 0.0;
+	bool regenerate_free_edges = true;
+
+	/// Region polygons the links are connected from.
+	LocalVector<gd::Polygon *> link_anchors;
+
+	/// Bounding volume hierarchy over the region hierarchies, used to find the polygons near a point or segment.
+	LocalVector<gd::PolygonBVHNode> region_bvh;
+	LocalVector<uint32_t> region_bvh_items;
 
-	/// Rvo world
-	RVO::KdTree rvo;
+	/// Plan long paths region by region before searching polygons.
+	bool use_hierarchical_paths = false;
+
+	/// For each map polygon, its index in its region boundary (or UINT32_MAX).
+	LocalVector<uint32_t> polygon_boundary_ids;
+
+	/// Statistics of the regions, the rebuilt count is for the last sync.
+	uint32_t rebuilt_region_count = 0;
+	uint32_t free_edge_count = 0;
 
 	/// Is agent array modified?
 	bool agents_dirty = false;
@@ -83,6 +110,21 @@ class NavMap : public NavRid {
 	/// Controlled agents
 	LocalVector<RvoAgent *> controlled_agents;
 
+	/// The avoidance neighbors are searched in a spatial hash of square columns on the XZ plane.
+	/// Only the agents that moved to another cell are moved in the hash on each step.
+	HashMap<Vector2i, LocalVector<uint32_t>> avoidance_cells;
+	real_t avoidance_cell_size = 0.0;
+	Vector2i avoidance_cells_min;
+	Vector2i avoidance_cells_max;
+
+	/// Avoidance state of the agents, in the same order as `agents`.
+	LocalVector<Vector3> agent_positions;
+	LocalVector<Vector2i> agent_cells;
+	LocalVector<uint32_t> agent_cell_slots;
+
+	/// Receives the new velocities of all the agents after each step, when valid.
+	Callable avoidance_callback;
+
 	/// Physics delta time
 	real_t deltatime = 0.0;
 
@@ -113,9 +155,16 @@ public:
 		return link_connection_radius;
 	}
 
+	void set_use_hierarchical_paths(bool p_enabled);
+	bool get_use_hierarchical_paths() const {
+		return use_hierarchical_paths;
+	}
+
 	gd::PointKey get_point_key(const Vector3 &p_pos) const;
 
 	Vector<Vector3> get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers = 1) const;
+	/// Same as above, reusing the buffers of `r_scratch` to avoid allocations when searching many paths.
+	Vector<Vector3> get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers, gd::PathQueryScratch &r_scratch) const;
 	Vector3 get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const;
 	Vector3 get_closest_point(const Vector3 &p_point) const;
 	Vector3 get_closest_point_normal(const Vector3 &p_point) const;
@@ -144,15 +193,57 @@ public:
 	void set_agent_as_controlled(RvoAgent *agent);
 	void remove_agent_as_controlled(RvoAgent *agent);
 
+	void set_avoidance_callback(const Callable &p_callback) {
+		avoidance_callback = p_callback;
+	}
+
 	uint32_t get_map_update_id() const {
 		return map_update_id;
 	}
 
+	uint32_t get_polygon_count() const {
+		return polygons.size();
+	}
+	uint32_t get_free_edge_count() const {
+		return free_edge_count;
+	}
+	/// Number of regions whose polygons were rebuilt by the last sync.
+	uint32_t get_rebuilt_region_count() const {
+		return rebuilt_region_count;
+	}
+
 	void sync();
 	void step(real_t p_deltatime);
 	void dispatch_callbacks();
 
 private:
+	template <class T>
+	void _query_polygon_bvh(T &r_query) const;
+
+	_FORCE_INLINE_ bool _is_map_polygon(const gd::Polygon *p_polygon) const {
+		return p_polygon->id != UINT32_MAX;
+	}
+	void _update_map();
+	void _update_map_regions();
+	void _build_map_region(uint32_t p_index, gd::MapRegion **p_map_regions);
+	void _add_free_edges(gd::MapRegion *p_map_region);
+	void _remove_free_edges(gd::MapRegion *p_map_region);
+	void _connect_free_edge(gd::MapRegion *p_map_region, uint32_t p_free_edge, const HashSet<gd::MapRegion *> &p_connected_map_regions, LocalVector<gd::FreeEdgeRef> &r_candidates);
+	void _update_links();
+
+	void _update_clusters();
+	void _compute_cluster_distances(uint32_t p_index, gd::MapRegion **p_map_regions);
+	void _get_cluster_distances(const gd::MapRegion &p_map_region, uint32_t p_from, LocalVector<float> &r_distances, LocalVector<gd::ClusterSearchEntry> &r_heap) const;
+	bool _find_path_corridor(const gd::Polygon *p_begin_poly, const gd::Polygon *p_end_poly, uint32_t p_navigation_layers, gd::PathQueryScratch &r_scratch) const;
+
+	_FORCE_INLINE_ Vector2i _get_avoidance_cell(const Vector3 &p_position) const {
+		return Vector2i(Math::floor(p_position.x / avoidance_cell_size), Math::floor(p_position.z / avoidance_cell_size));
+	}
+	void _insert_avoidance_agent(uint32_t p_index, const Vector2i &p_cell);
+	void _remove_avoidance_agent(uint32_t p_index);
+	void _update_avoidance_cells();
+	void _compute_avoidance_neighbors(RVO::Agent *p_agent) const;
+
 	void compute_single_step(uint32_t index, RvoAgent **agent);
 	void clip_path(const LocalVector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const;
 };
@@ -32,6 +32,10 @@
 
 #include "nav_map.h"
 
+#include "core/templates/safe_refcount.h"
+
+static SafeNumeric<uint32_t> last_polygons_version;
+
 void NavRegion::set_map(NavMap *p_map) {
 	map = p_map;
 	polygons_dirty = true;
@@ -83,6 +87,7 @@ void NavRegion::update_polygons() {
 	}
 	polygons.clear();
 	polygons_dirty = false;
+	polygons_version = last_polygons_version.increment();
 
 	if (map == nullptr) {
 		return;
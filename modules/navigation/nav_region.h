@@ -47,6 +47,9 @@ class NavRegion : public NavBase {
 	/// Cache
 	LocalVector<gd::Polygon> polygons;
 
+	/// Changes each time the polygons are rebuilt, unique among all regions.
+	uint32_t polygons_version = 0;
+
 public:
 	NavRegion() {}
 
@@ -79,6 +82,14 @@ public:
 	LocalVector<gd::Polygon> const &get_polygons() const {
 		return polygons;
 	}
+	/// The map writes the polygon connections in place, they stay valid until the polygons are rebuilt.
+	LocalVector<gd::Polygon> &get_polygons() {
+		return polygons;
+	}
+
+	uint32_t get_polygons_version() const {
+		return polygons_version;
+	}
 
 	bool sync();
 
@@ -31,12 +31,16 @@
 #ifndef NAV_UTILS_H
 #define NAV_UTILS_H
 
+#include "core/math/aabb.h"
 #include "core/math/vector3.h"
+#include "core/math/vector3i.h"
 #include "core/templates/hash_map.h"
+#include "core/templates/hash_set.h"
 #include "core/templates/hashfuncs.h"
 #include "core/templates/local_vector.h"
 
 class NavBase;
+class NavRegion;
 
 namespace gd {
 struct Polygon;
@@ -112,6 +116,9 @@ struct Polygon {
 
 	/// The center of this `Polygon`
 	Vector3 center;
+
+	/// Index of this `Polygon` in the map polygons, UINT32_MAX for link polygons.
+	uint32_t id = UINT32_MAX;
 };
 
 struct NavigationPoly {
@@ -144,6 +151,102 @@ struct NavigationPoly {
 	}
 };
 
+struct PolygonBVHNode {
+	AABB aabb;
+
+	/// For leaves, the index of the first polygon in the item list.
+	/// For branches, the index of the first child, the second child follows it.
+	uint32_t first = 0;
+
+	/// Number of polygons in a leaf, 0 for branches.
+	uint32_t count = 0;
+};
+
+/// A region polygon edge not shared with another polygon of the region, which may connect to other regions.
+struct FreeEdge {
+	/// Region local ID of the polygon.
+	uint32_t polygon = 0;
+	uint32_t edge = 0;
+	EdgeKey key;
+
+	/// Range of the map grid cells the edge is registered in, to find the edges near it.
+	Vector3i cell_begin;
+	Vector3i cell_end;
+};
+
+struct MapRegion;
+
+struct FreeEdgeRef {
+	MapRegion *region = nullptr;
+	uint32_t free_edge = 0;
+
+	bool operator==(const FreeEdgeRef &p_ref) const {
+		return region == p_ref.region && free_edge == p_ref.free_edge;
+	}
+};
+
+/// What a map keeps about each of its regions. It is only rebuilt when the region polygons change,
+/// the regions that didn't change keep their connections between map syncs.
+struct MapRegion {
+	NavRegion *region = nullptr;
+
+	/// Version of the region polygons this was built for.
+	uint32_t polygons_version = 0;
+
+	/// Where the region polygons are, connections pointing there are stale once the region changes.
+	const Polygon *polygons_begin = nullptr;
+	const Polygon *polygons_end = nullptr;
+
+	/// Range of the region polygons in the map polygons.
+	uint32_t polygon_offset = 0;
+	uint32_t polygon_count = 0;
+
+	/// Bounding volume hierarchy over the region polygons, with region local IDs.
+	LocalVector<PolygonBVHNode> bvh;
+	LocalVector<uint32_t> bvh_items;
+
+	LocalVector<FreeEdge> free_edges;
+
+	/// Hierarchical path search data, the region being one node of the search.
+	/// Region local IDs of the polygons connected to other regions or links.
+	LocalVector<uint32_t> boundary;
+
+	/// Distance between each pair of boundary polygons when staying inside the region,
+	/// not scaled by the region travel cost. Empty if the region has too many boundary polygons.
+	LocalVector<float> boundary_distances;
+};
+
+struct ClusterSearchEntry {
+	float cost = 0.0;
+	uint32_t polygon = 0;
+};
+
+struct ClusterSearchNode {
+	float cost = 0.0;
+	/// Boundary polygon this one was reached from, or -1 for the ones next to the start.
+	int64_t previous = -1;
+	/// Link crossed to reach this polygon, if any.
+	const NavBase *link = nullptr;
+};
+
+/// Buffers used by the path search, kept between searches to reuse their memory.
+struct PathQueryScratch {
+	/// All reachable navigation polys.
+	LocalVector<NavigationPoly> navigation_polys;
+
+	/// Navigation poly IDs to visit.
+	LocalVector<uint32_t> to_visit;
+
+	/// Hierarchical search state.
+	LocalVector<float> begin_distances;
+	LocalVector<float> end_distances;
+	LocalVector<ClusterSearchEntry> cluster_heap;
+	HashMap<uint32_t, ClusterSearchNode> cluster_nodes;
+
+	/// Regions and links the path search is restricted to.
+	HashSet<const NavBase *> corridor;
+};
+
 struct ClosestPointQueryResult {
 	Vector3 point;
 	Vector3 normal;
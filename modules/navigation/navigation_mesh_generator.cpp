@@ -33,6 +33,7 @@
 #include "navigation_mesh_generator.h"
 
 #include "core/math/convex_hull.h"
+#include "core/object/worker_thread_pool.h"
 #include "core/os/thread.h"
 #include "scene/3d/mesh_instance_3d.h"
 #include "scene/3d/multimesh_instance_3d.h"
@@ -467,14 +468,29 @@ void NavigationMeshGenerator::_parse_geometry(const Transform3D &p_navmesh_trans
 	}
 }
 
-void NavigationMeshGenerator::_convert_detail_mesh_to_native_navigation_mesh(const rcPolyMeshDetail *p_detail_mesh, Ref<NavigationMesh> p_nav_mesh) {
-	Vector<Vector3> nav_vertices;
+void NavigationMeshGenerator::_parse_source_geometry(Ref<NavigationMesh> p_nav_mesh, Node *p_node, Vector<float> &r_vertices, Vector<int> &r_indices) {
+	List<Node *> parse_nodes;
+
+	if (p_nav_mesh->get_source_geometry_mode() == NavigationMesh::SOURCE_GEOMETRY_NAVMESH_CHILDREN) {
+		parse_nodes.push_back(p_node);
+	} else {
+		p_node->get_tree()->get_nodes_in_group(p_nav_mesh->get_source_group_name(), &parse_nodes);
+	}
+
+	Transform3D navmesh_xform = Object::cast_to<Node3D>(p_node)->get_global_transform().affine_inverse();
+	for (Node *E : parse_nodes) {
+		NavigationMesh::ParsedGeometryType geometry_type = p_nav_mesh->get_parsed_geometry_type();
+		uint32_t collision_mask = p_nav_mesh->get_collision_mask();
+		bool recurse_children = p_nav_mesh->get_source_geometry_mode() != NavigationMesh::SOURCE_GEOMETRY_GROUPS_EXPLICIT;
+		_parse_geometry(navmesh_xform, E, r_vertices, r_indices, geometry_type, collision_mask, recurse_children);
+	}
+}
 
+void NavigationMeshGenerator::_convert_detail_mesh(const rcPolyMeshDetail *p_detail_mesh, Vector<Vector3> &r_vertices, Vector<Vector<int>> &r_polygons) {
 	for (int i = 0; i < p_detail_mesh->nverts; i++) {
 		const float *v = &p_detail_mesh->verts[i * 3];
-		nav_vertices.push_back(Vector3(v[0], v[1], v[2]));
+		r_vertices.push_back(Vector3(v[0], v[1], v[2]));
 	}
-	p_nav_mesh->set_vertices(nav_vertices);
 
 	for (int i = 0; i < p_detail_mesh->nmeshes; i++) {
 		const unsigned int *m = &p_detail_mesh->meshes[i * 4];
@@ -489,40 +505,24 @@ void NavigationMeshGenerator::_convert_detail_mesh_to_native_navigation_mesh(con
 			nav_indices.write[0] = ((int)(bverts + tris[j * 4 + 0]));
 			nav_indices.write[1] = ((int)(bverts + tris[j * 4 + 2]));
 			nav_indices.write[2] = ((int)(bverts + tris[j * 4 + 1]));
-			p_nav_mesh->add_polygon(nav_indices);
+			r_polygons.push_back(nav_indices);
 		}
 	}
 }
 
-void NavigationMeshGenerator::_build_recast_navigation_mesh(
-		Ref<NavigationMesh> p_nav_mesh,
-#ifdef TOOLS_ENABLED
-		EditorProgress *ep,
-#endif
-		rcHeightfield *hf,
-		rcCompactHeightfield *chf,
-		rcContourSet *cset,
-		rcPolyMesh *poly_mesh,
-		rcPolyMeshDetail *detail_mesh,
-		Vector<float> &vertices,
-		Vector<int> &indices) {
-	rcContext ctx;
+void NavigationMeshGenerator::_convert_detail_mesh_to_native_navigation_mesh(const rcPolyMeshDetail *p_detail_mesh, Ref<NavigationMesh> p_nav_mesh) {
+	Vector<Vector3> nav_vertices;
+	Vector<Vector<int>> nav_polygons;
+	_convert_detail_mesh(p_detail_mesh, nav_vertices, nav_polygons);
 
-#ifdef TOOLS_ENABLED
-	if (ep) {
-		ep->step(TTR("Setting up Configuration..."), 1);
+	p_nav_mesh->set_vertices(nav_vertices);
+	for (int i = 0; i < nav_polygons.size(); i++) {
+		p_nav_mesh->add_polygon(nav_polygons[i]);
 	}
-#endif
-
-	const float *verts = vertices.ptr();
-	const int nverts = vertices.size() / 3;
-	const int *tris = indices.ptr();
-	const int ntris = indices.size() / 3;
-
-	float bmin[3], bmax[3];
-	rcCalcBounds(verts, nverts, bmin, bmax);
+}
 
-	rcConfig cfg;
+void NavigationMeshGenerator::_setup_recast_config(Ref<NavigationMesh> p_nav_mesh, rcConfig &r_cfg) {
+	rcConfig &cfg = r_cfg;
 	memset(&cfg, 0, sizeof(cfg));
 
 	cfg.cs = p_nav_mesh->get_cell_size();
@@ -563,6 +563,38 @@ void NavigationMeshGenerator::_build_recast_navigation_mesh(
 	if (p_nav_mesh->get_cell_size() * p_nav_mesh->get_detail_sample_distance() < 0.1f) {
 		WARN_PRINT("Property detail_sample_distance is clamped to 0.1 world units as the resulting value from multiplying with cell_size is too low.");
 	}
+}
+
+void NavigationMeshGenerator::_build_recast_navigation_mesh(
+		Ref<NavigationMesh> p_nav_mesh,
+#ifdef TOOLS_ENABLED
+		EditorProgress *ep,
+#endif
+		rcHeightfield *hf,
+		rcCompactHeightfield *chf,
+		rcContourSet *cset,
+		rcPolyMesh *poly_mesh,
+		rcPolyMeshDetail *detail_mesh,
+		Vector<float> &vertices,
+		Vector<int> &indices) {
+	rcContext ctx;
+
+#ifdef TOOLS_ENABLED
+	if (ep) {
+		ep->step(TTR("Setting up Configuration..."), 1);
+	}
+#endif
+
+	const float *verts = vertices.ptr();
+	const int nverts = vertices.size() / 3;
+	const int *tris = indices.ptr();
+	const int ntris = indices.size() / 3;
+
+	float bmin[3], bmax[3];
+	rcCalcBounds(verts, nverts, bmin, bmax);
+
+	rcConfig cfg;
+	_setup_recast_config(p_nav_mesh, cfg);
 
 	cfg.bmin[0] = bmin[0];
 	cfg.bmin[1] = bmin[1];
@@ -753,22 +785,7 @@ void NavigationMeshGenerator::bake(Ref<NavigationMesh> p_nav_mesh, Node *p_node)
 
 	Vector<float> vertices;
 	Vector<int> indices;
-
-	List<Node *> parse_nodes;
-
-	if (p_nav_mesh->get_source_geometry_mode() == NavigationMesh::SOURCE_GEOMETRY_NAVMESH_CHILDREN) {
-		parse_nodes.push_back(p_node);
-	} else {
-		p_node->get_tree()->get_nodes_in_group(p_nav_mesh->get_source_group_name(), &parse_nodes);
-	}
-
-	Transform3D navmesh_xform = Object::cast_to<Node3D>(p_node)->get_global_transform().affine_inverse();
-	for (Node *E : parse_nodes) {
-		NavigationMesh::ParsedGeometryType geometry_type = p_nav_mesh->get_parsed_geometry_type();
-		uint32_t collision_mask = p_nav_mesh->get_collision_mask();
-		bool recurse_children = p_nav_mesh->get_source_geometry_mode() != NavigationMesh::SOURCE_GEOMETRY_GROUPS_EXPLICIT;
-		_parse_geometry(navmesh_xform, E, vertices, indices, geometry_type, collision_mask, recurse_children);
-	}
+	_parse_source_geometry(p_nav_mesh, p_node, vertices, indices);
 
 	if (vertices.size() > 0 && indices.size() > 0) {
 		rcHeightfield *hf = nullptr;
@@ -817,6 +834,218 @@ void NavigationMeshGenerator::bake(Ref<NavigationMesh> p_nav_mesh, Node *p_node)
 #endif
 }
 
+bool NavigationMeshGenerator::TiledBake::build_tile(TileBake &r_tile, rcContext &r_ctx, rcHeightfield *&r_hf, rcCompactHeightfield *&r_chf, rcContourSet *&r_cset, rcPolyMesh *&r_poly_mesh, rcPolyMeshDetail *&r_detail_mesh) {
+	// The tile is built with a border, so the polygons along its edges match the ones of the neighbor tiles.
+	rcConfig tile_cfg = cfg;
+	const float border_size = tile_cfg.borderSize * tile_cfg.cs;
+	tile_cfg.bmin[0] = r_tile.coords.x * tile_size - border_size;
+	tile_cfg.bmin[2] = r_tile.coords.y * tile_size - border_size;
+	tile_cfg.bmax[0] = (r_tile.coords.x + 1) * tile_size + border_size;
+	tile_cfg.bmax[2] = (r_tile.coords.y + 1) * tile_size + border_size;
+
+	r_hf = rcAllocHeightfield();
+	ERR_FAIL_COND_V(!r_hf, false);
+	ERR_FAIL_COND_V(!rcCreateHeightfield(&r_ctx, *r_hf, tile_cfg.width, tile_cfg.height, tile_cfg.bmin, tile_cfg.bmax, tile_cfg.cs, tile_cfg.ch), false);
+
+	const int ntris = r_tile.indices.size() / 3;
+	{
+		LocalVector<unsigned char> tri_areas;
+		tri_areas.resize(ntris);
+		memset(tri_areas.ptr(), 0, ntris * sizeof(unsigned char));
+		rcMarkWalkableTriangles(&r_ctx, tile_cfg.walkableSlopeAngle, vertices, vertex_count, r_tile.indices.ptr(), ntris, tri_areas.ptr());
+
+		ERR_FAIL_COND_V(!rcRasterizeTriangles(&r_ctx, vertices, vertex_count, r_tile.indices.ptr(), tri_areas.ptr(), ntris, *r_hf, tile_cfg.walkableClimb), false);
+	}
+
+	if (filter_low_hanging_obstacles) {
+		rcFilterLowHangingWalkableObstacles(&r_ctx, tile_cfg.walkableClimb, *r_hf);
+	}
+	if (filter_ledge_spans) {
+		rcFilterLedgeSpans(&r_ctx, tile_cfg.walkableHeight, tile_cfg.walkableClimb, *r_hf);
+	}
+	if (filter_walkable_low_height_spans) {
+		rcFilterWalkableLowHeightSpans(&r_ctx, tile_cfg.walkableHeight, *r_hf);
+	}
+
+	r_chf = rcAllocCompactHeightfield();
+	ERR_FAIL_COND_V(!r_chf, false);
+	ERR_FAIL_COND_V(!rcBuildCompactHeightfield(&r_ctx, tile_cfg.walkableHeight, tile_cfg.walkableClimb, *r_hf, *r_chf), false);
+
+	rcFreeHeightField(r_hf);
+	r_hf = nullptr;
+
+	ERR_FAIL_COND_V(!rcErodeWalkableArea(&r_ctx, tile_cfg.walkableRadius, *r_chf), false);
+
+	if (partition_type == NavigationMesh::SAMPLE_PARTITION_WATERSHED) {
+		ERR_FAIL_COND_V(!rcBuildDistanceField(&r_ctx, *r_chf), false);
+		ERR_FAIL_COND_V(!rcBuildRegions(&r_ctx, *r_chf, tile_cfg.borderSize, tile_cfg.minRegionArea, tile_cfg.mergeRegionArea), false);
+	} else if (partition_type == NavigationMesh::SAMPLE_PARTITION_MONOTONE) {
+		ERR_FAIL_COND_V(!rcBuildRegionsMonotone(&r_ctx, *r_chf, tile_cfg.borderSize, tile_cfg.minRegionArea, tile_cfg.mergeRegionArea), false);
+	} else {
+		ERR_FAIL_COND_V(!rcBuildLayerRegions(&r_ctx, *r_chf, tile_cfg.borderSize, tile_cfg.minRegionArea), false);
+	}
+
+	r_cset = rcAllocContourSet();
+	ERR_FAIL_COND_V(!r_cset, false);
+	ERR_FAIL_COND_V(!rcBuildContours(&r_ctx, *r_chf, tile_cfg.maxSimplificationError, tile_cfg.maxEdgeLen, *r_cset), false);
+	if (r_cset->nconts == 0) {
+		// Nothing walkable in this tile.
+		return true;
+	}
+
+	r_poly_mesh = rcAllocPolyMesh();
+	ERR_FAIL_COND_V(!r_poly_mesh, false);
+	ERR_FAIL_COND_V(!rcBuildPolyMesh(&r_ctx, *r_cset, tile_cfg.maxVertsPerPoly, *r_poly_mesh), false);
+
+	r_detail_mesh = rcAllocPolyMeshDetail();
+	ERR_FAIL_COND_V(!r_detail_mesh, false);
+	ERR_FAIL_COND_V(!rcBuildPolyMeshDetail(&r_ctx, *r_poly_mesh, *r_chf, tile_cfg.detailSampleDist, tile_cfg.detailSampleMaxError, *r_detail_mesh), false);
+
+	_convert_detail_mesh(r_detail_mesh, r_tile.vertices, r_tile.polygons);
+	return true;
+}
+
+void NavigationMeshGenerator::TiledBake::bake_tile(uint32_t p_index, TileBake *p_tiles) {
+	TileBake &tile = p_tiles[p_index];
+	if (tile.indices.is_empty()) {
+		return;
+	}
+
+	// Each tile has its own context and Recast data, so tiles can be built at the same time.
+	rcContext ctx;
+	rcHeightfield *hf = nullptr;
+	rcCompactHeightfield *chf = nullptr;
+	rcContourSet *cset = nullptr;
+	rcPolyMesh *poly_mesh = nullptr;
+	rcPolyMeshDetail *detail_mesh = nullptr;
+
+	if (!build_tile(tile, ctx, hf, chf, cset, poly_mesh, detail_mesh)) {
+		tile.vertices.clear();
+		tile.polygons.clear();
+	}
+
+	rcFreeHeightField(hf);
+	rcFreeCompactHeightfield(chf);
+	rcFreeContourSet(cset);
+	rcFreePolyMesh(poly_mesh);
+	rcFreePolyMeshDetail(detail_mesh);
+}
+
+Dictionary NavigationMeshGenerator::bake_tiles(Ref<NavigationMesh> p_nav_mesh, Node *p_node, real_t p_tile_size, const TypedArray<Vector2i> &p_tiles) {
+	ERR_FAIL_COND_V_MSG(!p_nav_mesh.is_valid(), Dictionary(), "Invalid navigation mesh.");
+	ERR_FAIL_COND_V_MSG(p_tile_size <= 0.0, Dictionary(), "The tile size must be greater than zero.");
+
+	// Parsing the scene has to happen on this thread, only the Recast work is split in tiles.
+	Vector<float> vertices;
+	Vector<int> indices;
+	_parse_source_geometry(p_nav_mesh, p_node, vertices, indices);
+
+	TiledBake bake;
+	_setup_recast_config(p_nav_mesh, bake.cfg);
+
+	// Tiles are a whole number of cells, so the cells of neighbor tiles line up.
+	const int tile_cells = MAX(1, (int)Math::ceil(p_tile_size / bake.cfg.cs));
+	bake.tile_size = tile_cells * bake.cfg.cs;
+	bake.cfg.tileSize = tile_cells;
+	bake.cfg.borderSize = bake.cfg.walkableRadius + 3;
+	bake.cfg.width = tile_cells + bake.cfg.borderSize * 2;
+	bake.cfg.height = tile_cells + bake.cfg.borderSize * 2;
+	bake.vertices = vertices.ptr();
+	bake.vertex_count = vertices.size() / 3;
+	bake.filter_low_hanging_obstacles = p_nav_mesh->get_filter_low_hanging_obstacles();
+	bake.filter_ledge_spans = p_nav_mesh->get_filter_ledge_spans();
+	bake.filter_walkable_low_height_spans = p_nav_mesh->get_filter_walkable_low_height_spans();
+	bake.partition_type = p_nav_mesh->get_sample_partition_type();
+
+	float bmin[3] = { 0.0, 0.0, 0.0 };
+	float bmax[3] = { 0.0, 0.0, 0.0 };
+	if (bake.vertex_count > 0) {
+		rcCalcBounds(bake.vertices, bake.vertex_count, bmin, bmax);
+	}
+
+	AABB baking_aabb = p_nav_mesh->get_filter_baking_aabb();
+	if (!baking_aabb.has_no_volume()) {
+		baking_aabb.position += p_nav_mesh->get_filter_baking_aabb_offset();
+		for (int i = 0; i < 3; i++) {
+			bmin[i] = baking_aabb.position[i];
+			bmax[i] = baking_aabb.position[i] + baking_aabb.size[i];
+		}
+	}
+	bake.cfg.bmin[1] = bmin[1];
+	bake.cfg.bmax[1] = bmax[1];
+
+	// Bake the requested tiles, or all the tiles covering the source geometry.
+	LocalVector<TileBake> tiles;
+	HashMap<Vector2i, uint32_t> tile_ids;
+	if (p_tiles.is_empty()) {
+		if (bake.vertex_count > 0) {
+			const Vector2i begin((int)Math::floor(bmin[0] / bake.tile_size), (int)Math::floor(bmin[2] / bake.tile_size));
+			const Vector2i end((int)Math::floor(bmax[0] / bake.tile_size), (int)Math::floor(bmax[2] / bake.tile_size));
+			for (int z = begin.y; z <= end.y; z++) {
+				for (int x = begin.x; x <= end.x; x++) {
+					tile_ids.insert(Vector2i(x, z), tiles.size());
+					tiles.push_back(TileBake());
+					tiles[tiles.size() - 1].coords = Vector2i(x, z);
+				}
+			}
+		}
+	} else {
+		for (int i = 0; i < p_tiles.size(); i++) {
+			const Vector2i coords = p_tiles[i];
+			if (!tile_ids.has(coords)) {
+				tile_ids.insert(coords, tiles.size());
+				tiles.push_back(TileBake());
+				tiles[tiles.size() - 1].coords = coords;
+			}
+		}
+	}
+
+	// Give each tile the triangles overlapping it or its border.
+	const float border_size = bake.cfg.borderSize * bake.cfg.cs;
+	for (int i = 0; i + 2 < indices.size(); i += 3) {
+		Vector2 tri_min(1e30, 1e30);
+		Vector2 tri_max(-1e30, -1e30);
+		for (int j = 0; j < 3; j++) {
+			const float *v = &bake.vertices[indices[i + j] * 3];
+			tri_min.x = MIN(tri_min.x, v[0]);
+			tri_min.y = MIN(tri_min.y, v[2]);
+			tri_max.x = MAX(tri_max.x, v[0]);
+			tri_max.y = MAX(tri_max.y, v[2]);
+		}
+
+		const Vector2i begin((int)Math::floor((tri_min.x - border_size) / bake.tile_size), (int)Math::floor((tri_min.y - border_size) / bake.tile_size));
+		const Vector2i end((int)Math::floor((tri_max.x + border_size) / bake.tile_size), (int)Math::floor((tri_max.y + border_size) / bake.tile_size));
+		for (int z = begin.y; z <= end.y; z++) {
+			for (int x = begin.x; x <= end.x; x++) {
+				HashMap<Vector2i, uint32_t>::Iterator E = tile_ids.find(Vector2i(x, z));
+				if (E) {
+					TileBake &tile = tiles[E->value];
+					tile.indices.push_back(indices[i]);
+					tile.indices.push_back(indices[i + 1]);
+					tile.indices.push_back(indices[i + 2]);
+				}
+			}
+		}
+	}
+
+	if (tiles.size() > 0) {
+		WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(&bake, &TiledBake::bake_tile, tiles.ptr(), tiles.size(), -1, true, SNAME("NavigationMeshTiles"));
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+	}
+
+	Dictionary tile_meshes;
+	for (uint32_t i = 0; i < tiles.size(); i++) {
+		Ref<NavigationMesh> tile_mesh = p_nav_mesh->duplicate();
+		clear(tile_mesh);
+		tile_mesh->set_vertices(tiles[i].vertices);
+		for (int j = 0; j < tiles[i].polygons.size(); j++) {
+			tile_mesh->add_polygon(tiles[i].polygons[j]);
+		}
+		tile_meshes[tiles[i].coords] = tile_mesh;
+	}
+	return tile_meshes;
+}
+
 void NavigationMeshGenerator::clear(Ref<NavigationMesh> p_nav_mesh) {
 	if (p_nav_mesh.is_valid()) {
 		p_nav_mesh->clear_polygons();
@@ -826,6 +1055,7 @@ void NavigationMeshGenerator::clear(Ref<NavigationMesh> p_nav_mesh) {
 
 void NavigationMeshGenerator::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("bake", "nav_mesh", "root_node"), &NavigationMeshGenerator::bake);
+	ClassDB::bind_method(D_METHOD("bake_tiles", "nav_mesh", "root_node", "tile_size", "tiles"), &NavigationMeshGenerator::bake_tiles, DEFVAL(TypedArray<Vector2i>()));
 	ClassDB::bind_method(D_METHOD("clear", "nav_mesh"), &NavigationMeshGenerator::clear);
 }
 
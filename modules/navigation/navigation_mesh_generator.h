@@ -33,6 +33,8 @@
 
 #ifndef _3D_DISABLED
 
+#include "core/templates/local_vector.h"
+#include "core/variant/typed_array.h"
 #include "scene/3d/navigation_region_3d.h"
 
 #include <Recast.h>
@@ -55,6 +57,10 @@ protected:
 	static void _add_faces(const PackedVector3Array &p_faces, const Transform3D &p_xform, Vector<float> &p_vertices, Vector<int> &p_indices);
 	static void _parse_geometry(const Transform3D &p_navmesh_transform, Node *p_node, Vector<float> &p_vertices, Vector<int> &p_indices, NavigationMesh::ParsedGeometryType p_generate_from, uint32_t p_collision_mask, bool p_recurse_children);
 
+	static void _parse_source_geometry(Ref<NavigationMesh> p_nav_mesh, Node *p_node, Vector<float> &r_vertices, Vector<int> &r_indices);
+	static void _setup_recast_config(Ref<NavigationMesh> p_nav_mesh, rcConfig &r_cfg);
+
+	static void _convert_detail_mesh(const rcPolyMeshDetail *p_detail_mesh, Vector<Vector3> &r_vertices, Vector<Vector<int>> &r_polygons);
 	static void _convert_detail_mesh_to_native_navigation_mesh(const rcPolyMeshDetail *p_detail_mesh, Ref<NavigationMesh> p_nav_mesh);
 	static void _build_recast_navigation_mesh(
 			Ref<NavigationMesh> p_nav_mesh,
@@ -69,6 +75,31 @@ protected:
 			Vector<float> &vertices,
 			Vector<int> &indices);
 
+	struct TileBake {
+		/// Tile coordinates on the XZ plane.
+		Vector2i coords;
+		/// Source triangles overlapping the tile or its border.
+		LocalVector<int> indices;
+
+		Vector<Vector3> vertices;
+		Vector<Vector<int>> polygons;
+	};
+
+	/// Settings shared by the tiles of a tiled bake, each tile being baked by its own task.
+	struct TiledBake {
+		rcConfig cfg;
+		float tile_size = 0.0;
+		const float *vertices = nullptr;
+		int vertex_count = 0;
+		bool filter_low_hanging_obstacles = false;
+		bool filter_ledge_spans = false;
+		bool filter_walkable_low_height_spans = false;
+		NavigationMesh::SamplePartitionType partition_type = NavigationMesh::SAMPLE_PARTITION_WATERSHED;
+
+		void bake_tile(uint32_t p_index, TileBake *p_tiles);
+		bool build_tile(TileBake &r_tile, rcContext &r_ctx, rcHeightfield *&r_hf, rcCompactHeightfield *&r_chf, rcContourSet *&r_cset, rcPolyMesh *&r_poly_mesh, rcPolyMeshDetail *&r_detail_mesh);
+	};
+
 public:
 	static NavigationMeshGenerator *get_singleton();
 
@@ -76,6 +107,7 @@ public:
 	~NavigationMeshGenerator();
 
 	void bake(Ref<NavigationMesh> p_nav_mesh, Node *p_node);
+	Dictionary bake_tiles(Ref<NavigationMesh> p_nav_mesh, Node *p_node, real_t p_tile_size, const TypedArray<Vector2i> &p_tiles = TypedArray<Vector2i>());
 	void clear(Ref<NavigationMesh> p_nav_mesh);
 };
 
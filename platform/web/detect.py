@@ -118,6 +118,8 @@ def configure(env):
         env.Append(LINKFLAGS=["-flto=full"])
 
     # Sanitizers
+    if env["use_asan"] or env["use_lsan"]:
+        env.Append(CCFLAGS=["-DSANITIZERS_ENABLED"])
     if env["use_ubsan"]:
         env.Append(CCFLAGS=["-fsanitize=undefined"])
         env.Append(LINKFLAGS=["-fsanitize=undefined"])
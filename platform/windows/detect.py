@@ -466,6 +466,7 @@ def configure_msvc(env, vcvars_msvc_config):
         env.extra_suffix += ".san"
         env.Append(LINKFLAGS=["/INFERASANLIBS"])
         env.Append(CCFLAGS=["/fsanitize=address"])
+        env.Append(CPPDEFINES=["SANITIZERS_ENABLED"])
 
     # Incremental linking fix
     env["BUILDERS"]["ProgramOriginal"] = env["BUILDERS"]["Program"]
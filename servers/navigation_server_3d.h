@@ -91,9 +91,22 @@ public:
 	/// Returns the link connection radius of this map.
 	virtual real_t map_get_link_connection_radius(RID p_map) const = 0;
 
+	/// Set whether long paths are planned region by region before searching polygons.
+	virtual void map_set_use_hierarchical_paths(RID p_map, bool p_enabled) const = 0;
+
+	/// Returns whether long paths are planned region by region.
+	virtual bool map_get_use_hierarchical_paths(RID p_map) const = 0;
+
+	/// Set a callback receiving the avoidance velocities of all the map agents at once after each step.
+	virtual void map_set_avoidance_callback(RID p_map, Callable p_callback) const = 0;
+
 	/// Returns the navigation path to reach the destination from the origin.
 	virtual Vector<Vector3> map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers = 1) const = 0;
 
+	/// Queues a batch of path queries that run on worker threads.
+	/// The callback receives the paths, in the order of the queries, during the next `process`.
+	virtual void map_get_paths_async(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, const Vector<int32_t> &p_navigation_layers, bool p_optimize, const Callable &p_callback) const = 0;
+
 	virtual Vector3 map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision = false) const = 0;
 	virtual Vector3 map_get_closest_point(RID p_map, const Vector3 &p_point) const = 0;
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const = 0;
@@ -243,6 +256,18 @@ public:
 	/// Note: This function is not thread safe.
 	virtual void process(real_t delta_time) = 0;
 
+	enum ProcessInfo {
+		INFO_ACTIVE_MAPS,
+		INFO_REGION_COUNT,
+		INFO_POLYGON_COUNT,
+		INFO_EDGE_FREE_COUNT,
+		INFO_REBUILT_REGION_COUNT,
+		INFO_SYNC_TIME_USEC,
+	};
+
+	/// Statistics of the active maps, gathered by the last `process`.
+	virtual int get_process_info(ProcessInfo p_info) = 0;
+
 	NavigationServer3D();
 	virtual ~NavigationServer3D();
 
@@ -343,4 +368,6 @@ public:
 	static NavigationServer3D *new_default_server();
 };
 
+VARIANT_ENUM_CAST(NavigationServer3D::ProcessInfo);
+
 #endif // NAVIGATION_SERVER_3D_H
@@ -37,6 +37,10 @@
 
 #define MIN_VELOCITY 0.0001
 #define MAX_BIAS_ROTATION (Math_PI / 8)
+// Relative motion under which the contacts of the last narrowphase are kept,
+// as a fraction of the contact recycle radius and in radians.
+#define MANIFOLD_REUSE_DISTANCE_RATIO 0.1
+#define MANIFOLD_REUSE_ROTATION 0.001
 
 void GodotBodyPair3D::_contact_added_callback(const Vector3 &p_point_A, int p_index_A, const Vector3 &p_point_B, int p_index_B, void *p_userdata) {
 	GodotBodyPair3D *pair = static_cast<GodotBodyPair3D *>(p_userdata);
@@ -161,6 +165,38 @@ void GodotBodyPair3D::validate_contacts() {
 	}
 }
 
+bool GodotBodyPair3D::_can_reuse_manifold(const Transform3D &p_relative_xform) const {
+	if (!manifold.valid || !collided || contact_count != manifold.contact_count) {
+		// Not touching, or some contacts were lost since the narrowphase.
+		return false;
+	}
+
+	const GodotShape3D *shape_A_ptr = A->get_shape(shape_A);
+	const GodotShape3D *shape_B_ptr = B->get_shape(shape_B);
+	if (shape_A_ptr != manifold.shape_A || shape_B_ptr != manifold.shape_B || shape_A_ptr->get_aabb() != manifold.shape_aabb_A || shape_B_ptr->get_aabb() != manifold.shape_aabb_B) {
+		return false;
+	}
+
+	const real_t max_distance = space->get_contact_recycle_radius() * MANIFOLD_REUSE_DISTANCE_RATIO;
+	if (p_relative_xform.origin.distance_squared_to(manifold.relative_xform.origin) > max_distance * max_distance) {
+		return false;
+	}
+
+	// For small rotations, the axes move by about the rotation angle.
+	const Basis &basis_A = A->get_transform().basis;
+	const real_t max_rotation_sq = MANIFOLD_REUSE_ROTATION * MANIFOLD_REUSE_ROTATION;
+	for (int i = 0; i < 3; i++) {
+		if ((p_relative_xform.basis.get_column(i) - manifold.relative_xform.basis.get_column(i)).length_squared() > max_rotation_sq) {
+			return false;
+		}
+		if ((basis_A.get_column(i) - manifold.basis_A.get_column(i)).length_squared() > max_rotation_sq) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 bool GodotBodyPair3D::_test_ccd(real_t p_step, GodotBody3D *p_A, int p_shape_A, const Transform3D &p_xform_A, GodotBody3D *p_B, int p_shape_B, const Transform3D &p_xform_B) {
 	Vector3 motion = p_A->get_linear_velocity() * p_step;
 	real_t mlen = motion.length();
@@ -219,9 +255,11 @@ real_t combine_friction(GodotBody3D *A, GodotBody3D *B) {
 
 bool GodotBodyPair3D::setup(real_t p_step) {
 	check_ccd = false;
+	batch_kind = SAT_BATCH_NONE;
 
 	if (!A->interacts_with(B) || A->has_exception(B->get_self()) || B->has_exception(A->get_self())) {
 		collided = false;
+		manifold.valid = false;
 		return false;
 	}
 
@@ -234,6 +272,7 @@ bool GodotBodyPair3D::setup(real_t p_step) {
 			report_contacts_only = true;
 		} else {
 			collided = false;
+			manifold.valid = false;
 			return false;
 		}
 	}
@@ -244,16 +283,50 @@ bool GodotBodyPair3D::setup(real_t p_step) {
 
 	const Vector3 &offset_A = A->get_transform().get_origin();
 	Transform3D xform_Au = Transform3D(A->get_transform().basis, Vector3());
-	Transform3D xform_A = xform_Au * A->get_shape_transform(shape_A);
+	shape_xform_A = xform_Au * A->get_shape_transform(shape_A);
 
 	Transform3D xform_Bu = B->get_transform();
 	xform_Bu.origin -= offset_A;
-	Transform3D xform_B = xform_Bu * B->get_shape_transform(shape_B);
+	shape_xform_B = xform_Bu * B->get_shape_transform(shape_B);
 
-	GodotShape3D *shape_A_ptr = A->get_shape(shape_A);
-	GodotShape3D *shape_B_ptr = B->get_shape(shape_B);
+	const Transform3D relative_xform = shape_xform_A.affine_inverse() * shape_xform_B;
+	if (_can_reuse_manifold(relative_xform)) {
+		// The shapes are still touching the same way, keep the contacts (and warm start from them).
+		for (int i = 0; i < contact_count; i++) {
+			contacts[i].used = true;
+		}
+		return true;
+	}
+	manifold.relative_xform = relative_xform;
+	manifold.basis_A = A->get_transform().basis;
 
-	collided = GodotCollisionSolver3D::solve_static(shape_A_ptr, xform_A, shape_B_ptr, xform_B, _contact_added_callback, this, &sep_axis);
+	batch_kind = sat_batch_get_kind(A->get_shape(shape_A), shape_xform_A, B->get_shape(shape_B), shape_xform_B);
+	if (batch_kind != SAT_BATCH_NONE) {
+		// The step runs the separation test for a whole batch, then calls finish_batch_setup().
+		return true;
+	}
+
+	return _finish_setup(false);
+}
+
+bool GodotBodyPair3D::_finish_setup(bool p_separated) {
+	if (p_separated) {
+		collided = false;
+	} else {
+		GodotShape3D *shape_A_ptr = A->get_shape(shape_A);
+		GodotShape3D *shape_B_ptr = B->get_shape(shape_B);
+
+		collided = GodotCollisionSolver3D::solve_static(shape_A_ptr, shape_xform_A, shape_B_ptr, shape_xform_B, _contact_added_callback, this, &sep_axis);
+	}
+
+	manifold.valid = collided && contact_count > 0;
+	if (manifold.valid) {
+		manifold.contact_count = contact_count;
+		manifold.shape_A = A->get_shape(shape_A);
+		manifold.shape_B = B->get_shape(shape_B);
+		manifold.shape_aabb_A = manifold.shape_A->get_aabb();
+		manifold.shape_aabb_B = manifold.shape_B->get_aabb();
+	}
 
 	if (!collided) {
 		if (A->is_continuous_collision_detection_enabled() && collide_A) {
@@ -272,6 +345,18 @@ bool GodotBodyPair3D::setup(real_t p_step) {
 	return true;
 }
 
+void GodotBodyPair3D::get_batch_pair(SATBatchPair &r_pair) const {
+	r_pair.shape_A = A->get_shape(shape_A);
+	r_pair.transform_A = &shape_xform_A;
+	r_pair.shape_B = B->get_shape(shape_B);
+	r_pair.transform_B = &shape_xform_B;
+}
+
+void GodotBodyPair3D::finish_batch_setup(bool p_separated) {
+	batch_kind = SAT_BATCH_NONE;
+	_finish_setup(p_separated);
+}
+
 bool GodotBodyPair3D::pre_solve(real_t p_step) {
 	if (!collided) {
 		if (check_ccd) {
@@ -93,21 +93,45 @@ class GodotBodyPair3D : public GodotBodyContact3D {
 
 	Vector3 offset_B; //use local A coordinates to avoid numerical issues on collision detection
 
+	// Shape transforms computed by setup(), kept for a batched narrowphase.
+	Transform3D shape_xform_A;
+	Transform3D shape_xform_B;
+	SATBatchKind batch_kind = SAT_BATCH_NONE;
+
 	Contact contacts[MAX_CONTACTS];
 	int contact_count = 0;
 
+	// What the contacts were generated from by the last narrowphase. While it barely changes,
+	// the contacts and their accumulated impulses are kept without running the narrowphase again.
+	struct Manifold {
+		bool valid = false;
+		int contact_count = 0;
+		Transform3D relative_xform; // Shape B in the space of shape A.
+		Basis basis_A; // Contact normals are in world orientation.
+		const GodotShape3D *shape_A = nullptr;
+		const GodotShape3D *shape_B = nullptr;
+		AABB shape_aabb_A;
+		AABB shape_aabb_B;
+	} manifold;
+
 	static void _contact_added_callback(const Vector3 &p_point_A, int p_index_A, const Vector3 &p_point_B, int p_index_B, void *p_userdata);
 
 	void contact_added_callback(const Vector3 &p_point_A, int p_index_A, const Vector3 &p_point_B, int p_index_B);
 
 	void validate_contacts();
+	bool _can_reuse_manifold(const Transform3D &p_relative_xform) const;
 	bool _test_ccd(real_t p_step, GodotBody3D *p_A, int p_shape_A, const Transform3D &p_xform_A, GodotBody3D *p_B, int p_shape_B, const Transform3D &p_xform_B);
+	bool _finish_setup(bool p_separated);
 
 public:
 	virtual bool setup(real_t p_step) override;
 	virtual bool pre_solve(real_t p_step) override;
 	virtual void solve(real_t p_step) override;
 
+	virtual SATBatchKind get_batch_kind() const override { return batch_kind; }
+	virtual void get_batch_pair(SATBatchPair &r_pair) const override;
+	virtual void finish_batch_setup(bool p_separated) override;
+
 	GodotBodyPair3D(GodotBody3D *p_A, int p_shape_A, GodotBody3D *p_B, int p_shape_B);
 	~GodotBodyPair3D();
 };
@@ -0,0 +1,308 @@
+/*************************************************************************/
+/*  godot_collision_solver_3d_batch.cpp                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "godot_collision_solver_3d_batch.h"
+
+// Pairs closer than this are left to the SAT solver, so that touching shapes are never rejected by rounding.
+#define SAT_BATCH_TOLERANCE 0.0001
+
+struct _SATBatchOrderedPair {
+	const GodotShape3D *shape_A = nullptr;
+	const Transform3D *transform_A = nullptr;
+	const GodotShape3D *shape_B = nullptr;
+	const Transform3D *transform_B = nullptr;
+
+	// Kernels expect the shape with the lowest type first, like the SAT collision table.
+	_FORCE_INLINE_ _SATBatchOrderedPair(const SATBatchPair &p_pair) {
+		if (p_pair.shape_A->get_type() > p_pair.shape_B->get_type()) {
+			shape_A = p_pair.shape_B;
+			transform_A = p_pair.transform_B;
+			shape_B = p_pair.shape_A;
+			transform_B = p_pair.transform_A;
+		} else {
+			shape_A = p_pair.shape_A;
+			transform_A = p_pair.transform_A;
+			shape_B = p_pair.shape_B;
+			transform_B = p_pair.transform_B;
+		}
+	}
+};
+
+static void _batch_sphere_sphere(const SATBatchPair *p_pairs, uint32_t p_count, bool *r_separated) {
+	real_t dx[SAT_BATCH_SIZE], dy[SAT_BATCH_SIZE], dz[SAT_BATCH_SIZE];
+	real_t radius[SAT_BATCH_SIZE];
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		_SATBatchOrderedPair pair(p_pairs[i]);
+		const Vector3 d = pair.transform_B->origin - pair.transform_A->origin;
+		dx[i] = d.x;
+		dy[i] = d.y;
+		dz[i] = d.z;
+		radius[i] = static_cast<const GodotSphereShape3D *>(pair.shape_A)->get_radius() + static_cast<const GodotSphereShape3D *>(pair.shape_B)->get_radius() + SAT_BATCH_TOLERANCE;
+	}
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		r_separated[i] = dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i] > radius[i] * radius[i];
+	}
+}
+
+static void _batch_sphere_box(const SATBatchPair *p_pairs, uint32_t p_count, bool *r_separated) {
+	// Sphere center relative to the box, box axes and extents.
+	real_t dx[SAT_BATCH_SIZE], dy[SAT_BATCH_SIZE], dz[SAT_BATCH_SIZE];
+	real_t axes[9][SAT_BATCH_SIZE];
+	real_t hx[SAT_BATCH_SIZE], hy[SAT_BATCH_SIZE], hz[SAT_BATCH_SIZE];
+	real_t radius[SAT_BATCH_SIZE];
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		_SATBatchOrderedPair pair(p_pairs[i]);
+		const Vector3 d = pair.transform_A->origin - pair.transform_B->origin;
+		dx[i] = d.x;
+		dy[i] = d.y;
+		dz[i] = d.z;
+		const Basis &basis = pair.transform_B->basis;
+		for (int j = 0; j < 3; j++) {
+			for (int k = 0; k < 3; k++) {
+				axes[j * 3 + k][i] = basis.rows[k][j];
+			}
+		}
+		const Vector3 half_extents = static_cast<const GodotBoxShape3D *>(pair.shape_B)->get_half_extents();
+		hx[i] = half_extents.x;
+		hy[i] = half_extents.y;
+		hz[i] = half_extents.z;
+		radius[i] = static_cast<const GodotSphereShape3D *>(pair.shape_A)->get_radius() + SAT_BATCH_TOLERANCE;
+	}
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		const real_t lx = axes[0][i] * dx[i] + axes[1][i] * dy[i] + axes[2][i] * dz[i];
+		const real_t ly = axes[3][i] * dx[i] + axes[4][i] * dy[i] + axes[5][i] * dz[i];
+		const real_t lz = axes[6][i] * dx[i] + axes[7][i] * dy[i] + axes[8][i] * dz[i];
+		// Distance from the sphere center to the closest point of the box.
+		const real_t qx = lx - CLAMP(lx, -hx[i], hx[i]);
+		const real_t qy = ly - CLAMP(ly, -hy[i], hy[i]);
+		const real_t qz = lz - CLAMP(lz, -hz[i], hz[i]);
+		r_separated[i] = qx * qx + qy * qy + qz * qz > radius[i] * radius[i];
+	}
+}
+
+static void _batch_sphere_capsule(const SATBatchPair *p_pairs, uint32_t p_count, bool *r_separated) {
+	// Sphere center relative to the capsule, and half of the capsule segment.
+	real_t dx[SAT_BATCH_SIZE], dy[SAT_BATCH_SIZE], dz[SAT_BATCH_SIZE];
+	real_t hx[SAT_BATCH_SIZE], hy[SAT_BATCH_SIZE], hz[SAT_BATCH_SIZE];
+	real_t radius[SAT_BATCH_SIZE];
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		_SATBatchOrderedPair pair(p_pairs[i]);
+		const GodotCapsuleShape3D *capsule = static_cast<const GodotCapsuleShape3D *>(pair.shape_B);
+		const Vector3 d = pair.transform_A->origin - pair.transform_B->origin;
+		const Vector3 h = pair.transform_B->basis.get_column(1) * (capsule->get_height() * 0.5 - capsule->get_radius());
+		dx[i] = d.x;
+		dy[i] = d.y;
+		dz[i] = d.z;
+		hx[i] = h.x;
+		hy[i] = h.y;
+		hz[i] = h.z;
+		radius[i] = static_cast<const GodotSphereShape3D *>(pair.shape_A)->get_radius() + capsule->get_radius() + SAT_BATCH_TOLERANCE;
+	}
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		const real_t hh = MAX(hx[i] * hx[i] + hy[i] * hy[i] + hz[i] * hz[i], (real_t)CMP_EPSILON);
+		const real_t t = CLAMP((dx[i] * hx[i] + dy[i] * hy[i] + dz[i] * hz[i]) / hh, (real_t)-1.0, (real_t)1.0);
+		const real_t qx = dx[i] - hx[i] * t;
+		const real_t qy = dy[i] - hy[i] * t;
+		const real_t qz = dz[i] - hz[i] * t;
+		r_separated[i] = qx * qx + qy * qy + qz * qz > radius[i] * radius[i];
+	}
+}
+
+static void _batch_capsule_capsule(const SATBatchPair *p_pairs, uint32_t p_count, bool *r_separated) {
+	// Center of A relative to B, and half of both capsule segments.
+	real_t dx[SAT_BATCH_SIZE], dy[SAT_BATCH_SIZE], dz[SAT_BATCH_SIZE];
+	real_t ax[SAT_BATCH_SIZE], ay[SAT_BATCH_SIZE], az[SAT_BATCH_SIZE];
+	real_t bx[SAT_BATCH_SIZE], by[SAT_BATCH_SIZE], bz[SAT_BATCH_SIZE];
+	real_t radius[SAT_BATCH_SIZE];
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		_SATBatchOrderedPair pair(p_pairs[i]);
+		const GodotCapsuleShape3D *capsule_A = static_cast<const GodotCapsuleShape3D *>(pair.shape_A);
+		const GodotCapsuleShape3D *capsule_B = static_cast<const GodotCapsuleShape3D *>(pair.shape_B);
+		const Vector3 d = pair.transform_A->origin - pair.transform_B->origin;
+		const Vector3 a = pair.transform_A->basis.get_column(1) * (capsule_A->get_height() * 0.5 - capsule_A->get_radius());
+		const Vector3 b = pair.transform_B->basis.get_column(1) * (capsule_B->get_height() * 0.5 - capsule_B->get_radius());
+		dx[i] = d.x;
+		dy[i] = d.y;
+		dz[i] = d.z;
+		ax[i] = a.x;
+		ay[i] = a.y;
+		az[i] = a.z;
+		bx[i] = b.x;
+		by[i] = b.y;
+		bz[i] = b.z;
+		radius[i] = capsule_A->get_radius() + capsule_B->get_radius() + SAT_BATCH_TOLERANCE;
+	}
+
+	// Closest points of the segments d + s * a and t * b, with s and t in [-1, 1].
+	for (uint32_t i = 0; i < p_count; i++) {
+		const real_t aa = MAX(ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i], (real_t)CMP_EPSILON);
+		const real_t bb = MAX(bx[i] * bx[i] + by[i] * by[i] + bz[i] * bz[i], (real_t)CMP_EPSILON);
+		const real_t ab = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+		const real_t ad = ax[i] * dx[i] + ay[i] * dy[i] + az[i] * dz[i];
+		const real_t bd = bx[i] * dx[i] + by[i] * dy[i] + bz[i] * dz[i];
+
+		const real_t denom = aa * bb - ab * ab;
+		real_t s = denom > (real_t)CMP_EPSILON ? CLAMP((ab * bd - ad * bb) / denom, (real_t)-1.0, (real_t)1.0) : (real_t)0.0;
+		real_t t = (ab * s + bd) / bb;
+		const real_t clamped_t = CLAMP(t, (real_t)-1.0, (real_t)1.0);
+		s = clamped_t != t ? CLAMP((ab * clamped_t - ad) / aa, (real_t)-1.0, (real_t)1.0) : s;
+		t = clamped_t;
+
+		const real_t qx = dx[i] + ax[i] * s - bx[i] * t;
+		const real_t qy = dy[i] + ay[i] * s - by[i] * t;
+		const real_t qz = dz[i] + az[i] * s - bz[i] * t;
+		r_separated[i] = qx * qx + qy * qy + qz * qz > radius[i] * radius[i];
+	}
+}
+
+static void _batch_box_box(const SATBatchPair *p_pairs, uint32_t p_count, bool *r_separated) {
+	// Center of B relative to A, axes and extents of both boxes.
+	real_t dx[SAT_BATCH_SIZE], dy[SAT_BATCH_SIZE], dz[SAT_BATCH_SIZE];
+	real_t axes_A[9][SAT_BATCH_SIZE], axes_B[9][SAT_BATCH_SIZE];
+	real_t extents_A[3][SAT_BATCH_SIZE], extents_B[3][SAT_BATCH_SIZE];
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		_SATBatchOrderedPair pair(p_pairs[i]);
+		const Vector3 d = pair.transform_B->origin - pair.transform_A->origin;
+		dx[i] = d.x;
+		dy[i] = d.y;
+		dz[i] = d.z;
+		const Basis &basis_A = pair.transform_A->basis;
+		const Basis &basis_B = pair.transform_B->basis;
+		for (int j = 0; j < 3; j++) {
+			for (int k = 0; k < 3; k++) {
+				axes_A[j * 3 + k][i] = basis_A.rows[k][j];
+				axes_B[j * 3 + k][i] = basis_B.rows[k][j];
+			}
+		}
+		const Vector3 half_extents_A = static_cast<const GodotBoxShape3D *>(pair.shape_A)->get_half_extents();
+		const Vector3 half_extents_B = static_cast<const GodotBoxShape3D *>(pair.shape_B)->get_half_extents();
+		for (int j = 0; j < 3; j++) {
+			extents_A[j][i] = half_extents_A[j] + SAT_BATCH_TOLERANCE * 0.5;
+			extents_B[j][i] = half_extents_B[j] + SAT_BATCH_TOLERANCE * 0.5;
+		}
+	}
+
+	// The 15 axes of the OBB separation test, with everything expressed in the frame of A.
+	for (uint32_t i = 0; i < p_count; i++) {
+		real_t r[3][3];
+		real_t abs_r[3][3];
+		for (int j = 0; j < 3; j++) {
+			for (int k = 0; k < 3; k++) {
+				r[j][k] = axes_A[j * 3][i] * axes_B[k * 3][i] + axes_A[j * 3 + 1][i] * axes_B[k * 3 + 1][i] + axes_A[j * 3 + 2][i] * axes_B[k * 3 + 2][i];
+				// Keeps edge axes of nearly parallel boxes from reporting a false separation.
+				abs_r[j][k] = Math::abs(r[j][k]) + (real_t)CMP_EPSILON;
+			}
+		}
+
+		real_t t[3];
+		for (int j = 0; j < 3; j++) {
+			t[j] = axes_A[j * 3][i] * dx[i] + axes_A[j * 3 + 1][i] * dy[i] + axes_A[j * 3 + 2][i] * dz[i];
+		}
+
+		const real_t a0 = extents_A[0][i], a1 = extents_A[1][i], a2 = extents_A[2][i];
+		const real_t b0 = extents_B[0][i], b1 = extents_B[1][i], b2 = extents_B[2][i];
+
+		bool separated = false;
+		for (int j = 0; j < 3; j++) {
+			separated |= Math::abs(t[j]) > extents_A[j][i] + b0 * abs_r[j][0] + b1 * abs_r[j][1] + b2 * abs_r[j][2];
+			separated |= Math::abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > a0 * abs_r[0][j] + a1 * abs_r[1][j] + a2 * abs_r[2][j] + extents_B[j][i];
+		}
+
+		separated |= Math::abs(t[2] * r[1][0] - t[1] * r[2][0]) > a1 * abs_r[2][0] + a2 * abs_r[1][0] + b1 * abs_r[0][2] + b2 * abs_r[0][1];
+		separated |= Math::abs(t[2] * r[1][1] - t[1] * r[2][1]) > a1 * abs_r[2][1] + a2 * abs_r[1][1] + b0 * abs_r[0][2] + b2 * abs_r[0][0];
+		separated |= Math::abs(t[2] * r[1][2] - t[1] * r[2][2]) > a1 * abs_r[2][2] + a2 * abs_r[1][2] + b0 * abs_r[0][1] + b1 * abs_r[0][0];
+		separated |= Math::abs(t[0] * r[2][0] - t[2] * r[0][0]) > a0 * abs_r[2][0] + a2 * abs_r[0][0] + b1 * abs_r[1][2] + b2 * abs_r[1][1];
+		separated |= Math::abs(t[0] * r[2][1] - t[2] * r[0][1]) > a0 * abs_r[2][1] + a2 * abs_r[0][1] + b0 * abs_r[1][2] + b2 * abs_r[1][0];
+		separated |= Math::abs(t[0] * r[2][2] - t[2] * r[0][2]) > a0 * abs_r[2][2] + a2 * abs_r[0][2] + b0 * abs_r[1][1] + b1 * abs_r[1][0];
+		separated |= Math::abs(t[1] * r[0][0] - t[0] * r[1][0]) > a0 * abs_r[1][0] + a1 * abs_r[0][0] + b1 * abs_r[2][2] + b2 * abs_r[2][1];
+		separated |= Math::abs(t[1] * r[0][1] - t[0] * r[1][1]) > a0 * abs_r[1][1] + a1 * abs_r[0][1] + b0 * abs_r[2][2] + b2 * abs_r[2][0];
+		separated |= Math::abs(t[1] * r[0][2] - t[0] * r[1][2]) > a0 * abs_r[1][2] + a1 * abs_r[0][2] + b0 * abs_r[2][1] + b1 * abs_r[2][0];
+
+		r_separated[i] = separated;
+	}
+}
+
+SATBatchKind sat_batch_get_kind(const GodotShape3D *p_shape_A, const Transform3D &p_transform_A, const GodotShape3D *p_shape_B, const Transform3D &p_transform_B) {
+	PhysicsServer3D::ShapeType type_A = p_shape_A->get_type();
+	PhysicsServer3D::ShapeType type_B = p_shape_B->get_type();
+	if (type_A > type_B) {
+		SWAP(type_A, type_B);
+	}
+
+	SATBatchKind kind = SAT_BATCH_NONE;
+	if (type_A == PhysicsServer3D::SHAPE_SPHERE) {
+		if (type_B == PhysicsServer3D::SHAPE_SPHERE) {
+			kind = SAT_BATCH_SPHERE_SPHERE;
+		} else if (type_B == PhysicsServer3D::SHAPE_BOX) {
+			kind = SAT_BATCH_SPHERE_BOX;
+		} else if (type_B == PhysicsServer3D::SHAPE_CAPSULE) {
+			kind = SAT_BATCH_SPHERE_CAPSULE;
+		}
+	} else if (type_A == PhysicsServer3D::SHAPE_BOX && type_B == PhysicsServer3D::SHAPE_BOX) {
+		kind = SAT_BATCH_BOX_BOX;
+	} else if (type_A == PhysicsServer3D::SHAPE_CAPSULE && type_B == PhysicsServer3D::SHAPE_CAPSULE) {
+		kind = SAT_BATCH_CAPSULE_CAPSULE;
+	}
+
+	// The kernels don't account for scale, unlike the shape projections used by the SAT solver.
+	if (kind != SAT_BATCH_NONE && (!p_transform_A.basis.is_orthogonal() || !p_transform_B.basis.is_orthogonal())) {
+		kind = SAT_BATCH_NONE;
+	}
+
+	return kind;
+}
+
+void sat_batch_test_separation(SATBatchKind p_kind, const SATBatchPair *p_pairs, uint32_t p_count, bool *r_separated) {
+	typedef void (*BatchFunc)(const SATBatchPair *, uint32_t, bool *);
+	static const BatchFunc batch_funcs[SAT_BATCH_MAX] = {
+		nullptr,
+		_batch_sphere_sphere,
+		_batch_sphere_box,
+		_batch_sphere_capsule,
+		_batch_capsule_capsule,
+		_batch_box_box,
+	};
+
+	ERR_FAIL_INDEX(p_kind, SAT_BATCH_MAX);
+	BatchFunc batch_func = batch_funcs[p_kind];
+	ERR_FAIL_COND(!batch_func);
+
+	for (uint32_t from = 0; from < p_count; from += SAT_BATCH_SIZE) {
+		batch_func(p_pairs + from, MIN(p_count - from, (uint32_t)SAT_BATCH_SIZE), r_separated + from);
+	}
+}
@@ -0,0 +1,65 @@
+/*************************************************************************/
+/*  godot_collision_solver_3d_batch.h                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GODOT_COLLISION_SOLVER_3D_BATCH_H
+#define GODOT_COLLISION_SOLVER_3D_BATCH_H
+
+#include "godot_collision_solver_3d.h"
+
+// Separation tests for many pairs of primitive shapes at once. Pairs of the same kind are gathered into
+// structure-of-arrays blocks and tested with branch-free loops, which compilers turn into SIMD code.
+// Only the pairs proven apart skip the SAT solver, which still generates the contacts of all others.
+
+enum SATBatchKind {
+	SAT_BATCH_NONE,
+	SAT_BATCH_SPHERE_SPHERE,
+	SAT_BATCH_SPHERE_BOX,
+	SAT_BATCH_SPHERE_CAPSULE,
+	SAT_BATCH_CAPSULE_CAPSULE,
+	SAT_BATCH_BOX_BOX,
+	SAT_BATCH_MAX,
+};
+
+enum {
+	SAT_BATCH_SIZE = 64,
+};
+
+struct SATBatchPair {
+	const GodotShape3D *shape_A = nullptr;
+	const Transform3D *transform_A = nullptr;
+	const GodotShape3D *shape_B = nullptr;
+	const Transform3D *transform_B = nullptr;
+};
+
+SATBatchKind sat_batch_get_kind(const GodotShape3D *p_shape_A, const Transform3D &p_transform_A, const GodotShape3D *p_shape_B, const Transform3D &p_transform_B);
+// All pairs must be of the given kind, in either shape order.
+void sat_batch_test_separation(SATBatchKind p_kind, const SATBatchPair *p_pairs, uint32_t p_count, bool *r_separated);
+
+#endif // GODOT_COLLISION_SOLVER_3D_BATCH_H
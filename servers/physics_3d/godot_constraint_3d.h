@@ -31,6 +31,8 @@
 #ifndef GODOT_CONSTRAINT_3D_H
 #define GODOT_CONSTRAINT_3D_H
 
+#include "godot_collision_solver_3d_batch.h"
+
 class GodotBody3D;
 class GodotSoftBody3D;
 
@@ -75,6 +77,11 @@ public:
 	virtual bool pre_solve(real_t p_step) = 0;
 	virtual void solve(real_t p_step) = 0;
 
+	// Setup may leave the narrowphase of primitive pairs to the step, which tests them in batches.
+	virtual SATBatchKind get_batch_kind() const { return SAT_BATCH_NONE; }
+	virtual void get_batch_pair(SATBatchPair &r_pair) const {}
+	virtual void finish_batch_setup(bool p_separated) {}
+
 	virtual ~GodotConstraint3D() {}
 };
 
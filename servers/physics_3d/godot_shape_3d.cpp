@@ -33,6 +33,7 @@
 #include "core/io/image.h"
 #include "core/math/convex_hull.h"
 #include "core/math/geometry_3d.h"
+#include "core/templates/hash_map.h"
 #include "core/templates/sort_array.h"
 
 // GodotHeightMapShape3D is based on Bullet btHeightfieldTerrainShape.
@@ -1284,12 +1285,12 @@ Vector3 GodotConcavePolygonShape3D::get_support(const Vector3 &p_normal) const {
 void GodotConcavePolygonShape3D::_cull_segment(int p_idx, _SegmentCullParams *p_params) const {
 	const BVH *bvh = &p_params->bvh[p_idx];
 
-	if (!bvh->aabb.intersects_segment(p_params->from, p_params->to)) {
+	if (!_get_bvh_aabb(*bvh).intersects_segment(p_params->from, p_params->to)) {
 		return;
 	}
 
-	if (bvh->face_index >= 0) {
-		const Face *f = &p_params->faces[bvh->face_index];
+	if (bvh->index >= 0) {
+		const Face *f = &p_params->faces[bvh->index];
 		GodotFaceShape3D *face = p_params->face;
 		face->normal = f->normal;
 		face->vertex[0] = p_params->vertices[f->indices[0]];
@@ -1308,12 +1309,8 @@ void GodotConcavePolygonShape3D::_cull_segment(int p_idx, _SegmentCullParams *p_
 			}
 		}
 	} else {
-		if (bvh->left >= 0) {
-			_cull_segment(bvh->left, p_params);
-		}
-		if (bvh->right >= 0) {
-			_cull_segment(bvh->right, p_params);
-		}
+		_cull_segment(p_idx + 1, p_params);
+		_cull_segment(-bvh->index, p_params);
 	}
 }
 
@@ -1364,12 +1361,14 @@ Vector3 GodotConcavePolygonShape3D::get_closest_point_to(const Vector3 &p_point)
 bool GodotConcavePolygonShape3D::_cull(int p_idx, _CullParams *p_params) const {
 	const BVH *bvh = &p_params->bvh[p_idx];
 
-	if (!p_params->aabb.intersects(bvh->aabb)) {
-		return false;
+	for (int i = 0; i < 3; i++) {
+		if (p_params->min[i] > bvh->max[i] || p_params->max[i] < bvh->min[i]) {
+			return false;
+		}
 	}
 
-	if (bvh->face_index >= 0) {
-		const Face *f = &p_params->faces[bvh->face_index];
+	if (bvh->index >= 0) {
+		const Face *f = &p_params->faces[bvh->index];
 		GodotFaceShape3D *face = p_params->face;
 		face->normal = f->normal;
 		face->vertex[0] = p_params->vertices[f->indices[0]];
@@ -1379,16 +1378,12 @@ bool GodotConcavePolygonShape3D::_cull(int p_idx, _CullParams *p_params) const {
 			return true;
 		}
 	} else {
-		if (bvh->left >= 0) {
-			if (_cull(bvh->left, p_params)) {
-				return true;
-			}
+		if (_cull(p_idx + 1, p_params)) {
+			return true;
 		}
 
-		if (bvh->right >= 0) {
-			if (_cull(bvh->right, p_params)) {
-				return true;
-			}
+		if (_cull(-bvh->index, p_params)) {
+			return true;
 		}
 	}
 
@@ -1401,7 +1396,9 @@ void GodotConcavePolygonShape3D::cull(const AABB &p_local_aabb, QueryCallback p_
 		return;
 	}
 
-	AABB local_aabb = p_local_aabb;
+	if (!p_local_aabb.intersects(get_aabb())) {
+		return;
+	}
 
 	// unlock data
 	const Face *fr = faces.ptr();
@@ -1413,7 +1410,7 @@ void GodotConcavePolygonShape3D::cull(const AABB &p_local_aabb, QueryCallback p_
 	face.invert_backface_collision = p_invert_backface_collision;
 
 	_CullParams params;
-	params.aabb = local_aabb;
+	_quantize_aabb(p_local_aabb, params.min, params.max);
 	params.face = &face;
 	params.faces = fr;
 	params.vertices = vr;
@@ -1516,27 +1513,30 @@ _Volume_BVH *_volume_build_bvh(_Volume_BVH_Element *p_elements, int p_size, int
 	return bvh;
 }
 
+void GodotConcavePolygonShape3D::_quantize_aabb(const AABB &p_aabb, uint16_t *r_min, uint16_t *r_max) const {
+	// Rounded outwards, so the quantized bounds always contain the original ones.
+	const Vector3 min = (p_aabb.position - bvh_origin) * bvh_scale;
+	const Vector3 max = (p_aabb.position + p_aabb.size - bvh_origin) * bvh_scale;
+	for (int i = 0; i < 3; i++) {
+		r_min[i] = (uint16_t)CLAMP(Math::floor(min[i]) - 1.0, 0.0, 65535.0);
+		r_max[i] = (uint16_t)CLAMP(Math::ceil(max[i]) + 1.0, 0.0, 65535.0);
+	}
+}
+
 void GodotConcavePolygonShape3D::_fill_bvh(_Volume_BVH *p_bvh_tree, BVH *p_bvh_array, int &p_idx) {
 	int idx = p_idx;
 
-	p_bvh_array[idx].aabb = p_bvh_tree->aabb;
-	p_bvh_array[idx].face_index = p_bvh_tree->face_index;
-	//printf("%p - %i: %i(%p)  -- %p:%p\n",%p_bvh_array[idx],p_idx,p_bvh_array[i]->face_index,&p_bvh_tree->face_index,p_bvh_tree->left,p_bvh_tree->right);
-
-	if (p_bvh_tree->left) {
-		p_bvh_array[idx].left = ++p_idx;
-		_fill_bvh(p_bvh_tree->left, p_bvh_array, p_idx);
+	_quantize_aabb(p_bvh_tree->aabb, p_bvh_array[idx].min, p_bvh_array[idx].max);
 
+	if (p_bvh_tree->face_index >= 0) {
+		p_bvh_array[idx].index = p_bvh_tree->face_index;
 	} else {
-		p_bvh_array[p_idx].left = -1;
-	}
+		// The left child follows, the right one comes after the whole left subtree.
+		++p_idx;
+		_fill_bvh(p_bvh_tree->left, p_bvh_array, p_idx);
 
-	if (p_bvh_tree->right) {
-		p_bvh_array[idx].right = ++p_idx;
+		p_bvh_array[idx].index = -(++p_idx);
 		_fill_bvh(p_bvh_tree->right, p_bvh_array, p_idx);
-
-	} else {
-		p_bvh_array[p_idx].right = -1;
 	}
 
 	memdelete(p_bvh_tree);
@@ -1545,6 +1545,9 @@ void GodotConcavePolygonShape3D::_fill_bvh(_Volume_BVH *p_bvh_tree, BVH *p_bvh_a
 void GodotConcavePolygonShape3D::_setup(const Vector<Vector3> &p_faces, bool p_backface_collision) {
 	int src_face_count = p_faces.size();
 	if (src_face_count == 0) {
+		faces.clear();
+		vertices.clear();
+		bvh.clear();
 		configure(AABB());
 		return;
 	}
@@ -1561,9 +1564,9 @@ void GodotConcavePolygonShape3D::_setup(const Vector<Vector3> &p_faces, bool p_b
 	faces.resize(src_face_count);
 	Face *facesw = faces.ptrw();
 
-	vertices.resize(src_face_count * 3);
-
-	Vector3 *verticesw = vertices.ptrw();
+	// Faces share their vertices, which are usually repeated several times in the source faces.
+	HashMap<Vector3, int> vertex_indices;
+	LocalVector<Vector3> unique_vertices;
 
 	AABB _aabb;
 
@@ -1573,13 +1576,17 @@ void GodotConcavePolygonShape3D::_setup(const Vector<Vector3> &p_faces, bool p_b
 		bvh_arrayw[i].aabb = face.get_aabb();
 		bvh_arrayw[i].center = bvh_arrayw[i].aabb.get_center();
 		bvh_arrayw[i].face_index = i;
-		facesw[i].indices[0] = i * 3 + 0;
-		facesw[i].indices[1] = i * 3 + 1;
-		facesw[i].indices[2] = i * 3 + 2;
+		for (int j = 0; j < 3; j++) {
+			HashMap<Vector3, int>::Iterator E = vertex_indices.find(face.vertex[j]);
+			if (E) {
+				facesw[i].indices[j] = E->value;
+			} else {
+				facesw[i].indices[j] = unique_vertices.size();
+				vertex_indices.insert(face.vertex[j], unique_vertices.size());
+				unique_vertices.push_back(face.vertex[j]);
+			}
+		}
 		facesw[i].normal = face.get_plane().normal;
-		verticesw[i * 3 + 0] = face.vertex[0];
-		verticesw[i * 3 + 1] = face.vertex[1];
-		verticesw[i * 3 + 2] = face.vertex[2];
 		if (i == 0) {
 			_aabb = bvh_arrayw[i].aabb;
 		} else {
@@ -1587,10 +1594,23 @@ void GodotConcavePolygonShape3D::_setup(const Vector<Vector3> &p_faces, bool p_b
 		}
 	}
 
+	vertices.resize(unique_vertices.size());
+	Vector3 *verticesw = vertices.ptrw();
+	for (uint32_t i = 0; i < unique_vertices.size(); i++) {
+		verticesw[i] = unique_vertices[i];
+	}
+
+	bvh_origin = _aabb.position;
+	for (int i = 0; i < 3; i++) {
+		// Flat axes quantize everything to 0.
+		bvh_scale[i] = _aabb.size[i] > 0.0 ? 65535.0 / _aabb.size[i] : 0.0;
+		bvh_inv_scale[i] = _aabb.size[i] / 65535.0;
+	}
+
 	int count = 0;
 	_Volume_BVH *bvh_tree = _volume_build_bvh(bvh_arrayw, src_face_count, count);
 
-	bvh.resize(count + 1);
+	bvh.resize(count);
 
 	BVH *bvh_arrayw2 = bvh.ptrw();
 
@@ -1648,236 +1668,159 @@ struct _HeightmapSegmentCullParams {
 	Vector3 from;
 	Vector3 to;
 	Vector3 dir;
+	real_t length = 0.0;
 
 	Vector3 result;
 	Vector3 normal;
+	real_t min_d = 1e20;
+	int collisions = 0;
 
 	const GodotHeightMapShape3D *heightmap = nullptr;
 	GodotFaceShape3D *face = nullptr;
 };
 
-struct _HeightmapGridCullState {
-	real_t length = 0.0;
-	real_t length_flat = 0.0;
+struct _HeightmapCullParams {
+	int start_x = 0;
+	int end_x = 0;
+	int start_z = 0;
+	int end_z = 0;
+	real_t min_y = 0.0;
+	real_t max_y = 0.0;
 
-	real_t dist = 0.0;
-	real_t prev_dist = 0.0;
-
-	int x = 0;
-	int z = 0;
+	GodotConcaveShape3D::QueryCallback callback = nullptr;
+	void *userdata = nullptr;
+	GodotFaceShape3D *face = nullptr;
 };
 
-_FORCE_INLINE_ bool _heightmap_face_cull_segment(_HeightmapSegmentCullParams &p_params) {
+// Finds where the segment enters a box, only if it's closer than the closest hit found so far.
+_FORCE_INLINE_ bool _heightmap_segment_enters_box(const _HeightmapSegmentCullParams &p_params, const Vector3 &p_min, const Vector3 &p_max, real_t &r_enter) {
+	real_t enter = 0.0;
+	real_t exit = MIN(p_params.length, p_params.min_d);
+
+	for (int i = 0; i < 3; i++) {
+		// Grown a bit, flat areas have boxes without height.
+		const real_t min = p_min[i] - CMP_EPSILON;
+		const real_t max = p_max[i] + CMP_EPSILON;
+
+		if (Math::abs(p_params.dir[i]) < CMP_EPSILON) {
+			if (p_params.from[i] < min || p_params.from[i] > max) {
+				return false;
+			}
+			continue;
+		}
+
+		const real_t inv_dir = 1.0 / p_params.dir[i];
+		real_t t0 = (min - p_params.from[i]) * inv_dir;
+		real_t t1 = (max - p_params.from[i]) * inv_dir;
+		if (t0 > t1) {
+			SWAP(t0, t1);
+		}
+		enter = MAX(enter, t0);
+		exit = MIN(exit, t1);
+		if (enter > exit) {
+			return false;
+		}
+	}
+
+	r_enter = enter;
+	return true;
+}
+
+_FORCE_INLINE_ void _heightmap_face_cull_segment(_HeightmapSegmentCullParams &p_params) {
 	Vector3 res;
 	Vector3 normal;
 	if (p_params.face->intersect_segment(p_params.from, p_params.to, res, normal, true)) {
-		p_params.result = res;
-		p_params.normal = normal;
-		return true;
+		real_t d = p_params.dir.dot(res - p_params.from);
+		if (d < p_params.min_d) {
+			p_params.min_d = d;
+			p_params.result = res;
+			p_params.normal = normal;
+			p_params.collisions++;
+		}
 	}
-
-	return false;
 }
 
-_FORCE_INLINE_ bool _heightmap_cell_cull_segment(_HeightmapSegmentCullParams &p_params, const _HeightmapGridCullState &p_state) {
+_FORCE_INLINE_ void _heightmap_cell_cull_segment(_HeightmapSegmentCullParams &p_params, int p_x, int p_z) {
 	// First triangle.
-	p_params.heightmap->_get_point(p_state.x, p_state.z, p_params.face->vertex[0]);
-	p_params.heightmap->_get_point(p_state.x + 1, p_state.z, p_params.face->vertex[1]);
-	p_params.heightmap->_get_point(p_state.x, p_state.z + 1, p_params.face->vertex[2]);
+	p_params.heightmap->_get_point(p_x, p_z, p_params.face->vertex[0]);
+	p_params.heightmap->_get_point(p_x + 1, p_z, p_params.face->vertex[1]);
+	p_params.heightmap->_get_point(p_x, p_z + 1, p_params.face->vertex[2]);
 	p_params.face->normal = Plane(p_params.face->vertex[0], p_params.face->vertex[1], p_params.face->vertex[2]).normal;
-	if (_heightmap_face_cull_segment(p_params)) {
-		return true;
-	}
+	_heightmap_face_cull_segment(p_params);
 
 	// Second triangle.
 	p_params.face->vertex[0] = p_params.face->vertex[1];
-	p_params.heightmap->_get_point(p_state.x + 1, p_state.z + 1, p_params.face->vertex[1]);
+	p_params.heightmap->_get_point(p_x + 1, p_z + 1, p_params.face->vertex[1]);
 	p_params.face->normal = Plane(p_params.face->vertex[0], p_params.face->vertex[1], p_params.face->vertex[2]).normal;
-	if (_heightmap_face_cull_segment(p_params)) {
-		return true;
-	}
-
-	return false;
-}
-
-_FORCE_INLINE_ bool _heightmap_chunk_cull_segment(_HeightmapSegmentCullParams &p_params, const _HeightmapGridCullState &p_state) {
-	const GodotHeightMapShape3D::Range &chunk = p_params.heightmap->_get_bounds_chunk(p_state.x, p_state.z);
-
-	Vector3 enter_pos;
-	Vector3 exit_pos;
-
-	if (p_state.length_flat > CMP_EPSILON) {
-		real_t flat_to_3d = p_state.length / p_state.length_flat;
-		real_t enter_param = p_state.prev_dist * flat_to_3d;
-		real_t exit_param = p_state.dist * flat_to_3d;
-		enter_pos = p_params.from + p_params.dir * enter_param;
-		exit_pos = p_params.from + p_params.dir * exit_param;
-	} else {
-		// Consider the ray vertical.
-		// (though we shouldn't reach this often because there is an early check up-front)
-		enter_pos = p_params.from;
-		exit_pos = p_params.to;
-	}
-
-	// Transform positions to heightmap space.
-	enter_pos *= GodotHeightMapShape3D::BOUNDS_CHUNK_SIZE;
-	exit_pos *= GodotHeightMapShape3D::BOUNDS_CHUNK_SIZE;
-
-	// We did enter the flat projection of the AABB,
-	// but we have to check if we intersect it on the vertical axis.
-	if ((enter_pos.y > chunk.max) && (exit_pos.y > chunk.max)) {
-		return false;
-	}
-	if ((enter_pos.y < chunk.min) && (exit_pos.y < chunk.min)) {
-		return false;
-	}
-
-	return p_params.heightmap->_intersect_grid_segment(_heightmap_cell_cull_segment, enter_pos, exit_pos, p_params.heightmap->width, p_params.heightmap->depth, p_params.heightmap->local_origin, p_params.result, p_params.normal);
-}
-
-template <typename ProcessFunction>
-bool GodotHeightMapShape3D::_intersect_grid_segment(ProcessFunction &p_process, const Vector3 &p_begin, const Vector3 &p_end, int p_width, int p_depth, const Vector3 &offset, Vector3 &r_point, Vector3 &r_normal) const {
-	Vector3 delta = (p_end - p_begin);
-	real_t length = delta.length();
-
-	if (length < CMP_EPSILON) {
-		return false;
-	}
-
-	Vector3 local_begin = p_begin + offset;
-
-	GodotFaceShape3D face;
-	face.backface_collision = false;
-
-	_HeightmapSegmentCullParams params;
-	params.from = p_begin;
-	params.to = p_end;
-	params.dir = delta / length;
-	params.heightmap = this;
-	params.face = &face;
-
-	_HeightmapGridCullState state;
-
-	// Perform grid query from projected ray.
-	Vector2 ray_dir_flat(delta.x, delta.z);
-	state.length = length;
-	state.length_flat = ray_dir_flat.length();
-
-	if (state.length_flat < CMP_EPSILON) {
-		ray_dir_flat = Vector2();
-	} else {
-		ray_dir_flat /= state.length_flat;
-	}
-
-	const int x_step = (ray_dir_flat.x > CMP_EPSILON) ? 1 : ((ray_dir_flat.x < -CMP_EPSILON) ? -1 : 0);
-	const int z_step = (ray_dir_flat.y > CMP_EPSILON) ? 1 : ((ray_dir_flat.y < -CMP_EPSILON) ? -1 : 0);
-
-	const real_t infinite = 1e20;
-	const real_t delta_x = (x_step != 0) ? 1.f / Math::abs(ray_dir_flat.x) : infinite;
-	const real_t delta_z = (z_step != 0) ? 1.f / Math::abs(ray_dir_flat.y) : infinite;
-
-	real_t cross_x; // At which value of `param` we will cross a x-axis lane?
-	real_t cross_z; // At which value of `param` we will cross a z-axis lane?
-
-	// X initialization.
-	if (x_step != 0) {
-		if (x_step == 1) {
-			cross_x = (Math::ceil(local_begin.x) - local_begin.x) * delta_x;
-		} else {
-			cross_x = (local_begin.x - Math::floor(local_begin.x)) * delta_x;
-		}
-	} else {
-		cross_x = infinite; // Will never cross on X.
-	}
-
-	// Z initialization.
-	if (z_step != 0) {
-		if (z_step == 1) {
-			cross_z = (Math::ceil(local_begin.z) - local_begin.z) * delta_z;
-		} else {
-			cross_z = (local_begin.z - Math::floor(local_begin.z)) * delta_z;
-		}
-	} else {
-		cross_z = infinite; // Will never cross on Z.
-	}
-
-	int x = Math::floor(local_begin.x);
-	int z = Math::floor(local_begin.z);
-
-	// Workaround cases where the ray starts at an integer position.
-	if (Math::is_zero_approx(cross_x)) {
-		cross_x += delta_x;
-		// If going backwards, we should ignore the position we would get by the above flooring,
-		// because the ray is not heading in that direction.
-		if (x_step == -1) {
-			x -= 1;
-		}
-	}
-
-	if (Math::is_zero_approx(cross_z)) {
-		cross_z += delta_z;
-		if (z_step == -1) {
-			z -= 1;
+	_heightmap_face_cull_segment(p_params);
+}
+
+void GodotHeightMapShape3D::_cull_segment_block(int p_level, int p_x, int p_z, _HeightmapSegmentCullParams &p_params) const {
+	const int size = BOUNDS_BLOCK_SIZE << p_level;
+	const int x0 = p_x * size;
+	const int z0 = p_z * size;
+
+	if (p_level == 0) {
+		const int x1 = MIN(x0 + size, width - 1);
+		const int z1 = MIN(z0 + size, depth - 1);
+		for (int z = z0; z < z1; z++) {
+			for (int x = x0; x < x1; x++) {
+				Range range;
+				_get_cell_range(x, z, range);
+				real_t enter;
+				if (_heightmap_segment_enters_box(p_params, Vector3(x - local_origin.x, range.min, z - local_origin.z), Vector3(x + 1 - local_origin.x, range.max, z + 1 - local_origin.z), enter)) {
+					_heightmap_cell_cull_segment(p_params, x, z);
+				}
+			}
 		}
+		return;
 	}
 
-	// Start inside the grid.
-	int x_start = MAX(MIN(x, p_width - 2), 0);
-	int z_start = MAX(MIN(z, p_depth - 2), 0);
-
-	// Adjust initial cross values.
-	cross_x += delta_x * x_step * (x_start - x);
-	cross_z += delta_z * z_step * (z_start - z);
-
-	x = x_start;
-	z = z_start;
-
-	while (true) {
-		state.prev_dist = state.dist;
-		state.x = x;
-		state.z = z;
-
-		if (cross_x < cross_z) {
-			// X lane.
-			x += x_step;
-			// Assign before advancing the param,
-			// to be in sync with the initialization step.
-			state.dist = cross_x;
-			cross_x += delta_x;
-		} else {
-			// Z lane.
-			z += z_step;
-			state.dist = cross_z;
-			cross_z += delta_z;
-		}
-
-		if (state.dist > state.length_flat) {
-			state.dist = state.length_flat;
-			if (p_process(params, state)) {
-				r_point = params.result;
-				r_normal = params.normal;
-				return true;
+	struct Child {
+		real_t enter = 0.0;
+		int x = 0;
+		int z = 0;
+	};
+	Child children[4];
+	int child_count = 0;
+
+	const BoundsLevel &child_level = bounds_levels[p_level - 1];
+	const int child_size = size / 2;
+	for (int cz = p_z * 2; cz < MIN(p_z * 2 + 2, child_level.depth); cz++) {
+		for (int cx = p_x * 2; cx < MIN(p_x * 2 + 2, child_level.width); cx++) {
+			const Range &range = _get_bounds_block(p_level - 1, cx, cz);
+			const int cx0 = cx * child_size;
+			const int cz0 = cz * child_size;
+			const int cx1 = MIN(cx0 + child_size, width - 1);
+			const int cz1 = MIN(cz0 + child_size, depth - 1);
+
+			Child child;
+			if (_heightmap_segment_enters_box(p_params, Vector3(cx0 - local_origin.x, range.min, cz0 - local_origin.z), Vector3(cx1 - local_origin.x, range.max, cz1 - local_origin.z), child.enter)) {
+				child.x = cx;
+				child.z = cz;
+
+				// Sorted by distance.
+				int i = child_count++;
+				while (i > 0 && children[i - 1].enter > child.enter) {
+					children[i] = children[i - 1];
+					i--;
+				}
+				children[i] = child;
 			}
-			break;
-		}
-
-		if (p_process(params, state)) {
-			r_point = params.result;
-			r_normal = params.normal;
-			return true;
 		}
+	}
 
-		// Stop when outside the grid.
-		if ((x < 0) || (z < 0) || (x >= p_width - 1) || (z >= p_depth - 1)) {
+	// The blocks don't overlap, so there is no closer hit in the blocks the segment enters after a hit.
+	for (int i = 0; i < child_count; i++) {
+		if (children[i].enter > p_params.min_d) {
 			break;
 		}
+		_cull_segment_block(p_level - 1, children[i].x, children[i].z, p_params);
 	}
-
-	return false;
 }
 
 bool GodotHeightMapShape3D::intersect_segment(const Vector3 &p_begin, const Vector3 &p_end, Vector3 &r_point, Vector3 &r_normal, bool p_hit_back_faces) const {
-	if (heights.is_empty()) {
+	if (heights.is_empty() || bounds_levels.is_empty()) {
 		return false;
 	}
 
@@ -1890,46 +1833,39 @@ bool GodotHeightMapShape3D::intersect_segment(const Vector3 &p_begin, const Vect
 	int end_x = Math::floor(local_end.x);
 	int end_z = Math::floor(local_end.z);
 
+	GodotFaceShape3D face;
+
+	_HeightmapSegmentCullParams params;
+	params.from = p_begin;
+	params.to = p_end;
+	params.dir = (p_end - p_begin).normalized();
+	params.length = p_begin.distance_to(p_end);
+
+	params.heightmap = this;
+	params.face = &face;
+
 	if ((begin_x == end_x) && (begin_z == end_z)) {
 		// Simple case for rays that don't traverse the grid horizontally.
 		// Just perform a test on the given cell.
-		GodotFaceShape3D face;
 		face.backface_collision = p_hit_back_faces;
-
-		_HeightmapSegmentCullParams params;
-		params.from = p_begin;
-		params.to = p_end;
-		params.dir = (p_end - p_begin).normalized();
-
-		params.heightmap = this;
-		params.face = &face;
-
-		_HeightmapGridCullState state;
-		state.x = MAX(MIN(begin_x, width - 2), 0);
-		state.z = MAX(MIN(begin_z, depth - 2), 0);
-		if (_heightmap_cell_cull_segment(params, state)) {
-			r_point = params.result;
-			r_normal = params.normal;
-			return true;
-		}
-	} else if (bounds_grid.is_empty()) {
-		// Process all cells intersecting the flat projection of the ray.
-		return _intersect_grid_segment(_heightmap_cell_cull_segment, p_begin, p_end, width, depth, local_origin, r_point, r_normal);
+		_heightmap_cell_cull_segment(params, MAX(MIN(begin_x, width - 2), 0), MAX(MIN(begin_z, depth - 2), 0));
 	} else {
-		Vector3 ray_diff = (p_end - p_begin);
-		real_t length_flat_sqr = ray_diff.x * ray_diff.x + ray_diff.z * ray_diff.z;
-		if (length_flat_sqr < BOUNDS_CHUNK_SIZE * BOUNDS_CHUNK_SIZE) {
-			// Don't use chunks, the ray is too short in the plane.
-			return _intersect_grid_segment(_heightmap_cell_cull_segment, p_begin, p_end, width, depth, local_origin, r_point, r_normal);
-		} else {
-			// The ray is long, run raycast on a higher-level grid.
-			Vector3 bounds_from = p_begin / BOUNDS_CHUNK_SIZE;
-			Vector3 bounds_to = p_end / BOUNDS_CHUNK_SIZE;
-			Vector3 bounds_offset = local_origin / BOUNDS_CHUNK_SIZE;
-			return _intersect_grid_segment(_heightmap_chunk_cull_segment, bounds_from, bounds_to, bounds_grid_width, bounds_grid_depth, bounds_offset, r_point, r_normal);
+		// Walk down the pyramid, only into the blocks the segment crosses within their height range.
+		face.backface_collision = false;
+		const int top_level = bounds_levels.size() - 1;
+		const Range &range = _get_bounds_block(top_level, 0, 0);
+		real_t enter;
+		if (_heightmap_segment_enters_box(params, Vector3(-local_origin.x, range.min, -local_origin.z), Vector3(width - 1 - local_origin.x, range.max, depth - 1 - local_origin.z), enter)) {
+			_cull_segment_block(top_level, 0, 0, params);
 		}
 	}
 
+	if (params.collisions > 0) {
+		r_point = params.result;
+		r_normal = params.normal;
+		return true;
+	}
+
 	return false;
 }
 
@@ -1956,8 +1892,69 @@ void GodotHeightMapShape3D::_get_cell(const Vector3 &p_point, int &r_x, int &r_y
 	r_z = (clamped_point.z < 0.0) ? (clamped_point.z - 0.5) : (clamped_point.z + 0.5);
 }
 
+bool GodotHeightMapShape3D::_cull_block(int p_level, int p_x, int p_z, _HeightmapCullParams &p_params) const {
+	const Range &range = _get_bounds_block(p_level, p_x, p_z);
+	if (range.max < p_params.min_y || range.min > p_params.max_y) {
+		return false;
+	}
+
+	const int size = BOUNDS_BLOCK_SIZE << p_level;
+	const int x0 = p_x * size;
+	const int z0 = p_z * size;
+	if (x0 >= p_params.end_x || x0 + size <= p_params.start_x || z0 >= p_params.end_z || z0 + size <= p_params.start_z) {
+		return false;
+	}
+
+	if (p_level > 0) {
+		const BoundsLevel &child_level = bounds_levels[p_level - 1];
+		for (int cz = p_z * 2; cz < MIN(p_z * 2 + 2, child_level.depth); cz++) {
+			for (int cx = p_x * 2; cx < MIN(p_x * 2 + 2, child_level.width); cx++) {
+				if (_cull_block(p_level - 1, cx, cz, p_params)) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	GodotFaceShape3D &face = *p_params.face;
+	const int start_x = MAX(x0, p_params.start_x);
+	const int end_x = MIN(x0 + size, p_params.end_x);
+	const int start_z = MAX(z0, p_params.start_z);
+	const int end_z = MIN(z0 + size, p_params.end_z);
+
+	for (int z = start_z; z < end_z; z++) {
+		for (int x = start_x; x < end_x; x++) {
+			Range cell_range;
+			_get_cell_range(x, z, cell_range);
+			if (cell_range.max < p_params.min_y || cell_range.min > p_params.max_y) {
+				continue;
+			}
+
+			// First triangle.
+			_get_point(x, z, face.vertex[0]);
+			_get_point(x + 1, z, face.vertex[1]);
+			_get_point(x, z + 1, face.vertex[2]);
+			face.normal = Plane(face.vertex[0], face.vertex[1], face.vertex[2]).normal;
+			if (p_params.callback(p_params.userdata, &face)) {
+				return true;
+			}
+
+			// Second triangle.
+			face.vertex[0] = face.vertex[1];
+			_get_point(x + 1, z + 1, face.vertex[1]);
+			face.normal = Plane(face.vertex[0], face.vertex[1], face.vertex[2]).normal;
+			if (p_params.callback(p_params.userdata, &face)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 void GodotHeightMapShape3D::cull(const AABB &p_local_aabb, QueryCallback p_callback, void *p_userdata, bool p_invert_backface_collision) const {
-	if (heights.is_empty()) {
+	if (heights.is_empty() || bounds_levels.is_empty()) {
 		return;
 	}
 
@@ -1977,35 +1974,23 @@ void GodotHeightMapShape3D::cull(const AABB &p_local_aabb, QueryCallback p_callb
 		aabb_max[i]++;
 	}
 
-	int start_x = MAX(0, aabb_min[0]);
-	int end_x = MIN(width - 1, aabb_max[0]);
-	int start_z = MAX(0, aabb_min[2]);
-	int end_z = MIN(depth - 1, aabb_max[2]);
-
 	GodotFaceShape3D face;
 	face.backface_collision = !p_invert_backface_collision;
 	face.invert_backface_collision = p_invert_backface_collision;
 
-	for (int z = start_z; z < end_z; z++) {
-		for (int x = start_x; x < end_x; x++) {
-			// First triangle.
-			_get_point(x, z, face.vertex[0]);
-			_get_point(x + 1, z, face.vertex[1]);
-			_get_point(x, z + 1, face.vertex[2]);
-			face.normal = Plane(face.vertex[0], face.vertex[1], face.vertex[2]).normal;
-			if (p_callback(p_userdata, &face)) {
-				return;
-			}
+	_HeightmapCullParams params;
+	params.start_x = MAX(0, aabb_min[0]);
+	params.end_x = MIN(width - 1, aabb_max[0]);
+	params.start_z = MAX(0, aabb_min[2]);
+	params.end_z = MIN(depth - 1, aabb_max[2]);
+	// Cells entirely above or below the aabb are skipped, along with whole blocks of the pyramid.
+	params.min_y = p_local_aabb.position.y;
+	params.max_y = p_local_aabb.position.y + p_local_aabb.size.y;
+	params.callback = p_callback;
+	params.userdata = p_userdata;
+	params.face = &face;
 
-			// Second triangle.
-			face.vertex[0] = face.vertex[1];
-			_get_point(x + 1, z + 1, face.vertex[1]);
-			face.normal = Plane(face.vertex[0], face.vertex[1], face.vertex[2]).normal;
-			if (p_callback(p_userdata, &face)) {
-				return;
-			}
-		}
-	}
+	_cull_block(bounds_levels.size() - 1, 0, 0, params);
 }
 
 Vector3 GodotHeightMapShape3D::get_moment_of_inertia(real_t p_mass) const {
@@ -2019,60 +2004,39 @@ Vector3 GodotHeightMapShape3D::get_moment_of_inertia(real_t p_mass) const {
 }
 
 void GodotHeightMapShape3D::_build_accelerator() {
-	bounds_grid.clear();
-
-	bounds_grid_width = width / BOUNDS_CHUNK_SIZE;
-	bounds_grid_depth = depth / BOUNDS_CHUNK_SIZE;
-
-	if (width % BOUNDS_CHUNK_SIZE > 0) {
-		++bounds_grid_width; // In case terrain size isn't dividable by chunk size.
-	}
-
-	if (depth % BOUNDS_CHUNK_SIZE > 0) {
-		++bounds_grid_depth;
-	}
-
-	uint32_t bound_grid_size = (uint32_t)(bounds_grid_width * bounds_grid_depth);
+	bounds_pyramid.clear();
+	bounds_levels.clear();
 
-	if (bound_grid_size < 2) {
-		// Grid is empty or just one chunk.
+	const int cells_x = width - 1;
+	const int cells_z = depth - 1;
+	if (cells_x <= 0 || cells_z <= 0) {
 		return;
 	}
 
-	bounds_grid.resize(bound_grid_size);
+	BoundsLevel level;
+	level.width = (cells_x + BOUNDS_BLOCK_SIZE - 1) / BOUNDS_BLOCK_SIZE;
+	level.depth = (cells_z + BOUNDS_BLOCK_SIZE - 1) / BOUNDS_BLOCK_SIZE;
+	level.offset = 0;
+	bounds_levels.push_back(level);
+	bounds_pyramid.resize(level.width * level.depth);
 
-	// Compute min and max height for all chunks.
-	for (int cz = 0; cz < bounds_grid_depth; ++cz) {
-		int z0 = cz * BOUNDS_CHUNK_SIZE;
+	// Compute min and max height for all the blocks of cells.
+	for (int bz = 0; bz < level.depth; ++bz) {
+		int z0 = bz * BOUNDS_BLOCK_SIZE;
 
-		for (int cx = 0; cx < bounds_grid_width; ++cx) {
-			int x0 = cx * BOUNDS_CHUNK_SIZE;
+		for (int bx = 0; bx < level.width; ++bx) {
+			int x0 = bx * BOUNDS_BLOCK_SIZE;
 
 			Range r;
 
 			r.min = _get_height(x0, z0);
 			r.max = r.min;
 
-			// Compute min and max height for this chunk.
-			// We have to include one extra cell to account for neighbors.
-			// Here is why:
-			// Say we have a flat terrain, and a plateau that fits a chunk perfectly.
-			//
-			//   Left        Right
-			// 0---0---0---1---1---1
-			// |   |   |   |   |   |
-			// 0---0---0---1---1---1
-			// |   |   |   |   |   |
-			// 0---0---0---1---1---1
-			//           x
-			//
-			// If the AABB for the Left chunk did not share vertices with the Right,
-			// then we would fail collision tests at x due to a gap.
-			//
-			int z_max = MIN(z0 + BOUNDS_CHUNK_SIZE + 1, depth);
-			int x_max = MIN(x0 + BOUNDS_CHUNK_SIZE + 1, width);
-			for (int z = z0; z < z_max; ++z) {
-				for (int x = x0; x < x_max; ++x) {
+			// The cells of the block include the vertices on its far edges, which are shared with the next blocks.
+			int z_max = MIN(z0 + BOUNDS_BLOCK_SIZE, cells_z);
+			int x_max = MIN(x0 + BOUNDS_BLOCK_SIZE, cells_x);
+			for (int z = z0; z <= z_max; ++z) {
+				for (int x = x0; x <= x_max; ++x) {
 					real_t height = _get_height(x, z);
 					if (height < r.min) {
 						r.min = height;
@@ -2082,9 +2046,37 @@ void GodotHeightMapShape3D::_build_accelerator() {
 				}
 			}
 
-			bounds_grid[cx + cz * bounds_grid_width] = r;
+			bounds_pyramid[bx + bz * level.width] = r;
 		}
 	}
+
+	// Merge 2 x 2 blocks into the next level, until a single block covers the whole heightmap.
+	while (level.width > 1 || level.depth > 1) {
+		const int prev_level = bounds_levels.size() - 1;
+
+		BoundsLevel next;
+		next.width = (level.width + 1) / 2;
+		next.depth = (level.depth + 1) / 2;
+		next.offset = bounds_pyramid.size();
+		bounds_pyramid.resize(next.offset + next.width * next.depth);
+
+		for (int bz = 0; bz < next.depth; ++bz) {
+			for (int bx = 0; bx < next.width; ++bx) {
+				Range r = _get_bounds_block(prev_level, bx * 2, bz * 2);
+				for (int cz = bz * 2; cz < MIN(bz * 2 + 2, level.depth); ++cz) {
+					for (int cx = bx * 2; cx < MIN(bx * 2 + 2, level.width); ++cx) {
+						const Range &child = _get_bounds_block(prev_level, cx, cz);
+						r.min = MIN(r.min, child.min);
+						r.max = MAX(r.max, child.max);
+					}
+				}
+				bounds_pyramid[next.offset + bx + bz * next.width] = r;
+			}
+		}
+
+		bounds_levels.push_back(next);
+		level = next;
+	}
 }
 
 void GodotHeightMapShape3D::_setup(const Vector<real_t> &p_heights, int p_width, int p_depth, real_t p_min_height, real_t p_max_height) {
@@ -314,18 +314,31 @@ struct GodotConcavePolygonShape3D : public GodotConcaveShape3D {
 	Vector<Face> faces;
 	Vector<Vector3> vertices;
 
+	// Nodes are stored depth first, so the left child of a branch always follows it.
+	// Bounds are quantized to 16 bits inside the shape AABB, which packs 4 nodes per cache line.
 	struct BVH {
-		AABB aabb;
-		int left = 0;
-		int right = 0;
-
-		int face_index = 0;
+		uint16_t min[3] = {};
+		uint16_t max[3] = {};
+		// The face of a leaf, or minus the index of the right child of a branch.
+		int32_t index = 0;
 	};
 
 	Vector<BVH> bvh;
+	Vector3 bvh_origin;
+	Vector3 bvh_scale;
+	Vector3 bvh_inv_scale;
+
+	void _quantize_aabb(const AABB &p_aabb, uint16_t *r_min, uint16_t *r_max) const;
+
+	_FORCE_INLINE_ AABB _get_bvh_aabb(const BVH &p_node) const {
+		const Vector3 min(p_node.min[0], p_node.min[1], p_node.min[2]);
+		const Vector3 max(p_node.max[0], p_node.max[1], p_node.max[2]);
+		return AABB(bvh_origin + min * bvh_inv_scale, (max - min) * bvh_inv_scale);
+	}
 
 	struct _CullParams {
-		AABB aabb;
+		uint16_t min[3] = {};
+		uint16_t max[3] = {};
 		QueryCallback callback = nullptr;
 		void *userdata = nullptr;
 		const Face *faces = nullptr;
@@ -380,25 +393,35 @@ public:
 	GodotConcavePolygonShape3D();
 };
 
+struct _HeightmapSegmentCullParams;
+struct _HeightmapCullParams;
+
 struct GodotHeightMapShape3D : public GodotConcaveShape3D {
 	Vector<real_t> heights;
 	int width = 0;
 	int depth = 0;
 	Vector3 local_origin;
 
-	// Accelerator.
+	// Accelerator, a pyramid of min and max heights.
+	// Level 0 has the range of each block of BOUNDS_BLOCK_SIZE x BOUNDS_BLOCK_SIZE cells,
+	// each next level merges 2 x 2 blocks of the previous one, up to a single block.
 	struct Range {
 		real_t min = 0.0;
 		real_t max = 0.0;
 	};
-	LocalVector<Range> bounds_grid;
-	int bounds_grid_width = 0;
-	int bounds_grid_depth = 0;
+	struct BoundsLevel {
+		int width = 0;
+		int depth = 0;
+		uint32_t offset = 0;
+	};
+	LocalVector<Range> bounds_pyramid;
+	LocalVector<BoundsLevel> bounds_levels;
 
-	static const int BOUNDS_CHUNK_SIZE = 16;
+	static const int BOUNDS_BLOCK_SIZE = 4;
 
-	_FORCE_INLINE_ const Range &_get_bounds_chunk(int p_x, int p_z) const {
-		return bounds_grid[(p_z * bounds_grid_width) + p_x];
+	_FORCE_INLINE_ const Range &_get_bounds_block(int p_level, int p_x, int p_z) const {
+		const BoundsLevel &level = bounds_levels[p_level];
+		return bounds_pyramid[level.offset + (p_z * level.width) + p_x];
 	}
 
 	_FORCE_INLINE_ real_t _get_height(int p_x, int p_z) const {
@@ -411,12 +434,21 @@ struct GodotHeightMapShape3D : public GodotConcaveShape3D {
 		r_point.z = p_z - 0.5 * (depth - 1.0);
 	}
 
+	_FORCE_INLINE_ void _get_cell_range(int p_x, int p_z, Range &r_range) const {
+		const real_t h0 = _get_height(p_x, p_z);
+		const real_t h1 = _get_height(p_x + 1, p_z);
+		const real_t h2 = _get_height(p_x, p_z + 1);
+		const real_t h3 = _get_height(p_x + 1, p_z + 1);
+		r_range.min = MIN(MIN(h0, h1), MIN(h2, h3));
+		r_range.max = MAX(MAX(h0, h1), MAX(h2, h3));
+	}
+
 	void _get_cell(const Vector3 &p_point, int &r_x, int &r_y, int &r_z) const;
 
 	void _build_accelerator();
 
-	template <typename ProcessFunction>
-	bool _intersect_grid_segment(ProcessFunction &p_process, const Vector3 &p_begin, const Vector3 &p_end, int p_width, int p_depth, const Vector3 &offset, Vector3 &r_point, Vector3 &r_normal) const;
+	void _cull_segment_block(int p_level, int p_x, int p_z, _HeightmapSegmentCullParams &p_params) const;
+	bool _cull_block(int p_level, int p_x, int p_z, _HeightmapCullParams &p_params) const;
 
 	void _setup(const Vector<real_t> &p_heights, int p_width, int p_depth, real_t p_min_height, real_t p_max_height);
 
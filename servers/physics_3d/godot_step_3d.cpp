@@ -116,6 +116,24 @@ void GodotStep3D::_setup_contraint(uint32_t p_constraint_index, void *p_userdata
 	constraint->setup(delta);
 }
 
+void GodotStep3D::_solve_batch_block(uint32_t p_block_index, void *p_userdata) {
+	const BatchBlock &block = batch_blocks[p_block_index];
+	const LocalVector<GodotConstraint3D *> &constraints = batched_constraints[block.kind];
+	uint32_t count = MIN(constraints.size() - block.from, (uint32_t)SAT_BATCH_SIZE);
+
+	SATBatchPair pairs[SAT_BATCH_SIZE];
+	bool separated[SAT_BATCH_SIZE];
+	for (uint32_t i = 0; i < count; i++) {
+		constraints[block.from + i]->get_batch_pair(pairs[i]);
+	}
+
+	sat_batch_test_separation(block.kind, pairs, count, separated);
+
+	for (uint32_t i = 0; i < count; i++) {
+		constraints[block.from + i]->finish_batch_setup(separated[i]);
+	}
+}
+
 void GodotStep3D::_pre_solve_island(LocalVector<GodotConstraint3D *> &p_constraint_island) const {
 	uint32_t constraint_count = p_constraint_island.size();
 	uint32_t valid_constraint_count = 0;
@@ -346,6 +364,31 @@ void GodotStep3D::step(GodotSpace3D *p_space, real_t p_delta) {
 	WorkerThreadPool::GroupID group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &GodotStep3D::_setup_contraint, nullptr, total_contraint_count, -1, true, SNAME("Physics3DConstraintSetup"));
 	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
 
+	// Pairs of primitive shapes left by setup are grouped by kind and tested for separation in blocks.
+	for (int kind = 0; kind < SAT_BATCH_MAX; kind++) {
+		batched_constraints[kind].clear();
+	}
+	for (uint32_t constraint_index = 0; constraint_index < total_contraint_count; ++constraint_index) {
+		GodotConstraint3D *constraint = all_constraints[constraint_index];
+		SATBatchKind kind = constraint->get_batch_kind();
+		if (kind != SAT_BATCH_NONE) {
+			batched_constraints[kind].push_back(constraint);
+		}
+	}
+	batch_blocks.clear();
+	for (int kind = 0; kind < SAT_BATCH_MAX; kind++) {
+		for (uint32_t from = 0; from < batched_constraints[kind].size(); from += SAT_BATCH_SIZE) {
+			BatchBlock block;
+			block.kind = SATBatchKind(kind);
+			block.from = from;
+			batch_blocks.push_back(block);
+		}
+	}
+	if (!batch_blocks.is_empty()) {
+		group_task = WorkerThreadPool::get_singleton()->add_template_group_task(this, &GodotStep3D::_solve_batch_block, nullptr, batch_blocks.size(), -1, true, SNAME("Physics3DBatchedNarrowphase"));
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_task);
+	}
+
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
 		p_space->set_elapsed_time(GodotSpace3D::ELAPSED_TIME_SETUP_CONSTRAINTS, profile_endtime - profile_begtime);
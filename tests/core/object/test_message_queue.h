@@ -0,0 +1,198 @@
+/*************************************************************************/
+/*  tests/core/object/test_message_queue.h                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_MESSAGE_QUEUE_H
+#define TEST_MESSAGE_QUEUE_H
+
+#include "core/object/message_queue.h"
+#include "core/object/object.h"
+#include "core/os/thread.h"
+
+#include "tests/test_macros.h"
+
+namespace TestMessageQueue {
+
+class Receiver : public Object {
+public:
+	Vector<int> calls;
+	MessageQueue *queue = nullptr;
+
+	void record(int p_value) {
+		calls.push_back(p_value);
+	}
+
+	void record_and_push(int p_value) {
+		calls.push_back(p_value);
+		queue->push_callable(callable_mp(this, &Receiver::record), p_value + 1);
+	}
+};
+
+struct ThreadPush {
+	MessageQueue *queue = nullptr;
+	Receiver *receiver = nullptr;
+	int first = 0;
+	int count = 0;
+};
+
+static void push_from_thread(void *p_userdata) {
+	ThreadPush *push = (ThreadPush *)p_userdata;
+	for (int i = 0; i < push->count; i++) {
+		push->queue->push_callable(callable_mp(push->receiver, &Receiver::record), push->first + i);
+	}
+}
+
+TEST_CASE("[MessageQueue] Messages of all threads are flushed in the order they were pushed") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver *receiver = memnew(Receiver);
+
+	queue->push_callable(callable_mp(receiver, &Receiver::record), 0);
+
+	ThreadPush push;
+	push.queue = queue;
+	push.receiver = receiver;
+	push.first = 1;
+	push.count = 1;
+	Thread thread;
+	thread.start(push_from_thread, &push);
+	thread.wait_to_finish();
+
+	queue->push_callable(callable_mp(receiver, &Receiver::record), 2);
+	queue->flush();
+
+	REQUIRE(receiver->calls.size() == 3);
+	CHECK(receiver->calls[0] == 0);
+	CHECK(receiver->calls[1] == 1);
+	CHECK(receiver->calls[2] == 2);
+
+	memdelete(receiver);
+	memdelete(queue);
+}
+
+TEST_CASE("[MessageQueue] Messages pushed by several threads at the same time") {
+	const int thread_count = 4;
+	const int message_count = 5000;
+
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver *receivers[thread_count];
+	ThreadPush pushes[thread_count];
+	Thread threads[thread_count];
+
+	for (int i = 0; i < thread_count; i++) {
+		receivers[i] = memnew(Receiver);
+		pushes[i].queue = queue;
+		pushes[i].receiver = receivers[i];
+		pushes[i].count = message_count;
+		threads[i].start(push_from_thread, &pushes[i]);
+	}
+	for (int i = 0; i < thread_count; i++) {
+		threads[i].wait_to_finish();
+	}
+
+	// More messages than fit in a single page.
+	CHECK(queue->get_max_buffer_usage() == 0);
+	queue->flush();
+	CHECK(queue->get_max_buffer_usage() > 64 * 1024);
+
+	for (int i = 0; i < thread_count; i++) {
+		REQUIRE(receivers[i]->calls.size() == message_count);
+		bool in_order = true;
+		for (int j = 0; j < message_count; j++) {
+			in_order = in_order && receivers[i]->calls[j] == j;
+		}
+		CHECK_MESSAGE(in_order, "The messages of each thread should be flushed in the order they were pushed.");
+		memdelete(receivers[i]);
+	}
+
+	memdelete(queue);
+}
+
+TEST_CASE("[MessageQueue] Messages of threads that ended are flushed") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver *receiver = memnew(Receiver);
+
+	// The buffers of the ended threads are deleted by the flushes, once their messages are taken.
+	for (int round = 0; round < 3; round++) {
+		for (int i = 0; i < 8; i++) {
+			ThreadPush push;
+			push.queue = queue;
+			push.receiver = receiver;
+			push.first = round * 8 + i;
+			push.count = 1;
+			Thread thread;
+			thread.start(push_from_thread, &push);
+			thread.wait_to_finish();
+		}
+		queue->flush();
+	}
+
+	REQUIRE(receiver->calls.size() == 24);
+	bool in_order = true;
+	for (int i = 0; i < 24; i++) {
+		in_order = in_order && receiver->calls[i] == i;
+	}
+	CHECK(in_order);
+
+	memdelete(receiver);
+	memdelete(queue);
+}
+
+TEST_CASE("[MessageQueue] Messages pushed while flushing are flushed too") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver *receiver = memnew(Receiver);
+	receiver->queue = queue;
+
+	queue->push_callable(callable_mp(receiver, &Receiver::record_and_push), 0);
+	queue->push_callable(callable_mp(receiver, &Receiver::record), 10);
+	queue->flush();
+
+	REQUIRE(receiver->calls.size() == 3);
+	CHECK(receiver->calls[0] == 0);
+	CHECK(receiver->calls[1] == 10);
+	CHECK(receiver->calls[2] == 1);
+	CHECK_FALSE(queue->is_flushing());
+
+	memdelete(receiver);
+	memdelete(queue);
+}
+
+TEST_CASE("[MessageQueue] Pending messages are freed with the queue") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver *receiver = memnew(Receiver);
+
+	queue->push_callable(callable_mp(receiver, &Receiver::record), 0);
+	memdelete(queue);
+
+	CHECK(receiver->calls.is_empty());
+	memdelete(receiver);
+}
+
+} // namespace TestMessageQueue
+
+#endif // TEST_MESSAGE_QUEUE_H
@@ -35,6 +35,7 @@
 #include "core/object/class_db.h"
 #include "core/object/object.h"
 #include "core/object/script_language.h"
+#include "core/os/os.h"
 
 #include "tests/test_macros.h"
 
@@ -109,6 +110,24 @@ public:
 	}
 };
 
+class _SignalReceiver : public Object {
+public:
+	int calls = 0;
+	int last_value = 0;
+	Object *emitter = nullptr;
+	_SignalReceiver *disconnect_target = nullptr;
+
+	void on_changed(int p_value) {
+		calls++;
+		last_value = p_value;
+	}
+
+	void on_changed_disconnect(int p_value) {
+		calls++;
+		emitter->disconnect("changed", callable_mp(disconnect_target, &_SignalReceiver::on_changed));
+	}
+};
+
 TEST_CASE("[Object] Core getters") {
 	Object object;
 
@@ -281,6 +300,78 @@ TEST_CASE("[Object] Absent name getter") {
 			actual_value == Variant(),
 			"The returned value should equal nil variant.");
 }
+
+TEST_CASE("[Object] Signal emission") {
+	Object emitter;
+	emitter.add_user_signal(MethodInfo("changed", PropertyInfo(Variant::INT, "value")));
+	const StringName changed = "changed";
+
+	_SignalReceiver receivers[3];
+	for (int i = 0; i < 3; i++) {
+		emitter.connect(changed, callable_mp(&receivers[i], &_SignalReceiver::on_changed));
+	}
+
+	SUBCASE("All the connections are called") {
+		CHECK(emitter.emit_signal(changed, 7) == OK);
+		for (int i = 0; i < 3; i++) {
+			CHECK(receivers[i].calls == 1);
+			CHECK(receivers[i].last_value == 7);
+		}
+	}
+
+#ifdef DEBUG_ENABLED
+	SUBCASE("Emitting doesn't allocate memory") {
+		emitter.emit_signal(changed, 0);
+		const uint64_t mem_usage = Memory::get_mem_usage();
+		for (int i = 0; i < 100; i++) {
+			emitter.emit_signal(changed, i);
+		}
+		CHECK_MESSAGE(Memory::get_mem_usage() == mem_usage, "The connections shouldn't be copied on each emission.");
+		CHECK(receivers[0].calls == 101);
+	}
+#endif
+
+	SUBCASE("Connections removed while emitting are still called by that emission") {
+		_SignalReceiver disconnecter;
+		disconnecter.emitter = &emitter;
+		disconnecter.disconnect_target = &receivers[1];
+		emitter.connect(changed, callable_mp(&disconnecter, &_SignalReceiver::on_changed_disconnect));
+
+		emitter.emit_signal(changed, 1);
+		emitter.emit_signal(changed, 2);
+		CHECK(disconnecter.calls == 2);
+		CHECK(receivers[0].calls == 2);
+		CHECK(receivers[1].calls == 1);
+		CHECK(receivers[1].last_value == 1);
+		CHECK(receivers[2].calls == 2);
+	}
+}
+
+TEST_CASE("[Object][Benchmark] Emitting a signal to native listeners" * doctest::skip()) {
+	const StringName changed = "changed";
+	const int listener_counts[] = { 1, 10, 100 };
+	const int emissions = 100000;
+
+	for (int count : listener_counts) {
+		Object emitter;
+		emitter.add_user_signal(MethodInfo("changed", PropertyInfo(Variant::INT, "value")));
+		LocalVector<_SignalReceiver> receivers;
+		receivers.resize(count);
+		for (int i = 0; i < count; i++) {
+			emitter.connect(changed, callable_mp(&receivers[i], &_SignalReceiver::on_changed));
+		}
+
+		const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < emissions; i++) {
+			emitter.emit_signal(changed, i);
+		}
+		const uint64_t usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+		print_line(vformat("%d listeners: %.1f ns per emission, %.1f ns per call.", count, usec * 1000.0 / emissions, usec * 1000.0 / emissions / count));
+		CHECK(receivers[0].calls == emissions);
+	}
+}
+
 } // namespace TestObject
 
 #endif // TEST_OBJECT_H
@@ -0,0 +1,192 @@
+/*************************************************************************/
+/*  tests/core/os/test_memory.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_MEMORY_H
+#define TEST_MEMORY_H
+
+#include "core/os/memory.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/string/ustring.h"
+
+#include "tests/test_macros.h"
+
+namespace TestMemory {
+
+static void fill(uint8_t *p_mem, size_t p_size, uint8_t p_seed) {
+	for (size_t i = 0; i < p_size; i++) {
+		p_mem[i] = uint8_t(i * 7 + p_seed);
+	}
+}
+
+static bool check_fill(const uint8_t *p_mem, size_t p_size, uint8_t p_seed) {
+	for (size_t i = 0; i < p_size; i++) {
+		if (p_mem[i] != uint8_t(i * 7 + p_seed)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("[Memory] Padded reallocations keep the data and padding") {
+	const size_t sizes[] = { 20, 24, 100, 1000, 5000, 700, 10 };
+
+	uint8_t *mem = (uint8_t *)Memory::alloc_static(8, true);
+	REQUIRE(mem);
+	fill(mem - 8, 16, 3);
+	size_t size = 8;
+
+	for (size_t new_size : sizes) {
+		mem = (uint8_t *)Memory::realloc_static(mem, new_size, true);
+		REQUIRE(mem);
+		// CowData keeps its reference count and size in the padding.
+		CHECK(check_fill(mem - 8, 8 + MIN(size, new_size), 3));
+		fill(mem - 8, 8 + new_size, 3);
+		size = new_size;
+	}
+
+	Memory::free_static(mem, true);
+}
+
+TEST_CASE("[Memory] Reallocating to zero bytes frees the block") {
+	const uint64_t alloc_count = Memory::get_alloc_count();
+
+	// Small enough to be pooled, too large to be, and without padding.
+	void *small = Memory::alloc_static(16, true);
+	void *large = Memory::alloc_static(1024 * 1024, true);
+	void *unpadded = Memory::alloc_static(64, false);
+	REQUIRE(small);
+	REQUIRE(large);
+	REQUIRE(unpadded);
+	CHECK(Memory::get_alloc_count() == alloc_count + 3);
+
+	CHECK(Memory::realloc_static(small, 0, true) == nullptr);
+	CHECK(Memory::realloc_static(large, 0, true) == nullptr);
+	CHECK(Memory::realloc_static(unpadded, 0, false) == nullptr);
+	CHECK(Memory::get_alloc_count() == alloc_count);
+}
+
+TEST_CASE("[Memory] Small padded blocks are reused") {
+	const uint64_t alloc_count = Memory::get_alloc_count();
+
+	void *mem = Memory::alloc_static(40, true);
+	CHECK(Memory::get_alloc_count() == alloc_count + 1);
+	Memory::free_static(mem, true);
+	CHECK(Memory::get_alloc_count() == alloc_count);
+
+#if MEMORY_POOL_MAX_SIZE >= 48
+	// A block of the same size class is taken from the pool of this thread.
+	void *reused = Memory::alloc_static(48, true);
+	CHECK(reused == mem);
+	Memory::free_static(reused, true);
+#endif
+}
+
+struct ThreadAllocations {
+	LocalVector<uint8_t *> blocks;
+	int count = 0;
+};
+
+static void allocate_blocks(void *p_userdata) {
+	ThreadAllocations *allocations = (ThreadAllocations *)p_userdata;
+	for (int i = 0; i < allocations->count; i++) {
+		const size_t size = 1 + (i * 37) % 1500;
+		uint8_t *mem = (uint8_t *)Memory::alloc_static(size, true);
+		fill(mem, size, uint8_t(i));
+		allocations->blocks.push_back(mem);
+	}
+}
+
+TEST_CASE("[Memory] Padded blocks freed on another thread") {
+	const int count = 5000;
+	for (int round = 0; round < 2; round++) {
+		ThreadAllocations allocations;
+		allocations.count = count;
+		Thread thread;
+		thread.start(allocate_blocks, &allocations);
+		thread.wait_to_finish();
+
+		REQUIRE(allocations.blocks.size() == count);
+		bool valid = true;
+		for (int i = 0; i < count; i++) {
+			valid = valid && check_fill(allocations.blocks[i], 1 + (i * 37) % 1500, uint8_t(i));
+			Memory::free_static(allocations.blocks[i], true);
+		}
+		CHECK_MESSAGE(valid, "The blocks of the thread should not overlap.");
+	}
+}
+
+#if MEMORY_POOL_MAX_SIZE >= 1024
+static void allocate_and_free_blocks(void *p_userdata) {
+	uint8_t *blocks[8];
+	for (int i = 0; i < 8; i++) {
+		blocks[i] = (uint8_t *)Memory::alloc_static(1000, true);
+	}
+	for (int i = 0; i < 8; i++) {
+		Memory::free_static(blocks[i], true);
+	}
+}
+
+TEST_CASE("[Memory] Threads give their pooled blocks back when they end") {
+	// Without it, every new thread would take another slab.
+	Thread first;
+	first.start(allocate_and_free_blocks, nullptr);
+	first.wait_to_finish();
+	const uint64_t pooled = Memory::get_mem_pooled();
+
+	for (int i = 0; i < 16; i++) {
+		Thread thread;
+		thread.start(allocate_and_free_blocks, nullptr);
+		thread.wait_to_finish();
+	}
+	CHECK(Memory::get_mem_pooled() == pooled);
+}
+#endif
+
+TEST_CASE("[Memory][Benchmark] Building short strings" * doctest::skip()) {
+	const int iterations = 1000000;
+
+	const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	int length = 0;
+	for (int i = 0; i < iterations; i++) {
+		String s = "node_";
+		s += itos(i);
+		s += "/child";
+		length += s.length();
+	}
+	const uint64_t usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	print_line(vformat("%.1f ns per string, %d bytes pooled.", usec * 1000.0 / iterations, Memory::get_mem_pooled()));
+	CHECK(length > 0);
+}
+
+} // namespace TestMemory
+
+#endif // TEST_MEMORY_H
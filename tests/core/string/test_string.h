@@ -31,7 +31,9 @@
 #ifndef TEST_STRING_H
 #define TEST_STRING_H
 
+#include "core/os/os.h"
 #include "core/string/ustring.h"
+#include "core/variant/dictionary.h"
 
 #include "tests/test_macros.h"
 
@@ -1723,6 +1725,71 @@ TEST_CASE("[String] Variant ptr indexed set") {
 	CHECK_EQ(s, String("azcd"));
 }
 
+TEST_CASE("[String] Case conversion of mixed text") {
+	const String mixed = String::utf8("Éclair ÀLA Mode, 42 Ω!");
+	CHECK(mixed.to_lower() == String::utf8("éclair àla mode, 42 ω!"));
+	CHECK(mixed.to_upper() == String::utf8("ÉCLAIR ÀLA MODE, 42 Ω!"));
+
+	// Unchanged strings share their data.
+	const String lower = "already lower 123";
+	CHECK(lower.to_lower().ptr() == lower.ptr());
+	CHECK(String().to_upper().is_empty());
+}
+
+TEST_CASE("[String] Replace all occurrences") {
+	const String s = "a-b--c-";
+	CHECK(s.replace("-", "+") == "a+b++c+");
+	CHECK(s.replace("-", "") == "abc");
+	CHECK(s.replace("--", "<->") == "a-b<->c-");
+	CHECK(s.replace("x", "y") == s);
+	CHECK(String("---").replace("-", "").is_empty());
+	CHECK(String("aaa").replace("a", "aa") == "aaaaaa");
+}
+
+TEST_CASE("[String][Benchmark] Common string operations" * doctest::skip()) {
+	const int iterations = 100000;
+	const String path = "res://assets/characters/player/Textures/Player_Albedo.png";
+	const String text = "The {name} has {count} items in the {place}.";
+	Dictionary values;
+	values["name"] = "player";
+	values["count"] = 42;
+	values["place"] = "inventory";
+
+	Dictionary lookup;
+	Vector<String> keys;
+	for (int i = 0; i < 1000; i++) {
+		keys.push_back(path.get_base_dir().path_join(itos(i) + ".tres"));
+		lookup[keys[i]] = i;
+	}
+
+	int result = 0;
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		result += text.format(values, "{_}").length();
+	}
+	print_line(vformat("format: %.1f ns.", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / iterations));
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		result += path.split("/").size();
+	}
+	print_line(vformat("split: %.1f ns.", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / iterations));
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		result += path.to_lower().length();
+	}
+	print_line(vformat("to_lower: %.1f ns.", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / iterations));
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		result += int(lookup[keys[i % keys.size()]]);
+	}
+	print_line(vformat("Dictionary lookup: %.1f ns.", (OS::get_singleton()->get_ticks_usec() - begin) * 1000.0 / iterations));
+
+	CHECK(result > 0);
+}
+
 TEST_CASE("[Stress][String] Empty via ' == String()'") {
 	for (int i = 0; i < 100000; ++i) {
 		String str = "Hello World!";
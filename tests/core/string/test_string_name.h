@@ -0,0 +1,131 @@
+/*************************************************************************/
+/*  test_string_name.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_STRING_NAME_H
+#define TEST_STRING_NAME_H
+
+#include "core/object/worker_thread_pool.h"
+#include "core/string/string_name.h"
+
+#include "tests/test_macros.h"
+
+namespace TestStringName {
+
+TEST_CASE("[StringName] Interning") {
+	const StringName from_cstr = StringName("test_string_name");
+	const StringName from_string = StringName(String("test_string_name"));
+	const StringName from_static = SNAME("test_string_name");
+
+	CHECK(from_cstr == from_string);
+	CHECK(from_cstr == from_static);
+	CHECK(from_cstr.data_unique_pointer() == from_static.data_unique_pointer());
+	CHECK(from_cstr != StringName("test_string_name_2"));
+
+	CHECK(from_static == "test_string_name");
+	CHECK(from_static == String("test_string_name"));
+	CHECK(from_static != String("test_string_name_2"));
+	CHECK(from_cstr == "test_string_name");
+	CHECK(from_cstr == String("test_string_name"));
+
+	CHECK(StringName::search("test_string_name") == from_cstr);
+	CHECK(StringName::search(String("test_string_name")) == from_cstr);
+	CHECK(StringName::search(U"test_string_name") == from_cstr);
+	CHECK(StringName::search("test_string_name_never_interned") == StringName());
+}
+
+struct StringNameThreadTestData {
+	static const int NAME_COUNT = 64;
+	String names[NAME_COUNT];
+	const void *pointers[NAME_COUNT] = {};
+	SafeNumeric<uint32_t> errors;
+	int iterations = 0;
+
+	void process(uint32_t p_index, void *p_userdata) {
+		for (int i = 0; i < iterations; i++) {
+			int name_idx = (p_index * 7 + i) % NAME_COUNT;
+			StringName sn = names[name_idx];
+			if (sn != names[name_idx]) {
+				errors.increment();
+			}
+			if (pointers[name_idx] && sn.data_unique_pointer() != pointers[name_idx]) {
+				errors.increment();
+			}
+		}
+	}
+};
+
+TEST_CASE("[StringName] Creation and destruction from many threads") {
+	StringNameThreadTestData data;
+	data.iterations = 1000;
+	LocalVector<StringName> kept;
+	for (int i = 0; i < StringNameThreadTestData::NAME_COUNT; i++) {
+		data.names[i] = "test_string_name_thread_" + itos(i);
+		if (i % 2) {
+			// Keep half of them alive so they must resolve to the same data from every thread,
+			// the rest are created and freed concurrently.
+			kept.push_back(StringName(data.names[i]));
+			data.pointers[i] = kept[kept.size() - 1].data_unique_pointer();
+		}
+	}
+
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_template_group_task(&data, &StringNameThreadTestData::process, nullptr, 256, -1, true);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+
+	CHECK(data.errors.get() == 0);
+	for (int i = 0; i < StringNameThreadTestData::NAME_COUNT; i++) {
+		if (i % 2 == 0) {
+			CHECK(StringName::search(data.names[i]) == StringName());
+		}
+	}
+}
+
+// Not run by default, use `--test --test-case="*Benchmark*" --no-skip` to run.
+TEST_CASE("[StringName][Benchmark] Contention when interning from many threads" * doctest::skip()) {
+	StringNameThreadTestData data;
+	data.iterations = 10000;
+	for (int i = 0; i < StringNameThreadTestData::NAME_COUNT; i++) {
+		data.names[i] = "test_string_name_benchmark_" + itos(i);
+	}
+
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	const int elements = 1024;
+	for (int threads = 1; threads <= pool->get_thread_count(); threads++) {
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		WorkerThreadPool::GroupID group = pool->add_template_group_task(&data, &StringNameThreadTestData::process, nullptr, elements, threads, true);
+		pool->wait_for_group_task_completion(group);
+		uint64_t elapsed = MAX(OS::get_singleton()->get_ticks_usec() - begin, 1u);
+		print_line(vformat("StringName create/destroy with %d threads: %d per second.", threads, uint64_t(elements) * data.iterations * 1000000 / elapsed));
+	}
+	CHECK(data.errors.get() == 0);
+}
+
+} // namespace TestStringName
+
+#endif // TEST_STRING_NAME_H
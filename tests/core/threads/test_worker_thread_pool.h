@@ -153,6 +153,159 @@ TEST_CASE("[WorkerThreadPool] Process 256 elements on native task group low prio
 	CHECK(callable_group_counter.get() == count - 1);
 }
 
+static void static_nested_test(void *p_arg) {
+	SafeNumeric<uint32_t> *counter = (SafeNumeric<uint32_t> *)p_arg;
+	const int count = 64;
+	WorkerThreadPool::TaskID tasks[count];
+	// Posted from a worker thread, these go to its local queue and are either run here or stolen.
+	for (int i = 0; i < count; i++) {
+		tasks[i] = WorkerThreadPool::get_singleton()->add_native_task(static_test, counter, true);
+	}
+	for (int i = 0; i < count; i++) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(tasks[i]);
+	}
+}
+
+TEST_CASE("[WorkerThreadPool] Process tasks posted from within tasks") {
+	const int count = 16;
+	SafeNumeric<uint32_t> counter;
+	WorkerThreadPool::TaskID tasks[count];
+	for (int i = 0; i < count; i++) {
+		tasks[i] = WorkerThreadPool::get_singleton()->add_native_task(static_nested_test, &counter, true);
+	}
+	for (int i = 0; i < count; i++) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(tasks[i]);
+	}
+
+	CHECK(counter.get() == count * 64);
+}
+
+static void static_group_count_test(void *p_arg, uint32_t p_index) {
+	SafeNumeric<uint32_t> *counter = (SafeNumeric<uint32_t> *)p_arg;
+	counter->increment();
+}
+
+TEST_CASE("[WorkerThreadPool] Process every element of a large native task group exactly once") {
+	const int count = 100000;
+	SafeNumeric<uint32_t> counter;
+	WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_native_group_task(static_group_count_test, &counter, count, -1, true);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+	CHECK(counter.get() == count);
+}
+
+struct DependencyTestData {
+	SafeNumeric<uint32_t> first_stage;
+	SafeNumeric<uint32_t> second_stage;
+	SafeNumeric<uint32_t> errors;
+};
+
+static void static_first_stage_test(void *p_arg, uint32_t p_index) {
+	DependencyTestData *data = (DependencyTestData *)p_arg;
+	data->first_stage.increment();
+}
+
+static void static_second_stage_test(void *p_arg, uint32_t p_index) {
+	DependencyTestData *data = (DependencyTestData *)p_arg;
+	if (data->first_stage.get() != 256) {
+		data->errors.increment();
+	}
+	data->second_stage.increment();
+}
+
+static void static_last_stage_test(void *p_arg) {
+	DependencyTestData *data = (DependencyTestData *)p_arg;
+	if (data->second_stage.get() != 256) {
+		data->errors.increment();
+	}
+}
+
+TEST_CASE("[WorkerThreadPool] Dependent tasks and groups run after their dependencies") {
+	DependencyTestData data;
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+
+	Vector<WorkerThreadPool::TaskID> first_dependencies;
+	first_dependencies.push_back(pool->add_native_group_task(static_first_stage_test, &data, 256, -1, true));
+	WorkerThreadPool::GroupID second = pool->add_dependent_native_group_task(static_second_stage_test, &data, 256, first_dependencies, -1, true);
+
+	Vector<WorkerThreadPool::TaskID> last_dependencies;
+	last_dependencies.push_back(second);
+	last_dependencies.push_back(first_dependencies[0]);
+	WorkerThreadPool::TaskID last = pool->add_dependent_native_task(static_last_stage_test, &data, last_dependencies, true);
+
+	pool->wait_for_task_completion(last);
+	CHECK(pool->is_group_task_completed(first_dependencies[0]));
+	CHECK(pool->is_group_task_completed(second));
+	pool->wait_for_group_task_completion(second);
+	pool->wait_for_group_task_completion(first_dependencies[0]);
+
+	CHECK(data.first_stage.get() == 256);
+	CHECK(data.second_stage.get() == 256);
+	CHECK(data.errors.get() == 0);
+}
+
+TEST_CASE("[WorkerThreadPool] Dependent low priority task runs after its dependencies") {
+	SafeNumeric<uint32_t> counter;
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+
+	Vector<WorkerThreadPool::TaskID> dependencies;
+	for (int i = 0; i < 16; i++) {
+		dependencies.push_back(pool->add_native_task(static_test, &counter, false));
+	}
+	WorkerThreadPool::TaskID last = pool->add_dependent_native_task(static_test, &counter, dependencies, false);
+	pool->wait_for_task_completion(last);
+	CHECK(counter.get() == 17);
+
+	for (int i = 0; i < dependencies.size(); i++) {
+		pool->wait_for_task_completion(dependencies[i]);
+	}
+}
+
+static void static_empty_test(void *p_arg) {
+}
+
+static void static_empty_group_test(void *p_arg, uint32_t p_index) {
+}
+
+// Not run by default, use `--test --test-case="*Benchmark*" --no-skip` to run.
+TEST_CASE("[WorkerThreadPool][Benchmark] Throughput of tiny tasks" * doctest::skip()) {
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+
+	const int task_count = 100000;
+	LocalVector<WorkerThreadPool::TaskID> tasks;
+	tasks.resize(task_count);
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < task_count; i++) {
+		tasks[i] = pool->add_native_task(static_empty_test, nullptr, true);
+	}
+	for (int i = 0; i < task_count; i++) {
+		pool->wait_for_task_completion(tasks[i]);
+	}
+	uint64_t elapsed = MAX(OS::get_singleton()->get_ticks_usec() - begin, 1u);
+	print_line(vformat("Tasks posted from main thread: %d tasks/s.", uint64_t(task_count) * 1000000 / elapsed));
+
+	SafeNumeric<uint32_t> counter;
+	const int nested_count = task_count / 64;
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < nested_count; i++) {
+		tasks[i] = pool->add_native_task(static_nested_test, &counter, true);
+	}
+	for (int i = 0; i < nested_count; i++) {
+		pool->wait_for_task_completion(tasks[i]);
+	}
+	elapsed = MAX(OS::get_singleton()->get_ticks_usec() - begin, 1u);
+	print_line(vformat("Tasks posted from worker threads: %d tasks/s.", uint64_t(nested_count) * 65 * 1000000 / elapsed));
+
+	const int element_count = 10000000;
+	for (int threads = 1; threads <= pool->get_thread_count(); threads++) {
+		begin = OS::get_singleton()->get_ticks_usec();
+		WorkerThreadPool::GroupID group = pool->add_native_group_task(static_empty_group_test, nullptr, element_count, threads, true);
+		pool->wait_for_group_task_completion(group);
+		elapsed = MAX(OS::get_singleton()->get_ticks_usec() - begin, 1u);
+		print_line(vformat("Group elements with %d threads: %d elements/s.", threads, uint64_t(element_count) * 1000000 / elapsed));
+	}
+}
+
 } // namespace TestWorkerThreadPool
 
 #endif // TEST_WORKER_THREAD_POOL_H
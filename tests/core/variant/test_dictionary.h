@@ -31,6 +31,7 @@
 #ifndef TEST_DICTIONARY_H
 #define TEST_DICTIONARY_H
 
+#include "core/os/os.h"
 #include "core/variant/dictionary.h"
 #include "tests/test_macros.h"
 
@@ -518,6 +519,107 @@ TEST_CASE("[Dictionary] Order and find") {
 	CHECK_EQ(d.find_key("does not exist"), Variant());
 }
 
+TEST_CASE("[Dictionary] Values stay in place while the dictionary grows") {
+	Dictionary d;
+	d[0] = 0;
+	const Variant *first = d.getptr(0);
+	for (int i = 1; i < 1000; i++) {
+		d[i] = d[i - 1];
+	}
+	CHECK(d.getptr(0) == first);
+	CHECK(int(d[999]) == 0);
+	CHECK(d.size() == 1000);
+}
+
+TEST_CASE("[Dictionary] Values stay in place when other keys are erased") {
+	Dictionary d;
+	for (int i = 0; i < 100; i++) {
+		d[i] = i;
+	}
+	for (int i = 0; i < 100; i++) {
+		CHECK(int(d.get_key_at_index(i)) == i);
+	}
+
+	const Variant *last = d.getptr(99);
+	for (int i = 0; i < 99; i++) {
+		d.erase(i);
+	}
+	CHECK(d.getptr(99) == last);
+	CHECK(int(*last) == 99);
+	CHECK(d.size() == 1);
+}
+
+TEST_CASE("[Dictionary] Order after erasing") {
+	Dictionary d;
+	for (int i = 0; i < 100; i++) {
+		d[i] = i * 10;
+	}
+	for (int i = 0; i < 100; i += 2) {
+		CHECK(d.erase(i));
+	}
+	CHECK_FALSE(d.erase(0));
+	CHECK(d.size() == 50);
+	CHECK(int(d.get_key_at_index(0)) == 1);
+	CHECK(int(d.get_value_at_index(49)) == 990);
+
+	// Erasing most of the entries compacts the storage on the next insertion.
+	for (int i = 1; i < 90; i += 2) {
+		d.erase(i);
+	}
+	d["last"] = true;
+	for (int i = 0; i < 100; i++) {
+		d[i] = i;
+	}
+
+	Array keys = d.keys();
+	REQUIRE(keys.size() == 101);
+	bool in_order = true;
+	const int expected_first[] = { 91, 93, 95, 97, 99 };
+	for (int i = 0; i < 5; i++) {
+		in_order = in_order && int(keys[i]) == expected_first[i];
+	}
+	in_order = in_order && keys[5] == Variant("last");
+	CHECK_MESSAGE(in_order, "The remaining keys should keep their order.");
+	CHECK(int(keys[6]) == 0);
+	CHECK(int(keys[100]) == 98);
+
+	int count = 0;
+	for (const Variant *key = d.next(); key; key = d.next(key)) {
+		CHECK(d.has(*key));
+		count++;
+	}
+	CHECK(count == 101);
+
+	d.clear();
+	CHECK(d.is_empty());
+	CHECK(d.next() == nullptr);
+	d["again"] = 1;
+	CHECK(d.keys() == build_array("again"));
+}
+
+TEST_CASE("[Dictionary][Benchmark] Building small dictionaries" * doctest::skip()) {
+	const int iterations = 1000000;
+	const StringName keys[] = { "id", "name", "position", "health", "items" };
+
+	int total = 0;
+	const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < iterations; i++) {
+		Dictionary d;
+		d[keys[0]] = i;
+		d[keys[1]] = "player";
+		d[keys[2]] = Vector2(i, i);
+		d[keys[3]] = 100;
+		d[keys[4]] = Array();
+		for (const Variant *key = d.next(); key; key = d.next(key)) {
+			total += d[*key].get_type();
+		}
+	}
+	const uint64_t usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	print_line(vformat("%.1f ns per dictionary.", usec * 1000.0 / iterations));
+	CHECK(total > 0);
+}
+
 } // namespace TestDictionary
 
 #endif // TEST_DICTIONARY_H
@@ -0,0 +1,743 @@
+/*************************************************************************/
+/*  test_navigation_server_3d.h                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_NAVIGATION_SERVER_3D_H
+#define TEST_NAVIGATION_SERVER_3D_H
+
+#include "core/config/engine.h"
+#include "core/math/face3.h"
+#include "core/math/random_pcg.h"
+#include "core/object/callable_method_pointer.h"
+#include "core/os/os.h"
+#include "scene/3d/collision_shape_3d.h"
+#include "scene/3d/physics_body_3d.h"
+#include "scene/main/window.h"
+#include "scene/resources/box_shape_3d.h"
+#include "scene/resources/navigation_mesh.h"
+#include "servers/navigation_server_3d.h"
+#include "tests/test_macros.h"
+
+namespace TestNavigationServer3D {
+
+// A flat grid of unit quads with bumps, so closest points are not trivially straight below.
+static Ref<NavigationMesh> create_grid_navmesh(int p_side, real_t p_bump_height = 0.1) {
+	Ref<NavigationMesh> navmesh;
+	navmesh.instantiate();
+
+	Vector<Vector3> vertices;
+	for (int z = 0; z <= p_side; z++) {
+		for (int x = 0; x <= p_side; x++) {
+			vertices.push_back(Vector3(x, ((x * 7 + z * 13) % 5) * p_bump_height, z));
+		}
+	}
+	navmesh->set_vertices(vertices);
+
+	for (int z = 0; z < p_side; z++) {
+		for (int x = 0; x < p_side; x++) {
+			const int v = z * (p_side + 1) + x;
+			Vector<int> polygon;
+			polygon.push_back(v);
+			polygon.push_back(v + p_side + 1);
+			polygon.push_back(v + p_side + 2);
+			polygon.push_back(v + 1);
+			navmesh->add_polygon(polygon);
+		}
+	}
+	return navmesh;
+}
+
+static real_t brute_force_closest_distance(Ref<NavigationMesh> p_navmesh, const Vector3 &p_point) {
+	const Vector<Vector3> vertices = p_navmesh->get_vertices();
+	real_t closest = 1e20;
+	for (int i = 0; i < p_navmesh->get_polygon_count(); i++) {
+		const Vector<int> polygon = p_navmesh->get_polygon(i);
+		for (int j = 2; j < polygon.size(); j++) {
+			const Face3 face(vertices[polygon[0]], vertices[polygon[j - 1]], vertices[polygon[j]]);
+			closest = MIN(closest, face.get_closest_point_to(p_point).distance_to(p_point));
+		}
+	}
+	return closest;
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Map queries find the closest polygons") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	Ref<NavigationMesh> navmesh = create_grid_navmesh(24);
+	RID map = server->map_create();
+	server->map_set_active(map, true);
+	RID region = server->region_create();
+	server->region_set_map(region, map);
+	server->region_set_navmesh(region, navmesh);
+	server->process(0.0);
+
+	RandomPCG rng(42);
+	for (int i = 0; i < 200; i++) {
+		const Vector3 point(rng.random(-5.0, 29.0), rng.random(-3.0, 3.0), rng.random(-5.0, 29.0));
+		const Vector3 closest = server->map_get_closest_point(map, point);
+		CHECK(closest.distance_to(point) == doctest::Approx(brute_force_closest_distance(navmesh, point)));
+		CHECK(server->map_get_closest_point_owner(map, point) == region);
+	}
+
+	// A segment crossing the mesh should report the crossing closest to its start.
+	const Vector3 crossing = server->map_get_closest_point_to_segment(map, Vector3(10.5, 5, 10.5), Vector3(10.5, -5, 10.5), true);
+	CHECK(crossing.x == doctest::Approx(10.5));
+	CHECK(crossing.z == doctest::Approx(10.5));
+
+	// A segment above and past the mesh should snap to the closest edge.
+	const Vector3 edge_point = server->map_get_closest_point_to_segment(map, Vector3(30, 0, 5), Vector3(30, 0, 8));
+	CHECK(edge_point.x == doctest::Approx(24));
+
+	const Vector<Vector3> path = server->map_get_path(map, Vector3(0.5, 2, 0.5), Vector3(23.5, 2, 23.5), true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[0].x == doctest::Approx(0.5));
+	CHECK(path[path.size() - 1].z == doctest::Approx(23.5));
+
+	// Only polygons on the requested layers are used to start a path.
+	CHECK(server->map_get_path(map, Vector3(0.5, 2, 0.5), Vector3(23.5, 2, 23.5), true, 2).is_empty());
+
+	server->free(region);
+	server->free(map);
+	server->process(0.0);
+}
+
+static Array *async_paths = nullptr;
+static int async_path_callbacks = 0;
+
+static void store_async_paths(const Array &p_paths) {
+	*async_paths = p_paths;
+	async_path_callbacks++;
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Asynchronous path queries match synchronous ones") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	Ref<NavigationMesh> navmesh = create_grid_navmesh(24);
+	RID map = server->map_create();
+	server->map_set_active(map, true);
+	RID region = server->region_create();
+	server->region_set_map(region, map);
+	server->region_set_navmesh(region, navmesh);
+	server->process(0.0);
+
+	Vector<Vector3> origins;
+	Vector<Vector3> destinations;
+	Vector<int32_t> navigation_layers;
+	RandomPCG rng(3);
+	for (int i = 0; i < 100; i++) {
+		origins.push_back(Vector3(rng.random(0.0, 24.0), 1, rng.random(0.0, 24.0)));
+		destinations.push_back(Vector3(rng.random(0.0, 24.0), 1, rng.random(0.0, 24.0)));
+		// Every tenth query uses a layer no region is on.
+		navigation_layers.push_back(i % 10 ? 1 : 2);
+	}
+
+	Array paths;
+	async_paths = &paths;
+	async_path_callbacks = 0;
+	server->map_get_paths_async(map, origins, destinations, navigation_layers, true, callable_mp_static(store_async_paths));
+
+	// The queries run after the next map update, and the results arrive on the process after it.
+	server->process(0.0);
+	CHECK(async_path_callbacks == 0);
+	server->process(0.0);
+	REQUIRE(async_path_callbacks == 1);
+	REQUIRE(paths.size() == origins.size());
+
+	bool all_match = true;
+	for (int i = 0; i < origins.size(); i++) {
+		const Vector<Vector3> path = server->map_get_path(map, origins[i], destinations[i], true, navigation_layers[i]);
+		all_match = all_match && PackedVector3Array(paths[i]) == path;
+	}
+	CHECK_MESSAGE(all_match, "Each path should be the one map_get_path() returns.");
+	CHECK(PackedVector3Array(paths[0]).is_empty());
+	CHECK_FALSE(PackedVector3Array(paths[1]).is_empty());
+
+	async_paths = nullptr;
+	server->free(region);
+	server->free(map);
+	server->process(0.0);
+}
+
+// Creates a map made of p_tiles * p_tiles regions of p_tile_side * p_tile_side quads each.
+static RID create_tiled_map(NavigationServer3D *p_server, Ref<NavigationMesh> p_tile, int p_tiles, int p_tile_side, LocalVector<RID> &r_regions) {
+	RID map = p_server->map_create();
+	p_server->map_set_active(map, true);
+	for (int z = 0; z < p_tiles; z++) {
+		for (int x = 0; x < p_tiles; x++) {
+			RID region = p_server->region_create();
+			p_server->region_set_transform(region, Transform3D(Basis(), Vector3(x * p_tile_side, 0, z * p_tile_side)));
+			p_server->region_set_map(region, map);
+			p_server->region_set_navmesh(region, p_tile);
+			r_regions.push_back(region);
+		}
+	}
+	return map;
+}
+
+static real_t get_path_length(const Vector<Vector3> &p_path) {
+	real_t length = 0.0;
+	for (int i = 1; i < p_path.size(); i++) {
+		length += p_path[i - 1].distance_to(p_path[i]);
+	}
+	return length;
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Hierarchical paths across regions") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	const int tiles = 4;
+	const int tile_side = 8;
+	Ref<NavigationMesh> tile = create_grid_navmesh(tile_side, 0.0);
+	LocalVector<RID> regions;
+	RID flat_map = create_tiled_map(server, tile, tiles, tile_side, regions);
+	RID hierarchical_map = create_tiled_map(server, tile, tiles, tile_side, regions);
+	server->map_set_use_hierarchical_paths(hierarchical_map, true);
+	server->process(0.0);
+	CHECK(server->map_get_use_hierarchical_paths(hierarchical_map));
+	CHECK_FALSE(server->map_get_use_hierarchical_paths(flat_map));
+
+	const double size = tiles * tile_side;
+	RandomPCG rng(11);
+	for (int i = 0; i < 50; i++) {
+		const Vector3 from(rng.random(0.0, size), 0, rng.random(0.0, size));
+		const Vector3 to(rng.random(0.0, size), 0, rng.random(0.0, size));
+		const Vector<Vector3> flat_path = server->map_get_path(flat_map, from, to, true);
+		const Vector<Vector3> hierarchical_path = server->map_get_path(hierarchical_map, from, to, true);
+		REQUIRE(flat_path.size() >= 2);
+		REQUIRE(hierarchical_path.size() >= 2);
+		CHECK(hierarchical_path[0].is_equal_approx(flat_path[0]));
+		CHECK(hierarchical_path[hierarchical_path.size() - 1].is_equal_approx(flat_path[flat_path.size() - 1]));
+		CHECK(get_path_length(hierarchical_path) <= get_path_length(flat_path) * 1.25);
+	}
+
+	// Paths still have to respect the navigation layers of each region.
+	server->region_set_navigation_layers(regions[tiles * tiles + 1], 2);
+	server->process(0.0);
+	const Vector<Vector3> detour = server->map_get_path(hierarchical_map, Vector3(0.5, 0, 0.5), Vector3(size - 0.5, 0, 0.5), true);
+	REQUIRE(detour.size() >= 2);
+	CHECK(detour[detour.size() - 1].is_equal_approx(Vector3(size - 0.5, 0, 0.5)));
+
+	for (uint32_t i = 0; i < regions.size(); i++) {
+		server->free(regions[i]);
+	}
+	server->free(flat_map);
+	server->free(hierarchical_map);
+	server->process(0.0);
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Streaming regions only rebuilds what changed") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	const int tiles = 4;
+	const int tile_side = 8;
+	Ref<NavigationMesh> tile = create_grid_navmesh(tile_side, 0.0);
+	LocalVector<RID> regions;
+	RID map = create_tiled_map(server, tile, tiles, tile_side, regions);
+	server->map_set_edge_connection_margin(map, 0.5);
+	server->process(0.0);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_ACTIVE_MAPS) == 1);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_REGION_COUNT) == tiles * tiles);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_POLYGON_COUNT) == tiles * tiles * tile->get_polygon_count());
+	CHECK(server->get_process_info(NavigationServer3D::INFO_REBUILT_REGION_COUNT) == tiles * tiles);
+	// All the tile borders can connect to other tiles.
+	CHECK(server->get_process_info(NavigationServer3D::INFO_EDGE_FREE_COUNT) == tiles * tiles * tile_side * 4);
+
+	const double size = tiles * tile_side;
+	const Vector3 from(0.5, 0, 0.5);
+	const Vector3 to(size - 0.5, 0, size - 0.5);
+	const real_t length = get_path_length(server->map_get_path(map, from, to, true));
+
+	server->process(0.0);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_REBUILT_REGION_COUNT) == 0);
+
+	// Unload a tile on the way, the path goes around it.
+	const RID unloaded = regions[tiles + 1];
+	server->region_set_map(unloaded, RID());
+	server->process(0.0);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_REBUILT_REGION_COUNT) == 0);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_REGION_COUNT) == tiles * tiles - 1);
+	CHECK(server->map_get_closest_point_owner(map, Vector3(tile_side * 1.5, 0, tile_side * 1.5)) != unloaded);
+	Vector<Vector3> path = server->map_get_path(map, from, to, true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[path.size() - 1].is_equal_approx(to));
+
+	// Load it back, only that tile is rebuilt and stitched again.
+	server->region_set_map(unloaded, map);
+	server->process(0.0);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_REBUILT_REGION_COUNT) == 1);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_EDGE_FREE_COUNT) == tiles * tiles * tile_side * 4);
+	CHECK(server->map_get_closest_point_owner(map, Vector3(tile_side * 1.5, 0, tile_side * 1.5)) == unloaded);
+	CHECK(get_path_length(server->map_get_path(map, from, to, true)) == doctest::Approx(length));
+
+	// Tiles a bit apart, so their edges don't match, are connected within the edge connection margin
+	// and disconnected when moved away.
+	const RID moved = regions[tiles - 1];
+	const RID neighbor = regions[tiles - 2];
+	server->region_set_transform(moved, Transform3D(Basis(), Vector3((tiles - 1) * tile_side + 0.3, 0, 0)));
+	server->process(0.0);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_REBUILT_REGION_COUNT) == 1);
+	CHECK(server->region_get_connections_count(moved) > 0);
+	CHECK(server->region_get_connections_count(neighbor) > 0);
+	path = server->map_get_path(map, Vector3(0.5, 0, 0.5), Vector3(size - 0.4, 0, 0.5), true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[path.size() - 1].is_equal_approx(Vector3(size - 0.4, 0, 0.5)));
+
+	server->region_set_transform(moved, Transform3D(Basis(), Vector3(size + 1.0, 0, 0)));
+	server->process(0.0);
+	CHECK(server->region_get_connections_count(moved) == 0);
+	CHECK(server->region_get_connections_count(neighbor) == 0);
+
+	for (uint32_t i = 0; i < regions.size(); i++) {
+		server->free(regions[i]);
+	}
+	server->free(map);
+	server->process(0.0);
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Freeing a region of an inactive map") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	const int tiles = 3;
+	const int tile_side = 8;
+	Ref<NavigationMesh> tile = create_grid_navmesh(tile_side, 0.0);
+	LocalVector<RID> regions;
+	RID map = create_tiled_map(server, tile, tiles, tile_side, regions);
+	server->process(0.0);
+	server->map_set_active(map, false);
+	server->process(0.0);
+	CHECK(server->get_process_info(NavigationServer3D::INFO_ACTIVE_MAPS) == 0);
+
+	// The map is never synced again, but it must not keep the polygons of the freed region.
+	const RID freed = regions[tiles + 1];
+	const Vector3 center(tile_side * 1.5, 0, tile_side * 1.5);
+	CHECK(server->map_get_closest_point_owner(map, center) == freed);
+	server->free(freed);
+	regions.erase(freed);
+	server->process(0.0);
+	CHECK(server->map_get_closest_point_owner(map, center) != freed);
+	CHECK(server->map_get_closest_point(map, center).distance_to(center) > 0.5);
+
+	const double size = tiles * tile_side;
+	const Vector3 from(0.5, 0, 0.5);
+	const Vector3 to(size - 0.5, 0, size - 0.5);
+	const Vector<Vector3> path = server->map_get_path(map, from, to, true);
+	REQUIRE(path.size() >= 2);
+	CHECK(path[path.size() - 1].is_equal_approx(to));
+	for (int i = 0; i < path.size(); i++) {
+		CHECK_FALSE(Rect2(tile_side, tile_side, tile_side, tile_side).grow(-0.5).has_point(Vector2(path[i].x, path[i].z)));
+	}
+
+	for (uint32_t i = 0; i < regions.size(); i++) {
+		server->free(regions[i]);
+	}
+	server->free(map);
+	server->process(0.0);
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Tiled navigation mesh baking") {
+	Object *generator = Engine::get_singleton()->get_singleton_object("NavigationMeshGenerator");
+	REQUIRE(generator);
+
+	// A 16x16 floor centered on the origin, its top at height 0.
+	Node3D *root = memnew(Node3D);
+	StaticBody3D *floor = memnew(StaticBody3D);
+	CollisionShape3D *collision = memnew(CollisionShape3D);
+	Ref<BoxShape3D> box;
+	box.instantiate();
+	box->set_size(Vector3(16, 1, 16));
+	collision->set_shape(box);
+	collision->set_position(Vector3(0, -0.5, 0));
+	floor->add_child(collision);
+	root->add_child(floor);
+	SceneTree::get_singleton()->get_root()->add_child(root);
+
+	Ref<NavigationMesh> nav_mesh;
+	nav_mesh.instantiate();
+	nav_mesh->set_parsed_geometry_type(NavigationMesh::PARSED_GEOMETRY_STATIC_COLLIDERS);
+	nav_mesh->set_cell_size(0.25);
+
+	const real_t tile_size = 4.0;
+	Dictionary tiles = generator->call("bake_tiles", nav_mesh, root, tile_size);
+	CHECK(nav_mesh->get_polygon_count() == 0);
+	REQUIRE(tiles.size() >= 16);
+
+	int baked_tiles = 0;
+	Array keys = tiles.keys();
+	for (int i = 0; i < keys.size(); i++) {
+		const Vector2i coords = keys[i];
+		Ref<NavigationMesh> tile = tiles[coords];
+		REQUIRE(tile.is_valid());
+		if (tile->get_polygon_count() == 0) {
+			continue;
+		}
+		baked_tiles++;
+
+		// The polygons of a tile are clipped to its bounds.
+		const Vector<Vector3> vertices = tile->get_vertices();
+		for (int j = 0; j < vertices.size(); j++) {
+			CHECK(vertices[j].x >= coords.x * tile_size - CMP_EPSILON);
+			CHECK(vertices[j].x <= (coords.x + 1) * tile_size + CMP_EPSILON);
+			CHECK(vertices[j].z >= coords.y * tile_size - CMP_EPSILON);
+			CHECK(vertices[j].z <= (coords.y + 1) * tile_size + CMP_EPSILON);
+		}
+	}
+	// The floor is covered by the 4x4 tiles inside it, the border tiles are empty or thin.
+	CHECK(baked_tiles >= 16);
+
+	// Rebaking a single tile only returns that tile, with the same result.
+	Ref<NavigationMesh> full_tile = tiles[Vector2i(0, 0)];
+	REQUIRE(full_tile.is_valid());
+	CHECK(full_tile->get_polygon_count() > 0);
+
+	TypedArray<Vector2i> dirty;
+	dirty.push_back(Vector2i(0, 0));
+	Dictionary rebaked = generator->call("bake_tiles", nav_mesh, root, tile_size, dirty);
+	REQUIRE(rebaked.size() == 1);
+	Ref<NavigationMesh> rebaked_tile = rebaked[Vector2i(0, 0)];
+	REQUIRE(rebaked_tile.is_valid());
+	CHECK(rebaked_tile->get_polygon_count() == full_tile->get_polygon_count());
+	CHECK(rebaked_tile->get_vertices() == full_tile->get_vertices());
+
+	memdelete(root);
+}
+
+static Array *avoidance_agents = nullptr;
+static PackedVector3Array *avoidance_velocities = nullptr;
+static int avoidance_callbacks = 0;
+
+static void store_avoidance_velocities(const Array &p_agents, const PackedVector3Array &p_velocities) {
+	*avoidance_agents = p_agents;
+	*avoidance_velocities = p_velocities;
+	avoidance_callbacks++;
+}
+
+static RID create_agent(NavigationServer3D *p_server, RID p_map, const Vector3 &p_position, const Vector3 &p_target_velocity) {
+	RID agent = p_server->agent_create();
+	p_server->agent_set_map(agent, p_map);
+	p_server->agent_set_radius(agent, 0.5);
+	p_server->agent_set_neighbor_distance(agent, 10.0);
+	p_server->agent_set_max_neighbors(agent, 10);
+	p_server->agent_set_time_horizon(agent, 5.0);
+	p_server->agent_set_max_speed(agent, 2.0);
+	p_server->agent_set_position(agent, p_position);
+	p_server->agent_set_velocity(agent, p_target_velocity);
+	p_server->agent_set_target_velocity(agent, p_target_velocity);
+	return agent;
+}
+
+static Vector3 get_avoidance_velocity(RID p_agent) {
+	const int index = avoidance_agents->find(p_agent);
+	REQUIRE(index >= 0);
+	return (*avoidance_velocities)[index];
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Agent avoidance velocities are delivered in one batch") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	RID map = server->map_create();
+	server->map_set_active(map, true);
+
+	// Two agents walking into each other, and one far away.
+	RID left = create_agent(server, map, Vector3(-2, 0, 0), Vector3(1, 0, 0));
+	RID right = create_agent(server, map, Vector3(2, 0, 0), Vector3(-1, 0, 0));
+	RID far = create_agent(server, map, Vector3(100, 0, 0), Vector3(0, 0, 1));
+
+	Array agents;
+	PackedVector3Array velocities;
+	avoidance_agents = &agents;
+	avoidance_velocities = &velocities;
+	avoidance_callbacks = 0;
+	server->map_set_avoidance_callback(map, callable_mp_static(store_avoidance_velocities));
+
+	server->process(0.1);
+	REQUIRE(avoidance_callbacks == 1);
+	REQUIRE(agents.size() == 3);
+	REQUIRE(velocities.size() == 3);
+	CHECK_FALSE(get_avoidance_velocity(left).is_equal_approx(Vector3(1, 0, 0)));
+	CHECK_FALSE(get_avoidance_velocity(right).is_equal_approx(Vector3(-1, 0, 0)));
+	CHECK(get_avoidance_velocity(far).is_equal_approx(Vector3(0, 0, 1)));
+
+	// Moving the far agent next to the others makes it avoid them.
+	server->agent_set_position(far, Vector3(0, 0, -1.5));
+	server->process(0.1);
+	REQUIRE(avoidance_callbacks == 2);
+	CHECK_FALSE(get_avoidance_velocity(far).is_equal_approx(Vector3(0, 0, 1)));
+
+	// And moving it away again leaves it alone.
+	server->agent_set_position(far, Vector3(-100, 0, 50));
+	server->process(0.1);
+	REQUIRE(avoidance_callbacks == 3);
+	CHECK(get_avoidance_velocity(far).is_equal_approx(Vector3(0, 0, 1)));
+
+	server->map_set_avoidance_callback(map, Callable());
+	server->process(0.1);
+	CHECK(avoidance_callbacks == 3);
+
+	avoidance_agents = nullptr;
+	avoidance_velocities = nullptr;
+	server->free(left);
+	server->free(right);
+	server->free(far);
+	server->free(map);
+	server->process(0.0);
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D] Agents avoid neighbors much farther away than their radius") {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	RID map = server->map_create();
+	server->map_set_active(map, true);
+
+	// Small agents walking into each other from far apart, and one beyond their neighbor distance.
+	// Slightly off a head-on course, where avoidance has no side to pick.
+	RID left = create_agent(server, map, Vector3(-15, 0, 0), Vector3(1, 0, 0));
+	RID right = create_agent(server, map, Vector3(15, 0, 0.05), Vector3(-1, 0, 0));
+	RID far = create_agent(server, map, Vector3(0, 0, 60), Vector3(1, 0, 0));
+	for (const RID &agent : { left, right, far }) {
+		server->agent_set_radius(agent, 0.1);
+		server->agent_set_neighbor_distance(agent, 50.0);
+		server->agent_set_time_horizon(agent, 20.0);
+	}
+
+	Array agents;
+	PackedVector3Array velocities;
+	avoidance_agents = &agents;
+	avoidance_velocities = &velocities;
+	avoidance_callbacks = 0;
+	server->map_set_avoidance_callback(map, callable_mp_static(store_avoidance_velocities));
+
+	server->process(0.1);
+	REQUIRE(avoidance_callbacks == 1);
+	REQUIRE(agents.size() == 3);
+	CHECK_FALSE(get_avoidance_velocity(left).is_equal_approx(Vector3(1, 0, 0)));
+	CHECK(get_avoidance_velocity(left).x > 0.5);
+	CHECK_FALSE(get_avoidance_velocity(right).is_equal_approx(Vector3(-1, 0, 0)));
+	CHECK(get_avoidance_velocity(right).x < -0.5);
+	CHECK(get_avoidance_velocity(far).is_equal_approx(Vector3(1, 0, 0)));
+
+	server->map_set_avoidance_callback(map, Callable());
+	avoidance_agents = nullptr;
+	avoidance_velocities = nullptr;
+	server->free(left);
+	server->free(right);
+	server->free(far);
+	server->free(map);
+	server->process(0.0);
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D][Benchmark] Closest point and path queries against map size" * doctest::skip()) {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	const int sides[] = { 32, 128, 448 };
+	for (int side : sides) {
+		Ref<NavigationMesh> navmesh = create_grid_navmesh(side);
+		RID map = server->map_create();
+		server->map_set_active(map, true);
+		RID region = server->region_create();
+		server->region_set_map(region, map);
+		server->region_set_navmesh(region, navmesh);
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		server->process(0.0);
+		const uint64_t sync_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+		RandomPCG rng(side);
+		const int closest_point_queries = 10000;
+		Vector3 closest_point_sum;
+		begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < closest_point_queries; i++) {
+			closest_point_sum += server->map_get_closest_point(map, Vector3(rng.random(0.0, (double)side), 1.0, rng.random(0.0, (double)side)));
+		}
+		const uint64_t closest_point_usec = OS::get_singleton()->get_ticks_usec() - begin;
+		CHECK(closest_point_sum != Vector3());
+
+		// Short paths, so the time is dominated by finding the start and end polygons.
+		const int path_queries = 1000;
+		begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < path_queries; i++) {
+			const Vector3 from(rng.random(0.0, side - 2.0), 1.0, rng.random(0.0, side - 2.0));
+			server->map_get_path(map, from, from + Vector3(1.5, 0, 1.5), true);
+		}
+		const uint64_t path_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+		print_line(vformat("%d polygons: sync %.2f ms, %.0f closest point queries/s, %.0f short path queries/s.", side * side, sync_usec / 1000.0, closest_point_queries * 1000000.0 / MAX(closest_point_usec, (uint64_t)1), path_queries * 1000000.0 / MAX(path_usec, (uint64_t)1)));
+
+		server->free(region);
+		server->free(map);
+		server->process(0.0);
+	}
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D][Benchmark] Long paths across tiled regions" * doctest::skip()) {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	const int tiles = 16;
+	const int tile_side = 16;
+	Ref<NavigationMesh> tile = create_grid_navmesh(tile_side, 0.0);
+	LocalVector<RID> regions;
+	RID map = create_tiled_map(server, tile, tiles, tile_side, regions);
+	server->process(0.0);
+
+	const double size = tiles * tile_side;
+	const int path_queries = 50;
+	for (int hierarchical = 0; hierarchical < 2; hierarchical++) {
+		server->map_set_use_hierarchical_paths(map, hierarchical);
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		server->process(0.0);
+		const uint64_t sync_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+		RandomPCG rng(5);
+		real_t total_length = 0.0;
+		uint64_t max_usec = 0;
+		begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < path_queries; i++) {
+			// From one corner area to the opposite one.
+			const Vector3 from(rng.random(0.0, size * 0.1), 0, rng.random(0.0, size * 0.1));
+			const Vector3 to(size - rng.random(0.0, size * 0.1), 0, size - rng.random(0.0, size * 0.1));
+			const uint64_t path_begin = OS::get_singleton()->get_ticks_usec();
+			total_length += get_path_length(server->map_get_path(map, from, to, true));
+			max_usec = MAX(max_usec, OS::get_singleton()->get_ticks_usec() - path_begin);
+		}
+		const uint64_t path_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+		print_line(vformat("%s, %d polygons in %d regions: sync %.2f ms.", hierarchical ? "Hierarchical" : "Flat", tiles * tiles * tile_side * tile_side, tiles * tiles, sync_usec / 1000.0));
+		print_line(vformat("Average path %.2f ms, slowest %.2f ms, average length %.1f.", path_usec / 1000.0 / path_queries, max_usec / 1000.0, total_length / path_queries));
+	}
+
+	for (uint32_t i = 0; i < regions.size(); i++) {
+		server->free(regions[i]);
+	}
+	server->free(map);
+	server->process(0.0);
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D][Benchmark] Streaming one region into a tiled map" * doctest::skip()) {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	const int tile_side = 16;
+	Ref<NavigationMesh> tile = create_grid_navmesh(tile_side, 0.0);
+	const int tile_counts[] = { 8, 16, 32 };
+	for (int tiles : tile_counts) {
+		LocalVector<RID> regions;
+		RID map = create_tiled_map(server, tile, tiles, tile_side, regions);
+		server->process(0.0);
+		const int full_sync_usec = server->get_process_info(NavigationServer3D::INFO_SYNC_TIME_USEC);
+
+		const int reloads = 20;
+		uint64_t reload_usec = 0;
+		for (int i = 0; i < reloads; i++) {
+			const RID region = regions[(i * 7919) % regions.size()];
+			server->region_set_map(region, RID());
+			server->process(0.0);
+			reload_usec += server->get_process_info(NavigationServer3D::INFO_SYNC_TIME_USEC);
+			server->region_set_map(region, map);
+			server->process(0.0);
+			reload_usec += server->get_process_info(NavigationServer3D::INFO_SYNC_TIME_USEC);
+		}
+
+		print_line(vformat("%d polygons in %d regions: full sync %.2f ms, unload or load of one region %.3f ms.", tiles * tiles * tile->get_polygon_count(), tiles * tiles, full_sync_usec / 1000.0, reload_usec / 1000.0 / (reloads * 2)));
+
+		for (uint32_t i = 0; i < regions.size(); i++) {
+			server->free(regions[i]);
+		}
+		server->free(map);
+		server->process(0.0);
+	}
+}
+
+TEST_CASE("[SceneTree][NavigationServer3D][Benchmark] Avoidance step for a large crowd" * doctest::skip()) {
+	NavigationServer3D *server = NavigationServer3D::get_singleton_mut();
+	REQUIRE(server);
+
+	RID map = server->map_create();
+	server->map_set_active(map, true);
+
+	// About one agent every 4 square meters, all walking in random directions.
+	const int agent_count = 10000;
+	const double side = 200.0;
+	RandomPCG rng(7);
+	LocalVector<RID> agent_rids;
+	HashMap<RID, Vector3> agent_positions;
+	for (int i = 0; i < agent_count; i++) {
+		const Vector3 position(rng.random(0.0, side), 0, rng.random(0.0, side));
+		const Vector3 direction = Vector3(rng.random(-1.0, 1.0), 0, rng.random(-1.0, 1.0)).normalized();
+		agent_rids.push_back(create_agent(server, map, position, direction));
+		agent_positions.insert(agent_rids[i], position);
+	}
+
+	Array agents;
+	PackedVector3Array velocities;
+	avoidance_agents = &agents;
+	avoidance_velocities = &velocities;
+	avoidance_callbacks = 0;
+	server->map_set_avoidance_callback(map, callable_mp_static(store_avoidance_velocities));
+	server->process(0.0);
+
+	const int steps = 20;
+	const real_t delta = 0.1;
+	uint64_t total_usec = 0;
+	for (int step = 0; step < steps; step++) {
+		// Move the agents by their safe velocities, so they change cells over time.
+		for (int i = 0; i < agents.size(); i++) {
+			const RID agent = agents[i];
+			Vector3 &position = agent_positions[agent];
+			position += velocities[i] * delta;
+			server->agent_set_velocity(agent, velocities[i]);
+			server->agent_set_position(agent, position);
+		}
+		const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		server->process(delta);
+		total_usec += OS::get_singleton()->get_ticks_usec() - begin;
+	}
+	CHECK(avoidance_callbacks == steps + 1);
+
+	print_line(vformat("%d agents: %.2f ms per avoidance step.", agent_count, total_usec / 1000.0 / steps));
+
+	avoidance_agents = nullptr;
+	avoidance_velocities = nullptr;
+	for (uint32_t i = 0; i < agent_rids.size(); i++) {
+		server->free(agent_rids[i]);
+	}
+	server->free(map);
+	server->process(0.0);
+}
+
+} // namespace TestNavigationServer3D
+
+#endif // TEST_NAVIGATION_SERVER_3D_H
@@ -0,0 +1,98 @@
+/*************************************************************************/
+/*  tests/servers/test_physics_server_2d.h                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_PHYSICS_SERVER_2D_H
+#define TEST_PHYSICS_SERVER_2D_H
+
+#include "servers/physics_2d/godot_physics_server_2d.h"
+#include "tests/test_macros.h"
+
+namespace TestPhysicsServer2D {
+
+// Creates an active space without gravity nor damping, so bodies keep their velocities.
+static RID create_free_space(PhysicsServer2D *p_server) {
+	RID space = p_server->space_create();
+	p_server->space_set_active(space, true);
+	p_server->area_set_param(space, PhysicsServer2D::AREA_PARAM_GRAVITY, 0.0);
+	p_server->area_set_param(space, PhysicsServer2D::AREA_PARAM_LINEAR_DAMP, 0.0);
+	p_server->area_set_param(space, PhysicsServer2D::AREA_PARAM_ANGULAR_DAMP, 0.0);
+	return space;
+}
+
+TEST_CASE("[Physics2D] Step integrates body velocities") {
+	GodotPhysicsServer2D *server = memnew(GodotPhysicsServer2D);
+	server->init();
+	server->set_active(true);
+
+	RID space = create_free_space(server);
+	RID shape = server->circle_shape_create();
+	server->shape_set_data(shape, 1.0);
+
+	// Far apart, so they don't collide.
+	RID moving = server->body_create();
+	server->body_add_shape(moving, shape);
+	server->body_set_state(moving, PhysicsServer2D::BODY_STATE_TRANSFORM, Transform2D(0.0, Vector2(0, 0)));
+	server->body_set_state(moving, PhysicsServer2D::BODY_STATE_LINEAR_VELOCITY, Vector2(10, -5));
+	server->body_set_state(moving, PhysicsServer2D::BODY_STATE_ANGULAR_VELOCITY, 2.0);
+	server->body_set_space(moving, space);
+
+	// Spinning around a center of mass away from its origin.
+	RID spinning = server->body_create();
+	server->body_add_shape(spinning, shape);
+	server->body_set_param(spinning, PhysicsServer2D::BODY_PARAM_CENTER_OF_MASS, Vector2(1, 0));
+	server->body_set_state(spinning, PhysicsServer2D::BODY_STATE_TRANSFORM, Transform2D(0.0, Vector2(100, 0)));
+	server->body_set_state(spinning, PhysicsServer2D::BODY_STATE_ANGULAR_VELOCITY, 2.0);
+	server->body_set_space(spinning, space);
+
+	const real_t delta = 0.1;
+	server->step(delta);
+	server->flush_queries();
+
+	const Transform2D moving_xform = server->body_get_state(moving, PhysicsServer2D::BODY_STATE_TRANSFORM);
+	CHECK(moving_xform.get_origin().is_equal_approx(Vector2(1, -0.5)));
+	CHECK(moving_xform.get_rotation() == doctest::Approx(0.2));
+
+	const Transform2D spinning_xform = server->body_get_state(spinning, PhysicsServer2D::BODY_STATE_TRANSFORM);
+	CHECK(spinning_xform.get_origin().is_equal_approx(Vector2(100, 0) + Vector2(1, 0) - Vector2(1, 0).rotated(0.2)));
+	CHECK(spinning_xform.get_rotation() == doctest::Approx(0.2));
+	// The center of mass itself stays in place.
+	CHECK(spinning_xform.xform(Vector2(1, 0)).is_equal_approx(Vector2(101, 0)));
+
+	server->free(moving);
+	server->free(spinning);
+	server->free(shape);
+	server->free(space);
+	server->finish();
+	memdelete(server);
+}
+
+} // namespace TestPhysicsServer2D
+
+#endif // TEST_PHYSICS_SERVER_2D_H
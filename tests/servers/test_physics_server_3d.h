@@ -0,0 +1,738 @@
+/*************************************************************************/
+/*  test_physics_server_3d.h                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_PHYSICS_SERVER_3D_H
+#define TEST_PHYSICS_SERVER_3D_H
+
+#include "core/math/bvh.h"
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "servers/physics_3d/godot_collision_solver_3d_batch.h"
+#include "servers/physics_3d/godot_physics_server_3d.h"
+#include "tests/test_macros.h"
+
+namespace TestPhysicsServer3D {
+
+TEST_CASE("[Physics3D] Batched separation tests agree with the SAT solver") {
+	GodotSphereShape3D *sphere = memnew(GodotSphereShape3D);
+	sphere->set_data(0.5);
+	GodotBoxShape3D *box = memnew(GodotBoxShape3D);
+	box->set_data(Vector3(0.5, 0.25, 0.75));
+	GodotCapsuleShape3D *capsule = memnew(GodotCapsuleShape3D);
+	Dictionary capsule_data;
+	capsule_data["radius"] = 0.3;
+	capsule_data["height"] = 1.6;
+	capsule->set_data(capsule_data);
+
+	const GodotShape3D *shape_pairs[][2] = {
+		{ sphere, sphere },
+		{ sphere, box },
+		{ box, sphere },
+		{ capsule, sphere },
+		{ capsule, capsule },
+		{ box, box },
+	};
+
+	RandomPCG rng(42);
+	const int pair_count = 1000;
+	LocalVector<Transform3D> transforms;
+	transforms.resize(pair_count * 2);
+	LocalVector<SATBatchPair> pairs;
+	pairs.resize(pair_count);
+	bool separated[pair_count];
+
+	for (const GodotShape3D *const *shapes : shape_pairs) {
+		for (int i = 0; i < pair_count * 2; i++) {
+			Basis basis = Basis::from_euler(Vector3(rng.random(-Math_PI, Math_PI), rng.random(-Math_PI, Math_PI), rng.random(-Math_PI, Math_PI)));
+			transforms[i] = Transform3D(basis, Vector3(rng.random(-1.5f, 1.5f), rng.random(-1.5f, 1.5f), rng.random(-1.5f, 1.5f)));
+		}
+
+		SATBatchKind kind = sat_batch_get_kind(shapes[0], transforms[0], shapes[1], transforms[1]);
+		REQUIRE(kind != SAT_BATCH_NONE);
+		for (int i = 0; i < pair_count; i++) {
+			pairs[i].shape_A = shapes[0];
+			pairs[i].transform_A = &transforms[i * 2];
+			pairs[i].shape_B = shapes[1];
+			pairs[i].transform_B = &transforms[i * 2 + 1];
+		}
+
+		sat_batch_test_separation(kind, pairs.ptr(), pair_count, separated);
+
+		int separated_count = 0;
+		int wrongly_separated_count = 0;
+		for (int i = 0; i < pair_count; i++) {
+			if (!separated[i]) {
+				continue;
+			}
+			separated_count++;
+			if (GodotCollisionSolver3D::solve_static(shapes[0], transforms[i * 2], shapes[1], transforms[i * 2 + 1], nullptr, nullptr)) {
+				wrongly_separated_count++;
+			}
+		}
+
+		CHECK_MESSAGE(wrongly_separated_count == 0, "Pairs found colliding by the SAT solver should never be reported as separated.");
+		CHECK_MESSAGE(separated_count > 0, "Distant pairs should be reported as separated.");
+		CHECK_MESSAGE(separated_count < pair_count, "Overlapping pairs should not be reported as separated.");
+	}
+
+	CHECK_MESSAGE(sat_batch_get_kind(box, Transform3D().scaled(Vector3(2, 2, 2)), box, Transform3D()) == SAT_BATCH_NONE, "Scaled shapes should be left to the SAT solver.");
+	CHECK_MESSAGE(sat_batch_get_kind(box, Transform3D(), capsule, Transform3D()) == SAT_BATCH_NONE, "Box and capsule pairs have no batched test.");
+
+	memdelete(sphere);
+	memdelete(box);
+	memdelete(capsule);
+}
+
+template <class T>
+class PairAllTestFunction {
+public:
+	static bool user_pair_check(const T *p_a, const T *p_b) {
+		return true;
+	}
+};
+
+template <class T>
+class CullAllTestFunction {
+public:
+	static bool user_cull_check(const T *p_a, const T *p_b) {
+		return true;
+	}
+};
+
+typedef BVH_Manager<int, 2, true, 128, PairAllTestFunction<int>, CullAllTestFunction<int>> PairingBVH;
+
+static void *pairing_log_pair(void *p_self, uint32_t p_a, int *p_object_a, int p_subindex_a, uint32_t p_b, int *p_object_b, int p_subindex_b) {
+	static_cast<LocalVector<Vector3i> *>(p_self)->push_back(Vector3i(1, p_a, p_b));
+	return nullptr;
+}
+
+static void pairing_log_unpair(void *p_self, uint32_t p_a, int *p_object_a, int p_subindex_a, uint32_t p_b, int *p_object_b, int p_subindex_b, void *p_pair_data) {
+	static_cast<LocalVector<Vector3i> *>(p_self)->push_back(Vector3i(-1, p_a, p_b));
+}
+
+TEST_CASE("[Physics3D] Parallel BVH pairing reports the same pairs as serial pairing") {
+	PairingBVH serial;
+	PairingBVH parallel;
+	parallel.params_set_parallel_pairing_threshold(1);
+
+	LocalVector<Vector3i> serial_log;
+	LocalVector<Vector3i> parallel_log;
+	serial.set_pair_callback(pairing_log_pair, &serial_log);
+	serial.set_unpair_callback(pairing_log_unpair, &serial_log);
+	parallel.set_pair_callback(pairing_log_pair, &parallel_log);
+	parallel.set_unpair_callback(pairing_log_unpair, &parallel_log);
+
+	const int item_count = 500;
+	int objects[item_count];
+	LocalVector<Vector3> positions;
+	LocalVector<BVHHandle> serial_handles;
+	LocalVector<BVHHandle> parallel_handles;
+	RandomPCG rng(7);
+	for (int i = 0; i < item_count; i++) {
+		objects[i] = i;
+		positions.push_back(Vector3(rng.random(0, 20), rng.random(0, 20), rng.random(0, 20)));
+		const AABB aabb(positions[i], Vector3(1, 1, 1));
+		serial_handles.push_back(serial.create(&objects[i], true, 1, 3, aabb));
+		parallel_handles.push_back(parallel.create(&objects[i], true, 1, 3, aabb));
+	}
+	serial.update();
+	parallel.update();
+
+	for (int step = 0; step < 10; step++) {
+		for (int i = 0; i < item_count; i += 2) {
+			positions[i] += Vector3(rng.random(-1, 1), rng.random(-1, 1), rng.random(-1, 1));
+			const AABB aabb(positions[i], Vector3(1, 1, 1));
+			serial.move(serial_handles[i], aabb);
+			parallel.move(parallel_handles[i], aabb);
+		}
+		serial.update();
+		parallel.update();
+	}
+
+	CHECK_MESSAGE(serial_log.size() > 0, "The test items should have paired.");
+	REQUIRE(parallel_log.size() == serial_log.size());
+	bool same_order = true;
+	for (uint32_t i = 0; i < serial_log.size(); i++) {
+		same_order = same_order && serial_log[i] == parallel_log[i];
+	}
+	CHECK_MESSAGE(same_order, "Pair and unpair callbacks should arrive in the same order.");
+}
+
+// Creates columns of unit crates on a static floor. The floor comes first in r_bodies,
+// then the crates of each column from bottom to top.
+static RID create_crate_stacks(PhysicsServer3D *p_server, int p_columns, int p_height, LocalVector<RID> &r_bodies, LocalVector<RID> &r_shapes) {
+	RID space = p_server->space_create();
+	p_server->space_set_active(space, true);
+	p_server->area_set_param(space, PhysicsServer3D::AREA_PARAM_GRAVITY, 9.8);
+	p_server->area_set_param(space, PhysicsServer3D::AREA_PARAM_GRAVITY_VECTOR, Vector3(0, -1, 0));
+
+	RID floor_shape = p_server->box_shape_create();
+	p_server->shape_set_data(floor_shape, Vector3(100, 1, 100));
+	RID floor = p_server->body_create();
+	p_server->body_set_mode(floor, PhysicsServer3D::BODY_MODE_STATIC);
+	p_server->body_add_shape(floor, floor_shape);
+	p_server->body_set_state(floor, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(0, -1, 0)));
+	p_server->body_set_space(floor, space);
+	r_bodies.push_back(floor);
+	r_shapes.push_back(floor_shape);
+
+	RID crate_shape = p_server->box_shape_create();
+	p_server->shape_set_data(crate_shape, Vector3(0.5, 0.5, 0.5));
+	r_shapes.push_back(crate_shape);
+	for (int column = 0; column < p_columns; column++) {
+		for (int y = 0; y < p_height; y++) {
+			RID crate = p_server->body_create();
+			p_server->body_add_shape(crate, crate_shape);
+			// Crates don't sleep, so the stacks are solved on every step.
+			p_server->body_set_state(crate, PhysicsServer3D::BODY_STATE_CAN_SLEEP, false);
+			p_server->body_set_state(crate, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3((column % 10) * 3.0, 0.5 + y * 1.01, (column / 10) * 3.0)));
+			p_server->body_set_space(crate, space);
+			r_bodies.push_back(crate);
+		}
+	}
+	return space;
+}
+
+TEST_CASE("[Physics3D] Stacked crates stay stacked") {
+	GodotPhysicsServer3D *server = memnew(GodotPhysicsServer3D);
+	server->init();
+	server->set_active(true);
+
+	const int height = 6;
+	LocalVector<RID> bodies;
+	LocalVector<RID> shapes;
+	RID space = create_crate_stacks(server, 1, height, bodies, shapes);
+
+	const real_t delta = 1.0 / 60.0;
+	for (int i = 0; i < 300; i++) {
+		server->step(delta);
+		server->flush_queries();
+	}
+
+	// The crates rest on each other, upright and right above the first one.
+	for (int y = 0; y < height; y++) {
+		const Transform3D xform = server->body_get_state(bodies[1 + y], PhysicsServer3D::BODY_STATE_TRANSFORM);
+		CHECK(xform.origin.y == doctest::Approx(0.5 + y).epsilon(0.05));
+		CHECK(Vector2(xform.origin.x, xform.origin.z).length() < 0.05);
+		CHECK(xform.basis.get_column(1).y > 0.999);
+	}
+	const Vector3 top_velocity = server->body_get_state(bodies[height], PhysicsServer3D::BODY_STATE_LINEAR_VELOCITY);
+	CHECK(top_velocity.length() < 0.05);
+
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		server->free(bodies[i]);
+	}
+	for (uint32_t i = 0; i < shapes.size(); i++) {
+		server->free(shapes[i]);
+	}
+	server->free(space);
+	server->finish();
+	memdelete(server);
+}
+
+// Counts the culled faces overlapping an AABB.
+struct FaceCullCount {
+	AABB aabb;
+	int count = 0;
+};
+
+static bool count_culled_face(void *p_userdata, GodotShape3D *p_face) {
+	FaceCullCount *cull_count = (FaceCullCount *)p_userdata;
+	const GodotFaceShape3D *face = static_cast<GodotFaceShape3D *>(p_face);
+	if (Face3(face->vertex[0], face->vertex[1], face->vertex[2]).get_aabb().intersects(cull_count->aabb)) {
+		cull_count->count++;
+	}
+	return false;
+}
+
+// Finds the closest face hit by a segment by testing all the faces.
+static bool intersect_faces(const LocalVector<Face3> &p_faces, const Vector3 &p_from, const Vector3 &p_to, Vector3 &r_point) {
+	GodotFaceShape3D face;
+	const Vector3 dir = (p_to - p_from).normalized();
+	real_t min_d = 1e20;
+	for (uint32_t i = 0; i < p_faces.size(); i++) {
+		for (int j = 0; j < 3; j++) {
+			face.vertex[j] = p_faces[i].vertex[j];
+		}
+		face.normal = p_faces[i].get_plane().normal;
+		Vector3 point;
+		Vector3 normal;
+		if (face.intersect_segment(p_from, p_to, point, normal, true)) {
+			const real_t d = dir.dot(point - p_from);
+			if (d < min_d) {
+				min_d = d;
+				r_point = point;
+			}
+		}
+	}
+	return min_d < 1e20;
+}
+
+static int count_faces_in_aabb(const LocalVector<Face3> &p_faces, const AABB &p_aabb) {
+	int count = 0;
+	for (uint32_t i = 0; i < p_faces.size(); i++) {
+		if (p_faces[i].get_aabb().intersects(p_aabb)) {
+			count++;
+		}
+	}
+	return count;
+}
+
+TEST_CASE("[Physics3D] Concave polygon queries agree with a search of all the faces") {
+	// A bumpy grid, so the faces share their vertices.
+	RandomPCG rng(11);
+	const int side = 24;
+	LocalVector<real_t> grid_heights;
+	grid_heights.resize((side + 1) * (side + 1));
+	for (uint32_t i = 0; i < grid_heights.size(); i++) {
+		grid_heights[i] = rng.random(-2.0f, 2.0f);
+	}
+	LocalVector<Face3> faces;
+	Vector<Vector3> face_vertices;
+	for (int z = 0; z < side; z++) {
+		for (int x = 0; x < side; x++) {
+			const Vector3 v00(x, grid_heights[z * (side + 1) + x], z);
+			const Vector3 v10(x + 1, grid_heights[z * (side + 1) + x + 1], z);
+			const Vector3 v01(x, grid_heights[(z + 1) * (side + 1) + x], z + 1);
+			const Vector3 v11(x + 1, grid_heights[(z + 1) * (side + 1) + x + 1], z + 1);
+			faces.push_back(Face3(v00, v10, v01));
+			faces.push_back(Face3(v10, v11, v01));
+		}
+	}
+	for (uint32_t i = 0; i < faces.size(); i++) {
+		for (int j = 0; j < 3; j++) {
+			face_vertices.push_back(faces[i].vertex[j]);
+		}
+	}
+
+	GodotConcavePolygonShape3D *shape = memnew(GodotConcavePolygonShape3D);
+	Dictionary data;
+	data["faces"] = face_vertices;
+	data["backface_collision"] = false;
+	shape->set_data(data);
+
+	// Shared vertices are stored once.
+	CHECK(shape->vertices.size() == (side + 1) * (side + 1));
+	CHECK(shape->get_faces().size() == face_vertices.size());
+
+	for (int i = 0; i < 500; i++) {
+		const Vector3 from(rng.random(-2.0f, side + 2.0f), rng.random(-3.0f, 6.0f), rng.random(-2.0f, side + 2.0f));
+		const Vector3 to(rng.random(-2.0f, side + 2.0f), rng.random(-6.0f, 3.0f), rng.random(-2.0f, side + 2.0f));
+		Vector3 expected_point;
+		const bool expected_hit = intersect_faces(faces, from, to, expected_point);
+
+		Vector3 point;
+		Vector3 normal;
+		const bool hit = shape->intersect_segment(from, to, point, normal, true);
+		CHECK(hit == expected_hit);
+		if (hit && expected_hit) {
+			CHECK(point.is_equal_approx(expected_point));
+		}
+	}
+
+	for (int i = 0; i < 200; i++) {
+		FaceCullCount cull_count;
+		cull_count.aabb = AABB(Vector3(rng.random(-2.0f, side + 2.0f), rng.random(-3.0f, 3.0f), rng.random(-2.0f, side + 2.0f)), Vector3(rng.random(0.1f, 4.0f), rng.random(0.1f, 2.0f), rng.random(0.1f, 4.0f)));
+		shape->cull(cull_count.aabb, count_culled_face, &cull_count, false);
+		CHECK(cull_count.count == count_faces_in_aabb(faces, cull_count.aabb));
+	}
+
+	memdelete(shape);
+}
+
+TEST_CASE("[Physics3D] Height map queries agree with a search of all the cells") {
+	// Sizes which are not a multiple of the pyramid blocks.
+	const int width = 45;
+	const int depth = 38;
+	RandomPCG rng(5);
+	Vector<real_t> heights;
+	heights.resize(width * depth);
+	for (int z = 0; z < depth; z++) {
+		for (int x = 0; x < width; x++) {
+			// Gentle hills with some noise, and a flat area.
+			const real_t height = x < 10 ? 0.0 : Math::sin(x * 0.3) * 3.0 + Math::cos(z * 0.2) * 2.0 + rng.random(-0.3f, 0.3f);
+			heights.write[z * width + x] = height;
+		}
+	}
+
+	GodotHeightMapShape3D *shape = memnew(GodotHeightMapShape3D);
+	Dictionary data;
+	data["width"] = width;
+	data["depth"] = depth;
+	data["heights"] = heights;
+	data["min_height"] = -6.0;
+	data["max_height"] = 6.0;
+	shape->set_data(data);
+
+	LocalVector<Face3> faces;
+	for (int z = 0; z < depth - 1; z++) {
+		for (int x = 0; x < width - 1; x++) {
+			Vector3 v00, v10, v01, v11;
+			shape->_get_point(x, z, v00);
+			shape->_get_point(x + 1, z, v10);
+			shape->_get_point(x, z + 1, v01);
+			shape->_get_point(x + 1, z + 1, v11);
+			faces.push_back(Face3(v00, v10, v01));
+			faces.push_back(Face3(v10, v11, v01));
+		}
+	}
+
+	const real_t half_width = (width - 1) * 0.5;
+	const real_t half_depth = (depth - 1) * 0.5;
+	for (int i = 0; i < 500; i++) {
+		// Rays crossing several cells, from above the terrain, so back faces don't matter.
+		const Vector3 from(rng.random(-half_width - 2.0f, half_width + 2.0f), rng.random(6.5f, 10.0f), rng.random(-half_depth - 2.0f, half_depth + 2.0f));
+		const Vector3 to = from + Vector3(rng.random(-30.0f, 30.0f), rng.random(-16.0f, -2.0f), rng.random(-30.0f, 30.0f));
+		Vector3 expected_point;
+		const bool expected_hit = intersect_faces(faces, from, to, expected_point);
+
+		Vector3 point;
+		Vector3 normal;
+		const bool hit = shape->intersect_segment(from, to, point, normal, false);
+		CHECK(hit == expected_hit);
+		if (hit && expected_hit) {
+			CHECK(point.is_equal_approx(expected_point));
+		}
+	}
+
+	for (int i = 0; i < 200; i++) {
+		FaceCullCount cull_count;
+		cull_count.aabb = AABB(Vector3(rng.random(-half_width - 2.0f, half_width + 2.0f), rng.random(-6.0f, 6.0f), rng.random(-half_depth - 2.0f, half_depth + 2.0f)), Vector3(rng.random(0.1f, 6.0f), rng.random(0.1f, 2.0f), rng.random(0.1f, 6.0f)));
+		shape->cull(cull_count.aabb, count_culled_face, &cull_count, false);
+		CHECK(cull_count.count == count_faces_in_aabb(faces, cull_count.aabb));
+	}
+
+	memdelete(shape);
+}
+
+// Creates a static field of pillars of different heights on a floor, every shape in its own body.
+static RID create_pillar_field(PhysicsServer3D *p_server, int p_side, LocalVector<RID> &r_bodies, LocalVector<RID> &r_shapes) {
+	RID space = p_server->space_create();
+	p_server->space_set_active(space, true);
+
+	RID floor_shape = p_server->box_shape_create();
+	p_server->shape_set_data(floor_shape, Vector3(p_side * 2.0, 1, p_side * 2.0));
+	RID floor = p_server->body_create();
+	p_server->body_set_mode(floor, PhysicsServer3D::BODY_MODE_STATIC);
+	p_server->body_add_shape(floor, floor_shape);
+	p_server->body_set_state(floor, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(p_side, -1, p_side)));
+	p_server->body_set_space(floor, space);
+	r_bodies.push_back(floor);
+	r_shapes.push_back(floor_shape);
+
+	RID pillar_shape = p_server->box_shape_create();
+	p_server->shape_set_data(pillar_shape, Vector3(0.5, 2.0, 0.5));
+	r_shapes.push_back(pillar_shape);
+	for (int x = 0; x < p_side; x++) {
+		for (int z = 0; z < p_side; z++) {
+			RID pillar = p_server->body_create();
+			p_server->body_set_mode(pillar, PhysicsServer3D::BODY_MODE_STATIC);
+			p_server->body_add_shape(pillar, pillar_shape);
+			p_server->body_set_state(pillar, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(x * 2.0 + 1.0, ((x * 7 + z * 3) % 5) * 0.5, z * 2.0 + 1.0)));
+			p_server->body_set_space(pillar, space);
+			r_bodies.push_back(pillar);
+		}
+	}
+	return space;
+}
+
+TEST_CASE("[Physics3D] Batched queries agree with single queries") {
+	GodotPhysicsServer3D *server = memnew(GodotPhysicsServer3D);
+	server->init();
+	server->set_active(true);
+
+	const int side = 16;
+	LocalVector<RID> bodies;
+	LocalVector<RID> shapes;
+	RID space = create_pillar_field(server, side, bodies, shapes);
+	server->step(1.0 / 60.0);
+	server->flush_queries();
+
+	PhysicsDirectSpaceState3D *space_state = server->space_get_direct_state(space);
+	REQUIRE(space_state);
+
+	// Enough queries for the batches to be split between several workers.
+	RandomPCG rng(7);
+	const int count = 2000;
+	LocalVector<Vector3> from;
+	LocalVector<Vector3> to;
+	from.resize(count);
+	to.resize(count);
+	for (int i = 0; i < count; i++) {
+		from[i] = Vector3(rng.random(-2.0f, side * 2.0f + 2.0f), rng.random(0.0f, 6.0f), rng.random(-2.0f, side * 2.0f + 2.0f));
+		to[i] = from[i] + Vector3(rng.random(-8.0f, 8.0f), rng.random(-8.0f, 2.0f), rng.random(-8.0f, 8.0f));
+	}
+
+	SUBCASE("Rays") {
+		PhysicsDirectSpaceState3D::RayParameters parameters;
+		LocalVector<bool> hits;
+		LocalVector<PhysicsDirectSpaceState3D::RayResult> results;
+		hits.resize(count);
+		results.resize(count);
+		space_state->intersect_rays(parameters, from.ptr(), to.ptr(), count, hits.ptr(), results.ptr());
+
+		int hit_count = 0;
+		for (int i = 0; i < count; i++) {
+			parameters.from = from[i];
+			parameters.to = to[i];
+			PhysicsDirectSpaceState3D::RayResult result;
+			const bool hit = space_state->intersect_ray(parameters, result);
+			CHECK(hits[i] == hit);
+			if (hit && hits[i]) {
+				CHECK(results[i].rid == result.rid);
+				CHECK(results[i].shape == result.shape);
+				CHECK(results[i].position.is_equal_approx(result.position));
+				CHECK(results[i].normal.is_equal_approx(result.normal));
+				hit_count++;
+			}
+		}
+		// Most rays hit the floor or a pillar, but not all of them.
+		CHECK(hit_count > count / 2);
+		CHECK(hit_count < count);
+	}
+
+	SUBCASE("Motions") {
+		RID sphere = server->sphere_shape_create();
+		server->shape_set_data(sphere, 0.25);
+
+		PhysicsDirectSpaceState3D::ShapeParameters parameters;
+		parameters.shape_rid = sphere;
+		LocalVector<Vector3> motions;
+		LocalVector<real_t> closest_safe;
+		LocalVector<real_t> closest_unsafe;
+		motions.resize(count);
+		closest_safe.resize(count);
+		closest_unsafe.resize(count);
+		for (int i = 0; i < count; i++) {
+			motions[i] = to[i] - from[i];
+		}
+		space_state->cast_motions(parameters, from.ptr(), motions.ptr(), count, closest_safe.ptr(), closest_unsafe.ptr());
+
+		int blocked_count = 0;
+		for (int i = 0; i < count; i++) {
+			parameters.transform.origin = from[i];
+			parameters.motion = motions[i];
+			real_t safe = 1.0;
+			real_t unsafe = 1.0;
+			CHECK(space_state->cast_motion(parameters, safe, unsafe));
+			CHECK(closest_safe[i] == doctest::Approx(safe));
+			CHECK(closest_unsafe[i] == doctest::Approx(unsafe));
+			if (safe < 1.0) {
+				blocked_count++;
+			}
+		}
+		CHECK(blocked_count > 0);
+
+		server->free(sphere);
+	}
+
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		server->free(bodies[i]);
+	}
+	for (uint32_t i = 0; i < shapes.size(); i++) {
+		server->free(shapes[i]);
+	}
+	server->free(space);
+	server->finish();
+	memdelete(server);
+}
+
+TEST_CASE("[Physics3D][Benchmark] Step a pile of 10000 boxes" * doctest::skip()) {
+	GodotPhysicsServer3D *server = memnew(GodotPhysicsServer3D);
+	server->init();
+	server->set_active(true);
+
+	RID space = server->space_create();
+	server->space_set_active(space, true);
+	server->area_set_param(space, PhysicsServer3D::AREA_PARAM_GRAVITY, 9.8);
+	server->area_set_param(space, PhysicsServer3D::AREA_PARAM_GRAVITY_VECTOR, Vector3(0, -1, 0));
+
+	RID floor_shape = server->box_shape_create();
+	server->shape_set_data(floor_shape, Vector3(100, 1, 100));
+	RID floor = server->body_create();
+	server->body_set_mode(floor, PhysicsServer3D::BODY_MODE_STATIC);
+	server->body_add_shape(floor, floor_shape);
+	server->body_set_state(floor, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(0, -1, 0)));
+	server->body_set_space(floor, space);
+
+	// Columns of boxes with a small gap, so they fall onto each other and settle into a pile.
+	const int side = 25;
+	const int layers = 16;
+	RID box_shape = server->box_shape_create();
+	server->shape_set_data(box_shape, Vector3(0.5, 0.5, 0.5));
+	LocalVector<RID> bodies;
+	for (int y = 0; y < layers; y++) {
+		for (int x = 0; x < side; x++) {
+			for (int z = 0; z < side; z++) {
+				RID body = server->body_create();
+				server->body_add_shape(body, box_shape);
+				server->body_set_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform3D(Basis(), Vector3(x * 1.05 + (y % 2) * 0.25, 0.5 + y * 1.1, z * 1.05)));
+				server->body_set_space(body, space);
+				bodies.push_back(body);
+			}
+		}
+	}
+
+	const int step_count = 120;
+	const real_t delta = 1.0 / 60.0;
+	uint64_t total_usec = 0;
+	uint64_t max_usec = 0;
+	for (int i = 0; i < step_count; i++) {
+		const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		server->step(delta);
+		const uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+		total_usec += elapsed;
+		max_usec = MAX(max_usec, elapsed);
+		server->flush_queries();
+	}
+
+	print_line(vformat("%d boxes, %d collision pairs: average step %.2f ms, slowest %.2f ms.", bodies.size(), server->get_process_info(PhysicsServer3D::INFO_COLLISION_PAIRS), total_usec / 1000.0 / step_count, max_usec / 1000.0));
+
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		server->free(bodies[i]);
+	}
+	server->free(floor);
+	server->free(box_shape);
+	server->free(floor_shape);
+	server->free(space);
+	server->finish();
+	memdelete(server);
+}
+
+TEST_CASE("[Physics3D][Benchmark] Step 100 stacks of 10 crates" * doctest::skip()) {
+	GodotPhysicsServer3D *server = memnew(GodotPhysicsServer3D);
+	server->init();
+	server->set_active(true);
+
+	const int columns = 100;
+	const int height = 10;
+	LocalVector<RID> bodies;
+	LocalVector<RID> shapes;
+	RID space = create_crate_stacks(server, columns, height, bodies, shapes);
+
+	const int step_count = 600;
+	const real_t delta = 1.0 / 60.0;
+	uint64_t total_usec = 0;
+	uint64_t settled_usec = 0;
+	for (int i = 0; i < step_count; i++) {
+		const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		server->step(delta);
+		const uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+		total_usec += elapsed;
+		if (i >= step_count / 2) {
+			settled_usec += elapsed;
+		}
+		server->flush_queries();
+	}
+
+	// How far the top crates drifted sideways, a measure of the stack stability.
+	real_t max_drift = 0.0;
+	for (int column = 0; column < columns; column++) {
+		const Transform3D top = server->body_get_state(bodies[1 + column * height + height - 1], PhysicsServer3D::BODY_STATE_TRANSFORM);
+		const Vector2 start((column % 10) * 3.0, (column / 10) * 3.0);
+		max_drift = MAX(max_drift, Vector2(top.origin.x, top.origin.z).distance_to(start));
+	}
+
+	print_line(vformat("%d crates: average step %.2f ms, %.2f ms once settled, top crates drifted up to %.3f.", columns * height, total_usec / 1000.0 / step_count, settled_usec / 1000.0 / (step_count - step_count / 2), max_drift));
+
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		server->free(bodies[i]);
+	}
+	for (uint32_t i = 0; i < shapes.size(); i++) {
+		server->free(shapes[i]);
+	}
+	server->free(space);
+	server->finish();
+	memdelete(server);
+}
+
+TEST_CASE("[Physics3D][Benchmark] Intersect 100000 rays against a static scene" * doctest::skip()) {
+	GodotPhysicsServer3D *server = memnew(GodotPhysicsServer3D);
+	server->init();
+	server->set_active(true);
+
+	const int side = 100;
+	LocalVector<RID> bodies;
+	LocalVector<RID> shapes;
+	RID space = create_pillar_field(server, side, bodies, shapes);
+	server->step(1.0 / 60.0);
+	server->flush_queries();
+	PhysicsDirectSpaceState3D *space_state = server->space_get_direct_state(space);
+
+	// Sight lines between random points above the pillars.
+	RandomPCG rng(3);
+	const int count = 100000;
+	LocalVector<Vector3> from;
+	LocalVector<Vector3> to;
+	from.resize(count);
+	to.resize(count);
+	for (int i = 0; i < count; i++) {
+		from[i] = Vector3(rng.random(0.0f, side * 2.0f), rng.random(0.5f, 4.0f), rng.random(0.0f, side * 2.0f));
+		to[i] = from[i] + Vector3(rng.random(-20.0f, 20.0f), rng.random(-2.0f, 2.0f), rng.random(-20.0f, 20.0f));
+	}
+
+	PhysicsDirectSpaceState3D::RayParameters parameters;
+	LocalVector<bool> hits;
+	LocalVector<PhysicsDirectSpaceState3D::RayResult> results;
+	hits.resize(count);
+	results.resize(count);
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < count; i++) {
+		parameters.from = from[i];
+		parameters.to = to[i];
+		hits[i] = space_state->intersect_ray(parameters, results[i]);
+	}
+	const uint64_t single_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	space_state->intersect_rays(parameters, from.ptr(), to.ptr(), count, hits.ptr(), results.ptr());
+	const uint64_t batch_usec = OS::get_singleton()->get_ticks_usec() - begin;
+
+	int hit_count = 0;
+	for (int i = 0; i < count; i++) {
+		hit_count += hits[i] ? 1 : 0;
+	}
+	print_line(vformat("%d rays against %d bodies, %d hits: one by one %.2f ms, batched %.2f ms.", count, bodies.size(), hit_count, single_usec / 1000.0, batch_usec / 1000.0));
+
+	for (uint32_t i = 0; i < bodies.size(); i++) {
+		server->free(bodies[i]);
+	}
+	for (uint32_t i = 0; i < shapes.size(); i++) {
+		server->free(shapes[i]);
+	}
+	server->free(space);
+	server->finish();
+	memdelete(server);
+}
+
+} // namespace TestPhysicsServer3D
+
+#endif // TEST_PHYSICS_SERVER_3D_H